@@ -148,7 +148,7 @@ public:
         using namespace std;
 
         MCresults<T,Nz,Nr,detector> myResultsMT;
-        MCmultithread<T,Nz,Nr,detector>(sample, this->Np, this->threads, this->z, this->r, myResultsMT, this->SphereR, this->SphereT, this->dist, this->lightSource);
+        MCmultithread<T,Nz,Nr,detector,DetectorTallies>(sample, this->Np, this->threads, this->z, this->r, myResultsMT, this->SphereR, this->SphereT, this->dist, this->lightSource);
         const auto rMC = myResultsMT.detectedR;
         const auto tMC = myResultsMT.detectedT;
         T func2min = 0;
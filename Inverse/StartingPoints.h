@@ -100,8 +100,8 @@ Matrix<T,gSize,gSize> distances(const Func<T,Nz,Nr,detector,M,N,fix>& f,
             if (mod == ModellingMethod::AD)
                 RTs<T,M>(Sample<T>(samples), vStart, wStart, rCalc, tCalc);
             else if (mod == ModellingMethod::MC) {
-                MCmultithread(Sample<T>(samples), Nphotons, Nthreads, f.getZ(), f.getR(),
-                              myResults, f.getSphereR(), f.getSphereT(), dist, f.getLightSource());
+                MCmultithread<T,Nz,Nr,detector,DetectorTallies>(Sample<T>(samples), Nphotons, Nthreads, f.getZ(), f.getR(),
+                                                                myResults, f.getSphereR(), f.getSphereT(), dist, f.getLightSource());
                 tCalc = myResults.detectedT[0].second;
                 rCalc = myResults.detectedR[0].second;
             }
@@ -0,0 +1,144 @@
+#pragma once
+
+#ifndef ENABLE_CHECK_CONTRACTS
+    #define ENABLE_CHECK_CONTRACTS
+#endif // ENABLE_CHECK_CONTRACTS
+
+#include "MonteCarlo.h"
+
+#include "../Math/Random.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+
+using namespace Eigen;
+using namespace std;
+
+class AdjointTests : public ::testing::Test {
+protected:
+    using T = double;
+    using Fiber = MonteCarlo_NS::OpticalFiber<T>;
+
+    static constexpr size_t Nz = 20;
+    static constexpr size_t Nr = 20;
+    static constexpr bool detector = 1;
+
+    static constexpr int Np = 10000;
+    static constexpr int replicates = 10;
+    static constexpr T d = 1E-3;
+    static constexpr T radius = 1E-2;
+    static constexpr T nLower = 1.33;
+
+    IntegratingSphere<T> sphereR{0.0508, 0.0125, 0.0125};
+    IntegratingSphere<T> sphereT{0.0508, 0.0125, 0.0};
+    DetectorDistance<T>  dist{0, 0.1, 0.05};
+    const LightSource<T> source{1E-3, SourceType::Circle};
+
+    /// water under the sample
+    const Sample<T> sample{{Medium<T>::fromCoeffs(1.4, 100, 10000, d, 0.9)}, 1, nLower};
+
+    struct Signals {
+        T meanR = 0, meanT = 0;
+        T varianceR = 0, varianceT = 0; ///< variances of means
+    };
+
+    static void add(Signals& signals, const T& R, const T& T_) {
+        signals.meanR += R / replicates;
+        signals.meanT += T_ / replicates;
+        signals.varianceR += R * R / replicates;
+        signals.varianceT += T_ * T_ / replicates;
+    }
+
+    static void finish(Signals& signals) {
+        signals.varianceR = (signals.varianceR - signals.meanR * signals.meanR) / (replicates - 1);
+        signals.varianceT = (signals.varianceT - signals.meanT * signals.meanT) / (replicates - 1);
+    }
+
+    /// forward runs with fibers on both sides, their signals are estimated at scattering events
+    Signals forward(const T& offset, const T& NA, const std::uint64_t& seed) const {
+        Signals signals;
+        for (int i = 0; i < replicates; i++) {
+            Math_NS::seedRandom(seed + i);
+            MonteCarlo<T,Nz,Nr,detector> mc(sample, Np, d, radius, sphereR, sphereT, dist, source);
+            auto fiberR = make_shared<Fiber>(offset, 4E-4, NA);
+            auto fiberT = make_shared<Fiber>(offset, 4E-4, NA, nLower);
+            mc.addFiberR(fiberR);
+            mc.addFiberT(fiberT);
+            mc.setFiberEstimator(3 * d);
+            mc.CalculateResult();
+            add(signals, fiberR->signal, fiberT->signal);
+        }
+        finish(signals);
+        return signals;
+    }
+
+    Signals adjoint(const T& offset, const T& NA, const std::uint64_t& seed) const {
+        Signals signals;
+        for (int i = 0; i < replicates; i++) {
+            Math_NS::seedRandom(seed + i);
+            MonteCarlo<T,Nz,Nr,detector> mcR(sample, Np, d, radius, sphereR, sphereT, dist, source);
+            MonteCarlo<T,Nz,Nr,detector> mcT(sample, Np, d, radius, sphereR, sphereT, dist, source);
+            add(signals, mcR.CalculateAdjoint(Fiber(offset, 4E-4, NA)),
+                         mcT.CalculateAdjoint(Fiber(offset, 4E-4, NA, nLower), false));
+        }
+        finish(signals);
+        return signals;
+    }
+};
+
+TEST_F(AdjointTests, AgreesWithForwardRuns) {
+    /// far from the beam and under it, where unscattered light reaches the fiber
+    for (const auto& [offset, NA]: {pair<T,T>{2E-3, 0.22}, pair<T,T>{0, 1}}) {
+        const auto reference = forward(offset, NA, 10);
+        const auto result = adjoint(offset, NA, 100);
+        EXPECT_LT(abs(result.meanR - reference.meanR), 4 * sqrt(result.varianceR + reference.varianceR));
+        EXPECT_LT(abs(result.meanT - reference.meanT), 4 * sqrt(result.varianceT + reference.varianceT));
+    }
+}
+
+TEST_F(AdjointTests, SmallFiberNeedsFewerPackets) {
+    const auto reference = forward(2E-3, 0.22, 200);
+    const auto result = adjoint(2E-3, 0.22, 300);
+    EXPECT_LT(4 * result.varianceR, reference.varianceR);
+    EXPECT_LT(4 * result.varianceT, reference.varianceT);
+}
+
+TEST_F(AdjointTests, BeamMissesFiber) {
+    /// Circle beam ends 1 mm from the axis, unscattered light misses the fiber and the rest needs a turbid sample
+    Math_NS::seedRandom(1);
+    MonteCarlo<T,Nz,Nr,detector> mc(sample, Np / 10, d, radius, sphereR, sphereT, dist, source);
+    EXPECT_GT(mc.CalculateAdjoint(Fiber(1.5E-3, 4E-4, 0.22)), 0);
+
+    const Sample<T> thin({Medium<T>::fromCoeffs(1.4, 100, 10, d, 0.9)}, 1, 1);
+    MonteCarlo<T,Nz,Nr,detector> clear(thin, Np / 10, d, radius, sphereR, sphereT, dist, source);
+    EXPECT_LT(clear.CalculateAdjoint(Fiber(5E-3, 4E-4, 0.22)), 1E-9);
+}
+
+TEST_F(AdjointTests, Throws) {
+    const Fiber fiber(2E-3, 4E-4, 0.22);
+    const LightSource<T> pointSource(0, SourceType::Point);
+    MonteCarlo<T,Nz,Nr,detector> point(sample, 10, d, radius, sphereR, sphereT, dist, pointSource);
+    EXPECT_THROW(point.CalculateAdjoint(fiber), invalid_argument);
+
+    MonteCarlo<T,Nz,Nr,detector> withFiber(sample, 10, d, radius, sphereR, sphereT, dist, source);
+    withFiber.addFiberR(make_shared<Fiber>(fiber));
+    EXPECT_THROW(withFiber.CalculateAdjoint(fiber), invalid_argument);
+
+    MonteCarlo<T,Nz,Nr,detector> quasi(sample, 10, d, radius, sphereR, sphereT, dist, source);
+    quasi.setQuasiRandom();
+    EXPECT_THROW(quasi.CalculateAdjoint(fiber), invalid_argument);
+
+    const Medium<T> glass = Medium<T>::fromCoeffs(1.5, 0, 0, 1E-3, 0);
+    const Sample<T> covered({glass, Medium<T>::fromCoeffs(1.4, 100, 10000, d, 0.9), glass}, 1, 1);
+    MonteCarlo<T,Nz,Nr,detector> withGlass(covered, 10, 3 * d, radius, sphereR, sphereT, dist, source);
+    EXPECT_THROW(withGlass.CalculateAdjoint(fiber), invalid_argument);
+
+    const Matrix<T,Dynamic,Dynamic> coag = Matrix<T,Dynamic,Dynamic>::Ones(Nz, Nr);
+    MonteCarlo<T,Nz,Nr,detector> heterogeneous(sample, 10, d, radius, sphereR, sphereT, dist, source, coag);
+    EXPECT_THROW(heterogeneous.CalculateAdjoint(fiber), invalid_argument);
+
+    const auto spectrum = Spectrum<T>::fromSamples({sample, Sample<T>({Medium<T>::fromCoeffs(1.4, 10, 10000, d, 0.9)}, 1, nLower)});
+    MonteCarlo<T,Nz,Nr,detector> spectral(sample, 10, d, radius, sphereR, sphereT, dist, source, spectrum);
+    EXPECT_THROW(spectral.CalculateAdjoint(fiber), invalid_argument);
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#ifndef ENABLE_CHECK_CONTRACTS
+    #define ENABLE_CHECK_CONTRACTS
+#endif // ENABLE_CHECK_CONTRACTS
+
+/// Eigen asserts on its heap allocations while they are disallowed, allocation_free_tests defines EIGEN_RUNTIME_NO_MALLOC
+#ifndef EIGEN_RUNTIME_NO_MALLOC
+    #error "AllocationFreeTests need EIGEN_RUNTIME_NO_MALLOC, they are built into allocation_free_tests"
+#endif // EIGEN_RUNTIME_NO_MALLOC
+
+#include "MonteCarlo.h"
+#include "Spectrum.h"
+#include "Detector/FullAbsorber.h"
+
+#include "../Math/Random.h"
+#include "../Tests/AllocationCounter.h"
+
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace Eigen;
+using namespace std;
+
+class AllocationFreeTests : public ::testing::Test {
+protected:
+    using T = double;
+    using Material = MaterialProperties<T>;
+
+    static constexpr size_t Nz = 20;
+    static constexpr size_t Nr = 50;
+    static constexpr bool detector = 1;
+
+    static constexpr int warmup = 200;
+    static constexpr int Np = 3000;
+    static constexpr T d = 1E-3;
+    static constexpr T radius = 1E-2;
+
+    /// exposes the photon loop of Calculate
+    class Probe : public MonteCarlo<T,Nz,Nr,detector> {
+    public:
+        using MonteCarlo<T,Nz,Nr,detector>::MonteCarlo;
+
+        /// allocations while tracing photons after warm-up photons
+        long steadyStateAllocations() {
+            /// TracePhotons reserves source points of the whole run up front
+            this->results.sourceMatrix.reserve(warmup + Np);
+            Math_NS::seedRandom(5);
+            this->TracePhotons(0, warmup);
+
+            AllocationCounter::allocations = 0;
+            internal::set_is_malloc_allowed(false);
+            AllocationCounter::enabled = true;
+            this->TracePhotons(warmup, warmup + Np);
+            AllocationCounter::enabled = false;
+            internal::set_is_malloc_allowed(true);
+
+            return AllocationCounter::allocations;
+        }
+    };
+
+    IntegratingSphere<T> sphereR{0.0508, 0.0125, 0.0125};
+    IntegratingSphere<T> sphereT{0.0508, 0.0125, 0.0};
+    DetectorDistance<T>  dist{0, 0.01, 0.002};
+    LightSource<T> source{0.0005, SourceType::Circle};
+
+    const Medium<T> glass = Medium<T>::fromCoeffs(1.5, 0, 0, 1E-3, 0);
+    const Sample<T> layered{{glass, Medium<T>::fromCoeffs(1.4, 100, 3000, d, 0.8), glass}, 1, 1};
+    const Sample<T> tissue{{Medium<T>::fromCoeffs(1.4, uaFunc<T>(1), usFunc<T>(1), d, gFunc<T>(1))}, 1, 1};
+
+    /// native tissue with coagulated core
+    static Matrix<T, Dynamic, Dynamic> phantom() {
+        Matrix<T, Dynamic, Dynamic> coag = Matrix<T, Dynamic, Dynamic>::Ones(Nz, Nr);
+        for (size_t i = 0; i < Nz; i++)
+            for (size_t j = 0; j < Nr; j++)
+                if (Math_NS::sqr(T(i) - Nz / 2) + Math_NS::sqr(T(j)) <= Math_NS::sqr(Nz / 2))
+                    coag(i, j) = 0.1;
+        return coag;
+    }
+};
+
+TEST_F(AllocationFreeTests, HomogeneousTransport) {
+    Probe mc(layered, Np, 3 * d, radius, sphereR, sphereT, dist, source);
+    mc.addDetectorR(make_shared<MonteCarlo_NS::FullAbsorber<T>>());
+    mc.addDetectorT(make_shared<MonteCarlo_NS::FullAbsorber<T>>());
+    EXPECT_EQ(mc.steadyStateAllocations(), 0);
+}
+
+TEST_F(AllocationFreeTests, SpectralTransport) {
+    const auto spectrum = Spectrum<T>::fromSamples({layered, Sample<T>({glass, Medium<T>::fromCoeffs(1.4, 500, 3000, d, 0.8), glass}, 1, 1)});
+    Probe mc(layered, Np, 3 * d, radius, sphereR, sphereT, dist, source, spectrum);
+    EXPECT_EQ(mc.steadyStateAllocations(), 0);
+}
+
+TEST_F(AllocationFreeTests, HeterogeneousTransport) {
+    const auto volume = HeterogeneousVolume<T>::create(phantom(), tissue.getTurbidMedium().getN());
+    for (const auto& tracking: {TrackingMode::VoxelWalk, TrackingMode::Woodcock, TrackingMode::MacroCell}) {
+        Probe mc(tissue, Np, d, radius, sphereR, sphereT, dist, source, volume, tracking);
+        EXPECT_EQ(mc.steadyStateAllocations(), 0) << static_cast<int>(tracking);
+    }
+}
+
+TEST_F(AllocationFreeTests, InclusionTransport) {
+    const auto scene = InclusionScene<T>::create({Inclusion<T>::slab(0.35 * d, 0.7 * d, Material::fromCoag(0.0, 1.4)),
+                                                  Inclusion<T>::sphere(Vector3D<T>(0, 0, 0.5 * d), 0.2 * d, Material::fromCoag(0.5, 1.4))},
+                                                 Material::fromCoag(1.0, 1.4));
+    Probe mc(tissue, Np, d, radius, sphereR, sphereT, dist, source, scene);
+    EXPECT_EQ(mc.steadyStateAllocations(), 0);
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "Detector.h"
+
+#include "../Math/Basic.h"
+#include "../Math/FastMath.h"
+#include "../Math/Vector3.h"
+
+#include <algorithm>
+#include <cmath>
+
+/// \brief Settings of angular biasing of scattering toward detector ports.
+/// Scattering events closer than depth to the top or the bottom of the scattering layers split off a branch
+/// uniform over cones toward ports of spheres on that side, it carries the ratio of the phase function to this density.
+/// The photon keeps directions of the phase function outside the cones and is replaced by the branch inside them,
+/// so every tally stays unbiased
+template < typename T >
+struct AngularBiasing {
+    T probability = 0; ///< part of scattering events near the surfaces which split, 0 disables biasing
+    T depth = 0;       ///< distance from the top and the bottom of the scattering layers where scattering splits
+    T margin = 2;      ///< cones are wider than ports seen from the scattering point by this factor, photons move before they exit
+};
+
+/// \brief Cone of directions toward a detector port, with a hole around the axis
+/// where light leaves the sphere through its opposite port
+template < typename T >
+struct BiasCone {
+    Vector3D<T> axis = Vector3D<T>(0, 0, 1);
+    T cosHalfAngle = 0; ///< cosine of the outer half-angle
+    T cosHole = 1;      ///< cosine of the half-angle of the hole, 1 for no hole
+
+    /// Cone inside the sample which refracts into directions toward the sphere on the beam axis
+    /// \param[in] coordinate scattering point
+    /// \param[in] sphere sphere with distance from the sample surface to its entrance port
+    /// \param[in] nInside refraction coefficient at scattering point
+    /// \param[in] nOutside refraction coefficient outside the sample
+    /// \param[in] up sphere is above the sample
+    /// \param[in] margin the cone is wider and the hole is narrower than the ports seen from the scattering point by this factor
+    /// \return cone of internal directions
+    static BiasCone toSphere(const Vector3D<T>& coordinate, const IntegratingSphere<T>& sphere,
+                             const T& nInside, const T& nOutside, const bool& up, const T& margin) noexcept;
+
+    /// \return probability density of uniform directions in cone per steradian
+    inline T density() const noexcept { return 1 / (2 * T(M_PI) * (cosHole - cosHalfAngle)); }
+    inline bool contains(const Vector3D<T>& direction) const noexcept {
+        const T cosine = axis * direction;
+        return cosine >= cosHalfAngle && (cosHole == 1 || cosine <= cosHole);
+    }
+
+    /// Uniform direction in cone
+    /// \param[in] u1 uniform number in (0, 1) for polar angle
+    /// \param[in] u2 uniform number in (0, 1) for azimuth
+    /// \return unit direction
+    Vector3D<T> sample(const T& u1, const T& u2) const noexcept;
+};
+
+/// Henyey-Greenstein phase function
+/// \param[in] cosTheta cosine of scattering angle
+/// \param[in] g anisotropy, less than 1
+/// \return probability density of scattering direction per steradian
+template < typename T >
+inline T HenyeyGreenstein(const T& cosTheta, const T& g) noexcept {
+    const T g2 = Math_NS::sqr(g);
+    const T denominator = 1 + g2 - 2 * g * cosTheta;
+    return (1 - g2) / (4 * T(M_PI) * denominator * std::sqrt(denominator));
+}
+
+/******************
+ * IMPLEMENTATION *
+ ******************/
+
+template < typename T >
+BiasCone<T> BiasCone<T>::toSphere(const Vector3D<T>& coordinate, const IntegratingSphere<T>& sphere,
+                                  const T& nInside, const T& nOutside, const bool& up, const T& margin) noexcept {
+    using namespace Math_NS;
+    using namespace std;
+
+    /// outside the sample ports are seen at polar angle of their centres and subtend half-angles,
+    /// all of them are refracted into the sample by Snell's law
+    const T ratio = nOutside / nInside;
+    const auto refract = [&ratio](const T& angle) { return min(ratio * sin(min(angle, T(M_PI) / 2)), T(1)); };
+
+    const T rho = sqrt(sqr(coordinate.x) + sqr(coordinate.y));
+    const T sinInside = refract(atan2(rho, sphere.getDistance()));
+    const T cosInside = sqrt(1 - sqr(sinInside));
+
+    BiasCone cone;
+    const T toAxisX = rho == 0 ? 0 : -coordinate.x / rho;
+    const T toAxisY = rho == 0 ? 0 : -coordinate.y / rho;
+    cone.axis = Vector3D<T>(toAxisX * sinInside, toAxisY * sinInside, up ? -cosInside : cosInside);
+    cone.cosHalfAngle = sqrt(1 - sqr(refract(atan2(sphere.getDPort1() / 2, sphere.getDistance()) * margin)));
+    cone.cosHole = sqrt(1 - sqr(refract(atan2(sphere.getDPort2() / 2, sphere.getDistance() + sphere.getDSphere()) / margin)));
+    return cone;
+}
+
+template < typename T >
+Vector3D<T> BiasCone<T>::sample(const T& u1, const T& u2) const noexcept {
+    using namespace Math_NS;
+    using namespace std;
+
+    const T cosTheta = cosHole - u1 * (cosHole - cosHalfAngle);
+    const T sinTheta = sqrt(max(T(0), 1 - sqr(cosTheta)));
+    T sinPhi, cosPhi;
+    transportSincos<T>(2 * T(M_PI) * u2, sinPhi, cosPhi);
+
+    /// orthonormal basis around axis
+    const Vector3D<T> helper = abs(axis.z) < T(0.9) ? Vector3D<T>(0, 0, 1) : Vector3D<T>(1, 0, 0);
+    Vector3D<T> e1 = helper ^ axis;
+    e1 /= e1.norm();
+    const Vector3D<T> e2 = axis ^ e1;
+    return sinTheta * cosPhi * e1 + sinTheta * sinPhi * e2 + cosTheta * axis;
+}
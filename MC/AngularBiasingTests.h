@@ -0,0 +1,126 @@
+#pragma once
+
+#ifndef ENABLE_CHECK_CONTRACTS
+    #define ENABLE_CHECK_CONTRACTS
+#endif // ENABLE_CHECK_CONTRACTS
+
+#include "AngularBiasing.h"
+#include "MonteCarlo.h"
+
+#include "../Math/Random.h"
+
+#include <gtest/gtest.h>
+
+using namespace Eigen;
+using namespace std;
+
+class AngularBiasingTests : public ::testing::Test {
+protected:
+    using T = double;
+
+    static constexpr size_t Nz = 20;
+    static constexpr size_t Nr = 50;
+    static constexpr bool detector = 1;
+
+    static constexpr int Np = 100000;
+    static constexpr T d = 2E-3;
+
+    IntegratingSphere<T> sphereR{0.0508, 0.0125, 0.0125};
+    IntegratingSphere<T> sphereT{0.0508, 0.0125, 0.0};
+    DetectorDistance<T>  dist{0.04, 0.16, 0.04};
+    const LightSource<T> source{1E-3, SourceType::Circle};
+
+    const Medium<T> glass = Medium<T>::fromCoeffs(1.5, 0, 0, 1E-3, 0);
+    const Sample<T> sample{{glass, Medium<T>::fromCoeffs(1.4, 100, 5000, d, 0.8), glass}, 1, 1};
+
+    MCresults<T,Nz,Nr,detector> run(const AngularBiasing<T>& biasing, const std::uint64_t& seed) const {
+        Math_NS::seedRandom(seed);
+        MonteCarlo<T,Nz,Nr,detector> mc(sample, Np, sample.getTotalThickness(), 1E-2, sphereR, sphereT, dist, source);
+        mc.setAngularBiasing(biasing);
+        return mc.CalculateResult();
+    }
+};
+
+TEST_F(AngularBiasingTests, ConeAroundRefractedPorts) {
+    /// sphere right above the scattering point, light near the axis leaves through its opposite port
+    const IntegratingSphere<T> withHole(0.05, 0.01, 0.01, 0.1);
+    const auto above = BiasCone<T>::toSphere({0, 0, 1E-3}, withHole, 1.4, 1, true, 1);
+    EXPECT_NEAR(above.axis.z, -1, 1E-15);
+    EXPECT_NEAR(sqrt(1 - above.cosHalfAngle * above.cosHalfAngle), sin(atan(0.05)) / 1.4, 1E-12);
+    EXPECT_NEAR(sqrt(1 - above.cosHole * above.cosHole), sin(atan(0.005 / 0.15)) / 1.4, 1E-12);
+    EXPECT_FALSE(above.contains(above.axis));
+
+    /// sphere seen off axis, the axis is tilted toward the beam axis by the refracted angle
+    const IntegratingSphere<T> noHole(0.05, 0.01, 0.0, 0.1);
+    const auto below = BiasCone<T>::toSphere({0.01, 0, 1E-3}, noHole, 1.4, 1, false, 2);
+    EXPECT_LT(below.axis.x, 0);
+    EXPECT_NEAR(below.axis.y, 0, 1E-15);
+    EXPECT_NEAR(below.axis.x, -sin(atan(0.1)) / 1.4, 1E-12);
+    EXPECT_NEAR(below.axis.norm(), 1, 1E-12);
+    EXPECT_EQ(below.cosHole, 1);
+    EXPECT_TRUE(below.contains(below.axis));
+
+    Math_NS::seedRandom(1);
+    for (const auto& cone: {above, below}) {
+        T meanCos = 0;
+        const int N = 100000;
+        for (int i = 0; i < N; i++) {
+            const auto direction = cone.sample(Math_NS::random<T>(0, 1), Math_NS::random<T>(0, 1));
+            EXPECT_NEAR(direction.norm(), 1, 1E-12);
+            EXPECT_TRUE(cone.contains(direction));
+            meanCos += direction * cone.axis / N;
+        }
+        /// uniform on the cap
+        EXPECT_NEAR(meanCos, (cone.cosHole + cone.cosHalfAngle) / 2, 1E-4);
+        EXPECT_NEAR(cone.density() * 2 * M_PI * (cone.cosHole - cone.cosHalfAngle), 1, 1E-12);
+    }
+}
+
+TEST_F(AngularBiasingTests, PhaseFunctionIsNormalized) {
+    for (T g: {0.0, 0.5, 0.9, -0.3}) {
+        const int N = 200000;
+        T integral = 0;
+        for (int i = 0; i < N; i++)
+            integral += HenyeyGreenstein<T>(-1 + (i + T(0.5)) * 2 / N, g) * 2 * M_PI * 2 / N;
+        EXPECT_NEAR(integral, 1, 1E-6);
+    }
+}
+
+TEST_F(AngularBiasingTests, UnbiasedWithLowerVarianceAtDistance) {
+    const auto analog = run(AngularBiasing<T>(), 2);
+    const auto biased = run(AngularBiasing<T>{1, 0.4E-3}, 3);
+
+    EXPECT_NEAR(biased.diffuseReflection  , analog.diffuseReflection  , 0.02 * analog.diffuseReflection  );
+    EXPECT_NEAR(biased.diffuseTransmission, analog.diffuseTransmission, 0.02 * analog.diffuseTransmission);
+    EXPECT_NEAR(biased.absorbed           , analog.absorbed           , 0.02 * analog.absorbed           );
+
+    ASSERT_EQ(biased.detectedRvariance.size(), analog.detectedR.size());
+    for (size_t i = 0; i < analog.detectedR.size(); i++) {
+        for (const auto& [a, b, va, vb]: {make_tuple(analog.detectedR[i].second, biased.detectedR[i].second, analog.detectedRvariance[i].second, biased.detectedRvariance[i].second),
+                                          make_tuple(analog.detectedT[i].second, biased.detectedT[i].second, analog.detectedTvariance[i].second, biased.detectedTvariance[i].second)}) {
+            EXPECT_GT(va, 0);
+            EXPECT_GT(vb, 0);
+            EXPECT_LT(abs(a - b), 4 * sqrt(va + vb));
+        }
+    }
+
+    /// relative variance of the farthest spheres
+    const int far = analog.detectedR.size() - 1;
+    EXPECT_LT(biased.detectedRvariance[far].second / Math_NS::sqr(biased.detectedR[far].second),
+              analog.detectedRvariance[far].second / Math_NS::sqr(analog.detectedR[far].second) / 2);
+    EXPECT_LT(biased.detectedTvariance[far].second / Math_NS::sqr(biased.detectedT[far].second),
+              analog.detectedTvariance[far].second / Math_NS::sqr(analog.detectedT[far].second) / 2);
+}
+
+TEST_F(AngularBiasingTests, Throws) {
+    MonteCarlo<T,Nz,Nr,detector> mc(sample, 10, sample.getTotalThickness(), 1E-2, sphereR, sphereT, dist, source);
+    EXPECT_THROW(mc.setAngularBiasing(AngularBiasing<T>{1.5, 1E-3}), invalid_argument);
+    EXPECT_THROW(mc.setAngularBiasing(AngularBiasing<T>{-0.1, 1E-3}), invalid_argument);
+    EXPECT_THROW(mc.setAngularBiasing(AngularBiasing<T>{0.5, -1E-3}), invalid_argument);
+    EXPECT_THROW(mc.setAngularBiasing(AngularBiasing<T>{0.5, 1E-3, 0.5}), invalid_argument);
+
+    const auto tissue = Sample<T>({Medium<T>::fromCoeffs(1.4, 100, 3000, d, 0.8)}, 1, 1);
+    const Matrix<T,Dynamic,Dynamic> coag = Matrix<T,Dynamic,Dynamic>::Ones(Nz, Nr);
+    MonteCarlo<T,Nz,Nr,detector> heterogeneous(tissue, 10, d, 1E-2, sphereR, sphereT, dist, source, coag);
+    EXPECT_THROW(heterogeneous.setAngularBiasing(AngularBiasing<T>{0.5, 1E-3}), invalid_argument);
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#ifndef ENABLE_CHECK_CONTRACTS
+    #define ENABLE_CHECK_CONTRACTS
+#endif // ENABLE_CHECK_CONTRACTS
+
+#include "BeamProfile.h"
+#include "MonteCarlo.h"
+
+#include "../Math/Random.h"
+
+#include <gtest/gtest.h>
+
+using namespace Eigen;
+using namespace std;
+
+class BeamConvolutionTests : public ::testing::Test {
+protected:
+    using T = double;
+
+    static constexpr size_t Nz = 20;
+    static constexpr size_t Nr = 50;
+    static constexpr bool detector = 1;
+
+    static constexpr int Np = 100000;
+    static constexpr T d = 1E-3;
+    static constexpr T radius = 1E-2;
+    static constexpr T dr = radius / Nr;
+
+    IntegratingSphere<T> sphereR{0.0508, 0.0125, 0.0125};
+    IntegratingSphere<T> sphereT{0.0508, 0.0125, 0.0};
+    DetectorDistance<T>  dist{0, 0.02, 0.004};
+    const LightSource<T> point{0, SourceType::Point};
+
+    const Medium<T> glass = Medium<T>::fromCoeffs(1.5, 0, 0, 1E-3, 0);
+    const Sample<T> sample{{glass, Medium<T>::fromCoeffs(1.4, 100, 3000, d, 0.8), glass}, 1, 1};
+
+    MCresults<T,Nz,Nr,detector> direct(const LightSource<T>& source, const std::uint64_t& seed) const {
+        Math_NS::seedRandom(seed);
+        MonteCarlo<T,Nz,Nr,detector> mc(sample, Np, 3 * d, radius, sphereR, sphereT, dist, source);
+        return mc.CalculateResult();
+    }
+
+    /// cumulative radial profile normalized by total weight
+    static Matrix<T,1,Dynamic> profile(const Matrix<T,1,Dynamic>& array) {
+        Matrix<T,1,Dynamic> cumulative = array;
+        for (int i = 1; i < cumulative.size(); i++)
+            cumulative(i) += cumulative(i - 1);
+        return cumulative / array.sum();
+    }
+};
+
+TEST_F(BeamConvolutionTests, KernelKeepsWeight) {
+    const auto circle = BeamProfile<T>::fromLightSource(LightSource<T>(2E-3, SourceType::Circle));
+    const auto K = circle.kernel(dr, Nr);
+    for (int j = 0; j < Nr; j++)
+        EXPECT_NEAR(K.row(j).sum(), 1, 1E-12);
+
+    /// centre bin spreads over the beam
+    EXPECT_NEAR(K.row(0).head(11).sum(), 1, 1E-12);
+    EXPECT_GT(K(0, 5), 0);
+
+    const auto pointBeam = BeamProfile<T>::fromLightSource(point);
+    EXPECT_EQ(pointBeam.getMaxRadius(), 0);
+    EXPECT_EQ(pointBeam.kernel(dr, Nr), (Matrix<T,Dynamic,Dynamic>::Identity(Nr, Nr)));
+}
+
+TEST_F(BeamConvolutionTests, OffsetsFollowProfile) {
+    const T R = 2E-3;
+    const auto circle = BeamProfile<T>::fromLightSource(LightSource<T>(R, SourceType::Circle));
+    const auto gaussian = BeamProfile<T>::fromLightSource(LightSource<T>(R, SourceType::Gaussian));
+
+    Math_NS::seedRandom(1);
+    const int N = 100000;
+    T circleR2 = 0, gaussianR2 = 0;
+    for (int i = 0; i < N; i++) {
+        const auto offset = circle.sampleOffset();
+        EXPECT_LE(offset.norm(), R * (1 + 1E-12));
+        EXPECT_EQ(offset.z, 0);
+        circleR2 += offset.norm2();
+        gaussianR2 += gaussian.sampleOffset().norm2();
+    }
+    EXPECT_NEAR(circleR2 / N, R * R / 2, 0.01 * R * R);
+    EXPECT_NEAR(gaussianR2 / N, R * R, 0.02 * R * R);
+}
+
+TEST_F(BeamConvolutionTests, PointSourceRunMatchesBeamRuns) {
+    const LightSource<T> circle(2E-3, SourceType::Circle);
+    const LightSource<T> gaussian(1E-3, SourceType::Gaussian);
+
+    Math_NS::seedRandom(7);
+    MonteCarlo<T,Nz,Nr,detector> mc(sample, Np, 3 * d, radius, sphereR, sphereT, dist, point);
+    const auto beams = mc.CalculateBeams({BeamProfile<T>::fromLightSource(circle), BeamProfile<T>::fromLightSource(gaussian)});
+    ASSERT_EQ(beams.size(), 2);
+
+    for (const auto& [beam, source]: {make_pair(beams[0], circle), make_pair(beams[1], gaussian)}) {
+        const auto reference = direct(source, 11);
+        EXPECT_NEAR(beam.diffuseReflection  , reference.diffuseReflection  , 0.03 * reference.diffuseReflection  );
+        EXPECT_NEAR(beam.diffuseTransmission, reference.diffuseTransmission, 0.03 * reference.diffuseTransmission);
+        EXPECT_NEAR(beam.absorbed           , reference.absorbed           , 0.03 * reference.absorbed           );
+        EXPECT_LT((profile(beam.arrayR) - profile(reference.arrayR)).cwiseAbs().maxCoeff(), 0.02);
+        EXPECT_LT((profile(beam.arrayT) - profile(reference.arrayT)).cwiseAbs().maxCoeff(), 0.02);
+        EXPECT_NEAR(beam.matrixA.sum(), beam.absorbed * Np, 1E-6 * Np);
+        EXPECT_NEAR(beam.heatSourceNorm.sum(), reference.heatSourceNorm.sum(), 0.05 * reference.heatSourceNorm.sum());
+
+        ASSERT_EQ(beam.detectedR.size(), reference.detectedR.size());
+        for (size_t i = 0; i < reference.detectedR.size(); i++) {
+            EXPECT_EQ(beam.detectedR[i].first, reference.detectedR[i].first);
+            EXPECT_NEAR(beam.detectedR[i].second, reference.detectedR[i].second, 0.05 * reference.detectedR[i].second + 1E-3);
+            EXPECT_NEAR(beam.detectedT[i].second, reference.detectedT[i].second, 0.05 * reference.detectedT[i].second + 1E-3);
+        }
+    }
+}
+
+TEST_F(BeamConvolutionTests, Throws) {
+    const LightSource<T> circleSource(1E-3, SourceType::Circle);
+    MonteCarlo<T,Nz,Nr,detector> circle(sample, 10, 3 * d, radius, sphereR, sphereT, dist, circleSource);
+    EXPECT_THROW(circle.CalculateBeams({BeamProfile<T>()}), invalid_argument);
+
+    const auto tissue = Sample<T>({Medium<T>::fromCoeffs(1.4, 100, 3000, d, 0.8)}, 1, 1);
+    const Matrix<T,Dynamic,Dynamic> coag = Matrix<T,Dynamic,Dynamic>::Ones(Nz, Nr);
+    MonteCarlo<T,Nz,Nr,detector> heterogeneous(tissue, 10, d, radius, sphereR, sphereT, dist, point, coag);
+    EXPECT_THROW(heterogeneous.CalculateBeams({BeamProfile<T>()}), invalid_argument);
+
+    EXPECT_THROW(BeamProfile<T>::fromIntensity([](const T&) { return T(-1); }, 1E-3), invalid_argument);
+    EXPECT_THROW(BeamProfile<T>::fromIntensity([](const T&) { return T(0); }, 1E-3), invalid_argument);
+    EXPECT_THROW(BeamProfile<T>::fromIntensity([](const T&) { return T(1); }, -1E-3), invalid_argument);
+}
@@ -0,0 +1,192 @@
+#pragma once
+
+#include "LightSource.h"
+
+#include "../Math/Basic.h"
+#include "../Math/FastMath.h"
+#include "../Math/Random.h"
+#include "../Math/Vector3.h"
+#include "../Utils/Contracts.h"
+#include "../eigen/Eigen/Dense"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+/// \brief Axisymmetric beam profile split into rings of equal width.
+/// Results of a point-source run on layered samples are shift-invariant,
+/// so results for the beam are their convolution with the profile, see MonteCarlo::CalculateBeams
+template < typename T >
+class BeamProfile {
+public:
+    BeamProfile() noexcept = default;
+    ~BeamProfile() noexcept = default;
+
+    static constexpr int RINGS = 200; ///< default number of rings
+
+    /// Beam from radial intensity
+    /// \param[in] intensity radial intensity, callable with radius, evaluated at ring centres
+    /// \param[in] maxRadius radius where intensity is cut, point beam for zero
+    /// \param[in] Nrings number of rings
+    /// \return beam with power of rings normalized to 1
+    /// \throw std::invalid_argument if ENABLE_CHECK_CONTRACTS is defined and maxRadius is negative, Nrings is not positive,
+    /// intensity is negative or has no power
+    template < typename Intensity >
+    static BeamProfile fromIntensity(const Intensity& intensity, const T& maxRadius, const int& Nrings = RINGS) EXCEPT_INPUT_PARAMS;
+
+    /// Beam of light source, gaussian beam is cut at 4 radii, radial table is interpolated linearly
+    /// \param[in] source light source
+    /// \param[in] Nrings number of rings
+    /// \return beam with the launch profile of source
+    /// \throw std::invalid_argument if ENABLE_CHECK_CONTRACTS is defined and source is an image, it is not axisymmetric
+    static BeamProfile fromLightSource(const LightSource<T>& source, const int& Nrings = RINGS) EXCEPT_INPUT_PARAMS;
+
+    /// Offset of launch point from beam axis
+    /// \return random point in z = 0 plane distributed as beam power
+    Vector3D<T> sampleOffset() const noexcept;
+
+    /// Convolution kernel of radial tallies binned by dr,
+    /// row j is the part of point-source weight of bin j which falls in every bin after convolution with the beam.
+    /// Weight is assumed uniform over the area of a bin, last bin collects everything beyond the grid and keeps its weight
+    /// \param[in] dr width of radial bins
+    /// \param[in] Nr number of radial bins
+    /// \return Nr x Nr kernel with rows summing to 1, radial tally of the beam is tally of point source times kernel
+    Eigen::Matrix<T,Eigen::Dynamic,Eigen::Dynamic> kernel(const T& dr, const int& Nr) const noexcept;
+
+    inline int getNrings()     const noexcept { return power.size();         }
+    inline T getMaxRadius()    const noexcept { return width * power.size(); }
+    inline T getPower(const int& ring) const noexcept { return power[ring];  }
+
+protected:
+    T width = 0; ///< width of rings, zero for point beam
+    std::vector<T> power = {1}; ///< part of power of every ring
+    std::vector<T> cumulative = {1}; ///< cumulative power of rings
+
+    static constexpr int BIN_SAMPLES = 4;   ///< radii sampled in every bin of point-source tally
+    static constexpr int ANGLE_SAMPLES = 64; ///< angles between bin and beam radii sampled on [0, pi]
+};
+
+/******************
+ * IMPLEMENTATION *
+ ******************/
+
+template < typename T >
+template < typename Intensity >
+BeamProfile<T> BeamProfile<T>::fromIntensity(const Intensity& intensity, const T& maxRadius, const int& Nrings) EXCEPT_INPUT_PARAMS {
+    CHECK_ARGUMENT_CONTRACT(maxRadius >= 0);
+    CHECK_ARGUMENT_CONTRACT(Nrings > 0);
+
+    BeamProfile beam;
+    if (maxRadius == 0)
+        return beam;
+
+    beam.width = maxRadius / Nrings;
+    beam.power.resize(Nrings);
+    beam.cumulative.resize(Nrings);
+    T total = 0;
+    for (int m = 0; m < Nrings; m++) {
+        const T inner = m * beam.width;
+        const T outer = inner + beam.width;
+        const T value = intensity(inner + beam.width / 2);
+        CHECK_ARGUMENT_CONTRACT(value >= 0);
+
+        beam.power[m] = value * (outer * outer - inner * inner);
+        total += beam.power[m];
+    }
+    CHECK_ARGUMENT_CONTRACT(total > 0);
+
+    T sum = 0;
+    for (int m = 0; m < Nrings; m++) {
+        beam.power[m] /= total;
+        sum += beam.power[m];
+        beam.cumulative[m] = sum;
+    }
+    beam.cumulative.back() = 1;
+    return beam;
+}
+
+template < typename T >
+BeamProfile<T> BeamProfile<T>::fromLightSource(const LightSource<T>& source, const int& Nrings) EXCEPT_INPUT_PARAMS {
+    CHECK_ARGUMENT_CONTRACT(source.getType() != SourceType::Image);
+
+    const T radius = source.getRadius();
+    switch (source.getType()) {
+    case SourceType::Circle:
+        return fromIntensity([](const T&) { return T(1); }, radius, Nrings);
+    case SourceType::Gaussian:
+        return fromIntensity([radius](const T& r) { return std::exp(-Math_NS::sqr(r / radius)); }, 4 * radius, Nrings);
+    case SourceType::RadialTable: {
+        const auto& table = source.getTable();
+        return fromIntensity([&table](const T& r) {
+            const auto upper = std::upper_bound(table.begin(), table.end(), r, [](const T& x, const std::pair<T,T>& point) { return x < point.first; });
+            if (upper == table.begin())
+                return upper->second;
+            if (upper == table.end())
+                return table.back().second;
+            const auto lower = upper - 1;
+            return lower->second + (r - lower->first) / (upper->first - lower->first) * (upper->second - lower->second);
+        }, radius, Nrings);
+    }
+    default:
+        return BeamProfile();
+    }
+}
+
+template < typename T >
+Vector3D<T> BeamProfile<T>::sampleOffset() const noexcept {
+    using namespace Math_NS;
+    using namespace std;
+
+    if (width == 0)
+        return Vector3D<T>(0, 0, 0);
+
+    const int m = min(static_cast<int>(upper_bound(cumulative.begin(), cumulative.end(), random<T>(0, 1)) - cumulative.begin()),
+                      static_cast<int>(cumulative.size()) - 1);
+    /// uniform over the area of ring
+    const T inner = m * width;
+    const T outer = inner + width;
+    const T r = sqrt(sqr(inner) + random<T>(0, 1) * (sqr(outer) - sqr(inner)));
+    T sinA, cosA;
+    transportSincos(random<T>(0, 1) * 2 * T(M_PI), sinA, cosA);
+    return Vector3D<T>(r * cosA, r * sinA, 0);
+}
+
+template < typename T >
+Eigen::Matrix<T,Eigen::Dynamic,Eigen::Dynamic> BeamProfile<T>::kernel(const T& dr, const int& Nr) const noexcept {
+    using namespace Math_NS;
+    using namespace std;
+
+    if (width == 0)
+        return Eigen::Matrix<T,Eigen::Dynamic,Eigen::Dynamic>::Identity(Nr, Nr);
+
+    Eigen::Matrix<T,Eigen::Dynamic,Eigen::Dynamic> K = Eigen::Matrix<T,Eigen::Dynamic,Eigen::Dynamic>::Zero(Nr, Nr);
+    K(Nr - 1, Nr - 1) = 1;
+
+    /// cosines of angles between bin and beam radii, midpoints of equal steps on [0, pi]
+    T cosines[ANGLE_SAMPLES];
+    for (int k = 0; k < ANGLE_SAMPLES; k++)
+        cosines[k] = cos((k + T(0.5)) * T(M_PI) / ANGLE_SAMPLES);
+
+    for (int j = 0; j < Nr - 1; j++) {
+        /// radii of bin weighted by area
+        T radii[BIN_SAMPLES], areas[BIN_SAMPLES], totalArea = 0;
+        for (int s = 0; s < BIN_SAMPLES; s++) {
+            radii[s] = (j + (s + T(0.5)) / BIN_SAMPLES) * dr;
+            areas[s] = radii[s];
+            totalArea += areas[s];
+        }
+        for (int s = 0; s < BIN_SAMPLES; s++) {
+            const T r = radii[s];
+            for (int m = 0; m < getNrings(); m++) {
+                const T rho = (m + T(0.5)) * width;
+                const T weight = areas[s] / totalArea * power[m] / ANGLE_SAMPLES;
+                for (int k = 0; k < ANGLE_SAMPLES; k++) {
+                    const T shifted = sqrt(sqr(r) + sqr(rho) + 2 * r * rho * cosines[k]);
+                    const int i = min(static_cast<int>(shifted / dr), Nr - 1);
+                    K(j, i) += weight;
+                }
+            }
+        }
+    }
+    return K;
+}
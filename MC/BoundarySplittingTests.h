@@ -0,0 +1,90 @@
+#pragma once
+
+#ifndef ENABLE_CHECK_CONTRACTS
+    #define ENABLE_CHECK_CONTRACTS
+#endif // ENABLE_CHECK_CONTRACTS
+
+#include "MonteCarlo.h"
+
+#include "../Math/Random.h"
+
+#include <gtest/gtest.h>
+
+using namespace Eigen;
+using namespace std;
+
+class BoundarySplittingTests : public ::testing::Test {
+protected:
+    using T = double;
+
+    static constexpr size_t Nz = 20;
+    static constexpr size_t Nr = 20;
+    static constexpr bool detector = 1;
+
+    static constexpr int Np = 100000;
+    static constexpr T d = 1E-3;
+    static constexpr T radius = 1E-2;
+
+    IntegratingSphere<T> sphereR{0.0508, 0.0125, 0.0125};
+    IntegratingSphere<T> sphereT{0.0508, 0.0125, 0.0};
+    DetectorDistance<T>  dist{0, 0.1, 0.05};
+    const LightSource<T> source{1E-3, SourceType::Circle};
+
+    const Medium<T> glass = Medium<T>::fromCoeffs(1.5, 0, 0, 1E-3, 0);
+    /// watery tissue reflects more at the glass than 1.4
+    const Sample<T> sample{{glass, Medium<T>::fromCoeffs(1.33, 100, 3000, d, 0.8), glass}, 1, 1};
+
+    MCresults<T,Nz,Nr,detector> run(const int& maxSplits, const std::uint64_t& seed) const {
+        Math_NS::seedRandom(seed);
+        MonteCarlo<T,Nz,Nr,detector> mc(sample, Np, 3 * d, radius, sphereR, sphereT, dist, source);
+        mc.setBoundarySplitting(maxSplits, 0);
+        return mc.CalculateResult();
+    }
+};
+
+TEST_F(BoundarySplittingTests, DisabledSplittingKeepsRun) {
+    Math_NS::seedRandom(1);
+    MonteCarlo<T,Nz,Nr,detector> plain(sample, Np / 10, 3 * d, radius, sphereR, sphereT, dist, source);
+    const auto reference = plain.CalculateResult();
+
+    Math_NS::seedRandom(1);
+    MonteCarlo<T,Nz,Nr,detector> disabled(sample, Np / 10, 3 * d, radius, sphereR, sphereT, dist, source);
+    disabled.setBoundarySplitting(0);
+    const auto result = disabled.CalculateResult();
+
+    EXPECT_EQ(result.diffuseReflection, reference.diffuseReflection);
+    EXPECT_EQ(result.diffuseTransmission, reference.diffuseTransmission);
+    EXPECT_EQ(result.matrixA, reference.matrixA);
+    EXPECT_EQ(result.detectedR, reference.detectedR);
+}
+
+TEST_F(BoundarySplittingTests, SplittingIsUnbiased) {
+    const auto analog = run(0, 2);
+    for (const int& maxSplits: {1, 8}) {
+        const auto split = run(maxSplits, 3);
+        EXPECT_NEAR(split.diffuseReflection  , analog.diffuseReflection  , 0.02 * analog.diffuseReflection  );
+        EXPECT_NEAR(split.diffuseTransmission, analog.diffuseTransmission, 0.01 * analog.diffuseTransmission);
+        EXPECT_NEAR(split.absorbed           , analog.absorbed           , 0.02 * analog.absorbed           );
+        EXPECT_NEAR(split.specularReflection + split.diffuseReflection + split.diffuseTransmission + split.absorbed, 1, 1E-2);
+        for (size_t i = 0; i < analog.detectedR.size(); i++) {
+            EXPECT_LT(abs(split.detectedR[i].second - analog.detectedR[i].second), 4 * sqrt(split.detectedRvariance[i].second + analog.detectedRvariance[i].second));
+            EXPECT_LT(abs(split.detectedT[i].second - analog.detectedT[i].second), 4 * sqrt(split.detectedTvariance[i].second + analog.detectedTvariance[i].second));
+        }
+    }
+}
+
+TEST_F(BoundarySplittingTests, Throws) {
+    MonteCarlo<T,Nz,Nr,detector> mc(sample, 10, 3 * d, radius, sphereR, sphereT, dist, source);
+    EXPECT_THROW(mc.setBoundarySplitting(-1), invalid_argument);
+    EXPECT_THROW(mc.setBoundarySplitting(4, -0.1), invalid_argument);
+    EXPECT_THROW(mc.setBoundarySplitting(4, 1), invalid_argument);
+
+    const auto tissue = Sample<T>({Medium<T>::fromCoeffs(1.4, 100, 3000, d, 0.8)}, 1, 1);
+    const Matrix<T,Dynamic,Dynamic> coag = Matrix<T,Dynamic,Dynamic>::Ones(Nz, Nr);
+    MonteCarlo<T,Nz,Nr,detector> heterogeneous(tissue, 10, d, radius, sphereR, sphereT, dist, source, coag);
+    EXPECT_THROW(heterogeneous.setBoundarySplitting(4), invalid_argument);
+
+    const auto spectrum = Spectrum<T>::fromSamples({tissue, Sample<T>({Medium<T>::fromCoeffs(1.4, 10, 3000, d, 0.8)}, 1, 1)});
+    MonteCarlo<T,Nz,Nr,detector> spectral(tissue, 10, d, radius, sphereR, sphereT, dist, source, spectrum);
+    EXPECT_THROW(spectral.setBoundarySplitting(4), invalid_argument);
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "DetectorInterface.h"
+
+#include "../Photon.h"
+#include "../../Utils/Contracts.h"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace MonteCarlo_NS {
+    /// \brief Buffer of exit photons for a group of detectors.
+    /// Photons are handed to every detector in whole batches through detectBatch,
+    /// so the photon loop itself makes no virtual calls. One batch belongs to one simulation thread.
+    template < typename T >
+    class DetectorBatch {
+    public:
+        static constexpr size_t BATCH_SIZE = 1024; ///< photons buffered before detectors are called
+
+        DetectorBatch() noexcept = default;
+
+        /// Add detector to the group
+        /// \param[in] detector detector shared with the caller, which reads it after the run
+        /// \throw std::invalid_argument if ENABLE_CHECK_CONTRACTS is defined and detector is nullptr
+        void add(std::shared_ptr<DetectorInterface<T>> detector) EXCEPT_INPUT_PARAMS;
+
+        /// Buffer photon, full buffer is handed to detectors
+        /// \param[in] photon Photon that should be detected
+        void push(const Photon<T>& photon);
+
+        /// Hand buffered photons to detectors
+        void flush();
+
+        /// Hand buffered photons to detectors and calibrate them
+        /// \param[in] totalWeights total weights for all simulated photons
+        void calibrate(const T& totalWeights);
+
+        inline bool empty() const noexcept { return detectors.empty(); }
+        inline size_t getNdetectors() const noexcept { return detectors.size(); }
+        inline size_t getNbuffered() const noexcept { return buffer.size(); }
+
+    protected:
+        std::vector<std::shared_ptr<DetectorInterface<T>>> detectors;
+        std::vector<Photon<T>> buffer;
+    };
+}
+
+/******************
+ * IMPLEMENTATION *
+ ******************/
+
+template < typename T >
+void MonteCarlo_NS::DetectorBatch<T>::add(std::shared_ptr<DetectorInterface<T>> detector) EXCEPT_INPUT_PARAMS {
+    CHECK_ARGUMENT_CONTRACT(detector != nullptr);
+
+    detectors.push_back(std::move(detector));
+    buffer.reserve(BATCH_SIZE);
+}
+
+template < typename T >
+void MonteCarlo_NS::DetectorBatch<T>::push(const Photon<T>& photon) {
+    if (detectors.empty())
+        return;
+
+    buffer.push_back(photon);
+    if (buffer.size() == BATCH_SIZE)
+        flush();
+}
+
+template < typename T >
+void MonteCarlo_NS::DetectorBatch<T>::flush() {
+    if (buffer.empty())
+        return;
+
+    for (const auto& detector: detectors)
+        detector->detectBatch(buffer.data(), buffer.size());
+    buffer.clear();
+}
+
+template < typename T >
+void MonteCarlo_NS::DetectorBatch<T>::calibrate(const T& totalWeights) {
+    flush();
+    for (const auto& detector: detectors)
+        detector->calibrate(totalWeights);
+}
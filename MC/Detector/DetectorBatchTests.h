@@ -0,0 +1,208 @@
+#pragma once
+
+#ifndef ENABLE_CHECK_CONTRACTS
+    #define ENABLE_CHECK_CONTRACTS
+#endif // ENABLE_CHECK_CONTRACTS
+
+#include "DetectorBatch.h"
+#include "FullAbsorber.h"
+
+#include "../MonteCarlo.h"
+#include "../MonteCarloMultithread.h"
+#include "../../Math/Random.h"
+
+#include <gtest/gtest.h>
+
+using namespace MonteCarlo_NS;
+using namespace std;
+
+class DetectorBatchTests : public ::testing::Test {
+protected:
+    /// counts batches and photons it gets
+    class CountingDetector : public DetectorInterface<double> {
+    public:
+        void detectBatch(const Photon<double>* photons, const size_t& count) override {
+            batches++;
+            for (size_t i = 0; i < count; i++)
+                weight += photons[i].weight;
+            detected += count;
+        }
+
+        void calibrate(const double& totalWeights) override {
+            calibratedBy = totalWeights;
+        }
+
+        int batches = 0;
+        size_t detected = 0;
+        double weight = 0;
+        double calibratedBy = 0;
+    };
+
+    static Photon<double> photon(const double& cosine, const double& weight) {
+        return Photon<double>({0, 0, 0}, {sqrt(1 - cosine * cosine), 0, cosine}, weight, 0);
+    }
+};
+
+TEST_F(DetectorBatchTests, DetectorsGetWholeBatches) {
+    DetectorBatch<double> batch;
+    auto first = make_shared<CountingDetector>();
+    auto second = make_shared<CountingDetector>();
+    batch.add(first);
+    batch.add(second);
+    EXPECT_EQ(batch.getNdetectors(), 2);
+
+    const size_t N = 2 * DetectorBatch<double>::BATCH_SIZE + 10;
+    for (size_t i = 0; i < N; i++)
+        batch.push(photon(1, 0.5));
+    EXPECT_EQ(first->batches, 2);
+    EXPECT_EQ(batch.getNbuffered(), 10);
+
+    batch.calibrate(N);
+    for (const auto& detector: {first, second}) {
+        EXPECT_EQ(detector->batches, 3);
+        EXPECT_EQ(detector->detected, N);
+        EXPECT_DOUBLE_EQ(detector->weight, 0.5 * N);
+        EXPECT_EQ(detector->calibratedBy, N);
+    }
+    EXPECT_EQ(batch.getNbuffered(), 0);
+}
+
+TEST_F(DetectorBatchTests, EmptyBatchBuffersNothing) {
+    DetectorBatch<double> batch;
+    batch.push(photon(1, 1));
+    EXPECT_TRUE(batch.empty());
+    EXPECT_EQ(batch.getNbuffered(), 0);
+}
+
+TEST_F(DetectorBatchTests, Throws) {
+    DetectorBatch<double> batch;
+    EXPECT_THROW(batch.add(nullptr), invalid_argument);
+
+    /// interface handles batches photon by photon
+    batch.add(make_shared<DetectorInterface<double>>());
+    batch.push(photon(1, 1));
+    EXPECT_THROW(batch.flush(), runtime_error);
+}
+
+TEST_F(DetectorBatchTests, FullAbsorberBatchMatchesSinglePhotons) {
+    FullAbsorber<double> single(0.9);
+    FullAbsorber<double> batched(0.9);
+    vector<Photon<double>> photons;
+    for (int i = 0; i < 100; i++)
+        photons.push_back(photon(i / 99.0, 0.01 * i));
+
+    for (const auto& p: photons)
+        single.detect(p);
+    batched.detectBatch(photons.data(), photons.size());
+    EXPECT_DOUBLE_EQ(batched.collimatedAbsorbed, single.collimatedAbsorbed);
+    EXPECT_DOUBLE_EQ(batched.diffusiveAbsorbed, single.diffusiveAbsorbed);
+}
+
+TEST_F(DetectorBatchTests, SeveralDetectorsInOneSimulation) {
+    using T = double;
+    constexpr size_t Nz = 20;
+    constexpr size_t Nr = 50;
+    constexpr int Np = 10000;
+
+    const IntegratingSphere<T> sphereR(0.0508, 0.0125, 0.0125);
+    const IntegratingSphere<T> sphereT(0.0508, 0.0125, 0.0);
+    const DetectorDistance<T> dist{0, 0, 0.002};
+    const LightSource<T> source(0.0005, SourceType::Circle);
+    const Sample<T> sample({Medium<T>::fromCoeffs(1.5, 0, 0, 1E-3, 0), Medium<T>::fromCoeffs(1.4, 100, 3000, 1E-3, 0.8), Medium<T>::fromCoeffs(1.5, 0, 0, 1E-3, 0)}, 1, 1);
+
+    auto absorberR = make_shared<FullAbsorber<T>>(0.99);
+    auto counterR = make_shared<CountingDetector>();
+    auto absorberT = make_shared<FullAbsorber<T>>(0.99);
+
+    Math_NS::seedRandom(3);
+    MonteCarlo<T,Nz,Nr,1> mc(sample, Np, 3E-3, 1E-2, sphereR, sphereT, dist, source);
+    mc.addDetectorR(absorberR);
+    mc.addDetectorR(counterR);
+    mc.addDetectorT(absorberT);
+    EXPECT_THROW(mc.addDetectorT(nullptr), invalid_argument);
+    const auto results = mc.CalculateResult();
+
+    /// every exit photon reaches full absorbers, specular reflection is collimated
+    EXPECT_NEAR(absorberR->collimatedAbsorbed + absorberR->diffusiveAbsorbed, results.specularReflection + results.diffuseReflection, 1E-12);
+    EXPECT_NEAR(absorberT->collimatedAbsorbed + absorberT->diffusiveAbsorbed, results.diffuseTransmission, 1E-12);
+    EXPECT_GE(absorberR->collimatedAbsorbed, results.specularReflection - 1E-12);
+    EXPECT_GT(absorberT->collimatedAbsorbed, 0);
+    EXPECT_GT(absorberT->diffusiveAbsorbed, 0);
+
+    EXPECT_NEAR(counterR->weight / Np, results.specularReflection + results.diffuseReflection, 1E-12);
+    EXPECT_GT(counterR->batches, 1);
+    EXPECT_EQ(counterR->calibratedBy, Np);
+}
+
+TEST_F(DetectorBatchTests, EngineSpheresAreDetectors) {
+    using T = double;
+    constexpr size_t Nz = 20;
+    constexpr size_t Nr = 50;
+    constexpr int Np = 10000;
+
+    const IntegratingSphere<T> sphereR(0.0508, 0.0125, 0.0125);
+    const IntegratingSphere<T> sphereT(0.0508, 0.0125, 0.0);
+    const DetectorDistance<T> dist{0, 0.02, 0.01};
+    const LightSource<T> source(0.0005, SourceType::Circle);
+    const Sample<T> sample({Medium<T>::fromCoeffs(1.4, 100, 3000, 1E-3, 0.8)}, 1, 1);
+
+    /// the same spheres added as detectors see the same exit photons as the ones of the engine
+    auto addedR = make_shared<IntegratingSphereComplex<T>>(0.0508, 0.0125, 0.0125, vector<T>{0, 0.01, 0.02}, 0, true);
+    auto addedT = make_shared<IntegratingSphereComplex<T>>(0.0508, 0.0125, 0.0, vector<T>{0, 0.01, 0.02}, 1E-3, false);
+
+    Math_NS::seedRandom(4);
+    MonteCarlo<T,Nz,Nr,1> mc(sample, Np, 1E-3, 1E-2, sphereR, sphereT, dist, source);
+    mc.addDetectorR(addedR);
+    mc.addDetectorT(addedT);
+    const auto results = mc.CalculateResult();
+
+    ASSERT_EQ(results.detectedR.size(), 3);
+    for (int i = 0; i < 3; i++) {
+        EXPECT_NEAR(addedR->detected[i], results.detectedR[i].second, 1E-12);
+        EXPECT_NEAR(addedT->detected[i], results.detectedT[i].second, 1E-12);
+        EXPECT_NEAR(addedR->variance[i], results.detectedRvariance[i].second, 1E-15);
+        EXPECT_NEAR(addedT->variance[i], results.detectedTvariance[i].second, 1E-15);
+    }
+    EXPECT_GT(results.detectedR[0].second, results.detectedR[2].second);
+    EXPECT_GT(results.detectedT[0].second, results.detectedT[2].second);
+}
+
+TEST_F(DetectorBatchTests, DetectorsOfWorkerThreads) {
+    using namespace MonteCarloMultithreadDetail;
+    using T = double;
+    constexpr size_t Nz = 20;
+    constexpr size_t Nr = 50;
+    constexpr int Np = 10000;
+    constexpr int threads = 2;
+
+    const IntegratingSphere<T> sphereR(0.0508, 0.0125, 0.0125);
+    const IntegratingSphere<T> sphereT(0.0508, 0.0125, 0.0);
+    const DetectorDistance<T> dist{0, 0, 0.002};
+    const LightSource<T> source(0.0005, SourceType::Circle);
+    const Sample<T> sample({Medium<T>::fromCoeffs(1.4, 100, 3000, 1E-3, 0.8)}, 1, 1);
+
+    vector<WorkerDetectors<T>> detectors(threads);
+    vector<shared_ptr<FullAbsorber<T>>> absorbersR, absorbersT;
+    for (auto& group: detectors) {
+        absorbersR.push_back(make_shared<FullAbsorber<T>>(0.99));
+        absorbersT.push_back(make_shared<FullAbsorber<T>>(0.99));
+        group.reflection.push_back(absorbersR.back());
+        group.transmission.push_back(absorbersT.back());
+    }
+
+    MCresults<T,Nz,Nr,1> results;
+    MCmultithread<T,Nz,Nr,1>(sample, Np, threads, 3E-3, 1E-2, results, sphereR, sphereT, dist, source, detectors);
+
+    /// every worker calibrates its own absorbers, the run is their mean
+    T meanR = 0, meanT = 0;
+    for (int thread = 0; thread < threads; thread++) {
+        EXPECT_GT(absorbersR[thread]->diffusiveAbsorbed, 0);
+        meanR += (absorbersR[thread]->collimatedAbsorbed + absorbersR[thread]->diffusiveAbsorbed) / threads;
+        meanT += (absorbersT[thread]->collimatedAbsorbed + absorbersT[thread]->diffusiveAbsorbed) / threads;
+    }
+    EXPECT_NEAR(meanR, results.specularReflection + results.diffuseReflection, 1E-12);
+    EXPECT_NEAR(meanT, results.diffuseTransmission, 1E-12);
+
+    detectors.pop_back();
+    EXPECT_THROW((MCmultithread<T,Nz,Nr,1>(sample, Np, threads, 3E-3, 1E-2, results, sphereR, sphereT, dist, source, detectors)), invalid_argument);
+}
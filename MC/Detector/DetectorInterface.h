@@ -5,6 +5,7 @@
 #include "../Photon.h"
 #include "../../Utils/Contracts.h"
 
+#include <cstddef>
 #include <memory>
 
 namespace MonteCarlo_NS {
@@ -22,6 +23,12 @@ namespace MonteCarlo_NS {
         /// \param[in] photon Photon that should be detected
         virtual void detect(const Photon<T>& photon) EXCEPT_INPUT_PARAMS;
 
+        /// Accumulate batch of photons, calls detect for every photon by default,
+        /// detectors override it to handle the whole batch in one virtual call
+        /// \param[in] photons Photons that should be detected
+        /// \param[in] count number of photons
+        virtual void detectBatch(const Photon<T>* photons, const size_t& count) EXCEPT_INPUT_PARAMS;
+
         /// Calibrate results
         /// \param[in] totalWeights total weights for all simulated photons
         virtual void calibrate(const T& totalWeights) EXCEPT_INPUT_PARAMS;
@@ -48,6 +55,12 @@ void MonteCarlo_NS::DetectorInterface<T>::detect(const Photon<T>& photon) EXCEPT
     FAIL_RUNTIME_CONTRACT("Detector detect was not implemented");
 }
 
+template < typename T >
+void MonteCarlo_NS::DetectorInterface<T>::detectBatch(const Photon<T>* photons, const size_t& count) EXCEPT_INPUT_PARAMS {
+    for (size_t i = 0; i < count; i++)
+        detect(photons[i]);
+}
+
 template < typename T >
 void MonteCarlo_NS::DetectorInterface<T>::calibrate(const T& totalWeights) EXCEPT_INPUT_PARAMS {
     using namespace std;
@@ -32,3 +32,8 @@ TEST_F(DetectorInterfaceTests, ThrowsExceptionForDetect) {
 TEST_F(DetectorInterfaceTests, ThrowsExceptionForCalibrate) {
     EXPECT_THROW(detector->calibrate(1), runtime_error);
 }
+
+TEST_F(DetectorInterfaceTests, ThrowsExceptionForDetectBatch) {
+    const Photon<float> photon;
+    EXPECT_THROW(detector->detectBatch(&photon, 1), runtime_error);
+}
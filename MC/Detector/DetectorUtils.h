@@ -63,10 +63,11 @@ template < typename T >
 MonteCarlo_NS::DetectorType MonteCarlo_NS::detectorType(MonteCarlo_NS::DetectorInterface<T>* const detector) EXCEPT_INPUT_PARAMS {
     if (dynamic_cast<FullAbsorber<T>*>(detector))
         return DetectorType::FullAbsorber;
-    if (dynamic_cast<IntegratingSphereSimple<T>*>(detector))
-        return DetectorType::IntegratingSphereSimple;
+    /// complex sphere derives from simple one, so it is tested first
     if (dynamic_cast<IntegratingSphereComplex<T>*>(detector))
         return DetectorType::IntegratingSphereComplex;
+    if (dynamic_cast<IntegratingSphereSimple<T>*>(detector))
+        return DetectorType::IntegratingSphereSimple;
     if (dynamic_cast<OpticalFiber<T>*>(detector))
         return DetectorType::OpticalFiber;
 
@@ -204,3 +204,10 @@ TEST(DetectorUtilsTests, ExportDetectorProperties_ForFullAbsorber) {
     EXPECT_EQ(properties.type, DetectorType::FullAbsorber);
     EXPECT_FLOAT_EQ(properties.collimatedCosine.value(), collimatedCosine);
 }
+
+TEST(DetectorUtilsTests, ExportDetectorProperties_ForIntegratingSpheres) {
+    auto simple = make_unique<IntegratingSphereSimple<float>>();
+    auto complex = make_unique<IntegratingSphereComplex<float>>();
+    EXPECT_EQ(exportDetectorProperties<float>(simple.get()).type, DetectorType::IntegratingSphereSimple);
+    EXPECT_EQ(exportDetectorProperties<float>(complex.get()).type, DetectorType::IntegratingSphereComplex);
+}
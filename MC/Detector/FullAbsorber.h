@@ -20,6 +20,7 @@ namespace MonteCarlo_NS {
         explicit FullAbsorber(const DetectorProperties<T>& properties) noexcept;
 
         void detect(const Photon<T>& photon) override;
+        void detectBatch(const Photon<T>* photons, const size_t& count) override;
         void calibrate(const T& totalWeights) override;
 
     public:
@@ -28,6 +29,10 @@ namespace MonteCarlo_NS {
     public:
         T collimatedAbsorbed = 0; ///< total absorbed collimated weights
         T diffusiveAbsorbed  = 0; ///< total absorbed diffusive weights
+
+    protected:
+        /// non-virtual accumulation of one photon shared by detect and detectBatch
+        inline void absorb(const Photon<T>& photon) noexcept;
     };
 }
 
@@ -49,6 +54,17 @@ MonteCarlo_NS::FullAbsorber<T>::FullAbsorber(const MonteCarlo_NS::DetectorProper
 
 template < typename T >
 void MonteCarlo_NS::FullAbsorber<T>::detect(const Photon<T>& photon) {
+    absorb(photon);
+}
+
+template < typename T >
+void MonteCarlo_NS::FullAbsorber<T>::detectBatch(const Photon<T>* photons, const size_t& count) {
+    for (size_t i = 0; i < count; i++)
+        absorb(photons[i]);
+}
+
+template < typename T >
+void MonteCarlo_NS::FullAbsorber<T>::absorb(const Photon<T>& photon) noexcept {
     using namespace std;
 
     if (abs(photon.direction.z) < collimatedCosine)
@@ -64,3 +64,13 @@ TEST_F(FullAbsorberTests, Calibrate) {
     EXPECT_FLOAT_EQ(nondefaultDetector->collimatedAbsorbed, 0.1);
     EXPECT_FLOAT_EQ(nondefaultDetector->diffusiveAbsorbed , 0.1);
 }
+
+TEST_F(FullAbsorberTests, DetectBatch) {
+    vector<Photon<float>> photons(3);
+    photons[0].direction.z = 1;
+    photons[1].direction.z = -0.95;
+    photons[2].direction.z = 0.5;
+    nondefaultDetector->detectBatch(photons.data(), photons.size());
+    EXPECT_FLOAT_EQ(nondefaultDetector->collimatedAbsorbed, 2);
+    EXPECT_FLOAT_EQ(nondefaultDetector->diffusiveAbsorbed , 1);
+}
@@ -2,17 +2,49 @@
 
 #include "DetectorInterface.h"
 #include "DetectorProperties.h"
+#include "IntegratingSphereSimple.h"
+
+#include "../Photon.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
 
 namespace MonteCarlo_NS {
-    /// \brief Complex integrating sphere
+    /// \brief Integrating sphere with a tunnel in front of the input port, as Thorlabs spheres.
+    /// The first DARK_TUNNEL of the tunnel absorbs light, photons hitting the rest of it are caught with TUNNEL_CATCH of their weight.
+    /// Photons crossing the sphere into the opposite port are caught by a second tunnel behind it the same way.
+    /// Distances, tallies and calibration are those of IntegratingSphereSimple
     template < typename T >
-    class IntegratingSphereComplex : public DetectorInterface<T> {
+    class IntegratingSphereComplex : public IntegratingSphereSimple<T> {
     public:
-        using Base = DetectorInterface<T>;
+        using Base = IntegratingSphereSimple<T>;
+
+        static constexpr T DARK_TUNNEL  = T(0.003); ///< length of the black part of tunnel
+        static constexpr T LIGHT_TUNNEL = T(0.009); ///< length of the reflecting part of tunnel
+        static constexpr T TUNNEL_CATCH = T(0.3);   ///< part of light hitting the reflecting tunnel which gets into the sphere
 
         explicit IntegratingSphereComplex() noexcept;
         /// \param[in] properties DetectorProperties
         explicit IntegratingSphereComplex(const DetectorProperties<T>& properties) noexcept;
+        /// \param[in] dSphere diameter of the sphere
+        /// \param[in] dPort1 diameter of the input port and its tunnel
+        /// \param[in] dPort2 diameter of the opposite port and its tunnel, 0 if it is closed
+        /// \param[in] distances increasing distances from the sample surface to the tunnel
+        /// \param[in] surface z of the sample surface facing the sphere
+        /// \param[in] reflection sphere is above the sample, otherwise below it
+        /// \throw std::invalid_argument if ENABLE_CHECK_CONTRACTS is defined and dSphere is not positive,
+        /// port diameters are negative or distances are negative or decreasing
+        IntegratingSphereComplex(const T& dSphere, const T& dPort1, const T& dPort2, const std::vector<T>& distances,
+                                 const T& surface, const bool& reflection) EXCEPT_INPUT_PARAMS;
+
+        void detect(const Photon<T>& photon) EXCEPT_INPUT_PARAMS override;
+        void detectBatch(const Photon<T>* photons, const size_t& count) EXCEPT_INPUT_PARAMS override;
+
+        /// Light of exit photon caught at every distance through the tunnels, without tallying it
+        /// \param[in] photon exit photon
+        /// \return caught weights, valid until the next call
+        const std::vector<T>& catchLight(Photon<T> photon) noexcept;
     };
 }
 
@@ -29,3 +61,66 @@ template < typename T >
 MonteCarlo_NS::IntegratingSphereComplex<T>::IntegratingSphereComplex(const MonteCarlo_NS::DetectorProperties<T>& properties) noexcept
     : Base(DetectorType::IntegratingSphereComplex) {
 }
+
+template < typename T >
+MonteCarlo_NS::IntegratingSphereComplex<T>::IntegratingSphereComplex(const T& dSphere, const T& dPort1, const T& dPort2, const std::vector<T>& distances,
+                                                                     const T& surface, const bool& reflection) EXCEPT_INPUT_PARAMS
+    : Base(DetectorType::IntegratingSphereComplex, dSphere, dPort1, dPort2, distances, surface, reflection) {
+}
+
+template < typename T >
+void MonteCarlo_NS::IntegratingSphereComplex<T>::detect(const Photon<T>& photon) EXCEPT_INPUT_PARAMS {
+    this->tally(catchLight(photon), photon.number);
+}
+
+template < typename T >
+void MonteCarlo_NS::IntegratingSphereComplex<T>::detectBatch(const Photon<T>* photons, const size_t& count) EXCEPT_INPUT_PARAMS {
+    for (size_t i = 0; i < count; i++)
+        this->tally(catchLight(photons[i]), photons[i].number);
+}
+
+template < typename T >
+const std::vector<T>& MonteCarlo_NS::IntegratingSphereComplex<T>::catchLight(Photon<T> photon) noexcept {
+    using namespace std;
+
+    auto& caught = this->caught;
+    fill(caught.begin(), caught.end(), 0);
+    for (size_t i = 0; i < this->distances.size(); i++) {
+        photon.coordinate += this->stepToPort(photon, this->distances[i]) * photon.direction;
+        if (!this->inPort(photon, this->dPort1))
+            break;
+        /// every leg is walked back, so the next distance starts from the tunnel entrance
+        const T stepDarkTunnel = abs(DARK_TUNNEL / photon.direction.z);
+        photon.coordinate += stepDarkTunnel * photon.direction;
+        if (!this->inPort(photon, this->dPort1)) {
+            photon.coordinate -= stepDarkTunnel * photon.direction;
+            continue;
+        }
+        const T stepLightTunnel = abs(LIGHT_TUNNEL / photon.direction.z);
+        photon.coordinate += stepLightTunnel * photon.direction;
+        if (!this->inPort(photon, this->dPort1)) {
+            caught[i] += TUNNEL_CATCH * photon.weight;
+            photon.coordinate -= stepDarkTunnel * photon.direction;
+            photon.coordinate -= stepLightTunnel * photon.direction;
+            continue;
+        }
+        const T stepSphere = abs(this->dSphere / photon.direction.z);
+        photon.coordinate += stepSphere * photon.direction;
+        if (!this->inPort(photon, this->dPort2)) {
+            caught[i] += photon.weight;
+            photon.coordinate -= stepDarkTunnel * photon.direction;
+            photon.coordinate -= stepLightTunnel * photon.direction;
+            photon.coordinate -= stepSphere * photon.direction;
+            continue;
+        }
+        const T stepLightTunnel2 = abs(LIGHT_TUNNEL / photon.direction.z);
+        photon.coordinate += stepLightTunnel2 * photon.direction;
+        if (!this->inPort(photon, this->dPort2))
+            caught[i] += TUNNEL_CATCH * photon.weight;
+        photon.coordinate -= stepDarkTunnel * photon.direction;
+        photon.coordinate -= stepLightTunnel * photon.direction;
+        photon.coordinate -= stepSphere * photon.direction;
+        photon.coordinate -= stepLightTunnel2 * photon.direction;
+    }
+    return caught;
+}
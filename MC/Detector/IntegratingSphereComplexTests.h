@@ -8,22 +8,61 @@
 
 #include <gtest/gtest.h>
 
+#include <cmath>
+
 using namespace MonteCarlo_NS;
 using namespace std;
 
 class IntegratingSphereComplexTests : public ::testing::Test {
 protected:
     unique_ptr<IntegratingSphereComplex<float>> detector = make_unique<IntegratingSphereComplex<float>>();
+
+    /// 2 inch sphere above the sample with 12.5 mm ports and tunnels
+    IntegratingSphereComplex<double> sphere{0.0508, 0.0125, 0.0125, {0, 0.02}, 0, true};
+    IntegratingSphereComplex<double> closed{0.0508, 0.0125, 0, {0, 0.02}, 0, true};
+
+    /// photon leaving the top surface at x with tangent of the exit angle in xz plane
+    static Photon<double> exitPhoton(const double& x, const double& tangent, const double& weight = 1, const int& number = 0) {
+        const double norm = sqrt(1 + tangent * tangent);
+        return Photon<double>({x, 0, 0}, {tangent / norm, 0, -1 / norm}, weight, number);
+    }
 };
 
 TEST_F(IntegratingSphereComplexTests, TypeIsIntegratingSphereComplex) {
     EXPECT_EQ(detector->type, DetectorType::IntegratingSphereComplex);
 }
 
-TEST_F(IntegratingSphereComplexTests, ThrowsExceptionForDetect) {
-    EXPECT_THROW(detector->detect(Photon<float>()), runtime_error);
+TEST_F(IntegratingSphereComplexTests, DefaultSphereDetectsNothing) {
+    detector->detect(Photon<float>());
+    detector->calibrate(1);
+    EXPECT_TRUE(detector->detected.empty());
+}
+
+TEST_F(IntegratingSphereComplexTests, CatchPhotonCrossingTunnel) {
+    EXPECT_EQ(closed.catchLight(exitPhoton(0, 0, 0.5)), vector<double>({0.5, 0.5}));
+    /// the straight photon leaves through the opposite port and its tunnel
+    EXPECT_EQ(sphere.catchLight(exitPhoton(0, 0)), vector<double>({0, 0}));
+}
+
+TEST_F(IntegratingSphereComplexTests, DarkTunnelAbsorbs) {
+    /// 45 degrees from 5 mm off the axis, the photon hits the wall within 3 mm
+    EXPECT_EQ(sphere.catchLight(exitPhoton(0.005, 1)), vector<double>({0, 0}));
+}
+
+TEST_F(IntegratingSphereComplexTests, LightTunnelCatchesPart) {
+    /// 45 degrees from the axis, the photon passes the dark part and hits the reflecting one
+    EXPECT_EQ(sphere.catchLight(exitPhoton(0, 1)), vector<double>({IntegratingSphereComplex<double>::TUNNEL_CATCH, 0}));
+    /// the photon crosses the sphere into the opposite port and hits its tunnel
+    const auto caught = sphere.catchLight(exitPhoton(0, 0.093));
+    EXPECT_DOUBLE_EQ(caught[0], IntegratingSphereComplex<double>::TUNNEL_CATCH);
 }
 
-TEST_F(IntegratingSphereComplexTests, ThrowsExceptionForCalibrate) {
-    EXPECT_THROW(detector->calibrate(1), runtime_error);
+TEST_F(IntegratingSphereComplexTests, CalibrateOverHistories) {
+    closed.detect(exitPhoton(0, 0, 0.5, 0));
+    closed.detect(exitPhoton(0, 0, 0.5, 0));
+    const auto photon = exitPhoton(0, 0, 1, 1);
+    closed.detectBatch(&photon, 1);
+    closed.calibrate(4);
+    EXPECT_DOUBLE_EQ(closed.detected[0], 0.5);
+    EXPECT_DOUBLE_EQ(closed.variance[0], (2.0 / 4 - 0.25) / 4);
 }
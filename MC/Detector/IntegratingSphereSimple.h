@@ -3,8 +3,20 @@
 #include "DetectorInterface.h"
 #include "DetectorProperties.h"
 
+#include "../Photon.h"
+#include "../../Math/Basic.h"
+#include "../../Utils/Contracts.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
 namespace MonteCarlo_NS {
-    /// \brief Simple integrating sphere
+    /// \brief Simple integrating sphere moved over distances from the sample surface, its ports are on the beam axis.
+    /// Exit photon which enters the input port at a distance is caught unless it crosses the sphere into the opposite port.
+    /// Photons missing the input port at a distance miss it at larger ones too.
+    /// Light caught at every distance is tallied with its second moment over photon histories,
+    /// exit photons of one history come in a row
     template < typename T >
     class IntegratingSphereSimple : public DetectorInterface<T> {
     public:
@@ -13,6 +25,61 @@ namespace MonteCarlo_NS {
         explicit IntegratingSphereSimple() noexcept;
         /// \param[in] properties DetectorProperties
         explicit IntegratingSphereSimple(const DetectorProperties<T>& properties) noexcept;
+        /// \param[in] dSphere diameter of the sphere
+        /// \param[in] dPort1 diameter of the input port
+        /// \param[in] dPort2 diameter of the opposite port, 0 if it is closed
+        /// \param[in] distances increasing distances from the sample surface to the input port
+        /// \param[in] surface z of the sample surface facing the sphere
+        /// \param[in] reflection sphere is above the sample, otherwise below it
+        /// \throw std::invalid_argument if ENABLE_CHECK_CONTRACTS is defined and dSphere is not positive,
+        /// port diameters are negative or distances are negative or decreasing
+        IntegratingSphereSimple(const T& dSphere, const T& dPort1, const T& dPort2, const std::vector<T>& distances,
+                                const T& surface, const bool& reflection) EXCEPT_INPUT_PARAMS;
+
+        void detect(const Photon<T>& photon) EXCEPT_INPUT_PARAMS override;
+        void detectBatch(const Photon<T>* photons, const size_t& count) EXCEPT_INPUT_PARAMS override;
+        void calibrate(const T& totalWeights) EXCEPT_INPUT_PARAMS override;
+
+        /// Light of exit photon caught at every distance, without tallying it
+        /// \param[in] photon exit photon
+        /// \return caught weights, valid until the next call
+        const std::vector<T>& catchLight(Photon<T> photon) noexcept;
+
+        inline const std::vector<T>& getDistances() const noexcept { return distances; }
+        inline int getNdistances() const noexcept { return static_cast<int>(distances.size()); }
+
+    public:
+        std::vector<T> totalLight; ///< light caught at every distance
+        std::vector<T> detected;   ///< totalLight per unit weight, set by calibrate
+        std::vector<T> variance;   ///< variance of detected over photon histories, set by calibrate
+
+    protected:
+        /// \param[in] type is used to set in derived classes
+        explicit IntegratingSphereSimple(const DetectorType& type) noexcept;
+        IntegratingSphereSimple(const DetectorType& type, const T& dSphere, const T& dPort1, const T& dPort2, const std::vector<T>& distances,
+                                const T& surface, const bool& reflection) EXCEPT_INPUT_PARAMS;
+
+        /// step of photon along its direction to the plane of input port at distance
+        inline T stepToPort(const Photon<T>& photon, const T& distance) const noexcept;
+        /// \return photon is inside the port of diameter
+        static inline bool inPort(const Photon<T>& photon, const T& diameter) noexcept;
+
+        /// add caught light of exit photon of history number, closing the previous history
+        inline void tally(const std::vector<T>& light, const int& number) noexcept;
+        /// add second moment of the open history
+        inline void closeHistory() noexcept;
+
+        T dSphere = 0;
+        T dPort1 = 0;
+        T dPort2 = 0;
+        std::vector<T> distances;
+        T surface = 0;
+        bool reflection = true;
+
+        std::vector<T> caught;
+        std::vector<T> history;
+        std::vector<T> squares;
+        int historyNumber = -1;
     };
 }
 
@@ -29,3 +96,112 @@ template < typename T >
 MonteCarlo_NS::IntegratingSphereSimple<T>::IntegratingSphereSimple(const MonteCarlo_NS::DetectorProperties<T>& properties) noexcept
     : Base(DetectorType::IntegratingSphereSimple) {
 }
+
+template < typename T >
+MonteCarlo_NS::IntegratingSphereSimple<T>::IntegratingSphereSimple(const DetectorType& type) noexcept
+    : Base(type) {
+}
+
+template < typename T >
+MonteCarlo_NS::IntegratingSphereSimple<T>::IntegratingSphereSimple(const T& dSphere, const T& dPort1, const T& dPort2, const std::vector<T>& distances,
+                                                                   const T& surface, const bool& reflection) EXCEPT_INPUT_PARAMS
+    : IntegratingSphereSimple(DetectorType::IntegratingSphereSimple, dSphere, dPort1, dPort2, distances, surface, reflection) {
+}
+
+template < typename T >
+MonteCarlo_NS::IntegratingSphereSimple<T>::IntegratingSphereSimple(const DetectorType& type, const T& dSphere, const T& dPort1, const T& dPort2,
+                                                                   const std::vector<T>& distances, const T& surface, const bool& reflection) EXCEPT_INPUT_PARAMS
+    : Base(type)
+    , totalLight(distances.size(), 0)
+    , dSphere(dSphere)
+    , dPort1(dPort1)
+    , dPort2(dPort2)
+    , distances(distances)
+    , surface(surface)
+    , reflection(reflection)
+    , caught(distances.size(), 0)
+    , history(distances.size(), 0)
+    , squares(distances.size(), 0) {
+    CHECK_ARGUMENT_CONTRACT(dSphere > 0);
+    CHECK_ARGUMENT_CONTRACT(dPort1 >= 0 && dPort2 >= 0);
+    CHECK_ARGUMENT_CONTRACT(std::all_of(distances.begin(), distances.end(), [](const T& distance) { return distance >= 0; }));
+    CHECK_ARGUMENT_CONTRACT(std::is_sorted(distances.begin(), distances.end()));
+}
+
+template < typename T >
+void MonteCarlo_NS::IntegratingSphereSimple<T>::detect(const Photon<T>& photon) EXCEPT_INPUT_PARAMS {
+    tally(catchLight(photon), photon.number);
+}
+
+template < typename T >
+void MonteCarlo_NS::IntegratingSphereSimple<T>::detectBatch(const Photon<T>* photons, const size_t& count) EXCEPT_INPUT_PARAMS {
+    for (size_t i = 0; i < count; i++)
+        tally(catchLight(photons[i]), photons[i].number);
+}
+
+template < typename T >
+const std::vector<T>& MonteCarlo_NS::IntegratingSphereSimple<T>::catchLight(Photon<T> photon) noexcept {
+    using namespace std;
+
+    fill(caught.begin(), caught.end(), 0);
+    for (size_t i = 0; i < distances.size(); i++) {
+        photon.coordinate += stepToPort(photon, distances[i]) * photon.direction;
+        if (!inPort(photon, dPort1))
+            break;
+        const T stepSphere = abs(dSphere / photon.direction.z);
+        photon.coordinate += stepSphere * photon.direction;
+        if (!inPort(photon, dPort2))
+            caught[i] += photon.weight;
+        photon.coordinate -= stepSphere * photon.direction;
+    }
+    return caught;
+}
+
+template < typename T >
+T MonteCarlo_NS::IntegratingSphereSimple<T>::stepToPort(const Photon<T>& photon, const T& distance) const noexcept {
+    const T port = reflection ? surface - distance : surface + distance;
+    return std::abs((port - photon.coordinate.z) / photon.direction.z);
+}
+
+template < typename T >
+bool MonteCarlo_NS::IntegratingSphereSimple<T>::inPort(const Photon<T>& photon, const T& diameter) noexcept {
+    using namespace Math_NS;
+
+    return sqr(photon.coordinate.x) + sqr(photon.coordinate.y) < sqr(diameter / 2);
+}
+
+template < typename T >
+void MonteCarlo_NS::IntegratingSphereSimple<T>::tally(const std::vector<T>& light, const int& number) noexcept {
+    if (number != historyNumber) {
+        closeHistory();
+        historyNumber = number;
+    }
+    for (size_t i = 0; i < light.size(); i++) {
+        totalLight[i] += light[i];
+        history[i] += light[i];
+    }
+}
+
+template < typename T >
+void MonteCarlo_NS::IntegratingSphereSimple<T>::closeHistory() noexcept {
+    for (size_t i = 0; i < history.size(); i++) {
+        squares[i] += Math_NS::sqr(history[i]);
+        history[i] = 0;
+    }
+}
+
+template < typename T >
+void MonteCarlo_NS::IntegratingSphereSimple<T>::calibrate(const T& totalWeights) EXCEPT_INPUT_PARAMS {
+    using namespace Math_NS;
+
+    CHECK_ARGUMENT_CONTRACT(totalWeights != 0);
+
+    closeHistory();
+    historyNumber = -1;
+    detected.resize(distances.size());
+    variance.resize(distances.size());
+    for (size_t i = 0; i < distances.size(); i++) {
+        detected[i] = totalLight[i] / totalWeights;
+        variance[i] = (squares[i] / totalWeights - sqr(detected[i])) / totalWeights;
+    }
+}
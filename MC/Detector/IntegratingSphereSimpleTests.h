@@ -8,22 +8,87 @@
 
 #include <gtest/gtest.h>
 
+#include <cmath>
+
 using namespace MonteCarlo_NS;
 using namespace std;
 
 class IntegratingSphereSimpleTests : public ::testing::Test {
 protected:
     unique_ptr<IntegratingSphereSimple<float>> detector = make_unique<IntegratingSphereSimple<float>>();
+
+    /// 2 inch sphere above the sample with 12.5 mm input port and closed opposite port
+    IntegratingSphereSimple<double> closed{0.0508, 0.0125, 0, {0, 0.005, 0.02}, 0, true};
+    /// the same sphere with open opposite port
+    IntegratingSphereSimple<double> open{0.0508, 0.0125, 0.0125, {0, 0.005, 0.02}, 0, true};
+
+    /// photon leaving the top surface at x with tangent of the exit angle in xz plane
+    static Photon<double> exitPhoton(const double& x, const double& tangent, const double& weight = 1, const int& number = 0) {
+        const double norm = sqrt(1 + tangent * tangent);
+        return Photon<double>({x, 0, 0}, {tangent / norm, 0, -1 / norm}, weight, number);
+    }
 };
 
 TEST_F(IntegratingSphereSimpleTests, TypeIsIntegratingSphereSimple) {
     EXPECT_EQ(detector->type, DetectorType::IntegratingSphereSimple);
 }
 
-TEST_F(IntegratingSphereSimpleTests, ThrowsExceptionForDetect) {
-    EXPECT_THROW(detector->detect(Photon<float>()), runtime_error);
+TEST_F(IntegratingSphereSimpleTests, DefaultSphereDetectsNothing) {
+    detector->detect(Photon<float>());
+    detector->calibrate(1);
+    EXPECT_TRUE(detector->detected.empty());
+}
+
+TEST_F(IntegratingSphereSimpleTests, CatchPhotonThroughInputPort) {
+    EXPECT_EQ(closed.catchLight(exitPhoton(0, 0, 0.5)), vector<double>({0.5, 0.5, 0.5}));
+    /// the straight photon leaves through the open opposite port
+    EXPECT_EQ(open.catchLight(exitPhoton(0, 0)), vector<double>({0, 0, 0}));
+}
+
+TEST_F(IntegratingSphereSimpleTests, MissInputPortFartherAway) {
+    /// 30 degrees off the normal, the photon passes beside the port beyond 10.8 mm
+    EXPECT_EQ(open.catchLight(exitPhoton(0, tan(M_PI / 6))), vector<double>({1, 1, 0}));
+    EXPECT_EQ(open.catchLight(exitPhoton(0.007, 0)), vector<double>({0, 0, 0}));
+}
+
+TEST_F(IntegratingSphereSimpleTests, SphereBelowSample) {
+    IntegratingSphereSimple<double> below(0.0508, 0.0125, 0, {0, 0.01}, 1E-3, false);
+    EXPECT_EQ(below.catchLight(Photon<double>({0, 0, 1E-3}, {0, 0, 1}, 1, 0)), vector<double>({1, 1}));
+    EXPECT_EQ(below.catchLight(Photon<double>({0, 0, 1E-3}, {0.8, 0, 0.6}, 1, 0)), vector<double>({1, 0}));
+}
+
+TEST_F(IntegratingSphereSimpleTests, CalibrateOverHistories) {
+    closed.detect(exitPhoton(0, 0, 0.5, 0));
+    closed.detect(exitPhoton(0, 0, 0.5, 0));
+    closed.detect(exitPhoton(0, 0, 1, 1));
+    closed.calibrate(4);
+    for (int i = 0; i < closed.getNdistances(); i++) {
+        EXPECT_DOUBLE_EQ(closed.totalLight[i], 2);
+        EXPECT_DOUBLE_EQ(closed.detected[i], 0.5);
+        /// two histories of 1 and two without light
+        EXPECT_DOUBLE_EQ(closed.variance[i], (2.0 / 4 - 0.25) / 4);
+    }
+}
+
+TEST_F(IntegratingSphereSimpleTests, BatchIsSameAsSingleDetections) {
+    const vector<Photon<double>> photons = {exitPhoton(0, 0, 0.5, 0), exitPhoton(0.001, 0.3, 0.2, 0), exitPhoton(0.002, 0.1, 0.7, 1)};
+    for (const auto& photon: photons)
+        closed.detect(photon);
+    IntegratingSphereSimple<double> batched(0.0508, 0.0125, 0, {0, 0.005, 0.02}, 0, true);
+    batched.detectBatch(photons.data(), photons.size());
+    closed.calibrate(3);
+    batched.calibrate(3);
+    EXPECT_EQ(batched.detected, closed.detected);
+    EXPECT_EQ(batched.variance, closed.variance);
+}
+
+TEST_F(IntegratingSphereSimpleTests, ThrowsForWrongGeometry) {
+    EXPECT_THROW(IntegratingSphereSimple<double>(0, 0.0125, 0, {0}, 0, true), invalid_argument);
+    EXPECT_THROW(IntegratingSphereSimple<double>(0.0508, -1, 0, {0}, 0, true), invalid_argument);
+    EXPECT_THROW(IntegratingSphereSimple<double>(0.0508, 0.0125, 0, {-0.01}, 0, true), invalid_argument);
+    EXPECT_THROW(IntegratingSphereSimple<double>(0.0508, 0.0125, 0, {0.02, 0.01}, 0, true), invalid_argument);
 }
 
-TEST_F(IntegratingSphereSimpleTests, ThrowsExceptionForCalibrate) {
-    EXPECT_THROW(detector->calibrate(1), runtime_error);
+TEST_F(IntegratingSphereSimpleTests, ThrowsForZeroWeights) {
+    EXPECT_THROW(closed.calibrate(0), invalid_argument);
 }
@@ -3,16 +3,59 @@
 #include "DetectorInterface.h"
 #include "DetectorProperties.h"
 
+#include "../../Math/Basic.h"
+#include "../../Utils/Contracts.h"
+
+#include <algorithm>
+#include <cmath>
+
 namespace MonteCarlo_NS {
-    /// \brief Optical fiber detector
+    /// \brief Optical fiber in contact with the sample surface, its axis is normal to the surface.
+    /// Exit photons are detected when they leave the sample within the core and the acceptance cone.
+    /// MonteCarlo adds expected signal of scattering events near the surface with expect, see MonteCarlo::addFiberR
     template < typename T >
-    class OpticalFiber : public DetectorInterface<T> {
+    class OpticalFiber final : public DetectorInterface<T> {
     public:
         using Base = DetectorInterface<T>;
 
         explicit OpticalFiber() noexcept;
         /// \param[in] properties DetectorProperties
         explicit OpticalFiber(const DetectorProperties<T>& properties) noexcept;
+        /// \param[in] offset distance from the beam axis to the fiber axis along x
+        /// \param[in] diameter diameter of the core
+        /// \param[in] NA numerical aperture
+        /// \param[in] nOutside refraction coefficient of the medium around the sample, where exit angles are measured
+        /// \throw std::invalid_argument if ENABLE_CHECK_CONTRACTS is defined and offset is negative, diameter is not positive,
+        /// NA is not positive or nOutside is less than 1
+        OpticalFiber(const T& offset, const T& diameter, const T& NA, const T& nOutside = 1) EXCEPT_INPUT_PARAMS;
+
+        void detect(const Photon<T>& photon) EXCEPT_INPUT_PARAMS override;
+        void detectBatch(const Photon<T>* photons, const size_t& count) EXCEPT_INPUT_PARAMS override;
+        void calibrate(const T& totalWeights) EXCEPT_INPUT_PARAMS override;
+
+        /// Add expected signal of one scattering event
+        inline void expect(const T& weight) noexcept { signal += weight; }
+
+        /// \return exit point on the sample surface is inside the core
+        inline bool inside(const T& x, const T& y) const noexcept {
+            return Math_NS::sqr(x - offset) + Math_NS::sqr(y) < Math_NS::sqr(diameter / 2);
+        }
+
+        inline T getOffset()        const noexcept { return offset;        }
+        inline T getDiameter()      const noexcept { return diameter;      }
+        /// \return sine of the half-angle of the acceptance cone outside the sample
+        inline T getSinAcceptance() const noexcept { return sinAcceptance; }
+
+    public:
+        T signal = 0; ///< detected and expected weights
+
+    protected:
+        T offset = 0;
+        T diameter = 0;
+        T sinAcceptance = 0;
+
+        /// non-virtual accumulation of one photon shared by detect and detectBatch
+        inline void accept(const Photon<T>& photon) noexcept;
     };
 }
 
@@ -29,3 +72,42 @@ template < typename T >
 MonteCarlo_NS::OpticalFiber<T>::OpticalFiber(const MonteCarlo_NS::DetectorProperties<T>& properties) noexcept
     : Base(DetectorType::OpticalFiber) {
 }
+
+template < typename T >
+MonteCarlo_NS::OpticalFiber<T>::OpticalFiber(const T& offset, const T& diameter, const T& NA, const T& nOutside) EXCEPT_INPUT_PARAMS
+    : Base(DetectorType::OpticalFiber)
+    , offset(offset)
+    , diameter(diameter)
+    , sinAcceptance(std::min(NA / nOutside, T(1))) {
+    CHECK_ARGUMENT_CONTRACT(offset >= 0);
+    CHECK_ARGUMENT_CONTRACT(diameter > 0);
+    CHECK_ARGUMENT_CONTRACT(NA > 0);
+    CHECK_ARGUMENT_CONTRACT(nOutside >= 1);
+}
+
+template < typename T >
+void MonteCarlo_NS::OpticalFiber<T>::detect(const Photon<T>& photon) EXCEPT_INPUT_PARAMS {
+    accept(photon);
+}
+
+template < typename T >
+void MonteCarlo_NS::OpticalFiber<T>::detectBatch(const Photon<T>* photons, const size_t& count) EXCEPT_INPUT_PARAMS {
+    for (size_t i = 0; i < count; i++)
+        accept(photons[i]);
+}
+
+template < typename T >
+void MonteCarlo_NS::OpticalFiber<T>::accept(const Photon<T>& photon) noexcept {
+    using namespace Math_NS;
+
+    /// z of exit direction is cosine of the exit angle outside the sample
+    if (inside(photon.coordinate.x, photon.coordinate.y) && 1 - sqr(photon.direction.z) <= sqr(sinAcceptance))
+        signal += photon.weight;
+}
+
+template < typename T >
+void MonteCarlo_NS::OpticalFiber<T>::calibrate(const T& totalWeights) EXCEPT_INPUT_PARAMS {
+    CHECK_ARGUMENT_CONTRACT(totalWeights != 0);
+
+    signal /= totalWeights;
+}
@@ -14,16 +14,74 @@ using namespace std;
 class OpticalFiberTests : public ::testing::Test {
 protected:
     unique_ptr<OpticalFiber<float>> detector = make_unique<OpticalFiber<float>>();
+
+    /// core of 0.4 mm at 1 mm from the beam, acceptance of 0.22 in air
+    unique_ptr<OpticalFiber<float>> nondefaultDetector = make_unique<OpticalFiber<float>>(1E-3, 0.4E-3, 0.22);
+
+    static Photon<float> exitPhoton(const float& x, const float& y, const float& cosExit) {
+        Photon<float> photon;
+        photon.coordinate = Vector3D<float>(x, y, 0);
+        photon.direction.z = cosExit;
+        photon.weight = 0.5;
+        return photon;
+    }
 };
 
 TEST_F(OpticalFiberTests, TypeIsOpticalFiber) {
     EXPECT_EQ(detector->type, DetectorType::OpticalFiber);
 }
 
-TEST_F(OpticalFiberTests, ThrowsExceptionForDetect) {
-    EXPECT_THROW(detector->detect(Photon<float>()), runtime_error);
+TEST_F(OpticalFiberTests, DefaultFiberDetectsNothing) {
+    detector->detect(exitPhoton(0, 0, 1));
+    EXPECT_FLOAT_EQ(detector->signal, 0);
+}
+
+TEST_F(OpticalFiberTests, ConstructorFromGeometry) {
+    EXPECT_FLOAT_EQ(nondefaultDetector->getOffset(), 1E-3);
+    EXPECT_FLOAT_EQ(nondefaultDetector->getDiameter(), 0.4E-3);
+    EXPECT_FLOAT_EQ(nondefaultDetector->getSinAcceptance(), 0.22);
+    EXPECT_FLOAT_EQ(OpticalFiber<float>(0, 1E-3, 0.22, 1.33).getSinAcceptance(), 0.22 / 1.33);
+    EXPECT_FLOAT_EQ(OpticalFiber<float>(0, 1E-3, 1.5).getSinAcceptance(), 1);
+}
+
+TEST_F(OpticalFiberTests, DetectInsideCoreAndCone) {
+    nondefaultDetector->detect(exitPhoton(1.1E-3, 0.1E-3, -0.99));
+    EXPECT_FLOAT_EQ(nondefaultDetector->signal, 0.5);
+}
+
+TEST_F(OpticalFiberTests, MissOutsideCore) {
+    nondefaultDetector->detect(exitPhoton(1E-3, 0.3E-3, 1));
+    nondefaultDetector->detect(exitPhoton(-1E-3, 0, 1));
+    EXPECT_FLOAT_EQ(nondefaultDetector->signal, 0);
+}
+
+TEST_F(OpticalFiberTests, MissOutsideAcceptance) {
+    nondefaultDetector->detect(exitPhoton(1E-3, 0, 0.95));
+    EXPECT_FLOAT_EQ(nondefaultDetector->signal, 0);
+}
+
+TEST_F(OpticalFiberTests, DetectBatch) {
+    const vector<Photon<float>> photons = {exitPhoton(1E-3, 0, 1), exitPhoton(1E-3, 0, 0.5), exitPhoton(0.9E-3, 0, -1)};
+    nondefaultDetector->detectBatch(photons.data(), photons.size());
+    EXPECT_FLOAT_EQ(nondefaultDetector->signal, 1);
+}
+
+TEST_F(OpticalFiberTests, ExpectedSignalAddsUp) {
+    nondefaultDetector->detect(exitPhoton(1E-3, 0, 1));
+    nondefaultDetector->expect(0.25);
+    EXPECT_FLOAT_EQ(nondefaultDetector->signal, 0.75);
+}
+
+TEST_F(OpticalFiberTests, Calibrate) {
+    nondefaultDetector->signal = 100;
+    nondefaultDetector->calibrate(1000);
+    EXPECT_FLOAT_EQ(nondefaultDetector->signal, 0.1);
 }
 
-TEST_F(OpticalFiberTests, ThrowsExceptionForCalibrate) {
-    EXPECT_THROW(detector->calibrate(1), runtime_error);
+TEST_F(OpticalFiberTests, Throws) {
+    EXPECT_THROW(OpticalFiber<float>(-1E-3, 1E-3, 0.22), invalid_argument);
+    EXPECT_THROW(OpticalFiber<float>(0, 0, 0.22), invalid_argument);
+    EXPECT_THROW(OpticalFiber<float>(0, 1E-3, 0), invalid_argument);
+    EXPECT_THROW(OpticalFiber<float>(0, 1E-3, 0.22, 0.5), invalid_argument);
+    EXPECT_THROW(nondefaultDetector->calibrate(0), invalid_argument);
 }
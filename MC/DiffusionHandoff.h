@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cmath>
+
+/// \brief Settings of hybrid diffusion and Monte Carlo transport in homogeneous layers.
+/// Photons which scattered enough times and are deep in a layer, far from its borders, are handed off to diffusion:
+/// they jump to a random point of the largest sphere around them which keeps margin from the borders, lose the weight
+/// absorbed inside it by the diffusion solution of the sphere and go on as photons from its surface.
+/// Near sources and borders transport stays Monte Carlo, so reflection, transmission and detectors see photons as usual
+template < typename T >
+struct DiffusionHandoff {
+    T depth = 10;         ///< transport mean free paths from photon to the nearest border of its layer needed for handoff, 0 disables it
+    T margin = 5;         ///< transport mean free paths kept between the sphere of a jump and the borders
+    int scatterings = 10; ///< scattering events of photon before handoff, its direction is random by then
+
+    /// Milne extrapolation length in transport mean free paths
+    static constexpr T EXTRAPOLATION = T(0.7104);
+
+    inline bool enabled() const noexcept { return depth > 0; }
+
+    /// Probability that diffusing light from the centre of an absorbing sphere reaches its surface
+    /// \param[in] k radius of sphere times effective attenuation coefficient
+    /// \return k / sinh(k)
+    static inline T reach(const T& k) noexcept;
+
+    /// Radius where light of a point source in the centre of an absorbing sphere is absorbed,
+    /// its density is proportional to r^2 times diffusion fluence sinh(k (1 - r)) / r of the sphere with zero fluence on its surface
+    /// \param[in] k radius of sphere times effective attenuation coefficient
+    /// \param[in] u uniform number in (0, 1)
+    /// \return radius over radius of sphere
+    static T absorptionRadius(const T& k, const T& u) noexcept;
+
+protected:
+    /// part of light absorbed within radius t of the sphere
+    static inline T absorbedWithin(const T& k, const T& t) noexcept;
+};
+
+/******************
+ * IMPLEMENTATION *
+ ******************/
+
+template < typename T >
+T DiffusionHandoff<T>::reach(const T& k) noexcept {
+    if (k == 0)
+        return 1;
+    /// sinh(k) overflows for thick absorbing spheres
+    return 2 * k * std::exp(-k) / -std::expm1(-2 * k);
+}
+
+template < typename T >
+T DiffusionHandoff<T>::absorbedWithin(const T& k, const T& t) noexcept {
+    using namespace std;
+
+    /// 1 - (k t cosh(k (1 - t)) + sinh(k (1 - t))) / sinh(k) in exponents which do not overflow
+    const T denominator = -expm1(-2 * k);
+    const T coshRatio = exp(-k * t) * (1 + exp(-2 * k * (1 - t))) / denominator;
+    const T sinhRatio = exp(-k * t) * -expm1(-2 * k * (1 - t)) / denominator;
+    return 1 - k * t * coshRatio - sinhRatio;
+}
+
+template < typename T >
+T DiffusionHandoff<T>::absorptionRadius(const T& k, const T& u) noexcept {
+    const T target = u * absorbedWithin(k, 1);
+    T low = 0;
+    T high = 1;
+    for (int i = 0; i < 40; i++) {
+        const T middle = (low + high) / 2;
+        if (absorbedWithin(k, middle) < target)
+            low = middle;
+        else
+            high = middle;
+    }
+    return (low + high) / 2;
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#ifndef ENABLE_CHECK_CONTRACTS
+    #define ENABLE_CHECK_CONTRACTS
+#endif // ENABLE_CHECK_CONTRACTS
+
+#include "MonteCarlo.h"
+
+#include "../Math/Random.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+
+using namespace Eigen;
+using namespace std;
+
+class DiffusionHandoffTests : public ::testing::Test {
+protected:
+    using T = double;
+
+    static constexpr size_t Nz = 20;
+    static constexpr size_t Nr = 20;
+    static constexpr bool detector = 1;
+
+    static constexpr int Np = 4000;
+    /// 50 transport mean free paths thick with albedo 0.9999
+    static constexpr T d = 5E-3;
+    static constexpr T radius = 2E-2;
+
+    IntegratingSphere<T> sphereR{0.0508, 0.0125, 0.0125};
+    IntegratingSphere<T> sphereT{0.0508, 0.0125, 0.0};
+    DetectorDistance<T>  dist{0, 0.1, 0.05};
+    const LightSource<T> source{1E-3, SourceType::Circle};
+
+    const Sample<T> sample{{Medium<T>::fromCoeffs(1.4, 10, 100000, d, 0.9)}, 1, 1};
+
+    MCresults<T,Nz,Nr,detector> run(const DiffusionHandoff<T>& handoff, const std::uint64_t& seed) const {
+        Math_NS::seedRandom(seed);
+        MonteCarlo<T,Nz,Nr,detector> mc(sample, Np, d, radius, sphereR, sphereT, dist, source);
+        mc.setDiffusionHandoff(handoff);
+        return mc.CalculateResult();
+    }
+};
+
+TEST_F(DiffusionHandoffTests, SphereSolution) {
+    EXPECT_EQ(DiffusionHandoff<T>::reach(0), 1);
+    for (const T& k: {1E-3, 0.5, 2.0, 10.0})
+        EXPECT_NEAR(DiffusionHandoff<T>::reach(k), k / sinh(k), 1E-12);
+    EXPECT_GE(DiffusionHandoff<T>::reach(1E3), 0);
+    EXPECT_LT(DiffusionHandoff<T>::reach(1E3), 1E-300);
+
+    /// mean radius of absorption against density t sinh(k (1 - t)) on the unit interval
+    for (const T& k: {0.1, 3.0, 30.0}) {
+        const int points = 100000;
+        T mean = 0, norm = 0;
+        for (int i = 0; i < points; i++) {
+            const T t = (i + T(0.5)) / points;
+            mean += sqr(t) * sinh(k * (1 - t));
+            norm += t * sinh(k * (1 - t));
+        }
+        T sampled = 0;
+        const int samples = 1000;
+        for (int i = 0; i < samples; i++) {
+            const T t = DiffusionHandoff<T>::absorptionRadius(k, (i + T(0.5)) / samples);
+            EXPECT_GE(t, 0);
+            EXPECT_LE(t, 1);
+            sampled += t / samples;
+        }
+        EXPECT_NEAR(sampled, mean / norm, 1E-3);
+    }
+}
+
+TEST_F(DiffusionHandoffTests, DisabledHandoffKeepsRun) {
+    Math_NS::seedRandom(1);
+    MonteCarlo<T,Nz,Nr,detector> plain(sample, Np / 20, d, radius, sphereR, sphereT, dist, source);
+    const auto reference = plain.CalculateResult();
+
+    DiffusionHandoff<T> disabled;
+    disabled.depth = 0;
+    Math_NS::seedRandom(1);
+    MonteCarlo<T,Nz,Nr,detector> handedOff(sample, Np / 20, d, radius, sphereR, sphereT, dist, source);
+    handedOff.setDiffusionHandoff(disabled);
+    const auto result = handedOff.CalculateResult();
+
+    EXPECT_EQ(result.diffuseReflection, reference.diffuseReflection);
+    EXPECT_EQ(result.diffuseTransmission, reference.diffuseTransmission);
+    EXPECT_EQ(result.matrixA, reference.matrixA);
+    EXPECT_EQ(result.detectedR, reference.detectedR);
+}
+
+TEST_F(DiffusionHandoffTests, AgreesWithPureMonteCarlo) {
+    DiffusionHandoff<T> none;
+    none.depth = 0;
+    const auto pure = run(none, 2);
+    const auto hybrid = run(DiffusionHandoff<T>(), 3);
+
+    EXPECT_NE(hybrid.matrixA, pure.matrixA);
+    EXPECT_NEAR(hybrid.diffuseReflection  , pure.diffuseReflection  , 0.03 * pure.diffuseReflection  );
+    EXPECT_NEAR(hybrid.diffuseTransmission, pure.diffuseTransmission, 0.25 * pure.diffuseTransmission);
+    EXPECT_NEAR(hybrid.absorbed           , pure.absorbed           , 0.15 * pure.absorbed           );
+    EXPECT_NEAR(hybrid.specularReflection + hybrid.diffuseReflection + hybrid.diffuseTransmission + hybrid.absorbed, 1, 1E-2);
+    /// absorption by depth
+    const Matrix<T,Dynamic,1> pureDepth = pure.matrixA.rowwise().sum() / Np;
+    const Matrix<T,Dynamic,1> hybridDepth = hybrid.matrixA.rowwise().sum() / Np;
+    EXPECT_NEAR(hybridDepth.head(Nz / 2).sum(), pureDepth.head(Nz / 2).sum(), 0.15 * pureDepth.head(Nz / 2).sum());
+    EXPECT_NEAR(hybridDepth.tail(Nz / 2).sum(), pureDepth.tail(Nz / 2).sum(), 0.25 * pureDepth.tail(Nz / 2).sum());
+    for (size_t i = 0; i < pure.detectedR.size(); i++) {
+        EXPECT_LT(abs(hybrid.detectedR[i].second - pure.detectedR[i].second), 4 * sqrt(hybrid.detectedRvariance[i].second + pure.detectedRvariance[i].second));
+        EXPECT_LT(abs(hybrid.detectedT[i].second - pure.detectedT[i].second), 4 * sqrt(hybrid.detectedTvariance[i].second + pure.detectedTvariance[i].second));
+    }
+}
+
+TEST_F(DiffusionHandoffTests, FiberEstimatorAgreesWithDirectHits) {
+    using Fiber = MonteCarlo_NS::OpticalFiber<T>;
+
+    /// events which jump are not estimated, so estimated and direct signals of a hybrid run agree
+    const auto signal = [&](const T& depth) {
+        T sum = 0;
+        for (int i = 0; i < 3; i++) {
+            Math_NS::seedRandom(10 + i);
+            MonteCarlo<T,Nz,Nr,detector> mc(sample, Np, d, radius, sphereR, sphereT, dist, source);
+            auto fiber = make_shared<Fiber>(0, 1E-3, 0.5);
+            mc.addFiberR(fiber);
+            mc.setFiberEstimator(depth);
+            mc.setDiffusionHandoff(DiffusionHandoff<T>());
+            mc.CalculateResult();
+            sum += fiber->signal;
+        }
+        return sum / 3;
+    };
+    const T direct = signal(0);
+    EXPECT_NEAR(signal(d), direct, 0.15 * direct);
+}
+
+TEST_F(DiffusionHandoffTests, Throws) {
+    MonteCarlo<T,Nz,Nr,detector> mc(sample, 10, d, radius, sphereR, sphereT, dist, source);
+    DiffusionHandoff<T> handoff;
+    handoff.depth = -1;
+    EXPECT_THROW(mc.setDiffusionHandoff(handoff), invalid_argument);
+    handoff.depth = 5;
+    EXPECT_THROW(mc.setDiffusionHandoff(handoff), invalid_argument);
+    handoff.depth = 10;
+    handoff.margin = -1;
+    EXPECT_THROW(mc.setDiffusionHandoff(handoff), invalid_argument);
+    handoff.margin = 5;
+    handoff.scatterings = -1;
+    EXPECT_THROW(mc.setDiffusionHandoff(handoff), invalid_argument);
+
+    const Matrix<T,Dynamic,Dynamic> coag = Matrix<T,Dynamic,Dynamic>::Ones(Nz, Nr);
+    MonteCarlo<T,Nz,Nr,detector> heterogeneous(sample, 10, d, radius, sphereR, sphereT, dist, source, coag);
+    EXPECT_THROW(heterogeneous.setDiffusionHandoff(DiffusionHandoff<T>()), invalid_argument);
+
+    const auto spectrum = Spectrum<T>::fromSamples({sample, Sample<T>({Medium<T>::fromCoeffs(1.4, 1, 100000, d, 0.9)}, 1, 1)});
+    MonteCarlo<T,Nz,Nr,detector> spectral(sample, 10, d, radius, sphereR, sphereT, dist, source, spectrum);
+    EXPECT_THROW(spectral.setDiffusionHandoff(DiffusionHandoff<T>()), invalid_argument);
+
+    MonteCarlo<T,Nz,Nr,detector> adjoint(sample, 10, d, radius, sphereR, sphereT, dist, source);
+    adjoint.setDiffusionHandoff(DiffusionHandoff<T>());
+    EXPECT_THROW(adjoint.CalculateAdjoint(MonteCarlo_NS::OpticalFiber<T>(0, 1E-3, 0.5)), invalid_argument);
+}
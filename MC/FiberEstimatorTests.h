@@ -0,0 +1,140 @@
+#pragma once
+
+#ifndef ENABLE_CHECK_CONTRACTS
+    #define ENABLE_CHECK_CONTRACTS
+#endif // ENABLE_CHECK_CONTRACTS
+
+#include "MonteCarlo.h"
+
+#include "../Math/Random.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+
+using namespace Eigen;
+using namespace std;
+
+class FiberEstimatorTests : public ::testing::Test {
+protected:
+    using T = double;
+    using Fiber = MonteCarlo_NS::OpticalFiber<T>;
+
+    static constexpr size_t Nz = 20;
+    static constexpr size_t Nr = 20;
+    static constexpr bool detector = 1;
+
+    static constexpr int Np = 4000;
+    static constexpr int replicates = 12;
+    static constexpr T d = 1E-3;
+    static constexpr T radius = 1E-2;
+
+    IntegratingSphere<T> sphereR{0.0508, 0.0125, 0.0125};
+    IntegratingSphere<T> sphereT{0.0508, 0.0125, 0.0};
+    DetectorDistance<T>  dist{0, 0.1, 0.05};
+    const LightSource<T> source{0, SourceType::Point};
+
+    const Sample<T> sample{{Medium<T>::fromCoeffs(1.4, 100, 10000, d, 0.9)}, 1, 1};
+
+    struct Signals {
+        T meanR = 0, meanT = 0;
+        T varianceR = 0, varianceT = 0; ///< variances of means
+    };
+
+    /// signals of fibers in reflection and transmission over replicates
+    Signals run(const T& depth, const T& NA, const std::uint64_t& seed) const {
+        T sum[2] = {0, 0}, sum2[2] = {0, 0};
+        for (int i = 0; i < replicates; i++) {
+            Math_NS::seedRandom(seed + i);
+            MonteCarlo<T,Nz,Nr,detector> mc(sample, Np, d, radius, sphereR, sphereT, dist, source);
+            auto fiberR = make_shared<Fiber>(1E-3, 4E-4, NA);
+            auto fiberT = make_shared<Fiber>(1E-3, 4E-4, NA);
+            mc.addFiberR(fiberR);
+            mc.addFiberT(fiberT);
+            mc.setFiberEstimator(depth);
+            mc.CalculateResult();
+            const T signals[2] = {fiberR->signal, fiberT->signal};
+            for (int k = 0; k < 2; k++) {
+                sum[k] += signals[k];
+                sum2[k] += signals[k] * signals[k];
+            }
+        }
+        Signals result;
+        result.meanR = sum[0] / replicates;
+        result.meanT = sum[1] / replicates;
+        result.varianceR = (sum2[0] / replicates - result.meanR * result.meanR) / (replicates - 1);
+        result.varianceT = (sum2[1] / replicates - result.meanT * result.meanT) / (replicates - 1);
+        return result;
+    }
+};
+
+TEST_F(FiberEstimatorTests, ZeroDepthKeepsRun) {
+    Math_NS::seedRandom(1);
+    MonteCarlo<T,Nz,Nr,detector> plain(sample, Np, d, radius, sphereR, sphereT, dist, source);
+    auto plainFiber = make_shared<Fiber>(1E-3, 4E-4, 0.22);
+    plain.addFiberR(plainFiber);
+    const auto reference = plain.CalculateResult();
+
+    Math_NS::seedRandom(1);
+    MonteCarlo<T,Nz,Nr,detector> disabled(sample, Np, d, radius, sphereR, sphereT, dist, source);
+    auto disabledFiber = make_shared<Fiber>(1E-3, 4E-4, 0.22);
+    disabled.addFiberR(disabledFiber);
+    disabled.setFiberEstimator(0);
+    const auto result = disabled.CalculateResult();
+
+    EXPECT_EQ(disabledFiber->signal, plainFiber->signal);
+    EXPECT_EQ(result.diffuseReflection, reference.diffuseReflection);
+    EXPECT_EQ(result.matrixA, reference.matrixA);
+}
+
+TEST_F(FiberEstimatorTests, FibersDetectExitPhotons) {
+    Math_NS::seedRandom(2);
+    MonteCarlo<T,Nz,Nr,detector> mc(sample, Np, d, radius, sphereR, sphereT, dist, source);
+    auto narrow = make_shared<Fiber>(1E-3, 4E-4, 0.22);
+    auto wide = make_shared<Fiber>(1E-3, 4E-4, 1);
+    auto far = make_shared<Fiber>(2E-2, 4E-4, 1);
+    mc.addFiberR(narrow);
+    mc.addFiberR(wide);
+    mc.addFiberR(far);
+    mc.CalculateResult();
+
+    EXPECT_GT(narrow->signal, 0);
+    EXPECT_GT(wide->signal, narrow->signal);
+    EXPECT_EQ(far->signal, 0);
+}
+
+TEST_F(FiberEstimatorTests, EstimatorIsUnbiased) {
+    for (const T& NA: {0.22, 1.0}) {
+        const auto analog = run(0, NA, 10);
+        const auto estimated = run(3 * d, NA, 100);
+        EXPECT_LT(abs(estimated.meanR - analog.meanR), 4 * sqrt(estimated.varianceR + analog.varianceR));
+        EXPECT_LT(abs(estimated.meanT - analog.meanT), 4 * sqrt(estimated.varianceT + analog.varianceT));
+    }
+}
+
+TEST_F(FiberEstimatorTests, EstimatorReducesVariance) {
+    const auto analog = run(0, 0.22, 200);
+    const auto estimated = run(3 * d, 0.22, 300);
+    EXPECT_LT(estimated.varianceR, analog.varianceR);
+    EXPECT_LT(estimated.varianceT, analog.varianceT);
+}
+
+TEST_F(FiberEstimatorTests, Throws) {
+    MonteCarlo<T,Nz,Nr,detector> mc(sample, 10, d, radius, sphereR, sphereT, dist, source);
+    EXPECT_THROW(mc.addFiberR(nullptr), invalid_argument);
+    EXPECT_THROW(mc.addFiberT(nullptr), invalid_argument);
+    EXPECT_THROW(mc.setFiberEstimator(-1E-3), invalid_argument);
+
+    const Medium<T> glass = Medium<T>::fromCoeffs(1.5, 0, 0, 1E-3, 0);
+    const Sample<T> covered({glass, Medium<T>::fromCoeffs(1.4, 100, 10000, d, 0.9), glass}, 1, 1);
+    MonteCarlo<T,Nz,Nr,detector> withGlass(covered, 10, 3 * d, radius, sphereR, sphereT, dist, source);
+    EXPECT_THROW(withGlass.setFiberEstimator(d), invalid_argument);
+
+    const Matrix<T,Dynamic,Dynamic> coag = Matrix<T,Dynamic,Dynamic>::Ones(Nz, Nr);
+    MonteCarlo<T,Nz,Nr,detector> heterogeneous(sample, 10, d, radius, sphereR, sphereT, dist, source, coag);
+    EXPECT_THROW(heterogeneous.setFiberEstimator(d), invalid_argument);
+
+    const auto spectrum = Spectrum<T>::fromSamples({sample, Sample<T>({Medium<T>::fromCoeffs(1.4, 10, 10000, d, 0.9)}, 1, 1)});
+    MonteCarlo<T,Nz,Nr,detector> spectral(sample, 10, d, radius, sphereR, sphereT, dist, source, spectrum);
+    EXPECT_THROW(spectral.setFiberEstimator(d), invalid_argument);
+}
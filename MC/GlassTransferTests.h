@@ -0,0 +1,159 @@
+#pragma once
+
+#ifndef ENABLE_CHECK_CONTRACTS
+    #define ENABLE_CHECK_CONTRACTS
+#endif // ENABLE_CHECK_CONTRACTS
+
+#include "MonteCarlo.h"
+
+#include "../Math/Random.h"
+#include "../Physics/Reflectance.h"
+
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace Eigen;
+using namespace std;
+
+class GlassTransferTests : public ::testing::Test {
+protected:
+    using T = double;
+
+    static constexpr size_t Nz = 20;
+    static constexpr size_t Nr = 50;
+    static constexpr bool detector = 1;
+
+    static constexpr T nGlass = 1.5;
+    static constexpr T nTissue = 1.4;
+    static constexpr T hGlass = 1E-3;
+    static constexpr T d = 1E-3;
+
+    /// exposes glass transfer of MonteCarlo
+    class Probe : public MonteCarlo<T,Nz,Nr,detector> {
+    public:
+        using MonteCarlo<T,Nz,Nr,detector>::MonteCarlo;
+        using MonteCarlo<T,Nz,Nr,detector>::TransferThroughGlass;
+
+        /// hand exit photons of transfers to detectors
+        void flushDetectors() {
+            this->detectorsR.flush();
+            this->detectorsT.flush();
+        }
+    };
+
+    /// keeps every exit photon
+    class RecordingDetector : public MonteCarlo_NS::DetectorInterface<T> {
+    public:
+        void detectBatch(const Photon<T>* photons, const size_t& count) override {
+            exits.insert(exits.end(), photons, photons + count);
+        }
+
+        vector<Photon<T>> exits;
+    };
+
+    IntegratingSphere<T> sphereR{0.0508, 0.0125, 0.0125};
+    IntegratingSphere<T> sphereT{0.0508, 0.0125, 0.0};
+    DetectorDistance<T>  dist{0, 0.01, 0.002};
+    LightSource<T> source{0.0005, SourceType::Circle};
+
+    const Medium<T> glass = Medium<T>::fromCoeffs(nGlass, 0, 0, hGlass, 0);
+    const Sample<T> sample{{glass, Medium<T>::fromCoeffs(nTissue, 100, 3000, d, 0.8), glass}, 1, 1};
+
+    /// photon which has just entered glass from tissue
+    static Photon<T> entering(const T& sine, const T& z, const int& layer, const bool& up) {
+        const T cosine = sqrt(1 - sine * sine);
+        Photon<T> photon({0, 0, z}, {sine, 0, up ? -cosine : cosine}, 1.0, 0);
+        photon.layer = layer;
+        return photon;
+    }
+};
+
+TEST_F(GlassTransferTests, SplitsWeightInClosedForm) {
+    using namespace Physics_NS;
+
+    Probe mc(sample, 1, 2 * hGlass + d, 1E-2, sphereR, sphereT, dist, source);
+    auto recorder = make_shared<RecordingDetector>();
+    mc.addDetectorR(recorder);
+
+    const T sine = 0.3;
+    auto photon = entering(sine, hGlass, 0, true);
+    mc.TransferThroughGlass(photon);
+    mc.flushDetectors();
+
+    const T cosine = sqrt(1 - sine * sine);
+    const T R1 = FresnelReflectance<T>(nGlass, 1, cosine);
+    const T R2 = FresnelReflectance<T>(nGlass, nTissue, cosine);
+    const T escaped = (1 - R1) / (1 - R1 * R2);
+
+    T recorded = 0;
+    for (const auto& exit: recorder->exits)
+        recorded += exit.weight;
+    EXPECT_NEAR(recorded, escaped, 1E-12);
+    EXPECT_NEAR(photon.weight, 1 - escaped, 1E-12);
+
+    /// first escape leaves after one crossing, next after every round trip
+    ASSERT_GE(recorder->exits.size(), 2);
+    const T shift = hGlass * sine / cosine;
+    for (size_t k = 0; k < recorder->exits.size(); k++) {
+        EXPECT_NEAR(recorder->exits[k].coordinate.x, (2 * k + 1) * shift, 1E-15);
+        EXPECT_EQ(recorder->exits[k].coordinate.z, 0);
+        EXPECT_LT(recorder->exits[k].direction.z, 0);
+    }
+
+    /// photon is back in tissue on the inner face at one of its exit points
+    EXPECT_EQ(photon.layer, 1);
+    EXPECT_EQ(photon.coordinate.z, hGlass);
+    const T roundTrips = (photon.coordinate.x / shift - 2) / 2;
+    EXPECT_NEAR(roundTrips, round(roundTrips), 1E-9);
+    EXPECT_GT(photon.direction.z, 0);
+    EXPECT_NEAR(photon.direction.x, sine * nGlass / nTissue, 1E-15);
+    EXPECT_NEAR(photon.direction.norm(), 1, 1E-12);
+}
+
+TEST_F(GlassTransferTests, TotalInternalReflectionReturnsWholeWeight) {
+    Probe mc(sample, 1, 2 * hGlass + d, 1E-2, sphereR, sphereT, dist, source);
+    auto recorder = make_shared<RecordingDetector>();
+    mc.addDetectorT(recorder);
+
+    /// beyond critical angle of glass and vacuum
+    auto photon = entering(0.8, hGlass + d, 2, false);
+    mc.TransferThroughGlass(photon);
+    mc.flushDetectors();
+
+    EXPECT_TRUE(recorder->exits.empty());
+    EXPECT_DOUBLE_EQ(photon.weight, 1);
+    EXPECT_EQ(photon.layer, 1);
+    EXPECT_EQ(photon.coordinate.z, hGlass + d);
+    EXPECT_LT(photon.direction.z, 0);
+}
+
+TEST_F(GlassTransferTests, BottomSlideTransmits) {
+    Probe mc(sample, 1, 2 * hGlass + d, 1E-2, sphereR, sphereT, dist, source);
+    auto recorderR = make_shared<RecordingDetector>();
+    auto recorderT = make_shared<RecordingDetector>();
+    mc.addDetectorR(recorderR);
+    mc.addDetectorT(recorderT);
+
+    auto photon = entering(0, hGlass + d, 2, false);
+    mc.TransferThroughGlass(photon);
+    mc.flushDetectors();
+
+    EXPECT_FALSE(recorderT->exits.empty());
+    EXPECT_EQ(recorderT->exits.front().coordinate.z, 2 * hGlass + d);
+    EXPECT_GT(recorderT->exits.front().direction.z, 0);
+    EXPECT_EQ(photon.layer, 1);
+    EXPECT_EQ(photon.coordinate.x, 0);
+    EXPECT_EQ(photon.direction.z, -1);
+}
+
+TEST_F(GlassTransferTests, NonAbsorbingSampleConservesEnergy) {
+    const Sample<T> clear{{glass, Medium<T>::fromCoeffs(nTissue, 0, 3000, d, 0.8), glass}, 1, 1};
+    Math_NS::seedRandom(5);
+    MonteCarlo<T,Nz,Nr,detector> mc(clear, 20000, 2 * hGlass + d, 1E-2, sphereR, sphereT, dist, source);
+    const auto results = mc.CalculateResult();
+
+    EXPECT_EQ(results.absorbed, 0);
+    EXPECT_NEAR(results.specularReflection + results.diffuseReflection + results.diffuseTransmission, 1, 0.01);
+}
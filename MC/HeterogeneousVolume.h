@@ -0,0 +1,162 @@
+#pragma once
+
+#include "MajorantGrid.h"
+#include "MaterialProperties.h"
+
+#include "../Math/Basic.h"
+#include "../Utils/Contracts.h"
+#include "../Utils/HugePageAllocator.h"
+
+#include "../eigen/Eigen/Dense"
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+/// \brief Read-only 3D voxel volume built from the axially symmetric Nz x Nr coag map
+/// The volume is built and validated once and then shared between all MonteCarlo workers and runs on the same phantom.
+/// Every voxel stores a compact material index into a small table of precomputed MaterialProperties,
+/// so the mapping from coagulation degree to optical properties is evaluated once at load.
+/// Voxels are stored in one contiguous cache-aligned (huge-page-backed for big volumes) block,
+/// x and y indices are in [0, 2 * Nr - 1), z index is in [0, Nz).
+/// Local majorants over macro cells of MACRO_CELL_SIZE^3 voxels are built with the volume for delta tracking.
+template < typename T, typename Index = std::uint8_t >
+class HeterogeneousVolume {
+public:
+    using Material = MaterialProperties<T>;
+    using CoagMatrix = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>;
+
+    /// macro cell edge of the majorant grid in voxels
+    static constexpr int MACRO_CELL_SIZE = 4;
+
+    /// \param[in] coagMatrix Nz x Nr coagulation degree map, values must be in [0, 1]
+    /// \param[in] n refraction coefficient of the tissue
+    /// \throw std::invalid_argument if coagMatrix has more distinct values than Index can address,
+    /// or if ENABLE_CHECK_CONTRACTS is defined and coagMatrix is empty or has values out of [0, 1]
+    explicit HeterogeneousVolume(const CoagMatrix& coagMatrix, const T& n = 1);
+    ~HeterogeneousVolume() noexcept = default;
+
+    /// Build volume to be shared between workers
+    /// \param[in] coagMatrix Nz x Nr coagulation degree map
+    /// \param[in] n refraction coefficient of the tissue
+    /// \return shared read-only volume
+    /// \throw std::invalid_argument if coagMatrix has more distinct values than Index can address
+    static std::shared_ptr<const HeterogeneousVolume> create(const CoagMatrix& coagMatrix, const T& n = 1);
+
+    /// Optical properties in voxel
+    /// \param[in] x voxel x index
+    /// \param[in] y voxel y index
+    /// \param[in] z voxel z index
+    /// \return optical properties in voxel
+    inline const Material& operator () (const int& x, const int& y, const int& z) const noexcept { return materials[voxels[index(x, y, z)]]; }
+
+    /// Material index in voxel
+    /// \param[in] x voxel x index
+    /// \param[in] y voxel y index
+    /// \param[in] z voxel z index
+    /// \return material index in voxel
+    inline Index material(const int& x, const int& y, const int& z) const noexcept { return voxels[index(x, y, z)]; }
+
+    /// Optical properties of material
+    /// \param[in] id material index
+    /// \return optical properties of material
+    inline const Material& properties(const Index& id) const noexcept { return materials[id]; }
+
+    inline int getNz()         const noexcept { return Nz;   }
+    inline int getNr()         const noexcept { return Nr;   }
+    inline int getSide()       const noexcept { return side; }
+    inline int getNmaterials() const noexcept { return static_cast<int>(materials.size()); }
+    /// majorant attenuation, maximal mut over all materials
+    inline T getMajorant()     const noexcept { return majorant; }
+    /// local majorants over macro cells
+    inline const MajorantGrid<T>& getMajorantGrid() const noexcept { return majorantGrid; }
+
+    /// Check if the volume was built for the grid
+    /// \param[in] gridNz grid size along z
+    /// \param[in] gridNr grid size along r
+    /// \return if volume matches grid
+    inline bool matches(const size_t& gridNz, const size_t& gridNr) const noexcept {
+        return static_cast<size_t>(Nz) == gridNz && static_cast<size_t>(Nr) == gridNr;
+    }
+
+protected:
+    inline size_t index(const int& x, const int& y, const int& z) const noexcept {
+        return (static_cast<size_t>(z) * side + x) * side + y;
+    }
+
+    int Nz;
+    int Nr;
+    int side;
+    T majorant = 0;
+    std::vector<Material> materials;
+    std::vector<Index, Utils_NS::HugePageAllocator<Index>> voxels;
+    MajorantGrid<T> majorantGrid;
+};
+
+/******************
+ * IMPLEMENTATION *
+ ******************/
+
+template < typename T, typename Index >
+HeterogeneousVolume<T,Index>::HeterogeneousVolume(const CoagMatrix& coagMatrix, const T& n)
+    : Nz(static_cast<int>(coagMatrix.rows()))
+    , Nr(static_cast<int>(coagMatrix.cols()))
+    , side(2 * static_cast<int>(coagMatrix.cols()) - 1) {
+    using namespace Math_NS;
+    using namespace std;
+
+    CHECK_ARGUMENT_CONTRACT(Nz > 0 && Nr > 0);
+    CHECK_ARGUMENT_CONTRACT(coagMatrix.allFinite());
+    CHECK_ARGUMENT_CONTRACT(coagMatrix.minCoeff() >= 0 && coagMatrix.maxCoeff() <= 1);
+
+    /// native tissue outside the map is material 0
+    map<T, Index> ids = {{1, 0}};
+    Eigen::Matrix<Index, Eigen::Dynamic, Eigen::Dynamic> idMatrix(Nz, Nr);
+    for (int i = 0; i < Nz; i++)
+        for (int j = 0; j < Nr; j++) {
+            auto it = ids.find(coagMatrix(i, j));
+            if (it == ids.end()) {
+                /// checked in every build, wrapped indices would overwrite materials of other voxels
+                if (ids.size() > numeric_limits<Index>::max())
+                    throw invalid_argument("Coag map has more distinct values than material index can address");
+                it = ids.emplace(coagMatrix(i, j), static_cast<Index>(ids.size())).first;
+            }
+            idMatrix(i, j) = it->second;
+        }
+
+    materials.resize(ids.size());
+    for (const auto& [coag, id]: ids) {
+        materials[id] = Material::fromCoag(coag, n);
+        majorant = max(majorant, materials[id].mut);
+    }
+
+    voxels.assign(static_cast<size_t>(Nz) * side * side, 0);
+
+    /// radial index of every (x, y) column is the same for all slices
+    vector<int> ring(static_cast<size_t>(side) * side, -1);
+    for (int k = 0; k < side; k++)
+        for (int l = 0; l < side; l++) {
+            const int d2 = sqr(k - Nr + 1) + sqr(l - Nr + 1);
+            if (d2 <= sqr(Nr))
+                ring[static_cast<size_t>(k) * side + l] = min(static_cast<int>(floor(sqrt(static_cast<T>(d2)))), Nr - 1);
+        }
+
+    for (int i = 0; i < Nz; i++)
+        for (int k = 0; k < side; k++)
+            for (int l = 0; l < side; l++) {
+                const int num = ring[static_cast<size_t>(k) * side + l];
+                if (num >= 0)
+                    voxels[index(k, l, i)] = idMatrix(i, num);
+            }
+
+    majorantGrid = MajorantGrid<T>(*this, MACRO_CELL_SIZE);
+}
+
+template < typename T, typename Index >
+std::shared_ptr<const HeterogeneousVolume<T,Index>> HeterogeneousVolume<T,Index>::create(const CoagMatrix& coagMatrix, const T& n) {
+    return std::make_shared<const HeterogeneousVolume<T,Index>>(coagMatrix, n);
+}
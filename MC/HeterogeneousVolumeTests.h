@@ -0,0 +1,125 @@
+#pragma once
+
+#ifndef ENABLE_CHECK_CONTRACTS
+    #define ENABLE_CHECK_CONTRACTS
+#endif // ENABLE_CHECK_CONTRACTS
+
+#include "HeterogeneousVolume.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+
+using namespace Eigen;
+using namespace std;
+
+class HeterogeneousVolumeTests : public ::testing::Test {
+protected:
+    static constexpr int Nz = 3;
+    static constexpr int Nr = 4;
+    static constexpr double n = 1.4;
+
+    Matrix<double, Dynamic, Dynamic> coag = (Matrix<double, Dynamic, Dynamic>(Nz, Nr) << 0.1, 0.2, 0.3, 0.4,
+                                                                                         0.5, 0.6, 0.7, 0.8,
+                                                                                         0.0, 0.0, 1.0, 1.0).finished();
+
+    void expectMaterial(const MaterialProperties<double>& material, double coagDegree) {
+        const auto expected = MaterialProperties<double>::fromCoag(coagDegree, n);
+        EXPECT_DOUBLE_EQ(material.mua, expected.mua);
+        EXPECT_DOUBLE_EQ(material.mus, expected.mus);
+        EXPECT_DOUBLE_EQ(material.mut, expected.mua + expected.mus);
+        EXPECT_DOUBLE_EQ(material.g  , expected.g  );
+        EXPECT_DOUBLE_EQ(material.n  , n           );
+    }
+};
+
+TEST_F(HeterogeneousVolumeTests, Dimensions) {
+    HeterogeneousVolume<double> volume(coag, n);
+    EXPECT_EQ(volume.getNz(), Nz);
+    EXPECT_EQ(volume.getNr(), Nr);
+    EXPECT_EQ(volume.getSide(), 2 * Nr - 1);
+    EXPECT_TRUE (volume.matches(Nz, Nr));
+    EXPECT_FALSE(volume.matches(Nz, Nr + 1));
+}
+
+TEST_F(HeterogeneousVolumeTests, MaterialTableHasDistinctCoagValues) {
+    HeterogeneousVolume<double> volume(coag, n);
+    EXPECT_EQ(volume.getNmaterials(), 10);
+    EXPECT_EQ(volume.material(0, 0, 0), 0);
+    expectMaterial(volume.properties(0), 1.0);
+}
+
+TEST_F(HeterogeneousVolumeTests, MaterialPropertiesFromCoag) {
+    const auto material = MaterialProperties<double>::fromCoag(0.5, n);
+    EXPECT_DOUBLE_EQ(material.mua, uaFunc<double>(0.5));
+    EXPECT_DOUBLE_EQ(material.mus, usFunc<double>(0.5));
+    EXPECT_DOUBLE_EQ(material.mut, uaFunc<double>(0.5) + usFunc<double>(0.5));
+    EXPECT_DOUBLE_EQ(material.g  , gFunc <double>(0.5));
+}
+
+TEST_F(HeterogeneousVolumeTests, AxisIsFirstColumn) {
+    HeterogeneousVolume<double> volume(coag, n);
+    for (int z = 0; z < Nz; z++)
+        expectMaterial(volume(Nr - 1, Nr - 1, z), coag(z, 0));
+}
+
+TEST_F(HeterogeneousVolumeTests, RadialSymmetry) {
+    HeterogeneousVolume<double> volume(coag, n);
+    for (int z = 0; z < Nz; z++)
+        for (int r = 0; r < Nr; r++) {
+            expectMaterial(volume(Nr - 1 + r, Nr - 1, z), coag(z, r));
+            expectMaterial(volume(Nr - 1 - r, Nr - 1, z), coag(z, r));
+            expectMaterial(volume(Nr - 1, Nr - 1 + r, z), coag(z, r));
+            expectMaterial(volume(Nr - 1, Nr - 1 - r, z), coag(z, r));
+        }
+}
+
+TEST_F(HeterogeneousVolumeTests, CornersOutsideMapAreNative) {
+    HeterogeneousVolume<double> volume(coag, n);
+    expectMaterial(volume(0, 0, 0), 1.0);
+    expectMaterial(volume(2 * Nr - 2, 2 * Nr - 2, Nz - 1), 1.0);
+}
+
+TEST_F(HeterogeneousVolumeTests, StorageIsCacheAligned) {
+    HeterogeneousVolume<double> volume(coag, n);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(&volume(0, 0, 0)) % alignof(MaterialProperties<double>), 0u);
+    EXPECT_EQ(sizeof(decltype(volume.material(0, 0, 0))), 1u);
+}
+
+TEST_F(HeterogeneousVolumeTests, SharedVolumeIsTheSameObject) {
+    auto volume = HeterogeneousVolume<double>::create(coag, n);
+    auto copy = volume;
+    EXPECT_EQ(volume.get(), copy.get());
+    EXPECT_EQ(volume.use_count(), 2);
+}
+
+TEST_F(HeterogeneousVolumeTests, WideIndexForManyMaterials) {
+    Matrix<double, Dynamic, Dynamic> smooth(1, 300);
+    for (int j = 0; j < smooth.cols(); j++)
+        smooth(0, j) = j / 300.0;
+    EXPECT_THROW(HeterogeneousVolume<double>::create(smooth), invalid_argument);
+    HeterogeneousVolume<double, uint16_t> volume(smooth, n);
+    EXPECT_EQ(volume.getNmaterials(), 301);
+    expectMaterial(volume(299, 299, 0), 0.0);
+}
+
+TEST_F(HeterogeneousVolumeTests, ThrowsForEmptyMap) {
+    EXPECT_THROW(HeterogeneousVolume<double>::create(Matrix<double, Dynamic, Dynamic>()), invalid_argument);
+}
+
+TEST_F(HeterogeneousVolumeTests, ThrowsForCoagOutOfRange) {
+    auto wrong = coag;
+    wrong(1, 1) = 1.5;
+    EXPECT_THROW(HeterogeneousVolume<double>::create(wrong), invalid_argument);
+    wrong(1, 1) = -0.5;
+    EXPECT_THROW(HeterogeneousVolume<double>::create(wrong), invalid_argument);
+}
+
+TEST_F(HeterogeneousVolumeTests, MajorantIsMaximalAttenuation) {
+    HeterogeneousVolume<double> volume(coag, n);
+    double expected = 0;
+    for (int id = 0; id < volume.getNmaterials(); id++)
+        expected = max(expected, volume.properties(id).mut);
+    EXPECT_DOUBLE_EQ(volume.getMajorant(), expected);
+    EXPECT_DOUBLE_EQ(volume.getMajorant(), MaterialProperties<double>::fromCoag(0.0, n).mut);
+}
@@ -0,0 +1,225 @@
+#pragma once
+
+#include "MaterialProperties.h"
+
+#include "../Math/Basic.h"
+#include "../Math/Vector3.h"
+#include "../Utils/Contracts.h"
+
+#include <cmath>
+#include <limits>
+
+enum class InclusionShape {
+    Sphere    = 0,
+    Ellipsoid = 1,
+    Cylinder  = 2, ///< elliptic cylinder with axis along z
+    Slab      = 3  ///< laterally unbounded layer between two z planes
+};
+
+/// \brief Analytic primitive of a heterogeneous sample with its own optical properties
+/// All primitives are axis aligned and described by center and semi-axes,
+/// for cylinder semi-axes are x and y radii and half height, for slab only z semi-axis is used.
+template < typename T >
+class Inclusion {
+public:
+    using Material = MaterialProperties<T>;
+
+    /// \param[in] center center of the sphere
+    /// \param[in] radius radius of the sphere
+    /// \param[in] material optical properties inside
+    /// \throw std::invalid_argument if ENABLE_CHECK_CONTRACTS is defined and radius is not positive
+    static Inclusion sphere(const Vector3D<T>& center, const T& radius, const Material& material) EXCEPT_INPUT_PARAMS;
+
+    /// \param[in] center center of the ellipsoid
+    /// \param[in] semiAxes semi-axes along x, y and z
+    /// \param[in] material optical properties inside
+    /// \throw std::invalid_argument if ENABLE_CHECK_CONTRACTS is defined and any semi-axis is not positive
+    static Inclusion ellipsoid(const Vector3D<T>& center, const Vector3D<T>& semiAxes, const Material& material) EXCEPT_INPUT_PARAMS;
+
+    /// \param[in] center center of the cylinder axis
+    /// \param[in] radiusX radius along x
+    /// \param[in] radiusY radius along y
+    /// \param[in] height height along z
+    /// \param[in] material optical properties inside
+    /// \throw std::invalid_argument if ENABLE_CHECK_CONTRACTS is defined and any size is not positive
+    static Inclusion cylinder(const Vector3D<T>& center, const T& radiusX, const T& radiusY, const T& height, const Material& material) EXCEPT_INPUT_PARAMS;
+
+    /// \param[in] zTop upper plane
+    /// \param[in] zBottom lower plane
+    /// \param[in] material optical properties inside
+    /// \throw std::invalid_argument if ENABLE_CHECK_CONTRACTS is defined and zBottom <= zTop
+    static Inclusion slab(const T& zTop, const T& zBottom, const Material& material) EXCEPT_INPUT_PARAMS;
+
+    /// Check if point is strictly inside
+    /// \param[in] point point
+    /// \return if point is inside
+    bool contains(const Vector3D<T>& point) const noexcept;
+
+    /// Nearest crossing of the surface along the ray
+    /// \param[in] origin ray origin
+    /// \param[in] direction ray direction, not necessarily normalized
+    /// \param[in] tMin crossings at or before tMin are skipped
+    /// \return ray parameter of the crossing, infinity if there is none
+    T intersect(const Vector3D<T>& origin, const Vector3D<T>& direction, const T& tMin) const noexcept;
+
+    inline InclusionShape getShape()        const noexcept { return shape;    }
+    inline const Vector3D<T>& getCenter()   const noexcept { return center;   }
+    inline const Vector3D<T>& getSemiAxes() const noexcept { return semiAxes; }
+    inline const Material& getMaterial()    const noexcept { return material; }
+
+    /// lower corner of the axis aligned bounding box
+    Vector3D<T> getLower() const noexcept;
+    /// upper corner of the axis aligned bounding box
+    Vector3D<T> getUpper() const noexcept;
+
+protected:
+    Inclusion(const InclusionShape& newShape, const Vector3D<T>& newCenter, const Vector3D<T>& newSemiAxes, const Material& newMaterial) noexcept
+        : shape(newShape)
+        , center(newCenter)
+        , semiAxes(newSemiAxes)
+        , material(newMaterial) {}
+
+    /// point in coordinates where the primitive has unit semi-axes
+    inline Vector3D<T> scaled(const Vector3D<T>& v) const noexcept {
+        return Vector3D<T>(v.x / semiAxes.x, v.y / semiAxes.y, v.z / semiAxes.z);
+    }
+
+    /// smaller root of a t^2 + b t + c = 0 after tMin, infinity if there is none
+    static T firstRoot(const T& a, const T& b, const T& c, const T& tMin) noexcept;
+
+    InclusionShape shape;
+    Vector3D<T> center;
+    Vector3D<T> semiAxes;
+    Material material;
+};
+
+/******************
+ * IMPLEMENTATION *
+ ******************/
+
+template < typename T >
+Inclusion<T> Inclusion<T>::sphere(const Vector3D<T>& center, const T& radius, const Material& material) EXCEPT_INPUT_PARAMS {
+    CHECK_ARGUMENT_CONTRACT(radius > 0);
+    return Inclusion(InclusionShape::Sphere, center, Vector3D<T>(radius, radius, radius), material);
+}
+
+template < typename T >
+Inclusion<T> Inclusion<T>::ellipsoid(const Vector3D<T>& center, const Vector3D<T>& semiAxes, const Material& material) EXCEPT_INPUT_PARAMS {
+    CHECK_ARGUMENT_CONTRACT(semiAxes.x > 0 && semiAxes.y > 0 && semiAxes.z > 0);
+    return Inclusion(InclusionShape::Ellipsoid, center, semiAxes, material);
+}
+
+template < typename T >
+Inclusion<T> Inclusion<T>::cylinder(const Vector3D<T>& center, const T& radiusX, const T& radiusY, const T& height, const Material& material) EXCEPT_INPUT_PARAMS {
+    CHECK_ARGUMENT_CONTRACT(radiusX > 0 && radiusY > 0 && height > 0);
+    return Inclusion(InclusionShape::Cylinder, center, Vector3D<T>(radiusX, radiusY, height / 2), material);
+}
+
+template < typename T >
+Inclusion<T> Inclusion<T>::slab(const T& zTop, const T& zBottom, const Material& material) EXCEPT_INPUT_PARAMS {
+    CHECK_ARGUMENT_CONTRACT(zBottom > zTop);
+    return Inclusion(InclusionShape::Slab, Vector3D<T>(0, 0, (zTop + zBottom) / 2), Vector3D<T>(1, 1, (zBottom - zTop) / 2), material);
+}
+
+template < typename T >
+bool Inclusion<T>::contains(const Vector3D<T>& point) const noexcept {
+    using namespace Math_NS;
+    using namespace std;
+
+    const auto q = scaled(point - center);
+    switch (shape) {
+        case InclusionShape::Sphere:
+        case InclusionShape::Ellipsoid:
+            return sqr(q.x) + sqr(q.y) + sqr(q.z) < 1;
+        case InclusionShape::Cylinder:
+            return sqr(q.x) + sqr(q.y) < 1 && abs(q.z) < 1;
+        case InclusionShape::Slab:
+            return abs(q.z) < 1;
+    }
+    return false;
+}
+
+template < typename T >
+T Inclusion<T>::intersect(const Vector3D<T>& origin, const Vector3D<T>& direction, const T& tMin) const noexcept {
+    using namespace Math_NS;
+    using namespace std;
+
+    constexpr T inf = numeric_limits<T>::infinity();
+    const auto o = scaled(origin - center);
+    const auto d = scaled(direction);
+
+    /// crossing of the planes z = -1 and z = +1 in scaled coordinates
+    const auto capCrossing = [&](const bool& checkRadius) {
+        T best = inf;
+        if (d.z == 0)
+            return best;
+        for (const T plane: {T(-1), T(+1)}) {
+            const T t = (plane - o.z) / d.z;
+            if (t > tMin && t < best && (!checkRadius || sqr(o.x + t * d.x) + sqr(o.y + t * d.y) <= 1))
+                best = t;
+        }
+        return best;
+    };
+
+    switch (shape) {
+        case InclusionShape::Sphere:
+        case InclusionShape::Ellipsoid:
+            return firstRoot(d * d, 2 * (o * d), o * o - 1, tMin);
+        case InclusionShape::Cylinder: {
+            T best = capCrossing(true);
+            const T a = sqr(d.x) + sqr(d.y);
+            const T b = 2 * (o.x * d.x + o.y * d.y);
+            const T c = sqr(o.x) + sqr(o.y) - 1;
+            /// both lateral roots are checked, the first one may be out of the height range
+            T t = firstRoot(a, b, c, tMin);
+            if (t < inf && abs(o.z + t * d.z) > 1)
+                t = firstRoot(a, b, c, t);
+            if (t < inf && abs(o.z + t * d.z) <= 1)
+                best = min(best, t);
+            return best;
+        }
+        case InclusionShape::Slab:
+            return capCrossing(false);
+    }
+    return inf;
+}
+
+template < typename T >
+T Inclusion<T>::firstRoot(const T& a, const T& b, const T& c, const T& tMin) noexcept {
+    using namespace Math_NS;
+    using namespace std;
+
+    constexpr T inf = numeric_limits<T>::infinity();
+    if (a == 0)
+        return inf;
+    const T discriminant = sqr(b) - 4 * a * c;
+    if (discriminant < 0)
+        return inf;
+    /// numerically stable roots
+    const T q = -(b + (b >= 0 ? sqrt(discriminant) : -sqrt(discriminant))) / 2;
+    T t1 = q / a;
+    T t2 = q != 0 ? c / q : t1;
+    if (t1 > t2)
+        swap(t1, t2);
+    if (t1 > tMin)
+        return t1;
+    if (t2 > tMin)
+        return t2;
+    return inf;
+}
+
+template < typename T >
+Vector3D<T> Inclusion<T>::getLower() const noexcept {
+    constexpr T inf = std::numeric_limits<T>::infinity();
+    if (shape == InclusionShape::Slab)
+        return Vector3D<T>(-inf, -inf, center.z - semiAxes.z);
+    return center - semiAxes;
+}
+
+template < typename T >
+Vector3D<T> Inclusion<T>::getUpper() const noexcept {
+    constexpr T inf = std::numeric_limits<T>::infinity();
+    if (shape == InclusionShape::Slab)
+        return Vector3D<T>(inf, inf, center.z + semiAxes.z);
+    return center + semiAxes;
+}
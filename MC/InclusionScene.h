@@ -0,0 +1,223 @@
+#pragma once
+
+#include "Inclusion.h"
+
+#include "../Math/Vector3.h"
+#include "../Utils/Contracts.h"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+/// \brief Heterogeneous sample made of analytic inclusions in a background tissue
+/// Inclusions may overlap, inclusion listed later overrides earlier ones,
+/// so nested inclusions are listed from outer to inner.
+/// Inclusions are stored in a bounding volume hierarchy of axis aligned boxes
+/// for fast point queries and ray boundary crossings.
+/// Refraction on inclusion borders is not modelled, the tissue refraction coefficient is used everywhere.
+template < typename T >
+class InclusionScene {
+public:
+    using Material = MaterialProperties<T>;
+
+    /// \param[in] newInclusions inclusions in ascending priority
+    /// \param[in] newBackground optical properties outside of inclusions
+    /// \throw std::invalid_argument if ENABLE_CHECK_CONTRACTS is defined and any material has negative attenuation or g out of [-1, 1]
+    InclusionScene(const std::vector<Inclusion<T>>& newInclusions, const Material& newBackground) EXCEPT_INPUT_PARAMS;
+    ~InclusionScene() noexcept = default;
+
+    /// Build scene to be shared between workers
+    /// \param[in] newInclusions inclusions in ascending priority
+    /// \param[in] newBackground optical properties outside of inclusions
+    /// \return shared read-only scene
+    static std::shared_ptr<const InclusionScene> create(const std::vector<Inclusion<T>>& newInclusions, const Material& newBackground) EXCEPT_INPUT_PARAMS;
+
+    /// Optical properties at point
+    /// \param[in] point point
+    /// \return optical properties of the inclusion with highest priority containing point or background
+    const Material& operator () (const Vector3D<T>& point) const noexcept;
+
+    /// Nearest crossing of any inclusion border along the ray
+    /// \param[in] origin ray origin
+    /// \param[in] direction ray direction
+    /// \param[in] tMin crossings at or before tMin are skipped
+    /// \return ray parameter of the crossing, infinity if there is none
+    T nextBoundary(const Vector3D<T>& origin, const Vector3D<T>& direction, const T& tMin) const noexcept;
+
+    inline int getNinclusions()                         const noexcept { return static_cast<int>(inclusions.size()); }
+    inline const Inclusion<T>& getInclusion(const int& i) const noexcept { return inclusions[i]; }
+    inline const Material& getBackground()              const noexcept { return background; }
+    inline int getNnodes()                              const noexcept { return static_cast<int>(nodes.size()); }
+
+protected:
+    struct Node {
+        Vector3D<T> lower;
+        Vector3D<T> upper;
+        int left  = -1; ///< children, -1 for leaf
+        int right = -1;
+        int first = 0;  ///< leaf range in order
+        int count = 0;
+    };
+
+    static constexpr int LEAF_SIZE = 2;
+    static constexpr int STACK_SIZE = 64;
+
+    int build(const int& first, const int& count);
+    static bool inside(const Node& node, const Vector3D<T>& point) noexcept;
+    static bool hit(const Node& node, const Vector3D<T>& origin, const Vector3D<T>& direction, const T& tMin, const T& tMax) noexcept;
+
+    std::vector<Inclusion<T>> inclusions;
+    std::vector<int> order;
+    std::vector<Node> nodes;
+    Material background;
+};
+
+/******************
+ * IMPLEMENTATION *
+ ******************/
+
+template < typename T >
+InclusionScene<T>::InclusionScene(const std::vector<Inclusion<T>>& newInclusions, const Material& newBackground) EXCEPT_INPUT_PARAMS
+    : inclusions(newInclusions)
+    , background(newBackground) {
+    const auto checkMaterial = [](const Material& material) {
+        CHECK_ARGUMENT_CONTRACT(material.mua >= 0 && material.mus >= 0);
+        CHECK_ARGUMENT_CONTRACT(material.g >= -1 && material.g <= 1);
+    };
+    checkMaterial(background);
+    for (const auto& inclusion: inclusions)
+        checkMaterial(inclusion.getMaterial());
+
+    order.resize(inclusions.size());
+    std::iota(order.begin(), order.end(), 0);
+    if (!inclusions.empty())
+        build(0, static_cast<int>(inclusions.size()));
+}
+
+template < typename T >
+std::shared_ptr<const InclusionScene<T>> InclusionScene<T>::create(const std::vector<Inclusion<T>>& newInclusions, const Material& newBackground) EXCEPT_INPUT_PARAMS {
+    return std::make_shared<const InclusionScene<T>>(newInclusions, newBackground);
+}
+
+template < typename T >
+int InclusionScene<T>::build(const int& first, const int& count) {
+    using namespace std;
+
+    const int id = static_cast<int>(nodes.size());
+    nodes.push_back(Node());
+
+    Node node;
+    node.lower = inclusions[order[first]].getLower();
+    node.upper = inclusions[order[first]].getUpper();
+    Vector3D<T> centerLower = inclusions[order[first]].getCenter();
+    Vector3D<T> centerUpper = centerLower;
+    for (int i = first; i < first + count; i++) {
+        const auto& inclusion = inclusions[order[i]];
+        for (int axis = 0; axis < 3; axis++) {
+            node.lower[axis] = min(node.lower[axis], inclusion.getLower()[axis]);
+            node.upper[axis] = max(node.upper[axis], inclusion.getUpper()[axis]);
+            centerLower[axis] = min(centerLower[axis], inclusion.getCenter()[axis]);
+            centerUpper[axis] = max(centerUpper[axis], inclusion.getCenter()[axis]);
+        }
+    }
+
+    if (count <= LEAF_SIZE) {
+        node.first = first;
+        node.count = count;
+    } else {
+        /// median split of centers along the widest axis
+        const auto extent = centerUpper - centerLower;
+        const int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+        const int half = count / 2;
+        nth_element(order.begin() + first, order.begin() + first + half, order.begin() + first + count, [&](const int& a, const int& b) {
+            return inclusions[a].getCenter()[axis] < inclusions[b].getCenter()[axis];
+        });
+        node.left  = build(first, half);
+        node.right = build(first + half, count - half);
+    }
+    nodes[id] = node;
+    return id;
+}
+
+template < typename T >
+bool InclusionScene<T>::inside(const Node& node, const Vector3D<T>& point) noexcept {
+    for (int axis = 0; axis < 3; axis++)
+        if (point[axis] < node.lower[axis] || point[axis] > node.upper[axis])
+            return false;
+    return true;
+}
+
+template < typename T >
+bool InclusionScene<T>::hit(const Node& node, const Vector3D<T>& origin, const Vector3D<T>& direction, const T& tMin, const T& tMax) noexcept {
+    using namespace std;
+
+    T t0 = tMin;
+    T t1 = tMax;
+    for (int axis = 0; axis < 3; axis++) {
+        if (direction[axis] == 0) {
+            if (origin[axis] < node.lower[axis] || origin[axis] > node.upper[axis])
+                return false;
+            continue;
+        }
+        T tLower = (node.lower[axis] - origin[axis]) / direction[axis];
+        T tUpper = (node.upper[axis] - origin[axis]) / direction[axis];
+        if (tLower > tUpper)
+            swap(tLower, tUpper);
+        t0 = max(t0, tLower);
+        t1 = min(t1, tUpper);
+        if (t0 > t1)
+            return false;
+    }
+    return true;
+}
+
+template < typename T >
+const typename InclusionScene<T>::Material& InclusionScene<T>::operator () (const Vector3D<T>& point) const noexcept {
+    int best = -1;
+    if (!nodes.empty()) {
+        std::array<int, STACK_SIZE> stack;
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const Node& node = nodes[stack[--top]];
+            if (!inside(node, point))
+                continue;
+            if (node.left < 0) {
+                for (int i = node.first; i < node.first + node.count; i++)
+                    if (order[i] > best && inclusions[order[i]].contains(point))
+                        best = order[i];
+            } else {
+                stack[top++] = node.left;
+                stack[top++] = node.right;
+            }
+        }
+    }
+    return best < 0 ? background : inclusions[best].getMaterial();
+}
+
+template < typename T >
+T InclusionScene<T>::nextBoundary(const Vector3D<T>& origin, const Vector3D<T>& direction, const T& tMin) const noexcept {
+    T best = std::numeric_limits<T>::infinity();
+    if (nodes.empty())
+        return best;
+
+    std::array<int, STACK_SIZE> stack;
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const Node& node = nodes[stack[--top]];
+        if (!hit(node, origin, direction, tMin, best))
+            continue;
+        if (node.left < 0) {
+            for (int i = node.first; i < node.first + node.count; i++)
+                best = std::min(best, inclusions[order[i]].intersect(origin, direction, tMin));
+        } else {
+            stack[top++] = node.left;
+            stack[top++] = node.right;
+        }
+    }
+    return best;
+}
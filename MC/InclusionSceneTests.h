@@ -0,0 +1,129 @@
+#pragma once
+
+#ifndef ENABLE_CHECK_CONTRACTS
+    #define ENABLE_CHECK_CONTRACTS
+#endif // ENABLE_CHECK_CONTRACTS
+
+#include "InclusionScene.h"
+#include "MonteCarlo.h"
+
+#include "../Math/Random.h"
+
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <vector>
+
+using namespace std;
+
+class InclusionSceneTests : public ::testing::Test {
+protected:
+    using T = double;
+    using V = Vector3D<T>;
+    using Material = MaterialProperties<T>;
+
+    const Material background = Material::fromCoag(1.0, 1.4);
+
+    /// grid of spheres with nested ellipsoid and cylinder, later inclusions override earlier
+    vector<Inclusion<T>> inclusions() const {
+        vector<Inclusion<T>> result;
+        for (int i = 0; i < 5; i++)
+            for (int j = 0; j < 5; j++)
+                result.push_back(Inclusion<T>::sphere(V(i - 2, j - 2, 0), 0.4, Material::fromCoag(0.1 * (i + 1), 1.4)));
+        result.push_back(Inclusion<T>::ellipsoid(V(0, 0, 0), V(1, 1, 0.5), Material::fromCoag(0.05, 1.4)));
+        result.push_back(Inclusion<T>::cylinder(V(0, 0, 0), 0.2, 0.2, 0.4, Material::fromCoag(0.0, 1.4)));
+        return result;
+    }
+
+    /// brute force material lookup
+    static const Material& material(const vector<Inclusion<T>>& all, const Material& background, const V& point) {
+        const Material* result = &background;
+        for (const auto& inclusion: all)
+            if (inclusion.contains(point))
+                result = &inclusion.getMaterial();
+        return *result;
+    }
+};
+
+TEST_F(InclusionSceneTests, HierarchyIsBuilt) {
+    InclusionScene<T> scene(inclusions(), background);
+    EXPECT_EQ(scene.getNinclusions(), 27);
+    EXPECT_GT(scene.getNnodes(), 1);
+    EXPECT_DOUBLE_EQ(scene.getBackground().mut, background.mut);
+}
+
+TEST_F(InclusionSceneTests, PointQueryMatchesBruteForce) {
+    const auto all = inclusions();
+    InclusionScene<T> scene(all, background);
+    for (int i = 0; i < 10000; i++) {
+        const V point(Math_NS::random<T>(-3, 3), Math_NS::random<T>(-3, 3), Math_NS::random<T>(-1, 1));
+        EXPECT_DOUBLE_EQ(scene(point).mut, material(all, background, point).mut);
+    }
+}
+
+TEST_F(InclusionSceneTests, LaterInclusionOverrides) {
+    InclusionScene<T> scene(inclusions(), background);
+    EXPECT_DOUBLE_EQ(scene(V(0, 0, 0)).mut, Material::fromCoag(0.0, 1.4).mut);
+    EXPECT_DOUBLE_EQ(scene(V(0.5, 0, 0)).mut, Material::fromCoag(0.05, 1.4).mut);
+    EXPECT_DOUBLE_EQ(scene(V(2, 2, 0)).mut, Material::fromCoag(0.5, 1.4).mut);
+    EXPECT_DOUBLE_EQ(scene(V(1.5, 1.5, 0)).mut, background.mut);
+}
+
+TEST_F(InclusionSceneTests, NextBoundaryMatchesBruteForce) {
+    const auto all = inclusions();
+    InclusionScene<T> scene(all, background);
+    for (int i = 0; i < 10000; i++) {
+        const V origin(Math_NS::random<T>(-3, 3), Math_NS::random<T>(-3, 3), Math_NS::random<T>(-1, 1));
+        V direction(Math_NS::random<T>(-1, 1), Math_NS::random<T>(-1, 1), Math_NS::random<T>(-1, 1));
+        direction /= direction.norm();
+        const T tMin = Math_NS::random<T>(0, 1);
+
+        T expected = numeric_limits<T>::infinity();
+        for (const auto& inclusion: all)
+            expected = min(expected, inclusion.intersect(origin, direction, tMin));
+        EXPECT_EQ(scene.nextBoundary(origin, direction, tMin), expected);
+    }
+}
+
+TEST_F(InclusionSceneTests, EmptySceneIsBackground) {
+    InclusionScene<T> scene({}, background);
+    EXPECT_DOUBLE_EQ(scene(V(0, 0, 0)).mut, background.mut);
+    EXPECT_EQ(scene.nextBoundary(V(0, 0, 0), V(0, 0, 1), 0), numeric_limits<T>::infinity());
+}
+
+TEST_F(InclusionSceneTests, ThrowsForWrongMaterial) {
+    auto wrong = background;
+    wrong.g = 2;
+    EXPECT_THROW(InclusionScene<T>::create({}, wrong), invalid_argument);
+}
+
+/// slab inclusion in one layer must give the same result as three homogeneous layers
+TEST_F(InclusionSceneTests, SlabMatchesLayeredSample) {
+    constexpr size_t Nz = 20;
+    constexpr size_t Nr = 50;
+    constexpr int Np = 20000;
+    constexpr T d = 1E-3;
+    constexpr T r = 1E-1;
+
+    IntegratingSphere<T> sphereR{0.0508, 0.0125, 0.0125};
+    IntegratingSphere<T> sphereT{0.0508, 0.0125, 0.0};
+    DetectorDistance<T>  dist;
+    LightSource<T> source{0.0005, SourceType::Circle};
+
+    const auto layer = [](const T& coag, const T& thickness) {
+        return Medium<T>::fromCoeffs(1.4, uaFunc<T>(coag), usFunc<T>(coag), thickness, gFunc<T>(coag));
+    };
+    const Sample<T> single({layer(1, d)}, 1, 1);
+    const Sample<T> layered({layer(1, 0.35 * d), layer(0, 0.35 * d), layer(1, 0.3 * d)}, 1, 1);
+    const auto scene = InclusionScene<T>::create({Inclusion<T>::slab(0.35 * d, 0.7 * d, Material::fromCoag(0.0, 1.4))}, background);
+
+    MonteCarlo<T,Nz,Nr,1> mcScene(single, Np, d, r, sphereR, sphereT, dist, source, scene);
+    MonteCarlo<T,Nz,Nr,1> mcLayered(layered, Np, d, r, sphereR, sphereT, dist, source);
+    const auto withScene = mcScene.CalculateResult();
+    const auto withLayers = mcLayered.CalculateResult();
+
+    EXPECT_DOUBLE_EQ(withScene.specularReflection, withLayers.specularReflection);
+    EXPECT_NEAR(withScene.diffuseReflection  , withLayers.diffuseReflection  , 0.05 * withLayers.diffuseReflection  );
+    EXPECT_NEAR(withScene.diffuseTransmission, withLayers.diffuseTransmission, 0.05 * withLayers.diffuseTransmission);
+    EXPECT_NEAR(withScene.absorbed           , withLayers.absorbed           , 0.05 * withLayers.absorbed           );
+}
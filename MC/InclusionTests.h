@@ -0,0 +1,91 @@
+#pragma once
+
+#ifndef ENABLE_CHECK_CONTRACTS
+    #define ENABLE_CHECK_CONTRACTS
+#endif // ENABLE_CHECK_CONTRACTS
+
+#include "Inclusion.h"
+
+#include <gtest/gtest.h>
+
+#include <limits>
+
+using namespace std;
+
+class InclusionTests : public ::testing::Test {
+protected:
+    using T = double;
+    using V = Vector3D<T>;
+
+    static constexpr T inf = numeric_limits<T>::infinity();
+    const MaterialProperties<T> material = MaterialProperties<T>::fromCoeffs(10, 1000, 0.9, 1.4);
+};
+
+TEST_F(InclusionTests, SphereContains) {
+    const auto sphere = Inclusion<T>::sphere(V(1, 2, 3), 2, material);
+    EXPECT_EQ(sphere.getShape(), InclusionShape::Sphere);
+    EXPECT_TRUE (sphere.contains(V(1, 2, 3)));
+    EXPECT_TRUE (sphere.contains(V(2.9, 2, 3)));
+    EXPECT_FALSE(sphere.contains(V(3.1, 2, 3)));
+    EXPECT_FALSE(sphere.contains(V(2.5, 3.5, 3)));
+}
+
+TEST_F(InclusionTests, SphereIntersect) {
+    const auto sphere = Inclusion<T>::sphere(V(0, 0, 0), 1, material);
+    EXPECT_DOUBLE_EQ(sphere.intersect(V(0, 0, -3), V(0, 0, 1), 0), 2);
+    EXPECT_DOUBLE_EQ(sphere.intersect(V(0, 0, -3), V(0, 0, 1), 2), 4);
+    EXPECT_DOUBLE_EQ(sphere.intersect(V(0, 0, 0), V(1, 0, 0), 0), 1);
+    EXPECT_EQ(sphere.intersect(V(0, 0, -3), V(0, 0, 1), 4), inf);
+    EXPECT_EQ(sphere.intersect(V(0, 2, -3), V(0, 0, 1), 0), inf);
+    EXPECT_EQ(sphere.intersect(V(0, 0, 3), V(0, 0, 1), 0), inf);
+}
+
+TEST_F(InclusionTests, EllipsoidIntersect) {
+    const auto ellipsoid = Inclusion<T>::ellipsoid(V(0, 0, 1), V(2, 3, 0.5), material);
+    EXPECT_DOUBLE_EQ(ellipsoid.intersect(V(-5, 0, 1), V(1, 0, 0), 0), 3);
+    EXPECT_DOUBLE_EQ(ellipsoid.intersect(V(0, -5, 1), V(0, 1, 0), 0), 2);
+    EXPECT_DOUBLE_EQ(ellipsoid.intersect(V(0, 0, 0), V(0, 0, 1), 0), 0.5);
+    EXPECT_TRUE (ellipsoid.contains(V(1.9, 0, 1)));
+    EXPECT_FALSE(ellipsoid.contains(V(0, 0, 1.6)));
+}
+
+TEST_F(InclusionTests, CylinderIntersect) {
+    const auto cylinder = Inclusion<T>::cylinder(V(0, 0, 2), 1, 1, 2, material);
+    EXPECT_TRUE (cylinder.contains(V(0.5, 0.5, 1.5)));
+    EXPECT_FALSE(cylinder.contains(V(0, 0, 3.5)));
+    EXPECT_FALSE(cylinder.contains(V(1, 1, 2)));
+    /// through caps
+    EXPECT_DOUBLE_EQ(cylinder.intersect(V(0, 0, 0), V(0, 0, 1), 0), 1);
+    EXPECT_DOUBLE_EQ(cylinder.intersect(V(0, 0, 0), V(0, 0, 1), 1), 3);
+    /// through lateral surface
+    EXPECT_DOUBLE_EQ(cylinder.intersect(V(-3, 0, 2), V(1, 0, 0), 0), 2);
+    EXPECT_DOUBLE_EQ(cylinder.intersect(V(-3, 0, 2), V(1, 0, 0), 2), 4);
+    /// lateral root out of height, enters through cap
+    EXPECT_NEAR(cylinder.intersect(V(-1.5, 0, 0), V(1, 0, 1), 0), 1.0, 1E-12);
+    /// misses
+    EXPECT_EQ(cylinder.intersect(V(-3, 0, 4), V(1, 0, 0), 0), inf);
+}
+
+TEST_F(InclusionTests, SlabIntersect) {
+    const auto slab = Inclusion<T>::slab(1, 2, material);
+    EXPECT_TRUE (slab.contains(V(100, -100, 1.5)));
+    EXPECT_FALSE(slab.contains(V(0, 0, 0.5)));
+    EXPECT_DOUBLE_EQ(slab.intersect(V(5, 5, 0), V(0, 0, 1), 0), 1);
+    EXPECT_DOUBLE_EQ(slab.intersect(V(5, 5, 0), V(0, 0, 1), 1), 2);
+    EXPECT_EQ(slab.intersect(V(5, 5, 0), V(1, 0, 0), 0), inf);
+    EXPECT_EQ(slab.getLower().x, -inf);
+    EXPECT_EQ(slab.getUpper().z, 2);
+}
+
+TEST_F(InclusionTests, BoundingBox) {
+    const auto ellipsoid = Inclusion<T>::ellipsoid(V(1, 1, 1), V(1, 2, 3), material);
+    EXPECT_EQ(ellipsoid.getLower(), V(0, -1, -2));
+    EXPECT_EQ(ellipsoid.getUpper(), V(2, 3, 4));
+}
+
+TEST_F(InclusionTests, ThrowsForWrongSizes) {
+    EXPECT_THROW(Inclusion<T>::sphere(V(0, 0, 0), 0, material), invalid_argument);
+    EXPECT_THROW(Inclusion<T>::ellipsoid(V(0, 0, 0), V(1, -1, 1), material), invalid_argument);
+    EXPECT_THROW(Inclusion<T>::cylinder(V(0, 0, 0), 1, 1, 0, material), invalid_argument);
+    EXPECT_THROW(Inclusion<T>::slab(2, 1, material), invalid_argument);
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "MaterialProperties.h"
+#include "Medium.h"
+#include "Sample.h"
+
+#include <vector>
+
+/// \brief Constants of one layer of Sample read by photon transport, one or two cache lines per layer
+template < typename T >
+struct alignas(64) LayerConstants {
+    T zUpper = 0; ///< z of upper border
+    T zLower = 0; ///< z of lower border
+    T mua    = 0; ///< absorption coefficient
+    T mus    = 0; ///< scattering coefficient
+    T mut    = 0; ///< total attenuation coefficient
+    T albedo = 0; ///< mus / mut, 0 in glass
+    T g      = 0; ///< scattering anisotropy
+    T n      = 1; ///< refraction coefficient
+    T nUpper = 1; ///< refraction coefficient above upper border, vacuum above the sample
+    T nLower = 1; ///< refraction coefficient below lower border, vacuum below the sample
+    int upper = -1; ///< layer above, -1 for the top layer
+    int lower = -1; ///< layer below, -1 for the bottom layer
+};
+
+/// \brief Layers of Sample flattened into one table, built once per run,
+/// so transport reads borders and coefficients of the current layer without summing thicknesses or copying Medium
+template < typename T >
+class LayerTable {
+public:
+    LayerTable() noexcept = default;
+    /// Table of sample layers
+    /// \param[in] sample layered sample
+    /// \param[in] scatteringOnly drop absorption of every layer, for runs which apply it along the path
+    explicit LayerTable(const Sample<T>& sample, const bool& scatteringOnly = false);
+    ~LayerTable() noexcept = default;
+
+    inline const LayerConstants<T>& operator[](const int& layer) const noexcept { return layers[layer]; }
+    inline int getNlayers() const noexcept { return layers.size(); }
+
+    /// Optical properties of layer
+    /// \param[in] layer layer index
+    /// \return material of layer
+    inline MaterialProperties<T> material(const int& layer) const noexcept {
+        const auto& constants = layers[layer];
+        return MaterialProperties<T>{constants.mua, constants.mus, constants.mut, constants.g, constants.n};
+    }
+
+protected:
+    std::vector<LayerConstants<T>> layers;
+};
+
+/******************
+ * IMPLEMENTATION *
+ ******************/
+
+template < typename T >
+LayerTable<T>::LayerTable(const Sample<T>& sample, const bool& scatteringOnly)
+    : layers(sample.getNlayers()) {
+    const int Nlayers = sample.getNlayers();
+
+    T zUpper = 0;
+    for (int i = 0; i < Nlayers; i++) {
+        const auto medium = sample.getMedium(i);
+        auto& layer = layers[i];
+
+        layer.zUpper = zUpper;
+        layer.zLower = zUpper + medium.getD();
+        zUpper += medium.getD();
+
+        layer.mua = scatteringOnly ? 0 : medium.getMua();
+        layer.mus = medium.getMus();
+        layer.mut = scatteringOnly ? medium.getMus() : medium.getMut();
+        layer.albedo = layer.mut == 0 ? 0 : layer.mus / layer.mut;
+        layer.g = medium.getG();
+        layer.n = medium.getN();
+
+        layer.upper = i - 1;
+        layer.lower = i == Nlayers - 1 ? -1 : i + 1;
+        layer.nUpper = i == 0 ? sample.getNvacUpper() : sample.getMedium(i - 1).getN();
+        layer.nLower = i == Nlayers - 1 ? sample.getNvacLower() : sample.getMedium(i + 1).getN();
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#ifndef ENABLE_CHECK_CONTRACTS
+    #define ENABLE_CHECK_CONTRACTS
+#endif // ENABLE_CHECK_CONTRACTS
+
+#include "LayerTable.h"
+
+#include <cstdint>
+
+#include <gtest/gtest.h>
+
+using namespace std;
+
+class LayerTableTests : public ::testing::Test {
+protected:
+    using T = double;
+
+    const Medium<T> glassTop    = Medium<T>::fromCoeffs(1.5, 0, 0, 1E-3, 0);
+    const Medium<T> tissue      = Medium<T>::fromCoeffs(1.4, 100, 3000, 2E-3, 0.8);
+    const Medium<T> glassBottom = Medium<T>::fromCoeffs(1.6, 0, 0, 0.5E-3, 0);
+    const Sample<T> sample{{glassTop, tissue, glassBottom}, 1.1, 1.2};
+};
+
+TEST_F(LayerTableTests, MatchesSample) {
+    const LayerTable<T> layers(sample);
+    ASSERT_EQ(layers.getNlayers(), 3);
+
+    for (int i = 0; i < layers.getNlayers(); i++) {
+        const auto medium = sample.getMedium(i);
+        EXPECT_EQ(layers[i].zUpper, sample.CurrentUpperBorderZ(i));
+        EXPECT_EQ(layers[i].zLower, sample.CurrentLowerBorderZ(i));
+        EXPECT_EQ(layers[i].mua, medium.getMua());
+        EXPECT_EQ(layers[i].mus, medium.getMus());
+        EXPECT_EQ(layers[i].mut, medium.getMut());
+        EXPECT_EQ(layers[i].g, medium.getG());
+        EXPECT_EQ(layers[i].n, medium.getN());
+    }
+    EXPECT_EQ(layers[0].albedo, 0);
+    EXPECT_DOUBLE_EQ(layers[1].albedo, tissue.getA());
+}
+
+TEST_F(LayerTableTests, Neighbours) {
+    const LayerTable<T> layers(sample);
+
+    EXPECT_EQ(layers[0].upper, -1);
+    EXPECT_EQ(layers[0].lower, 1);
+    EXPECT_EQ(layers[1].upper, 0);
+    EXPECT_EQ(layers[1].lower, 2);
+    EXPECT_EQ(layers[2].upper, 1);
+    EXPECT_EQ(layers[2].lower, -1);
+
+    EXPECT_EQ(layers[0].nUpper, 1.1);
+    EXPECT_EQ(layers[0].nLower, 1.4);
+    EXPECT_EQ(layers[1].nUpper, 1.5);
+    EXPECT_EQ(layers[1].nLower, 1.6);
+    EXPECT_EQ(layers[2].nUpper, 1.4);
+    EXPECT_EQ(layers[2].nLower, 1.2);
+
+    const LayerTable<T> single(Sample<T>({tissue}, 1.3, 1.0));
+    EXPECT_EQ(single[0].upper, -1);
+    EXPECT_EQ(single[0].lower, -1);
+    EXPECT_EQ(single[0].nUpper, 1.3);
+    EXPECT_EQ(single[0].nLower, 1.0);
+}
+
+TEST_F(LayerTableTests, ScatteringOnly) {
+    const LayerTable<T> layers(sample, true);
+
+    EXPECT_EQ(layers[0].mut, 0);
+    EXPECT_EQ(layers[1].mua, 0);
+    EXPECT_EQ(layers[1].mut, tissue.getMus());
+    EXPECT_EQ(layers[1].albedo, 1);
+
+    const auto material = layers.material(1);
+    EXPECT_EQ(material.mua, 0);
+    EXPECT_EQ(material.mut, tissue.getMus());
+    EXPECT_EQ(material.g, tissue.getG());
+}
+
+TEST_F(LayerTableTests, LayersAreCacheAligned) {
+    const LayerTable<T> layers(sample);
+
+    EXPECT_EQ(alignof(LayerConstants<T>), 64);
+    for (int i = 0; i < layers.getNlayers(); i++)
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(&layers[i]) % 64, 0);
+}
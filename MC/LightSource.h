@@ -1,15 +1,26 @@
 #pragma once
 
+#include "../Math/AliasTable.h"
+#include "../Math/FastMath.h"
 #include "../Math/Random.h"
 #include "../Math/Vector3.h"
 #include "../Math/Basic.h"
+#include "../Utils/Contracts.h"
+#include "../eigen/Eigen/Dense"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
 
 #include <math.h>
 
 enum class SourceType {
     Point = 0,
     Circle = 1,
-    Gaussian = 2
+    Gaussian = 2,
+    Image = 3,      ///< measured 2D beam profile
+    RadialTable = 4 ///< measured radial beam profile
 };
 
 template < typename T >
@@ -19,37 +30,220 @@ public:
     LightSource(const T& newRadius, SourceType newType) noexcept;
     ~LightSource() noexcept = default;
 
+    /// Source of measured beam image centred on the beam axis, pixels are sampled from alias table
+    /// and launch points are uniform over the area of pixel
+    /// \param[in] intensity intensity of pixels, rows go along y and columns along x
+    /// \param[in] pixelSize side of square pixel
+    /// \return source with radius of the circle around the image
+    /// \throw std::invalid_argument if ENABLE_CHECK_CONTRACTS is defined and pixelSize is not positive,
+    /// intensity is empty, negative or has no power
+    static LightSource fromImage(const Eigen::Matrix<T,Eigen::Dynamic,Eigen::Dynamic>& intensity, const T& pixelSize) EXCEPT_INPUT_PARAMS;
+
+    /// Source of measured radial beam profile, rings between neighbouring radii of table
+    /// carry their mean intensity and are sampled from alias table
+    /// \param[in] table radii in increasing order from zero and intensities at them, as read by readTable
+    /// \return source with the last radius of table
+    /// \throw std::invalid_argument if ENABLE_CHECK_CONTRACTS is defined and table has less than 2 points,
+    /// radii are negative or not increasing, intensity is negative or has no power
+    static LightSource fromRadialTable(const std::vector<std::pair<T,T>>& table) EXCEPT_INPUT_PARAMS;
+
     Vector3D<T> getPhotonCoord() const noexcept;
 
+    static constexpr int UNIFORMS = 4; ///< uniform numbers of one launch point, at most
+
+    /// Launch point from given uniform numbers, e.g. coordinates of a quasi-random point
+    /// \param[in] u UNIFORMS uniform numbers in (0, 1), Circle and Gaussian read two of them
+    /// \return launch point
+    inline Vector3D<T> getPhotonCoord(const T* u) const noexcept { return launchPoint(u); }
+
+    /// Launch points in bulk, uniform numbers of every block of points are drawn at once
+    /// \param[out] coords launch points
+    /// \param[in] count number of points
+    void getPhotonCoords(Vector3D<T>* coords, const int& count) const noexcept;
+
+    /// Irradiance of source of unit power at normal incidence
+    /// \param[in] x, y point on the sample surface
+    /// \return power per unit area at point, zero for Point source which has no area
+    T irradiance(const T& x, const T& y) const noexcept;
+
+    inline SourceType getType() const noexcept { return type;   }
+    inline T getRadius()        const noexcept { return radius; }
+    /// \return radial table of RadialTable source, empty otherwise
+    inline const std::vector<std::pair<T,T>>& getTable() const noexcept {
+        static const std::vector<std::pair<T,T>> empty;
+        return profile ? profile->table : empty;
+    }
+
 protected:
     SourceType type;
     T radius;
+
+    /// \brief Measured profile shared by copies of source, built once
+    struct Profile {
+        Math_NS::AliasTable<T> alias; ///< pixels in row-major order or rings
+        std::vector<std::pair<T,T>> table; ///< radial table
+        int rows = 0;
+        int cols = 0;
+        T pixelSize = 0;
+    };
+    std::shared_ptr<const Profile> profile; ///< null for Point, Circle and Gaussian
+
+    static constexpr int BLOCK = 64; ///< launch points of one draw of uniform numbers
+    /// Launch point from uniform numbers
+    /// \param[in] u UNIFORMS uniform numbers in (0, 1), Circle and Gaussian read two of them
+    /// \return launch point
+    inline Vector3D<T> launchPoint(const T* u) const noexcept;
 };
 
+/******************
+ * IMPLEMENTATION *
+ ******************/
+
 template < typename T >
 LightSource<T>::LightSource(const T& newRadius, SourceType newType) noexcept
     : type(newType)
     , radius(newRadius) {
 }
 
+template < typename T >
+LightSource<T> LightSource<T>::fromImage(const Eigen::Matrix<T,Eigen::Dynamic,Eigen::Dynamic>& intensity, const T& pixelSize) EXCEPT_INPUT_PARAMS {
+    CHECK_ARGUMENT_CONTRACT(pixelSize > 0);
+    CHECK_ARGUMENT_CONTRACT(intensity.size() > 0);
+
+    std::vector<T> weights(intensity.size());
+    for (int i = 0; i < intensity.rows(); i++)
+        for (int j = 0; j < intensity.cols(); j++)
+            weights[i * intensity.cols() + j] = intensity(i, j);
+
+    Profile profile;
+    profile.alias = Math_NS::AliasTable<T>(weights);
+    profile.rows = intensity.rows();
+    profile.cols = intensity.cols();
+    profile.pixelSize = pixelSize;
+
+    LightSource source(pixelSize * std::sqrt(T(Math_NS::sqr(profile.rows) + Math_NS::sqr(profile.cols))) / 2, SourceType::Image);
+    source.profile = std::make_shared<const Profile>(std::move(profile));
+    return source;
+}
+
+template < typename T >
+LightSource<T> LightSource<T>::fromRadialTable(const std::vector<std::pair<T,T>>& table) EXCEPT_INPUT_PARAMS {
+    using namespace Math_NS;
+
+    CHECK_ARGUMENT_CONTRACT(table.size() >= 2);
+    CHECK_ARGUMENT_CONTRACT(table.front().first >= 0);
+
+    std::vector<T> weights(table.size() - 1);
+    for (int m = 0; m < static_cast<int>(weights.size()); m++) {
+        const auto& [inner, innerIntensity] = table[m];
+        const auto& [outer, outerIntensity] = table[m + 1];
+        CHECK_ARGUMENT_CONTRACT(outer > inner);
+        CHECK_ARGUMENT_CONTRACT(innerIntensity >= 0 && outerIntensity >= 0);
+        weights[m] = (innerIntensity + outerIntensity) / 2 * (sqr(outer) - sqr(inner));
+    }
+
+    Profile profile;
+    profile.alias = AliasTable<T>(weights);
+    profile.table = table;
+
+    LightSource source(table.back().first, SourceType::RadialTable);
+    source.profile = std::make_shared<const Profile>(std::move(profile));
+    return source;
+}
+
 template < typename T >
 Vector3D<T> LightSource<T>::getPhotonCoord() const noexcept {
-    Vector3D<T> coord;
     if (type == SourceType::Point)
-        coord = Vector3D<T>(0.0, 0.0, 0.0);
-    else if (type == SourceType::Circle) {
-        T RNDr, RNDa;
-        RNDr = Math_NS::random<T>(0, 1);
-        RNDa = Math_NS::random<T>(0, 1) * 2 * M_PI;
-        coord = Vector3D<T>(sqrt(RNDr) * radius * cos(RNDa), sqrt(RNDr) * radius * sin(RNDa), 0);
-    //    std::cerr << coord << std::endl;
-    } else if (type == SourceType::Gaussian) {
-        T RNDr, RNDa;
-        RNDr = Math_NS::random<T>(0, 1);
-        RNDa = Math_NS::random<T>(0, 1) * 2 * M_PI;
-        coord = Vector3D<T>(sqrt(-log(RNDr)) * radius * cos(RNDa), sqrt(-log(RNDr)) * radius * sin(RNDa), 0);
-    //    std::cerr << coord << std::endl;
-    }
-
-    return coord;
+        return Vector3D<T>(0.0, 0.0, 0.0);
+
+    T u[UNIFORMS];
+    const int n = (type == SourceType::Circle || type == SourceType::Gaussian) ? 2 : UNIFORMS;
+    for (int k = 0; k < n; k++)
+        u[k] = Math_NS::random<T>(0, 1);
+    return launchPoint(u);
+}
+
+template < typename T >
+void LightSource<T>::getPhotonCoords(Vector3D<T>* coords, const int& count) const noexcept {
+    if (type == SourceType::Point) {
+        std::fill(coords, coords + count, Vector3D<T>(0.0, 0.0, 0.0));
+        return;
+    }
+
+    const int n = (type == SourceType::Circle || type == SourceType::Gaussian) ? 2 : UNIFORMS;
+    T u[UNIFORMS * BLOCK];
+    for (int first = 0; first < count; first += BLOCK) {
+        const int size = std::min(BLOCK, count - first);
+        Math_NS::threadRandomStream().fill(u, n * size);
+        for (int k = 0; k < size; k++)
+            coords[first + k] = launchPoint(u + n * k);
+    }
+}
+
+template < typename T >
+T LightSource<T>::irradiance(const T& x, const T& y) const noexcept {
+    using namespace Math_NS;
+
+    const T r2 = sqr(x) + sqr(y);
+    switch (type) {
+    case SourceType::Circle:
+        return r2 < sqr(radius) ? 1 / (T(M_PI) * sqr(radius)) : 0;
+    case SourceType::Gaussian:
+        return std::exp(-r2 / sqr(radius)) / (T(M_PI) * sqr(radius));
+    case SourceType::Image: {
+        const int col = static_cast<int>(std::floor(x / profile->pixelSize + T(0.5) * profile->cols));
+        const int row = static_cast<int>(std::floor(y / profile->pixelSize + T(0.5) * profile->rows));
+        if (col < 0 || col >= profile->cols || row < 0 || row >= profile->rows)
+            return 0;
+        return profile->alias.getProbability(row * profile->cols + col) / sqr(profile->pixelSize);
+    }
+    case SourceType::RadialTable: {
+        const auto& table = profile->table;
+        const T r = std::sqrt(r2);
+        const auto outer = std::upper_bound(table.begin(), table.end(), r, [](const T& value, const std::pair<T,T>& point) { return value < point.first; });
+        if (outer == table.begin() || outer == table.end())
+            return 0;
+        const int ring = static_cast<int>(outer - table.begin()) - 1;
+        return profile->alias.getProbability(ring) / (T(M_PI) * (sqr(outer->first) - sqr(table[ring].first)));
+    }
+    default:
+        return 0;
+    }
+}
+
+template < typename T >
+Vector3D<T> LightSource<T>::launchPoint(const T* u) const noexcept {
+    using namespace Math_NS;
+
+    T sinA, cosA;
+    switch (type) {
+    case SourceType::Circle: {
+        transportSincos(u[1] * 2 * T(M_PI), sinA, cosA);
+        const T rho = sqrt(u[0]) * radius;
+        return Vector3D<T>(rho * cosA, rho * sinA, 0);
+    }
+    case SourceType::Gaussian: {
+        transportSincos(u[1] * 2 * T(M_PI), sinA, cosA);
+        const T rho = sqrt(-transportLog(u[0])) * radius;
+        return Vector3D<T>(rho * cosA, rho * sinA, 0);
+    }
+    case SourceType::Image: {
+        const int pixel = profile->alias.sample(u[0], u[1]);
+        const int row = pixel / profile->cols;
+        const int col = pixel - row * profile->cols;
+        return Vector3D<T>((col + u[2] - T(0.5) * profile->cols) * profile->pixelSize,
+                           (row + u[3] - T(0.5) * profile->rows) * profile->pixelSize, 0);
+    }
+    case SourceType::RadialTable: {
+        const int ring = profile->alias.sample(u[0], u[1]);
+        const T inner = profile->table[ring].first;
+        const T outer = profile->table[ring + 1].first;
+        /// uniform over the area of ring
+        const T rho = sqrt(sqr(inner) + u[2] * (sqr(outer) - sqr(inner)));
+        transportSincos(u[3] * 2 * T(M_PI), sinA, cosA);
+        return Vector3D<T>(rho * cosA, rho * sinA, 0);
+    }
+    default:
+        return Vector3D<T>(0.0, 0.0, 0.0);
+    }
 }
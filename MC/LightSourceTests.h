@@ -0,0 +1,171 @@
+#pragma once
+
+#ifndef ENABLE_CHECK_CONTRACTS
+    #define ENABLE_CHECK_CONTRACTS
+#endif // ENABLE_CHECK_CONTRACTS
+
+#include "BeamProfile.h"
+#include "LightSource.h"
+
+#include "../Math/Random.h"
+
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace Eigen;
+using namespace std;
+
+class LightSourceTests : public ::testing::Test {
+protected:
+    using T = double;
+
+    static constexpr int N = 200000;
+    static constexpr T pixel = 1E-4;
+
+    /// launch points of source drawn in bulk
+    static vector<Vector3D<T>> launch(const LightSource<T>& source, const int& count = N) {
+        vector<Vector3D<T>> coords(count);
+        source.getPhotonCoords(coords.data(), count);
+        return coords;
+    }
+};
+
+TEST_F(LightSourceTests, SinglePixelImage) {
+    Matrix<T,Dynamic,Dynamic> image = Matrix<T,Dynamic,Dynamic>::Zero(4, 6);
+    image(1, 4) = 5;
+    const auto source = LightSource<T>::fromImage(image, pixel);
+    EXPECT_EQ(source.getType(), SourceType::Image);
+    EXPECT_DOUBLE_EQ(source.getRadius(), pixel * sqrt(T(4 * 4 + 6 * 6)) / 2);
+
+    /// pixel (1, 4) spans x in [1, 2] and y in [-1, 0] pixels from the centre
+    Math_NS::seedRandom(3);
+    for (const auto& coord: launch(source, 10000)) {
+        EXPECT_GE(coord.x, 1 * pixel);
+        EXPECT_LE(coord.x, 2 * pixel);
+        EXPECT_GE(coord.y, -1 * pixel);
+        EXPECT_LE(coord.y, 0);
+        EXPECT_EQ(coord.z, 0);
+    }
+}
+
+TEST_F(LightSourceTests, ImageFollowsIntensity) {
+    /// intensity grows linearly along x, mean of x is 1/6 of the image width from the centre
+    const int size = 50;
+    Matrix<T,Dynamic,Dynamic> image(size, size);
+    for (int i = 0; i < size; i++)
+        for (int j = 0; j < size; j++)
+            image(i, j) = j + T(0.5);
+    const auto source = LightSource<T>::fromImage(image, pixel);
+
+    Math_NS::seedRandom(4);
+    T meanX = 0, meanY = 0;
+    for (const auto& coord: launch(source)) {
+        EXPECT_LE(abs(coord.x), size * pixel / 2);
+        EXPECT_LE(abs(coord.y), size * pixel / 2);
+        meanX += coord.x / N;
+        meanY += coord.y / N;
+    }
+    EXPECT_NEAR(meanX, size * pixel / 6, 0.01 * size * pixel);
+    EXPECT_NEAR(meanY, 0, 0.01 * size * pixel);
+}
+
+TEST_F(LightSourceTests, FlatRadialTableIsCircle) {
+    const T R = 2E-3;
+    const auto table = LightSource<T>::fromRadialTable({{0, 1}, {0.5E-3, 1}, {1.2E-3, 1}, {R, 1}});
+    const LightSource<T> circle(R, SourceType::Circle);
+    EXPECT_EQ(table.getType(), SourceType::RadialTable);
+    EXPECT_EQ(table.getRadius(), R);
+
+    Math_NS::seedRandom(5);
+    T tableR2 = 0, circleR2 = 0;
+    for (const auto& coord: launch(table)) {
+        EXPECT_LE(coord.norm(), R * (1 + 1E-12));
+        tableR2 += coord.norm2() / N;
+    }
+    for (const auto& coord: launch(circle)) {
+        EXPECT_LE(coord.norm(), R * (1 + 1E-12));
+        circleR2 += coord.norm2() / N;
+    }
+    EXPECT_NEAR(tableR2 , R * R / 2, 0.01 * R * R);
+    EXPECT_NEAR(circleR2, R * R / 2, 0.01 * R * R);
+}
+
+TEST_F(LightSourceTests, RadialTableRings) {
+    /// no power inside 1 mm
+    const auto source = LightSource<T>::fromRadialTable({{0, 0}, {1E-3, 0}, {2E-3, 3}, {3E-3, 3}});
+    Math_NS::seedRandom(6);
+    for (const auto& coord: launch(source, 10000)) {
+        EXPECT_GE(coord.norm(), 1E-3 * (1 - 1E-12));
+        EXPECT_LE(coord.norm(), 3E-3 * (1 + 1E-12));
+    }
+
+    /// beam profile of the table is interpolated between its points
+    const auto beam = BeamProfile<T>::fromLightSource(source, 30);
+    EXPECT_DOUBLE_EQ(beam.getMaxRadius(), 3E-3);
+    for (int m = 0; m < 10; m++)
+        EXPECT_EQ(beam.getPower(m), 0);
+    EXPECT_LT(beam.getPower(10) / (21 * 21 - 20 * 20), beam.getPower(19) / (20 * 20 - 19 * 19));
+    EXPECT_NEAR(beam.getPower(25) / (26 * 26 - 25 * 25), beam.getPower(29) / (30 * 30 - 29 * 29), 1E-12);
+}
+
+TEST_F(LightSourceTests, BulkMatchesSingleLaunches) {
+    const LightSource<T> gaussian(1E-3, SourceType::Gaussian);
+
+    Math_NS::seedRandom(7);
+    T singleR2 = 0;
+    for (int i = 0; i < N; i++)
+        singleR2 += gaussian.getPhotonCoord().norm2() / N;
+    T bulkR2 = 0;
+    for (const auto& coord: launch(gaussian))
+        bulkR2 += coord.norm2() / N;
+    EXPECT_NEAR(singleR2, 1E-6, 0.02E-6);
+    EXPECT_NEAR(bulkR2  , 1E-6, 0.02E-6);
+
+    for (const auto& coord: launch(LightSource<T>(0, SourceType::Point), 100))
+        EXPECT_EQ(coord.norm(), 0);
+}
+
+TEST_F(LightSourceTests, IrradianceHasUnitPower) {
+    Matrix<T,Dynamic,Dynamic> image = Matrix<T,Dynamic,Dynamic>::Zero(4, 6);
+    image(1, 4) = 5;
+    image(2, 0) = 1;
+    const vector<LightSource<T>> sources = {
+        LightSource<T>(1E-3, SourceType::Circle),
+        LightSource<T>(1E-3, SourceType::Gaussian),
+        LightSource<T>::fromImage(image, 5 * pixel),
+        LightSource<T>::fromRadialTable({{0, 1}, {1E-3, 2}, {2E-3, 0}}),
+    };
+
+    /// midpoints of a grid over 4 mm x 4 mm
+    const int cells = 800;
+    const T side = 4E-3 / cells;
+    for (const auto& source: sources) {
+        T power = 0;
+        for (int i = 0; i < cells; i++)
+            for (int j = 0; j < cells; j++)
+                power += source.irradiance((i + T(0.5)) * side - 2E-3, (j + T(0.5)) * side - 2E-3) * side * side;
+        EXPECT_NEAR(power, 1, 1E-2);
+    }
+
+    EXPECT_DOUBLE_EQ(sources[0].irradiance(0.5E-3, 0.5E-3), 1 / (M_PI * 1E-6));
+    EXPECT_EQ(sources[0].irradiance(1E-3, 0.5E-3), 0);
+    /// pixel (1, 4) holds 5/6 of power
+    EXPECT_DOUBLE_EQ(sources[2].irradiance(7.5 * pixel, -2.5 * pixel), 5.0 / 6 / Math_NS::sqr(5 * pixel));
+    EXPECT_EQ(LightSource<T>(0, SourceType::Point).irradiance(0, 0), 0);
+}
+
+TEST_F(LightSourceTests, Throws) {
+    EXPECT_THROW(LightSource<T>::fromImage(Matrix<T,Dynamic,Dynamic>::Ones(3, 3), 0), invalid_argument);
+    EXPECT_THROW(LightSource<T>::fromImage(Matrix<T,Dynamic,Dynamic>(), pixel), invalid_argument);
+    EXPECT_THROW(LightSource<T>::fromImage(-Matrix<T,Dynamic,Dynamic>::Ones(3, 3), pixel), invalid_argument);
+
+    EXPECT_THROW(LightSource<T>::fromRadialTable({{0, 1}}), invalid_argument);
+    EXPECT_THROW(LightSource<T>::fromRadialTable({{0, 1}, {1E-3, 1}, {1E-3, 1}}), invalid_argument);
+    EXPECT_THROW(LightSource<T>::fromRadialTable({{0, 1}, {1E-3, -1}}), invalid_argument);
+    EXPECT_THROW(LightSource<T>::fromRadialTable({{0, 0}, {1E-3, 0}}), invalid_argument);
+
+    const auto image = LightSource<T>::fromImage(Matrix<T,Dynamic,Dynamic>::Ones(3, 3), pixel);
+    EXPECT_THROW(BeamProfile<T>::fromLightSource(image), invalid_argument);
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "../Utils/Contracts.h"
+
+#include <algorithm>
+#include <vector>
+
+/// \brief Coarse grid of local majorant attenuations over the voxels of a heterogeneous volume
+/// Every macro cell covers cellSize^3 voxels and stores the maximal mut over them and their direct neighbours.
+/// The one voxel margin keeps the majorant conservative when a photon on a macro cell border
+/// is rounded into the voxel of the neighbouring cell, so delta tracking with local majorants stays unbiased.
+/// Cell x and y indices are in [0, getNxy()), z index is in [0, getNz()).
+template < typename T >
+class MajorantGrid {
+public:
+    MajorantGrid() noexcept = default;
+
+    /// \param[in] volume voxel volume with getNz(), getSide() and operator () (x, y, z).mut
+    /// \param[in] newCellSize macro cell edge in voxels
+    /// \throw std::invalid_argument if ENABLE_CHECK_CONTRACTS is defined and newCellSize is not positive
+    template < typename Volume >
+    MajorantGrid(const Volume& volume, const int& newCellSize) EXCEPT_INPUT_PARAMS;
+    ~MajorantGrid() noexcept = default;
+
+    /// Local majorant attenuation
+    /// \param[in] x macro cell x index
+    /// \param[in] y macro cell y index
+    /// \param[in] z macro cell z index
+    /// \return maximal mut in macro cell
+    inline T operator () (const int& x, const int& y, const int& z) const noexcept { return majorants[index(x, y, z)]; }
+
+    /// Macro cell containing voxel
+    /// \param[in] voxel voxel index along any axis
+    /// \return macro cell index along the same axis
+    inline int cell(const int& voxel) const noexcept { return voxel / cellSize; }
+
+    inline int getCellSize() const noexcept { return cellSize; }
+    inline int getNxy()      const noexcept { return Nxy;      }
+    inline int getNz()       const noexcept { return Nz;       }
+
+protected:
+    inline size_t index(const int& x, const int& y, const int& z) const noexcept {
+        return (static_cast<size_t>(z) * Nxy + x) * Nxy + y;
+    }
+
+    int cellSize = 1;
+    int Nxy = 0;
+    int Nz = 0;
+    std::vector<T> majorants;
+};
+
+/******************
+ * IMPLEMENTATION *
+ ******************/
+
+template < typename T >
+template < typename Volume >
+MajorantGrid<T>::MajorantGrid(const Volume& volume, const int& newCellSize) EXCEPT_INPUT_PARAMS
+    : cellSize(newCellSize) {
+    using namespace std;
+
+    CHECK_ARGUMENT_CONTRACT(cellSize > 0);
+
+    const int side = volume.getSide();
+    const int Nvz = volume.getNz();
+    Nxy = (side + cellSize - 1) / cellSize;
+    Nz  = (Nvz  + cellSize - 1) / cellSize;
+    majorants.assign(static_cast<size_t>(Nz) * Nxy * Nxy, 0);
+
+    for (int k = 0; k < Nvz; k++)
+        for (int i = 0; i < side; i++)
+            for (int j = 0; j < side; j++) {
+                const T mut = volume(i, j, k).mut;
+                /// voxel contributes to every cell its 3x3x3 neighbourhood touches
+                for (int cz = cell(max(k - 1, 0)); cz <= cell(min(k + 1, Nvz - 1)); cz++)
+                    for (int cx = cell(max(i - 1, 0)); cx <= cell(min(i + 1, side - 1)); cx++)
+                        for (int cy = cell(max(j - 1, 0)); cy <= cell(min(j + 1, side - 1)); cy++) {
+                            T& majorant = majorants[index(cx, cy, cz)];
+                            majorant = max(majorant, mut);
+                        }
+            }
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#ifndef ENABLE_CHECK_CONTRACTS
+    #define ENABLE_CHECK_CONTRACTS
+#endif // ENABLE_CHECK_CONTRACTS
+
+#include "HeterogeneousVolume.h"
+#include "MajorantGrid.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+using namespace Eigen;
+using namespace std;
+
+class MajorantGridTests : public ::testing::Test {
+protected:
+    static constexpr int Nz = 9;
+    static constexpr int Nr = 12;
+
+    /// native tissue with coagulated core on the axis at the top
+    Matrix<double, Dynamic, Dynamic> coag() const {
+        Matrix<double, Dynamic, Dynamic> coag = Matrix<double, Dynamic, Dynamic>::Ones(Nz, Nr);
+        coag.topLeftCorner(3, 3).setConstant(0.2);
+        return coag;
+    }
+};
+
+TEST_F(MajorantGridTests, Dimensions) {
+    HeterogeneousVolume<double> volume(coag());
+    MajorantGrid<double> grid(volume, 4);
+    EXPECT_EQ(grid.getCellSize(), 4);
+    EXPECT_EQ(grid.getNxy(), 6); // 23 voxels
+    EXPECT_EQ(grid.getNz(), 3);  // 9 voxels
+    EXPECT_EQ(grid.cell(0), 0);
+    EXPECT_EQ(grid.cell(3), 0);
+    EXPECT_EQ(grid.cell(4), 1);
+}
+
+TEST_F(MajorantGridTests, BoundsVoxelsAndTheirNeighbours) {
+    HeterogeneousVolume<double> volume(coag());
+    MajorantGrid<double> grid(volume, 4);
+    const int side = volume.getSide();
+    for (int k = 0; k < Nz; k++)
+        for (int i = 0; i < side; i++)
+            for (int j = 0; j < side; j++)
+                for (int dk = -1; dk <= 1; dk++)
+                    for (int di = -1; di <= 1; di++)
+                        for (int dj = -1; dj <= 1; dj++) {
+                            const int nk = clamp(k + dk, 0, Nz - 1);
+                            const int ni = clamp(i + di, 0, side - 1);
+                            const int nj = clamp(j + dj, 0, side - 1);
+                            EXPECT_GE(grid(grid.cell(i), grid.cell(j), grid.cell(k)), volume(ni, nj, nk).mut);
+                        }
+}
+
+TEST_F(MajorantGridTests, LocalMajorantIsLowerAwayFromCore) {
+    HeterogeneousVolume<double> volume(coag());
+    const auto& grid = volume.getMajorantGrid();
+    EXPECT_EQ(grid.getCellSize(), HeterogeneousVolume<double>::MACRO_CELL_SIZE);
+
+    const int center = grid.cell(Nr - 1);
+    EXPECT_DOUBLE_EQ(grid(center, center, 0), volume.getMajorant());
+    EXPECT_DOUBLE_EQ(grid(0, 0, grid.getNz() - 1), MaterialProperties<double>::fromCoag(1.0, 1.0).mut);
+    EXPECT_LT(grid(0, 0, grid.getNz() - 1), volume.getMajorant());
+}
+
+TEST_F(MajorantGridTests, ThrowsForNonPositiveCellSize) {
+    HeterogeneousVolume<double> volume(coag());
+    EXPECT_THROW(MajorantGrid<double>(volume, 0), invalid_argument);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Medium.h"
+
+/// \brief Precomputed optical properties of one material of a heterogeneous sample
+template < typename T >
+struct MaterialProperties {
+    T mua = 0; ///< absorption coefficient
+    T mus = 0; ///< scattering coefficient
+    T mut = 0; ///< total attenuation coefficient = mua + mus
+    T g   = 0; ///< scattering anisotropy
+    T n   = 1; ///< refraction coefficient
+
+    /// Material from optical coefficients
+    /// \param[in] newMua absorption coefficient
+    /// \param[in] newMus scattering coefficient
+    /// \param[in] newG scattering anisotropy
+    /// \param[in] newN refraction coefficient
+    /// \return material with total attenuation evaluated
+    static MaterialProperties fromCoeffs(const T& newMua, const T& newMus, const T& newG, const T& newN) noexcept {
+        return MaterialProperties{newMua, newMus, newMua + newMus, newG, newN};
+    }
+
+    /// Material of tissue with coagulation degree, evaluated with uaFunc, usFunc and gFunc
+    /// \param[in] coag coagulation degree, 1 is native tissue
+    /// \param[in] newN refraction coefficient
+    /// \return material of tissue with coagulation degree
+    static MaterialProperties fromCoag(const T& coag, const T& newN) noexcept {
+        return fromCoeffs(uaFunc<T>(coag), usFunc<T>(coag), gFunc<T>(coag), newN);
+    }
+};
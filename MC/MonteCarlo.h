@@ -1,13 +1,28 @@
 #pragma once
 
+#include "AngularBiasing.h"
+#include "BeamProfile.h"
 #include "Detector.h"
+#include "DiffusionHandoff.h"
+#include "HeterogeneousVolume.h"
+#include "InclusionScene.h"
+#include "LayerTable.h"
+#include "TrackingMode.h"
 #include "Medium.h"
 #include "Photon.h"
 #include "Sample.h"
+#include "Spectrum.h"
 #include "LightSource.h"
+#include "TallyPolicy.h"
+#include "WeightWindows.h"
+#include "Detector/DetectorBatch.h"
+#include "Detector/IntegratingSphereComplex.h"
+#include "Detector/OpticalFiber.h"
 
 #include "../Math/Basic.h"
+#include "../Math/FastMath.h"
 #include "../Math/Random.h"
+#include "../Math/Sobol.h"
 #include "../Math/Bresenham.h"
 #include "../Physics/BugerLambert.h"
 #include "../Physics/Reflectance.h"
@@ -16,10 +31,12 @@
 #include "../eigen/Eigen/Dense"
 
 #include <iostream>
+#include <limits>
 #include <math.h>
 #include <tgmath.h>
 #include <map>
 #include <chrono>
+#include <type_traits>
 
 using namespace Eigen;
 
@@ -55,6 +72,9 @@ struct MCresults {
     /// TODO: structs instead of pair
     std::vector<std::pair<T,T>> detectedR;
     std::vector<std::pair<T,T>> detectedT;
+    /// variance of detectedR and detectedT, from squares of weights every photon brings to a sphere
+    std::vector<std::pair<T,T>> detectedRvariance;
+    std::vector<std::pair<T,T>> detectedTvariance;
 };
 
 template < typename T, size_t Nz, size_t Nr, bool detector >
@@ -75,20 +95,121 @@ std::ostream& operator << (std::ostream& os, const MCresults<T,Nz,Nr,detector>&
     return os;
 }
 
-template < typename T, size_t Nz, size_t Nr, bool detector>
+/// Tallies is TallyPolicy, tallies it disables are compiled out and left empty in results
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies = FullTallies>
 class MonteCarlo {
 public:
     MonteCarlo() noexcept = delete;
     MonteCarlo(const Sample<T>& sample, const int& Np, const T& z, const T& r, const IntegratingSphere<T>& sphereR, const IntegratingSphere<T>& sphereT,
                const DetectorDistance<T> dist, const LightSource<T>& source);
     MonteCarlo(const Sample<T>& sample, const int& Np, const T& z, const T& r, const IntegratingSphere<T>& sphereR, const IntegratingSphere<T>& sphereT,
-               const DetectorDistance<T> dist, const LightSource<T>& source, const Matrix<T,Dynamic,Dynamic>& coagMatrix);
+               const DetectorDistance<T> dist, const LightSource<T>& source, const Matrix<T,Dynamic,Dynamic>& coagMatrix,
+               const TrackingMode& tracking = TrackingMode::VoxelWalk);
+    MonteCarlo(const Sample<T>& sample, const int& Np, const T& z, const T& r, const IntegratingSphere<T>& sphereR, const IntegratingSphere<T>& sphereT,
+               const DetectorDistance<T> dist, const LightSource<T>& source, std::shared_ptr<const HeterogeneousVolume<T>> volume,
+               const TrackingMode& tracking = TrackingMode::VoxelWalk) EXCEPT_INPUT_PARAMS;
+    MonteCarlo(const Sample<T>& sample, const int& Np, const T& z, const T& r, const IntegratingSphere<T>& sphereR, const IntegratingSphere<T>& sphereT,
+               const DetectorDistance<T> dist, const LightSource<T>& source, std::shared_ptr<const InclusionScene<T>> inclusions) EXCEPT_INPUT_PARAMS;
+    /// Single-path multi-wavelength run on homogeneous layers,
+    /// sample gives scattering, refraction and geometry, its absorption is replaced with spectrum,
+    /// spectral runs record FullTallies only
+    /// \throw std::invalid_argument if ENABLE_CHECK_CONTRACTS is defined and spectrum does not match sample layers,
+    /// has absorption in glass or any tissue layer does not scatter
+    MonteCarlo(const Sample<T>& sample, const int& Np, const T& z, const T& r, const IntegratingSphere<T>& sphereR, const IntegratingSphere<T>& sphereT,
+               const DetectorDistance<T> dist, const LightSource<T>& source, const Spectrum<T>& spectrum) EXCEPT_INPUT_PARAMS;
     //MonteCarlo(const Sample<T>& sample, const int& Np, const T& z, const T& r, const OpticalFiber<T>& fiberR, const OpticalFiber<T>& fiberT, const DetectorDistance<T> dist);
     ~MonteCarlo() noexcept = default;
 
     /// TODO: Why not return result?
     void Calculate(MCresults<T,Nz,Nr,detector>& res);
     MCresults<T,Nz,Nr,detector> CalculateResult();
+    /// Run simulation and split results over wavelengths of spectrum, empty if there is no spectrum,
+    /// Calculate on a spectral run gives the same paths without absorption
+    std::vector<MCresults<T,Nz,Nr,detector>> CalculateSpectrum();
+    /// Run simulation from point source once and get results for every beam in the same order.
+    /// Radial tallies and absorption grid are convolved with beam kernels, sphere signals are collected
+    /// from every exit photon shifted by an offset sampled from every beam
+    /// \throw std::invalid_argument if ENABLE_CHECK_CONTRACTS is defined and light source is not a point,
+    /// sample is not homogeneous or run is spectral
+    std::vector<MCresults<T,Nz,Nr,detector>> CalculateBeams(const std::vector<BeamProfile<T>>& beams) EXCEPT_INPUT_PARAMS;
+
+    /// Detectors of reflected and transmitted photons, several detectors can be added to each side.
+    /// Exit photons are handed to them in batches and they are calibrated by the number of photons at the end of Calculate
+    /// \throw std::invalid_argument if ENABLE_CHECK_CONTRACTS is defined and detector is nullptr
+    void addDetectorR(std::shared_ptr<MonteCarlo_NS::DetectorInterface<T>> newDetector) EXCEPT_INPUT_PARAMS;
+    void addDetectorT(std::shared_ptr<MonteCarlo_NS::DetectorInterface<T>> newDetector) EXCEPT_INPUT_PARAMS;
+
+    /// Optical fibers on the top and the bottom of the sample, several fibers can be added to each side.
+    /// They see exit photons directly unless setFiberEstimator tallies their signal at scattering events,
+    /// and they are calibrated by the number of photons at the end of Calculate
+    /// \throw std::invalid_argument if ENABLE_CHECK_CONTRACTS is defined and fiber is nullptr
+    void addFiberR(std::shared_ptr<MonteCarlo_NS::OpticalFiber<T>> fiber) EXCEPT_INPUT_PARAMS;
+    void addFiberT(std::shared_ptr<MonteCarlo_NS::OpticalFiber<T>> fiber) EXCEPT_INPUT_PARAMS;
+    /// Next-event estimator of fibers: every scattering event closer than depth to the top or the bottom of the sample
+    /// adds the probability that its photon leaves the sample into the core and the acceptance cone of every fiber on that side
+    /// without further scattering. Exit photons of the flight after such an event are not counted by these fibers again,
+    /// so signals of small-NA fibers need no direct hits
+    /// \param[in] depth distance from the surfaces where events are estimated, 0 counts exit photons only
+    /// \throw std::invalid_argument if ENABLE_CHECK_CONTRACTS is defined and depth is negative, sample is not homogeneous,
+    /// has glass or layers of different refraction coefficients, or run is spectral
+    void setFiberEstimator(const T& depth) EXCEPT_INPUT_PARAMS;
+    /// Adjoint run for one small fiber: Np packets start from the core into the acceptance cone and are traced through
+    /// the same layers and borders as photons. Every scattering event adds the probability to leave the sample along the beam
+    /// times irradiance of the light source above it, so the signal comes from overlap of adjoint light with the beam profile,
+    /// by reciprocity it is the signal of the fiber in a forward run. Unscattered light, specular reflection and ballistic
+    /// transmission, is added from irradiance at launch points. Tallies of the object then hold adjoint packets,
+    /// forward runs need another object
+    /// \param[in] fiber fiber whose signal is calculated
+    /// \param[in] reflection fiber is on the top of the sample, otherwise on the bottom
+    /// \return signal of fiber per unit power of the light source
+    /// \throw std::invalid_argument if ENABLE_CHECK_CONTRACTS is defined and light source is Point, sample is not homogeneous,
+    /// has glass or layers of different refraction coefficients, run is spectral or quasi-random, has fibers or diffusion handoff
+    T CalculateAdjoint(const MonteCarlo_NS::OpticalFiber<T>& fiber, const bool& reflection = true) EXCEPT_INPUT_PARAMS;
+
+    /// Bias scattering near the sample surfaces toward ports of spheres, see AngularBiasing
+    /// \throw std::invalid_argument if ENABLE_CHECK_CONTRACTS is defined and probability is not in [0, 1],
+    /// depth is negative, margin is less than 1 or sample is not homogeneous
+    void setAngularBiasing(const AngularBiasing<T>& newBiasing) EXCEPT_INPUT_PARAMS;
+
+    /// Split and roulette photons in tissue by windows of their z/r bins instead of the fixed roulette
+    /// \throw std::invalid_argument if ENABLE_CHECK_CONTRACTS is defined and windows are not Nz x Nr or negative,
+    /// ratio is not greater than 1, maxSplit is less than 1, sample is not homogeneous or run is spectral
+    void setWeightWindows(const WeightWindows<T>& newWindows) EXCEPT_INPUT_PARAMS;
+    /// Windows from fluence of a short run with the same sample, grid, spheres and source.
+    /// Bins of one depth share the window of fluence summed over rings, so photons are split on their way down
+    /// rather than sideways
+    /// \param[in] pilotPhotons photons of the pilot run
+    /// \param[in] ratio upper bound of window over lower one
+    /// \param[in] maxSplit copies of one splitting, at most
+    /// \return windows which keep the number of photons at every depth uniform, see WeightWindows::fromFluence
+    /// \throw std::invalid_argument if ENABLE_CHECK_CONTRACTS is defined and pilotPhotons is not positive,
+    /// sample is not homogeneous or pilot photons were not absorbed
+    WeightWindows<T> PilotWeightWindows(const int& pilotPhotons, const T& ratio = 5, const int& maxSplit = 10) const EXCEPT_INPUT_PARAMS;
+
+    /// Send both reflected and transmitted parts of photons at internal boundaries on as separate packets,
+    /// instead of choosing one of them at random. Packets split at most maxSplits times, then choose at random
+    /// \param[in] newMaxSplits splittings of a packet and its ancestors, 0 disables splitting
+    /// \param[in] minReflectance boundaries reflecting less still choose at random, the choice adds little variance there
+    /// \throw std::invalid_argument if ENABLE_CHECK_CONTRACTS is defined and newMaxSplits is negative,
+    /// minReflectance is not in [0, 1), sample is not homogeneous or run is spectral
+    void setBoundarySplitting(const int& newMaxSplits, const T& minReflectance = 0.05) EXCEPT_INPUT_PARAMS;
+
+    /// Hand deep photons of optically thick layers off to diffusion, see DiffusionHandoff.
+    /// Events which jump are not estimated for fibers, photons after a jump reach them by direct hits.
+    /// Adjoint runs reject the handoff
+    /// \throw std::invalid_argument if ENABLE_CHECK_CONTRACTS is defined and depth or margin is negative,
+    /// depth is not greater than margin, scatterings is negative, sample is not homogeneous or run is spectral
+    void setDiffusionHandoff(const DiffusionHandoff<T>& newHandoff) EXCEPT_INPUT_PARAMS;
+
+    /// Take the launch point and the first flights of every photon, steps and scattering angles, from a scrambled Sobol point
+    /// indexed by photon number, the rest of its random decisions come from the pseudo-random stream.
+    /// Scrambling is seeded from the random stream of the thread, so runs of one seed repeat and runs of different seeds are independent.
+    /// Thin samples gain the most, their signals are decided within a few flights
+    /// \param[in] flights quasi-random flights of every photon, 0 keeps the pseudo-random launch point too
+    /// \throw std::invalid_argument if ENABLE_CHECK_CONTRACTS is defined and flights is not in [0, QUASI_FLIGHTS] or sample is not homogeneous
+    void setQuasiRandom(const int& flights = QUASI_FLIGHTS) EXCEPT_INPUT_PARAMS;
+    /// flights of a photon which Sobol points have dimensions for
+    static constexpr int QUASI_FLIGHTS = (Math_NS::ScrambledSobol::DIMENSIONS - LightSource<T>::UNIFORMS) / 3;
 
     inline Matrix<T,Dynamic,Dynamic> getMatrixA()    const noexcept { return A;            }
     inline Matrix<T,Dynamic,Dynamic> getArrayR()     const noexcept { return RR;           }
@@ -99,6 +220,8 @@ public:
 
 protected:
     const Sample<T>& sample;
+    /// layers of sample read by transport, without absorption in spectral runs
+    const LayerTable<T> layers;
     const LightSource<T>& lightSource;
 
     const int Nphotons;
@@ -108,17 +231,21 @@ protected:
     const T chance;
     const T threshold;
     const T radius;
+    /// escape through glass is recorded term by term until the rest is below this part of the entering weight
+    static constexpr T GLASS_TAIL = 1E-6;
 
     bool debug = 0;
     int debugPhoton = 0;
 
-    Matrix<T,Dynamic,Dynamic> A = Matrix<T, Nz, Nr>::Constant(0.0);
+    Matrix<T,Dynamic,Dynamic> A = Matrix<T,Dynamic,Dynamic>::Zero(Tallies::absorptionGrid ? Nz : 0, Tallies::absorptionGrid ? Nr : 0);
+    /// absorbed weight of all photons when absorption grid is not tallied
+    T absorbedWeight = 0;
     Matrix<T,1,Dynamic> RR = Matrix<T, 1, Nr>::Constant(0.0);
     Matrix<T,1,Dynamic> RRspecular = Matrix<T, 1, Nr>::Constant(0.0);
     Matrix<T,1,Dynamic> TT = Matrix<T, 1, Nr>::Constant(0.0);
 
-    Matrix<T,1,Dynamic> arrayAnglesR = Matrix<T, 1, 100>::Constant(0);
-    Matrix<T,1,Dynamic> arrayAnglesT = Matrix<T, 1, 100>::Constant(0);
+    Matrix<T,1,Dynamic> arrayAnglesR = Matrix<T,1,Dynamic>::Zero(Tallies::angles ? 100 : 0);
+    Matrix<T,1,Dynamic> arrayAnglesT = Matrix<T,1,Dynamic>::Zero(Tallies::angles ? 100 : 0);
 
     IntegratingSphere<T> mainSphereR;
     IntegratingSphere<T> mainSphereT;
@@ -132,23 +259,106 @@ protected:
 
     DetectorDistance<T> distances;
 
+    /// exit photons buffered for detectors added with addDetectorR and addDetectorT
+    MonteCarlo_NS::DetectorBatch<T> detectorsR;
+    MonteCarlo_NS::DetectorBatch<T> detectorsT;
+    std::vector<std::shared_ptr<MonteCarlo_NS::OpticalFiber<T>>> fibersR;
+    std::vector<std::shared_ptr<MonteCarlo_NS::OpticalFiber<T>>> fibersT;
+    /// scattering events closer than this to the surfaces are estimated for fibers
+    T fiberDepth = 0;
+    /// CalculateAdjoint traces adjoint packets, their scattering events are scored toward the light source
+    bool adjoint = false;
+    T adjointSignal = 0;
+
     const bool homogenous;
-    const Matrix<T,Dynamic,Dynamic> heterogeneousMatrix2D;
-    const std::vector<Matrix<T,Dynamic,Dynamic>> heterogeneousMatrix3D;
-    std::vector<Matrix<T, Dynamic, Dynamic>> getHeterogeneousMatrix3D();
+    /// coag volume shared between all workers, nullptr for homogenous samples
+    const std::shared_ptr<const HeterogeneousVolume<T>> volume;
+    const TrackingMode tracking = TrackingMode::VoxelWalk;
+    const std::shared_ptr<const InclusionScene<T>> inclusions;
+    /// voxels crossed by the current flight in heterogeneous tissue, reserved for the longest flight so transport never allocates
+    std::vector<Vector3D<int>> trajectory;
+    /// launch points of the next photons, generated in bulk by the light source
+    static constexpr int LAUNCH_BATCH = 256;
+    std::vector<Vector3D<T>> launchPoints = std::vector<Vector3D<T>>(LAUNCH_BATCH);
+
+    /// absorption spectra of single-path multi-wavelength runs, empty otherwise
+    const Spectrum<T> spectrum;
+    const bool spectral = false;
+    /// attenuation of the current photon for every wavelength
+    typename Spectrum<T>::Lanes lanes;
+    /// per wavelength tallies, Nwavelengths x (Nz * Nr) for A, Nwavelengths x bins for the rest
+    Matrix<T,Dynamic,Dynamic> spectralA;
+    Matrix<T,Dynamic,Dynamic> spectralRR;
+    Matrix<T,Dynamic,Dynamic> spectralTT;
+    Matrix<T,Dynamic,Dynamic> spectralAnglesR;
+    Matrix<T,Dynamic,Dynamic> spectralAnglesT;
+    Matrix<T,Dynamic,Dynamic> spectralDetectedR;
+    Matrix<T,Dynamic,Dynamic> spectralDetectedT;
+    /// spheres at every distance of SpheresArrayR and SpheresArrayT, fed by detectorsR and detectorsT,
+    /// spectral and beam runs also catch light of every exit photon with them directly
+    std::shared_ptr<MonteCarlo_NS::IntegratingSphereComplex<T>> spheresR;
+    std::shared_ptr<MonteCarlo_NS::IntegratingSphereComplex<T>> spheresT;
+
+    AngularBiasing<T> biasing;
+    /// borders of the scattering part of sample, depth of biasing is measured from them
+    T turbidTop = 0;
+    T turbidBottom = 0;
+    /// cones toward ports of the current scattering event, reserved for all spheres
+    std::vector<BiasCone<T>> cones;
+    /// branch split off by BiasedSpin is traced, it does not split again
+    bool tracingBranch = false;
+
+    WeightWindows<T> windows;
+    int maxBoundarySplits = 0;
+    T minSplitReflectance = 0;
+    /// disabled until setDiffusionHandoff
+    DiffusionHandoff<T> handoff{0};
+    /// copies of split photons waiting to be traced, they belong to the current history
+    std::vector<Photon<T>> secondaries;
+    static constexpr int SECONDARY_RESERVE = 1024;
+
+    int quasiFlights = 0;
+    Math_NS::ScrambledSobol sobol;
+    /// decisions of a flight, Sobol points hold the launch point and then these three numbers for every flight
+    enum Decision { STEP = 0, COS = 1, PHI = 2 };
+    /// Sobol point of the current photon and decisions of every kind it took
+    std::uint32_t quasiPoint = 0;
+    int quasiDecisions[3] = {0, 0, 0};
+
+    /// Uniform number of a decision of the current photon, Sobol coordinate during its first quasiFlights flights, pseudo-random after them
+    inline T Uniform(const Decision& decision);
+    Vector3D<T> QuasiLaunchPoint(const int& num) const;
+
+    /// beams of CalculateBeams, empty otherwise
+    std::vector<BeamProfile<T>> beams;
+    /// sphere signals of every beam, Nbeams x Nspheres
+    Matrix<T,Dynamic,Dynamic> beamDetectedR;
+    Matrix<T,Dynamic,Dynamic> beamDetectedT;
 
     void GenerateDetectorArrays();
-    void PhotonDetectionSphereR(Photon<T>& exit_photon);
-    void PhotonDetectionSphereT(Photon<T>& exit_photon);
+    /// exit angle of photon into angles, spheres get exit photons through detectorsR and detectorsT
+    void RecordAngle(const Photon<T>& exit_photon, Matrix<T,1,Dynamic>& angles);
+    /// sphere signals of beams from exit photon of point source
+    void BeamDetectionR(const Photon<T>& exit_photon);
+    void BeamDetectionT(const Photon<T>& exit_photon);
+    int AngleBin(const Vector3D<T>& direction);
+    void SpectralDetection(const Photon<T>& exit_photon, Matrix<T,Dynamic,Dynamic>& angles, const std::vector<T>& caught, Matrix<T,Dynamic,Dynamic>& detected);
 
     void FirstReflection(Photon<T>& photon);
 
     void HopDropSpin(Photon<T>& photon);
     void HopInGlass(Photon<T>& photon);
+    /// Resolve reflections inside glass at the sample border in closed form:
+    /// escape through the outer face is recorded term by term at its exit points,
+    /// the photon re-enters the inner layer with the rest of its weight at a sampled exit point
+    void TransferThroughGlass(Photon<T>& photon);
     void HopDropSpinInTissue(Photon<T>& photon);
     void HopDropSpinInHeterogeneousTissue(Photon<T>& photon);
+    void HopDropSpinInHeterogeneousTissueWoodcock(Photon<T>& photon);
+    void HopDropSpinInHeterogeneousTissueMacroCell(Photon<T>& photon);
+    void HopDropSpinInInclusions(Photon<T>& photon);
 
-    std::vector<Vector3D<int>> TrajectoryArrayInt(Photon<T>& photon, Vector3D<T>& finalBorderPoint);
+    void TrajectoryArrayInt(Photon<T>& photon, Vector3D<T>& finalBorderPoint, std::vector<Vector3D<int>>& trajectoryArrayInt);
     void InnerBordersArray(Photon<T>& photon, std::vector<Vector3D<T>>& bordersArray, std::vector<T>& attCoeffs);
     void HopInHeterogeneousTissue(Photon<T>& photon, const std::vector<Vector3D<T>>& bordersArray, const std::vector<T>& attCoeffs);
     void HopInHeterogeneousTissueNoBorder(Photon<T>& photon);
@@ -160,16 +370,42 @@ protected:
     void RecordT(Photon<T>& photon, const T& FRefl, const T& cosT);
 
     void Hop(Photon<T>& photon);
+    void AbsorbSpectrum(const Photon<T>& photon);
     void Drop(Photon<T>& photon);
+    void Drop(Photon<T>& photon, const MaterialProperties<T>& material);
+    /// Tally weight absorbed at coordinate
+    void Absorb(const Photon<T>& photon, const Vector3D<T>& coordinate, const T& weight);
     void Spin(Photon<T>& photon);
+    void Spin(Photon<T>& photon, const T& g);
+    void BiasedSpin(Photon<T>& photon);
+    /// Jump of photon over a sphere of diffusion instead of scattering, if it is deep enough
+    /// \return photon jumped
+    bool DiffusionJump(Photon<T>& photon);
+    /// Expected signals of fibers from the scattering event of photon, it has dropped its weight and has not spun yet
+    void EstimateFibers(Photon<T>& photon);
+    /// \return expected weight of photon which leaves the sample into fiber after scattering, with no further interaction
+    T ExpectedFiberSignal(const Photon<T>& photon, const MonteCarlo_NS::OpticalFiber<T>& fiber, const bool& up) const;
+    /// Adds expected weight of adjoint packet which leaves the top along the normal after scattering, times irradiance of the light source there
+    void ScoreAdjoint(const Photon<T>& photon);
+    /// \return optical depth of layers between z and surface along the normal
+    T OpticalDepth(const T& z, const T& surface) const;
+    MaterialProperties<T> LocalMaterial(const Photon<T>& photon);
 
     bool HitBoundary(Photon<T>& photon);
     void CrossOrNot(Photon<T>& photon);
     void CrossUpOrNot(Photon<T>& photon);
     void CrossDownOrNot(Photon<T>& photon);
+    /// Reflected part of photon at internal boundary goes to secondaries if the photon may split
+    /// \param[in,out] photon photon at boundary, keeps the transmitted part after splitting
+    /// \param[in] Ri Fresnel reflectance
+    /// \return photon is split
+    bool SplitAtBoundary(Photon<T>& photon, const T& Ri);
 
     void Roulette(Photon<T>& photon);
-    void Simulation(Photon<T>& photon, const int& num);
+    void ApplyWeightWindow(Photon<T>& photon);
+    void Simulation(Photon<T>& photon, const int& num, const Vector3D<T>& startCoord);
+    /// Trace photons [first, last), transport does not allocate once buffers of the first photons are grown
+    void TracePhotons(const int& first, const int& last);
 
     T Volume(const T& ir);
     T Area(const T& ir);
@@ -179,11 +415,12 @@ protected:
     MCresults<T,Nz,Nr,detector> results;
 };
 
-template < typename T, size_t Nz, size_t Nr, bool detector>
-MonteCarlo<T,Nz,Nr,detector>::MonteCarlo(const Sample<T>& newSample, const int& Np, const T& z, const T& r,
-                                         const IntegratingSphere<T>& detectorR, const IntegratingSphere<T>& detectorT,
-                                         const DetectorDistance<T> dist, const LightSource<T>& source)
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+MonteCarlo<T,Nz,Nr,detector,Tallies>::MonteCarlo(const Sample<T>& newSample, const int& Np, const T& z, const T& r,
+                                                 const IntegratingSphere<T>& detectorR, const IntegratingSphere<T>& detectorT,
+                                                 const DetectorDistance<T> dist, const LightSource<T>& source)
     : sample(newSample)
+    , layers(newSample)
     , Nphotons(Np)
     , dx(2 * r / (2 * Nr - 1))
     , dy(2 * r / (2 * Nr - 1))
@@ -200,11 +437,21 @@ MonteCarlo<T,Nz,Nr,detector>::MonteCarlo(const Sample<T>& newSample, const int&
     GenerateDetectorArrays();
 }
 
-template < typename T, size_t Nz, size_t Nr, bool detector>
-MonteCarlo<T,Nz,Nr,detector>::MonteCarlo(const Sample<T>& newSample, const int& Np, const T& z, const T& r,
-                                         const IntegratingSphere<T>& detectorR, const IntegratingSphere<T>& detectorT,
-                                         const DetectorDistance<T> dist, const LightSource<T>& source, const Matrix<T,Dynamic,Dynamic>& coagMatrix)
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+MonteCarlo<T,Nz,Nr,detector,Tallies>::MonteCarlo(const Sample<T>& newSample, const int& Np, const T& z, const T& r,
+                                                 const IntegratingSphere<T>& detectorR, const IntegratingSphere<T>& detectorT,
+                                                 const DetectorDistance<T> dist, const LightSource<T>& source, const Matrix<T,Dynamic,Dynamic>& coagMatrix,
+                                                 const TrackingMode& newTracking)
+    : MonteCarlo(newSample, Np, z, r, detectorR, detectorT, dist, source, HeterogeneousVolume<T>::create(coagMatrix, newSample.getTurbidMedium().getN()), newTracking) {
+}
+
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+MonteCarlo<T,Nz,Nr,detector,Tallies>::MonteCarlo(const Sample<T>& newSample, const int& Np, const T& z, const T& r,
+                                                 const IntegratingSphere<T>& detectorR, const IntegratingSphere<T>& detectorT,
+                                                 const DetectorDistance<T> dist, const LightSource<T>& source,
+                                                 std::shared_ptr<const HeterogeneousVolume<T>> sharedVolume, const TrackingMode& newTracking) EXCEPT_INPUT_PARAMS
     : sample(newSample)
+    , layers(newSample)
     , Nphotons(Np)
     , dx(2 * r / (2 * Nr - 1))
     , dy(2 * r / (2 * Nr - 1))
@@ -217,23 +464,90 @@ MonteCarlo<T,Nz,Nr,detector>::MonteCarlo(const Sample<T>& newSample, const int&
     , distances(dist)
     , lightSource(source)
     , radius(r)
-    , heterogeneousMatrix2D(coagMatrix)
-    , heterogeneousMatrix3D(getHeterogeneousMatrix3D())
-    , homogenous(0) {
+    , homogenous(0)
+    , volume(std::move(sharedVolume))
+    , tracking(newTracking) {
+    CHECK_ARGUMENT_CONTRACT(volume != nullptr);
+    CHECK_ARGUMENT_CONTRACT(volume->matches(Nz, Nr));
+
+    trajectory.reserve(2 * Nr + Nz);
+    GenerateDetectorArrays();
+}
+
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+MonteCarlo<T,Nz,Nr,detector,Tallies>::MonteCarlo(const Sample<T>& newSample, const int& Np, const T& z, const T& r,
+                                                 const IntegratingSphere<T>& detectorR, const IntegratingSphere<T>& detectorT,
+                                                 const DetectorDistance<T> dist, const LightSource<T>& source,
+                                                 std::shared_ptr<const InclusionScene<T>> sharedInclusions) EXCEPT_INPUT_PARAMS
+    : sample(newSample)
+    , layers(newSample)
+    , Nphotons(Np)
+    , dx(2 * r / (2 * Nr - 1))
+    , dy(2 * r / (2 * Nr - 1))
+    , dz(z / Nz)
+    , dr(r / Nr)
+    , chance(0.1)
+    , threshold(1E-4)
+    , mainSphereR(detectorR)
+    , mainSphereT(detectorT)
+    , distances(dist)
+    , lightSource(source)
+    , radius(r)
+    , homogenous(0)
+    , inclusions(std::move(sharedInclusions)) {
+    CHECK_ARGUMENT_CONTRACT(inclusions != nullptr);
+
     GenerateDetectorArrays();
-/*    cerr << coagMatrix << endl;
-    cerr << endl;
-    cerr << heterogeneousMatrix2D << endl;
-    cerr << endl;
-    for (auto x : heterogeneousMatrix3D) {
-        cerr << x << endl;
-        cerr << endl;
-    }*/
+}
+
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+MonteCarlo<T,Nz,Nr,detector,Tallies>::MonteCarlo(const Sample<T>& newSample, const int& Np, const T& z, const T& r,
+                                                 const IntegratingSphere<T>& detectorR, const IntegratingSphere<T>& detectorT,
+                                                 const DetectorDistance<T> dist, const LightSource<T>& source,
+                                                 const Spectrum<T>& newSpectrum) EXCEPT_INPUT_PARAMS
+    : sample(newSample)
+    , layers(newSample, true)
+    , Nphotons(Np)
+    , dx(2 * r / (2 * Nr - 1))
+    , dy(2 * r / (2 * Nr - 1))
+    , dz(z / Nz)
+    , dr(r / Nr)
+    , chance(0.1)
+    , threshold(1E-4)
+    , mainSphereR(detectorR)
+    , mainSphereT(detectorT)
+    , distances(dist)
+    , lightSource(source)
+    , radius(r)
+    , homogenous(1)
+    , spectrum(newSpectrum)
+    , spectral(true) {
+    static_assert(std::is_same_v<Tallies, FullTallies>, "spectral runs record full tallies");
+    CHECK_ARGUMENT_CONTRACT(spectrum.getNlayers() == sample.getNlayers());
+    for (int layer = 0; layer < sample.getNlayers(); layer++) {
+        const auto medium = sample.getMedium(layer);
+        if (medium.getMut() == 0)
+            CHECK_ARGUMENT_CONTRACT((spectrum.getMua(layer) == 0).all());
+        else
+            CHECK_ARGUMENT_CONTRACT(medium.getMus() > 0);
+    }
+
+    GenerateDetectorArrays();
+
+    const int K = spectrum.getNwavelengths();
+    lanes = Spectrum<T>::Lanes::Ones(K);
+    spectralA = Matrix<T,Dynamic,Dynamic>::Zero(K, Nz * Nr);
+    spectralRR = Matrix<T,Dynamic,Dynamic>::Zero(K, Nr);
+    spectralTT = Matrix<T,Dynamic,Dynamic>::Zero(K, Nr);
+    spectralAnglesR = Matrix<T,Dynamic,Dynamic>::Zero(K, arrayAnglesR.size());
+    spectralAnglesT = Matrix<T,Dynamic,Dynamic>::Zero(K, arrayAnglesT.size());
+    spectralDetectedR = Matrix<T,Dynamic,Dynamic>::Zero(K, SpheresArrayR.size());
+    spectralDetectedT = Matrix<T,Dynamic,Dynamic>::Zero(K, SpheresArrayT.size());
 }
 
 /*
-template < typename T, size_t Nz, size_t Nr, bool detector>
-MonteCarlo<T,Nz,Nr,detector>::MonteCarlo(const Sample<T>& sample, const int& Np, const T& z, const T& r, const OpticalFiber<T>& detectorR, const OpticalFiber<T>& detectorT, const DetectorDistance<T> dist)
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+MonteCarlo<T,Nz,Nr,detector,Tallies>::MonteCarlo(const Sample<T>& sample, const int& Np, const T& z, const T& r, const OpticalFiber<T>& detectorR, const OpticalFiber<T>& detectorT, const DetectorDistance<T> dist)
     : sample(sample)
     , Nphotons(Np)
     , dz(z / Nz)
@@ -246,41 +560,143 @@ MonteCarlo<T,Nz,Nr,detector>::MonteCarlo(const Sample<T>& sample, const int& Np,
     GenerateDetectorArrays();
 }
 //*/
-template < typename T, size_t Nz, size_t Nr, bool detector>
-std::vector<Matrix<T, Dynamic, Dynamic>> MonteCarlo<T,Nz,Nr,detector>::getHeterogeneousMatrix3D() {
-    using namespace std;
-    using namespace Math_NS;
-    std::vector<Matrix<T, Dynamic, Dynamic>> coag3D;
-    for (int i = 0; i < Nz; i++) {
-        Matrix<T,Dynamic,Dynamic> slice = Matrix<T, 2 * Nr - 1, 2 * Nr - 1>::Constant(1.0);
-        Matrix<T,1,Dynamic> line = heterogeneousMatrix2D.row(i);
-        Matrix<T,1,Dynamic> longLine = Matrix<T,1,2 * Nr - 1>::Zero();
-        longLine << line.rowwise().reverse(), line(all, lastN(Nr-1));
-  //      cerr << "longLine " << longLine << endl;
-            for (int k = 0; k < 2 * Nr - 1; k++)
-                for (int l = 0; l < 2 * Nr - 1; l++) {
-                    if (sqr(k - Nr + 1) + sqr(l - Nr + 1) <= sqr(Nr)) {
-                        T dist = sqrt(sqr(k - Nr + 1) + sqr(l - Nr + 1));
-                        int num = floor(dist);
-              //          cerr << k << " " << l << " " << Nr - 1 << " " << dist << " " << num << endl;
-                        slice(k, l) = line(num);
-                    }
-                }
-
-     /*   for (int j = 0; j < 2 * Nr - 1; j++) {
-            for (int k = 0; k < 2 * Nr - 1; k++) {
-                slice(k,j) = longLine(j);
-            }
-        }*/
- //       cerr << slice << endl;
-       coag3D.push_back(slice);
+
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::addDetectorR(std::shared_ptr<MonteCarlo_NS::DetectorInterface<T>> newDetector) EXCEPT_INPUT_PARAMS {
+    detectorsR.add(std::move(newDetector));
+}
+
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::addDetectorT(std::shared_ptr<MonteCarlo_NS::DetectorInterface<T>> newDetector) EXCEPT_INPUT_PARAMS {
+    detectorsT.add(std::move(newDetector));
+}
+
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::addFiberR(std::shared_ptr<MonteCarlo_NS::OpticalFiber<T>> fiber) EXCEPT_INPUT_PARAMS {
+    CHECK_ARGUMENT_CONTRACT(fiber != nullptr);
+
+    fibersR.push_back(std::move(fiber));
+}
+
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::addFiberT(std::shared_ptr<MonteCarlo_NS::OpticalFiber<T>> fiber) EXCEPT_INPUT_PARAMS {
+    CHECK_ARGUMENT_CONTRACT(fiber != nullptr);
+
+    fibersT.push_back(std::move(fiber));
+}
+
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::setFiberEstimator(const T& depth) EXCEPT_INPUT_PARAMS {
+    CHECK_ARGUMENT_CONTRACT(depth >= 0);
+    CHECK_ARGUMENT_CONTRACT(homogenous && !spectral);
+    /// flights go straight from scattering events to the surfaces
+    for (int i = 0; i < layers.getNlayers(); i++)
+        CHECK_ARGUMENT_CONTRACT(layers[i].mus > 0 && layers[i].n == layers[0].n);
+
+    fiberDepth = depth;
+}
+
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::setAngularBiasing(const AngularBiasing<T>& newBiasing) EXCEPT_INPUT_PARAMS {
+    CHECK_ARGUMENT_CONTRACT(newBiasing.probability >= 0 && newBiasing.probability <= 1);
+    CHECK_ARGUMENT_CONTRACT(newBiasing.depth >= 0);
+    CHECK_ARGUMENT_CONTRACT(newBiasing.margin >= 1);
+    CHECK_ARGUMENT_CONTRACT(homogenous);
+
+    biasing = newBiasing;
+    turbidTop = layers[layers.getNlayers() - 1].zLower;
+    turbidBottom = layers[0].zUpper;
+    for (int i = 0; i < layers.getNlayers(); i++)
+        if (layers[i].mus > 0) {
+            turbidTop = std::min(turbidTop, layers[i].zUpper);
+            turbidBottom = std::max(turbidBottom, layers[i].zLower);
+        }
+}
+
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::setWeightWindows(const WeightWindows<T>& newWindows) EXCEPT_INPUT_PARAMS {
+    CHECK_ARGUMENT_CONTRACT(newWindows.lower.rows() == static_cast<int>(Nz) && newWindows.lower.cols() == static_cast<int>(Nr));
+    CHECK_ARGUMENT_CONTRACT(newWindows.lower.minCoeff() >= 0);
+    CHECK_ARGUMENT_CONTRACT(newWindows.ratio > 1);
+    CHECK_ARGUMENT_CONTRACT(newWindows.maxSplit >= 1);
+    CHECK_ARGUMENT_CONTRACT(homogenous && !spectral);
+
+    windows = newWindows;
+    secondaries.reserve(SECONDARY_RESERVE);
+}
+
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+WeightWindows<T> MonteCarlo<T,Nz,Nr,detector,Tallies>::PilotWeightWindows(const int& pilotPhotons, const T& ratio, const int& maxSplit) const EXCEPT_INPUT_PARAMS {
+    CHECK_ARGUMENT_CONTRACT(pilotPhotons > 0);
+    CHECK_ARGUMENT_CONTRACT(homogenous);
+
+    MonteCarlo<T,Nz,Nr,detector,FullTallies> pilot(sample, pilotPhotons, dz * Nz, radius, mainSphereR, mainSphereT, distances, lightSource);
+    const auto absorbed = pilot.CalculateResult().matrixA;
+
+    /// fluence of a depth is absorbed weight over absorption, bins of non-absorbing layers stay empty
+    Matrix<T,Dynamic,Dynamic> fluence = Matrix<T,Dynamic,Dynamic>::Zero(Nz, Nr);
+    for (int iz = 0; iz < static_cast<int>(Nz); iz++) {
+        const T z = (iz + T(0.5)) * dz;
+        T mua = 0;
+        for (int i = 0; i < layers.getNlayers(); i++)
+            if (z >= layers[i].zUpper && z < layers[i].zLower)
+                mua = layers[i].mua;
+        if (mua > 0)
+            fluence.row(iz).setConstant(absorbed.row(iz).sum() / mua);
     }
-    return coag3D;
+    return WeightWindows<T>::fromFluence(fluence, ratio, maxSplit);
 }
 
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::setBoundarySplitting(const int& newMaxSplits, const T& minReflectance) EXCEPT_INPUT_PARAMS {
+    CHECK_ARGUMENT_CONTRACT(newMaxSplits >= 0);
+    CHECK_ARGUMENT_CONTRACT(minReflectance >= 0 && minReflectance < 1);
+    CHECK_ARGUMENT_CONTRACT(homogenous && !spectral);
+
+    maxBoundarySplits = newMaxSplits;
+    minSplitReflectance = minReflectance;
+    secondaries.reserve(SECONDARY_RESERVE);
+}
 
-template < typename T, size_t Nz, size_t Nr, bool detector>
-void MonteCarlo<T,Nz,Nr,detector>::GenerateDetectorArrays() {
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::setDiffusionHandoff(const DiffusionHandoff<T>& newHandoff) EXCEPT_INPUT_PARAMS {
+    CHECK_ARGUMENT_CONTRACT(newHandoff.depth >= 0 && newHandoff.margin >= 0);
+    CHECK_ARGUMENT_CONTRACT(newHandoff.depth == 0 || newHandoff.depth > newHandoff.margin);
+    CHECK_ARGUMENT_CONTRACT(newHandoff.scatterings >= 0);
+    CHECK_ARGUMENT_CONTRACT(homogenous && !spectral);
+
+    handoff = newHandoff;
+}
+
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::setQuasiRandom(const int& flights) EXCEPT_INPUT_PARAMS {
+    CHECK_ARGUMENT_CONTRACT(flights >= 0 && flights <= QUASI_FLIGHTS);
+    CHECK_ARGUMENT_CONTRACT(homogenous);
+
+    quasiFlights = flights;
+    /// 53 random bits of the stream, pseudo-random runs keep the stream untouched
+    if (flights > 0)
+        sobol = Math_NS::ScrambledSobol(static_cast<std::uint64_t>(Math_NS::random<double>(0, 1) * 9007199254740992.0));
+}
+
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+T MonteCarlo<T,Nz,Nr,detector,Tallies>::Uniform(const Decision& decision) {
+    int& taken = quasiDecisions[decision];
+    if (taken < quasiFlights)
+        return sobol.get<T>(quasiPoint, LightSource<T>::UNIFORMS + 3 * taken++ + decision);
+    return Math_NS::random<T>(0, 1);
+}
+
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+Vector3D<T> MonteCarlo<T,Nz,Nr,detector,Tallies>::QuasiLaunchPoint(const int& num) const {
+    T u[LightSource<T>::UNIFORMS];
+    for (int d = 0; d < LightSource<T>::UNIFORMS; d++)
+        u[d] = sobol.get<T>(num, d);
+    return lightSource.getPhotonCoord(u);
+}
+
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::GenerateDetectorArrays() {
     using namespace std;
 
     /// TODO: you need * 1.0 ?
@@ -303,232 +719,106 @@ void MonteCarlo<T,Nz,Nr,detector>::GenerateDetectorArrays() {
         }
         //*/
     }
+    if (detector == 1) {
+        vector<T> distancesR, distancesT;
+        for (const auto& sphere: SpheresArrayR)
+            distancesR.push_back(sphere.getDistance());
+        for (const auto& sphere: SpheresArrayT)
+            distancesT.push_back(sphere.getDistance());
+        spheresR = make_shared<MonteCarlo_NS::IntegratingSphereComplex<T>>(mainSphereR.getDSphere(), mainSphereR.getDPort1(), mainSphereR.getDPort2(),
+                                                                           distancesR, 0, true);
+        spheresT = make_shared<MonteCarlo_NS::IntegratingSphereComplex<T>>(mainSphereT.getDSphere(), mainSphereT.getDPort1(), mainSphereT.getDPort2(),
+                                                                           distancesT, sample.getTotalThickness(), false);
+        detectorsR.add(spheresR);
+        detectorsT.add(spheresT);
+    } else {
+        /// spheres without distances catch nothing
+        spheresR = make_shared<MonteCarlo_NS::IntegratingSphereComplex<T>>();
+        spheresT = make_shared<MonteCarlo_NS::IntegratingSphereComplex<T>>();
+    }
+    cones.reserve(SpheresArrayR.size() + SpheresArrayT.size());
 }
 
-template < typename T, size_t Nz, size_t Nr, bool detector>
-void MonteCarlo<T,Nz,Nr,detector>::PhotonDetectionSphereR(Photon<T>& exit_photon) {
-    using namespace Math_NS;
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::RecordAngle(const Photon<T>& exit_photon, Matrix<T,1,Dynamic>& angles) {
+    if constexpr (Tallies::angles) {
+        const int iTheta = AngleBin(exit_photon.direction);
+        if (iTheta >= 0)
+            angles[iTheta] += exit_photon.weight;
+    }
+}
+
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::BeamDetectionR(const Photon<T>& exit_photon) {
     using namespace Utils_NS;
-    using namespace std;
 
-    /*
-    for (int i = 0; i < isize(SpheresArrayR); i++) {
-        T step = abs((SpheresArrayR[i].getDistance() - abs(exit_photon.coordinate.z))/ exit_photon.direction.z);
-        exit_photon.coordinate += step * exit_photon.direction;
-        if (debug && exit_photon.number == debugPhoton)
-            cout << exit_photon << endl;
-        if ((sqr(exit_photon.coordinate.x) + sqr(exit_photon.coordinate.y)) < sqr(mainSphereR.getDPort1() / 2)) {
-            T stepSphere = abs(mainSphereR.getDSphere()/ exit_photon.direction.z);
-            exit_photon.coordinate += stepSphere * exit_photon.direction;
-            if (debug && exit_photon.number == debugPhoton)
-                cout << exit_photon << endl;
-            if ((sqr(exit_photon.coordinate.x) + sqr(exit_photon.coordinate.y)) >= sqr(mainSphereR.getDPort2() /2)) {
-                SpheresArrayR[i].totalLight += exit_photon.weight;
-                if (debug && exit_photon.number == debugPhoton)
-                    cout << "caught by R sphere " << i << endl;
-            }
-            exit_photon.coordinate -= stepSphere * exit_photon.direction;
-            if (debug && exit_photon.number == debugPhoton)
-                cout << exit_photon << endl;
-        } else
-            break;
-    }
-    //*/
-    if (exit_photon.direction.x == 0) {
-        arrayAnglesR[0] += 0.0;
-    } else {
-        if (debug && exit_photon.number == debugPhoton)
-            cerr << "R " << exit_photon.direction.z << " " << exit_photon.direction.x << endl;
-        T theta = atan(exit_photon.direction.z / exit_photon.direction.x);
-        size_t iTheta = 0;
-        if (theta > 0)
-            iTheta = floor(theta / (M_PI / 100));
-        else if (theta < 0)
-            iTheta = floor((M_PI + theta) / (M_PI / 100));
-        arrayAnglesR[iTheta] += exit_photon.weight;
-    }
-    /// weird thorlabs sphere
-    // cout << isize(SpheresArrayR) << endl;
-    for (int i = 0; i < isize(SpheresArrayR); i++) {
-        T step = abs((SpheresArrayR[i].getDistance() - abs(exit_photon.coordinate.z))/ exit_photon.direction.z);
-        exit_photon.coordinate += step * exit_photon.direction;
-        if (debug && exit_photon.number == debugPhoton)
-            cerr << "to sphere \n" << exit_photon << endl;
-        if ((sqr(exit_photon.coordinate.x) + sqr(exit_photon.coordinate.y)) < sqr(mainSphereR.getDPort1() / 2)) { // gets inside tunnel
-            T stepDarkTunnel = abs(0.003 / exit_photon.direction.z); // black part of tunnel is 3mm long
-            exit_photon.coordinate += stepDarkTunnel * exit_photon.direction;
-            if (debug && exit_photon.number == debugPhoton)
-                cerr << "in tunnel \n"<< exit_photon << endl;
-            if ((sqr(exit_photon.coordinate.x) + sqr(exit_photon.coordinate.y)) < sqr(mainSphereR.getDPort1() / 2)) {
-                T stepLightTunnel = abs(0.009 / exit_photon.direction.z);
-                exit_photon.coordinate += stepLightTunnel * exit_photon.direction;
-                if (debug && exit_photon.number == debugPhoton)
-                    cerr << "in light tunnel \n"<< exit_photon << endl;
-                if ((sqr(exit_photon.coordinate.x) + sqr(exit_photon.coordinate.y)) < sqr(mainSphereR.getDPort1() / 2)) {
-                    T stepSphere = abs(mainSphereR.getDSphere() / exit_photon.direction.z);
-                    exit_photon.coordinate += stepSphere * exit_photon.direction;
-                    if ((sqr(exit_photon.coordinate.x) + sqr(exit_photon.coordinate.y)) >= sqr(mainSphereR.getDPort2() / 2)) {
-                        SpheresArrayR[i].totalLight += exit_photon.weight;
-                        if (debug && exit_photon.number == debugPhoton)
-                            cerr << "caught by R sphere \n" << exit_photon << endl;
-                        exit_photon.coordinate -= stepDarkTunnel * exit_photon.direction;
-                        exit_photon.coordinate -= stepLightTunnel * exit_photon.direction;
-                        exit_photon.coordinate -= stepSphere * exit_photon.direction;
-                    } else {
-                        T stepLightTunnel2 = abs(0.009 / exit_photon.direction.z);
-                        exit_photon.coordinate += stepLightTunnel2 * exit_photon.direction;
-                        if (debug && exit_photon.number == debugPhoton)
-                            cerr << "in light tunnel2 \n"<< exit_photon << endl;
-                        if ((sqr(exit_photon.coordinate.x) + sqr(exit_photon.coordinate.y)) >= sqr(mainSphereR.getDPort2() / 2)) {
-                            SpheresArrayR[i].totalLight += 0.3 * exit_photon.weight;
-                            if (debug && exit_photon.number == debugPhoton)
-                                cerr << "caught by tunnel \n" << exit_photon << endl;
-                            exit_photon.coordinate -= stepDarkTunnel * exit_photon.direction;
-                            exit_photon.coordinate -= stepLightTunnel * exit_photon.direction;
-                            exit_photon.coordinate -= stepSphere * exit_photon.direction;
-                            exit_photon.coordinate -= stepLightTunnel2 * exit_photon.direction;
-                        } else {
-                            exit_photon.coordinate -= stepDarkTunnel * exit_photon.direction;
-                            exit_photon.coordinate -= stepLightTunnel * exit_photon.direction;
-                            exit_photon.coordinate -= stepSphere * exit_photon.direction;
-                            exit_photon.coordinate -= stepLightTunnel2 * exit_photon.direction;
-                        }
-                    }
-                } else {
-                    SpheresArrayR[i].totalLight += 0.3 * exit_photon.weight;
-                    if (debug && exit_photon.number == debugPhoton)
-                        cerr << "caught by tunnel \n" << exit_photon << endl;
-                    exit_photon.coordinate -= stepDarkTunnel * exit_photon.direction;
-                    exit_photon.coordinate -= stepLightTunnel * exit_photon.direction;
-                }
-            } else
-                exit_photon.coordinate -= stepDarkTunnel * exit_photon.direction;
-        } else
-            break;
+    for (int b = 0; b < isize(beams); b++) {
+        Photon<T> shifted = exit_photon;
+        shifted.coordinate += beams[b].sampleOffset();
+        const auto& caught = spheresR->catchLight(shifted);
+        for (int i = 0; i < isize(caught); i++)
+            beamDetectedR(b, i) += caught[i];
     }
 }
 
-template < typename T, size_t Nz, size_t Nr, bool detector>
-void MonteCarlo<T,Nz,Nr,detector>::PhotonDetectionSphereT(Photon<T>& exit_photon) {
-    using namespace Math_NS;
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::BeamDetectionT(const Photon<T>& exit_photon) {
     using namespace Utils_NS;
-    using namespace std;
 
-    /*
-    for (int i = 0; i < isize(SpheresArrayT); i++) {
-        T step = abs(((SpheresArrayT[i].getDistance() + sample.getTotalThickness()) - exit_photon.coordinate.z)/ exit_photon.direction.z);
-         exit_photon.coordinate += step * exit_photon.direction;
-         if (debug && exit_photon.number == debugPhoton)
-            cout << exit_photon << endl;
-        if ((sqr(exit_photon.coordinate.x) + sqr(exit_photon.coordinate.y)) < sqr(mainSphereT.getDPort1() / 2)) {
-            T stepSphere = abs(mainSphereT.getDSphere() / exit_photon.direction.z);
-            exit_photon.coordinate += stepSphere * exit_photon.direction;
-            if (debug && exit_photon.number == debugPhoton)
-                cout << exit_photon << endl;
-            if ((sqr(exit_photon.coordinate.x) + sqr(exit_photon.coordinate.y)) >= sqr(mainSphereT.getDPort2() / 2)) {
-                SpheresArrayT[i].totalLight += exit_photon.weight;
-                if (debug && exit_photon.number == debugPhoton)
-                    cout << "caught by T sphere " << i << endl;
-            }
-            exit_photon.coordinate -= stepSphere * exit_photon.direction;
-            if (debug && exit_photon.number == debugPhoton)
-                cout << exit_photon << endl;
-        } else
-            break;
-    }
-    //*/
-    if (exit_photon.direction.x == 0) {
-        arrayAnglesT[0] += 0.0;
-    } else {
-        if (debug && exit_photon.number == debugPhoton)
-            cerr << "T " << exit_photon.direction.z << " " << exit_photon.direction.x << endl;
-        T theta = atan(exit_photon.direction.z / exit_photon.direction.x);
-        size_t iTheta = 0;
-        if (theta > 0)
-            iTheta = floor(theta / (M_PI / 100));
-        else if (theta < 0)
-            iTheta = floor((M_PI + theta) / (M_PI / 100));
-        arrayAnglesT[iTheta] += exit_photon.weight;
-    }
-    /// weird thorlabs spheres with long tunnel
-    for (int i = 0; i < isize(SpheresArrayT); i++) {
-        T step = abs(((SpheresArrayT[i].getDistance() + sample.getTotalThickness()) - exit_photon.coordinate.z)/ exit_photon.direction.z);
-        exit_photon.coordinate += step * exit_photon.direction;
-        if (debug && exit_photon.number == debugPhoton)
-            cerr << "to sphere \n" << exit_photon << endl;
-
-        if ((sqr(exit_photon.coordinate.x) + sqr(exit_photon.coordinate.y)) < sqr(mainSphereT.getDPort1() / 2)) { // gets inside tunnel
-
-            T stepDarkTunnel = abs(0.003 / exit_photon.direction.z); // black part of tunnel is 3mm long
-            exit_photon.coordinate += stepDarkTunnel * exit_photon.direction;
-            if (debug && exit_photon.number == debugPhoton)
-                cerr << "in tunnel \n"<< exit_photon << endl;
-            if ((sqr(exit_photon.coordinate.x) + sqr(exit_photon.coordinate.y)) < sqr(mainSphereT.getDPort1() / 2)) {
-                T stepLightTunnel = abs(0.009 / exit_photon.direction.z);
-                exit_photon.coordinate += stepLightTunnel * exit_photon.direction;
-                if (debug && exit_photon.number == debugPhoton)
-                    cerr << "in light tunnel \n"<< exit_photon << endl;
-                if ((sqr(exit_photon.coordinate.x) + sqr(exit_photon.coordinate.y)) < sqr(mainSphereT.getDPort1() / 2)) {
-                    T stepSphere = abs(mainSphereT.getDSphere() / exit_photon.direction.z);
-                    exit_photon.coordinate += stepSphere * exit_photon.direction;
-                    if ((sqr(exit_photon.coordinate.x) + sqr(exit_photon.coordinate.y)) >= sqr(mainSphereT.getDPort2() / 2)) {
-                        SpheresArrayT[i].totalLight += exit_photon.weight;
-                        if (debug && exit_photon.number == debugPhoton)
-                            cerr << "caught by R sphere \n" << exit_photon << endl;
-                        exit_photon.coordinate -= stepDarkTunnel * exit_photon.direction;
-                        exit_photon.coordinate -= stepLightTunnel * exit_photon.direction;
-                        exit_photon.coordinate -= stepSphere * exit_photon.direction;
-                    } else {
-                        T stepLightTunnel2 = abs(0.009 / exit_photon.direction.z);
-                        exit_photon.coordinate += stepLightTunnel2 * exit_photon.direction;
-                        if (debug && exit_photon.number == debugPhoton)
-                            cerr << "in light tunnel2 \n"<< exit_photon << endl;
-                        if ((sqr(exit_photon.coordinate.x) + sqr(exit_photon.coordinate.y)) >= sqr(mainSphereT.getDPort2() / 2)) {
-                            SpheresArrayT[i].totalLight += 0.3 * exit_photon.weight;
-                            if (debug && exit_photon.number == debugPhoton)
-                                cerr << "caught by tunnel \n" << exit_photon << endl;
-                            exit_photon.coordinate -= stepDarkTunnel * exit_photon.direction;
-                            exit_photon.coordinate -= stepLightTunnel * exit_photon.direction;
-                            exit_photon.coordinate -= stepSphere * exit_photon.direction;
-                            exit_photon.coordinate -= stepLightTunnel2 * exit_photon.direction;
-                        } else {
-                            exit_photon.coordinate -= stepDarkTunnel * exit_photon.direction;
-                            exit_photon.coordinate -= stepLightTunnel * exit_photon.direction;
-                            exit_photon.coordinate -= stepSphere * exit_photon.direction;
-                            exit_photon.coordinate -= stepLightTunnel2 * exit_photon.direction;
-                        }
-                    }
-                } else {
-                    SpheresArrayT[i].totalLight += 0.3 * exit_photon.weight;
-                    if (debug && exit_photon.number == debugPhoton)
-                        cerr << "caught by tunnel \n" << exit_photon << endl;
-                    exit_photon.coordinate -= stepDarkTunnel * exit_photon.direction;
-                    exit_photon.coordinate -= stepLightTunnel * exit_photon.direction;
-                }
-            } else
-                exit_photon.coordinate -= stepDarkTunnel * exit_photon.direction;
-        } else
-            break;
+    for (int b = 0; b < isize(beams); b++) {
+        Photon<T> shifted = exit_photon;
+        shifted.coordinate += beams[b].sampleOffset();
+        const auto& caught = spheresT->catchLight(shifted);
+        for (int i = 0; i < isize(caught); i++)
+            beamDetectedT(b, i) += caught[i];
     }
 }
 
-template < typename T, size_t Nz, size_t Nr, bool detector>
-void MonteCarlo<T,Nz,Nr,detector>::FirstReflection(Photon<T>& photon) {
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+int MonteCarlo<T,Nz,Nr,detector,Tallies>::AngleBin(const Vector3D<T>& direction) {
+    using namespace std;
+
+    if (direction.x == 0)
+        return -1;
+    const T theta = atan(direction.z / direction.x);
+    int iTheta = 0;
+    if (theta > 0)
+        iTheta = floor(theta / (M_PI / 100));
+    else if (theta < 0)
+        iTheta = floor((M_PI + theta) / (M_PI / 100));
+    return iTheta;
+}
+
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::SpectralDetection(const Photon<T>& exit_photon, Matrix<T,Dynamic,Dynamic>& angles,
+                                                             const std::vector<T>& caught, Matrix<T,Dynamic,Dynamic>& detected) {
+    /// exit photon was already detected with the weight of the path without absorption,
+    /// every wavelength gets the same light attenuated by its own absorption along the path
+    const int iTheta = AngleBin(exit_photon.direction);
+    if (iTheta >= 0)
+        angles.col(iTheta) += exit_photon.weight * lanes.matrix();
+    for (int i = 0; i < static_cast<int>(caught.size()); i++)
+        if (caught[i] != 0)
+            detected.col(i) += caught[i] * lanes.matrix();
+}
+
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::FirstReflection(Photon<T>& photon) {
     using namespace Math_NS;
     using namespace Physics_NS;
     using namespace Utils_NS;
     using namespace std;
 
-    const auto ni = sample.getNvacUpper();
-    const auto nt = sample.getMedium(0).getN();
+    const auto ni = layers[0].nUpper;
+    const auto nt = layers[0].n;
     const auto cosi = abs(photon.direction.z);
     const auto cost = TransmittanceCos(ni, nt, cosi);
 
     T Ri = FresnelReflectance<T>(ni, nt, cosi);
 
-    if (sample.getMedium(0).getMut() == 0) { // specular from glass
+    if (layers[0].mut == 0) { // specular from glass
         const auto R1 = FresnelReflectance<T>(ni, nt, cosi);
-        const auto n3 = sample.getMedium(1).getN();
+        const auto n3 = layers[0].nLower;
         const auto R2 = FresnelReflectance<T>(nt, n3, cost);
         Ri = R1 + (sqr(1 - R1) * R2) / (1 - R1 * R2);
     }
@@ -542,27 +832,44 @@ void MonteCarlo<T,Nz,Nr,detector>::FirstReflection(Photon<T>& photon) {
     auto exitDir = Vector3D<T>(photon.direction.x, photon.direction.y, -photon.direction.z);
     auto exitWeight = Ri * photon.weight;
     Photon<T> exitPhoton = Photon<T>(exitCoord, exitDir, exitWeight, photon.number);
-    PhotonDetectionSphereR(exitPhoton);
+    detectorsR.push(exitPhoton);
+    for (const auto& fiber: fibersR)
+        fiber->detect(exitPhoton);
+    /// sphere detection moves exit photon, beams shift it from the exit point
+    if (!beams.empty())
+        BeamDetectionR(exitPhoton);
+    RecordAngle(exitPhoton, arrayAnglesR);
+    if (spectral)
+        SpectralDetection(exitPhoton, spectralAnglesR, spheresR->catchLight(exitPhoton), spectralDetectedR);
 
     photon.weight *= (1 - Ri);
     photon.direction.z = TransmittanceCos(ni, nt, cosi);
     // photon.coordinate.z += 1E-9; // crook
 }
 
-template < typename T, size_t Nz, size_t Nr, bool detector>
-void MonteCarlo<T,Nz,Nr,detector>::HopDropSpin(Photon<T>& photon) {
-    if (sample.getMedium(photon.layer).getMut() == 0)
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::HopDropSpin(Photon<T>& photon) {
+    if (layers[photon.layer].mut == 0)
         HopInGlass(photon);
     else
         if (homogenous) {
             HopDropSpinInTissue(photon);
-            Roulette(photon);
-        } else
+            if (windows.enabled())
+                ApplyWeightWindow(photon);
+            else
+                Roulette(photon);
+        } else if (inclusions)
+            HopDropSpinInInclusions(photon);
+        else if (tracking == TrackingMode::Woodcock)
+            HopDropSpinInHeterogeneousTissueWoodcock(photon);
+        else if (tracking == TrackingMode::MacroCell)
+            HopDropSpinInHeterogeneousTissueMacroCell(photon);
+        else
             HopDropSpinInHeterogeneousTissue(photon);
 }
 
-template < typename T, size_t Nz, size_t Nr, bool detector>
-void MonteCarlo<T,Nz,Nr,detector>::HopInGlass(Photon<T>& photon) {
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::HopInGlass(Photon<T>& photon) {
     using namespace std;
 
     if (debug && photon.number == debugPhoton) {
@@ -570,8 +877,12 @@ void MonteCarlo<T,Nz,Nr,detector>::HopInGlass(Photon<T>& photon) {
         cout << photon << endl;
     }
 
+    const auto& glass = layers[photon.layer];
+    const bool toBorder = photon.direction.z < 0 ? (glass.upper < 0 && glass.lower >= 0) : (glass.lower < 0 && glass.upper >= 0);
     if (photon.direction.z == 0)
         photon.alive = 0;
+    else if (toBorder)
+        TransferThroughGlass(photon);
     else {
         StepSizeInGlass(photon);
         Hop(photon);
@@ -584,8 +895,73 @@ void MonteCarlo<T,Nz,Nr,detector>::HopInGlass(Photon<T>& photon) {
     }
 }
 
-template < typename T, size_t Nz, size_t Nr, bool detector>
-void MonteCarlo<T,Nz,Nr,detector>::HopDropSpinInTissue(Photon<T>& photon) {
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::TransferThroughGlass(Photon<T>& photon) {
+    using namespace Math_NS;
+    using namespace Physics_NS;
+    using namespace std;
+
+    const auto& glass = layers[photon.layer];
+    const bool up = photon.direction.z < 0;
+    const T zOuter = up ? glass.zUpper : glass.zLower;
+    const T zInner = up ? glass.zLower : glass.zUpper;
+    const T nOuter = up ? glass.nUpper : glass.nLower;
+    const T nInner = up ? glass.nLower : glass.nUpper;
+
+    /// faces are parallel, so every bounce has the same incidence
+    const T cosOuter = photon.direction.z;
+    const T cosInner = -cosOuter;
+    const T R1 = FresnelReflectance<T>(glass.n, nOuter, cosOuter);
+    const T R2 = FresnelReflectance<T>(glass.n, nInner, cosInner);
+    const T q = R1 * R2; // round trip
+    if (q >= 1) { // grazing photon is trapped in glass
+        photon.alive = false;
+        return;
+    }
+
+    /// paths to the first outer hit and across the slide
+    const T first = (zOuter - photon.coordinate.z) / cosOuter;
+    const T crossing = (glass.zLower - glass.zUpper) / abs(cosOuter);
+    const Vector3D<T> start = photon.coordinate;
+    const T weight = photon.weight;
+
+    /// escape after k round trips is (1 - R1) q^k of weight, the tail of the series leaves with the last recorded term
+    if (R1 < 1) {
+        const T cosExit = TransmittanceCos(glass.n, nOuter, cosOuter);
+        for (int k = 0; ; k++) {
+            const T path = first + 2 * k * crossing;
+            photon.coordinate = Vector3D<T>(start.x + path * photon.direction.x, start.y + path * photon.direction.y, zOuter);
+            const bool last = photon.weight * q <= GLASS_TAIL * weight;
+            if (last)
+                photon.weight /= 1 - q;
+            if (up)
+                RecordR(photon, R1, cosExit);
+            else
+                RecordT(photon, R1, cosExit);
+            if (last)
+                break;
+            photon.weight *= R2;
+        }
+    }
+
+    /// re-entry after k round trips has probability (1 - q) q^k
+    const T reentered = weight * R1 * (1 - R2) / (1 - q);
+    if (reentered == 0) {
+        photon.alive = false;
+        return;
+    }
+    const int k = q == 0 ? 0 : floor(log(1 - random<T>(0, 1)) / log(q));
+    const T path = first + (2 * k + 1) * crossing;
+    photon.coordinate = Vector3D<T>(start.x + path * photon.direction.x, start.y + path * photon.direction.y, zInner);
+    photon.weight = reentered;
+    photon.layer = up ? glass.lower : glass.upper;
+    photon.direction.x *= glass.n / nInner;
+    photon.direction.y *= glass.n / nInner;
+    photon.direction.z = TransmittanceCos(glass.n, nInner, cosInner);
+}
+
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::HopDropSpinInTissue(Photon<T>& photon) {
     using namespace std;
 
     StepSizeInTissue(photon);
@@ -615,7 +991,20 @@ void MonteCarlo<T,Nz,Nr,detector>::HopDropSpinInTissue(Photon<T>& photon) {
             cout << "After Drop" << endl;
             cout << photon << endl;
         }
-        Spin(photon);
+        /// the jump replaces the scattering of the event, so its flight is not estimated for fibers
+        if (handoff.enabled() && DiffusionJump(photon)) {
+            if (debug && photon.number == debugPhoton)
+                cout << "Diffusion jump" << endl;
+        } else {
+            if (adjoint)
+                ScoreAdjoint(photon);
+            else if (fiberDepth > 0)
+                EstimateFibers(photon);
+            if (biasing.probability > 0)
+                BiasedSpin(photon);
+            else
+                Spin(photon);
+        }
         if (debug && photon.number == debugPhoton) {
             cout << "After Spin" << endl;
             cout << photon << endl;
@@ -623,8 +1012,8 @@ void MonteCarlo<T,Nz,Nr,detector>::HopDropSpinInTissue(Photon<T>& photon) {
     }
 }
 
-template < typename T, size_t Nz, size_t Nr, bool detector>
-void MonteCarlo<T,Nz,Nr,detector>::HopDropSpinInHeterogeneousTissue(Photon<T>& photon) {
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::HopDropSpinInHeterogeneousTissue(Photon<T>& photon) {
     using namespace std;
 
     ///1. make border array: find border point (jump to border), bresenham through coag, if there is change in properties, add coag border
@@ -632,8 +1021,8 @@ void MonteCarlo<T,Nz,Nr,detector>::HopDropSpinInHeterogeneousTissue(Photon<T>& p
     ///3. coag borders with reflection routine, add crossOrNot
     ///4. standard DropSpin routine
 
-    vector<Vector3D<T>> bordersArray;
-    vector<T> attCoeffs;
+//    vector<Vector3D<T>> bordersArray;
+//    vector<T> attCoeffs;
 //    InnerBordersArray(photon, bordersArray, attCoeffs);
     /// bordersArray size will always be >= 2.
         /// coag borders routine
@@ -659,16 +1048,212 @@ void MonteCarlo<T,Nz,Nr,detector>::HopDropSpinInHeterogeneousTissue(Photon<T>& p
     }*/
 }
 
-template < typename T, size_t Nz, size_t Nr, bool detector>
-std::vector<Vector3D<int>> MonteCarlo<T,Nz,Nr,detector>::TrajectoryArrayInt(Photon<T>& photon, Vector3D<T>& finalBorderPoint) {
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::HopDropSpinInHeterogeneousTissueWoodcock(Photon<T>& photon) {
+    using namespace Math_NS;
     using namespace std;
-    vector<Vector3D<int>> trajectoryArrayInt;
+
+    /// tentative collision against the majorant, the exponential flight is memoryless,
+    /// so after a layer border a new flight is sampled on the next call
+    const T majorant = volume->getMajorant();
+    photon.step = -transportLog(random<T>(0, 1)) / majorant;
+
+    const auto uz = photon.direction.z;
+    T distToBnd = 0;
+    if (uz > 0)
+        distToBnd = (layers[photon.layer].zLower - photon.coordinate.z) / uz;
+    else if (uz < 0)
+        distToBnd = (layers[photon.layer].zUpper - photon.coordinate.z) / uz;
+
+    if (uz != 0 && photon.step > distToBnd) {
+        photon.step = distToBnd;
+        Hop(photon);
+        CrossOrNot(photon);
+        return;
+    }
+
+    Hop(photon);
+    if (abs(photon.coordinate.x) >= radius || abs(photon.coordinate.y) >= radius) {
+        photon.alive = false;
+        return;
+    }
+
+    const Vector3D<int> point = CartesianGridPoint(photon.coordinate);
+    if (random<T>(0, 1) * majorant < (*volume)(point.x, point.y, point.z).mut) { // real collision
+        Drop(photon);
+        Spin(photon);
+    }
+    Roulette(photon);
+
+    if (debug && photon.number == debugPhoton) {
+        cout << "After Woodcock step" << endl;
+        cout << photon << endl;
+    }
+}
+
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::HopDropSpinInHeterogeneousTissueMacroCell(Photon<T>& photon) {
+    using namespace Math_NS;
+    using namespace std;
+
+    const auto& grid = volume->getMajorantGrid();
+    const int cellSize = grid.getCellSize();
+    const auto& start = photon.coordinate;
+    const auto& dir = photon.direction;
+    constexpr T inf = numeric_limits<T>::infinity();
+
+    /// distance to layer border ends the flight as in HopDropSpinInHeterogeneousTissueWoodcock
+    T tEnd = inf;
+    if (dir.z > 0)
+        tEnd = (layers[photon.layer].zLower - start.z) / dir.z;
+    else if (dir.z < 0)
+        tEnd = (layers[photon.layer].zUpper - start.z) / dir.z;
+
+    const Vector3D<int> voxel = CartesianGridPoint(start);
+    int cx = grid.cell(voxel.x);
+    int cy = grid.cell(voxel.y);
+    int cz = grid.cell(voxel.z);
+
+    /// distance from start to the border of the current macro cell along one lateral axis,
+    /// the outer cells are extended to the sample radius, where photons are killed
+    const auto lateralBorder = [&](const int& c, const T& p, const T& u, const T& d) {
+        if (u > 0)
+            return (min(static_cast<T>((c + 1) * cellSize - int(Nr - 1)) * d, radius) - p) / u;
+        if (u < 0)
+            return ((c == 0 ? -radius : static_cast<T>(c * cellSize - int(Nr - 1)) * d) - p) / u;
+        return inf;
+    };
+    /// z cells outside the grid are clamped to the border cells as in CartesianGridPoint
+    const auto axialBorder = [&](const int& c) {
+        if (dir.z > 0 && c < grid.getNz() - 1)
+            return (static_cast<T>((c + 1) * cellSize) * dz - start.z) / dir.z;
+        if (dir.z < 0 && c > 0)
+            return (static_cast<T>(c * cellSize) * dz - start.z) / dir.z;
+        return inf;
+    };
+
+    /// optical depth to the tentative collision is spent cell by cell against the local majorants
+    T tau = -transportLog(random<T>(0, 1));
+    T t = 0;
+    T majorant = 0;
+    while (true) {
+        majorant = grid(cx, cy, cz);
+        const T tx = lateralBorder(cx, start.x, dir.x, dx);
+        const T ty = lateralBorder(cy, start.y, dir.y, dy);
+        const T tz = axialBorder(cz);
+        const T tNext = min({tx, ty, tz});
+        const T segment = max(min(tNext, tEnd) - t, T(0));
+
+        if (majorant > 0 && majorant * segment >= tau) {
+            t += tau / majorant;
+            break;
+        }
+        tau -= majorant * segment;
+        t += segment;
+
+        if (tEnd <= tNext) {
+            photon.step = tEnd;
+            Hop(photon);
+            CrossOrNot(photon);
+            return;
+        }
+
+        if (tNext == tx)
+            cx += dir.x > 0 ? 1 : -1;
+        else if (tNext == ty)
+            cy += dir.y > 0 ? 1 : -1;
+        else
+            cz += dir.z > 0 ? 1 : -1;
+
+        if (cx < 0 || cx >= grid.getNxy() || cy < 0 || cy >= grid.getNxy()) { // out of sample radius
+            photon.alive = false;
+            return;
+        }
+    }
+
+    photon.step = t;
+    Hop(photon);
+
+    const Vector3D<int> point = CartesianGridPoint(photon.coordinate);
+    if (random<T>(0, 1) * majorant < (*volume)(point.x, point.y, point.z).mut) { // real collision
+        Drop(photon);
+        Spin(photon);
+    }
+    Roulette(photon);
+
+    if (debug && photon.number == debugPhoton) {
+        cout << "After macro cell step" << endl;
+        cout << photon << endl;
+    }
+}
+
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::HopDropSpinInInclusions(Photon<T>& photon) {
+    using namespace Math_NS;
+    using namespace std;
+
+    const auto& start = photon.coordinate;
+    const auto& dir = photon.direction;
+    constexpr T inf = numeric_limits<T>::infinity();
+
+    T tEnd = inf;
+    if (dir.z > 0)
+        tEnd = (layers[photon.layer].zLower - start.z) / dir.z;
+    else if (dir.z < 0)
+        tEnd = (layers[photon.layer].zUpper - start.z) / dir.z;
+
+    /// medium is constant between two crossings of inclusion borders,
+    /// optical depth is spent segment by segment with the material found in the middle of segment
+    T tau = -transportLog(random<T>(0, 1));
+    T t = 0;
+    MaterialProperties<T> material;
+    while (true) {
+        const T tNext = min(inclusions->nextBoundary(start, dir, t), tEnd);
+        const T tProbe = tNext < inf ? (t + tNext) / 2 : t + 1;
+        material = (*inclusions)(start + tProbe * dir);
+
+        if (material.mut > 0 && material.mut * (tNext - t) >= tau) {
+            t += tau / material.mut;
+            break;
+        }
+        if (tNext == inf) { // transparent medium without borders ahead
+            photon.alive = false;
+            return;
+        }
+        tau -= material.mut * (tNext - t);
+        t = tNext;
+
+        if (t >= tEnd) {
+            photon.step = tEnd;
+            Hop(photon);
+            CrossOrNot(photon);
+            return;
+        }
+    }
+
+    photon.step = t;
+    Hop(photon);
+    Drop(photon, material);
+    Spin(photon, material.g);
+    Roulette(photon);
+
+    if (debug && photon.number == debugPhoton) {
+        cout << "After inclusions step" << endl;
+        cout << photon << endl;
+    }
+}
+
+/// trajectoryArrayInt is refilled, its capacity is kept between flights
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::TrajectoryArrayInt(Photon<T>& photon, Vector3D<T>& finalBorderPoint, std::vector<Vector3D<int>>& trajectoryArrayInt) {
+    using namespace std;
+    trajectoryArrayInt.clear();
     T step;
     const auto uz = photon.direction.z;
     if (uz > 0)
-        step = (sample.CurrentLowerBorderZ(photon.layer) - photon.coordinate.z) / uz;
+        step = (layers[photon.layer].zLower - photon.coordinate.z) / uz;
     else if (uz < 0)
-        step = (sample.CurrentUpperBorderZ(photon.layer) - photon.coordinate.z) / uz;
+        step = (layers[photon.layer].zUpper - photon.coordinate.z) / uz;
 
     finalBorderPoint = photon.coordinate + step * photon.direction;
     Vector3D<T> startPoint = photon.coordinate;
@@ -678,29 +1263,29 @@ std::vector<Vector3D<int>> MonteCarlo<T,Nz,Nr,detector>::TrajectoryArrayInt(Phot
             cerr << x << endl;
         cerr << endl;
     }*/
-    return trajectoryArrayInt;
 }
 
 
-template < typename T, size_t Nz, size_t Nr, bool detector>
-void MonteCarlo<T,Nz,Nr,detector>::InnerBordersArray(Photon<T>& photon, std::vector<Vector3D<T>>& bordersArray, std::vector<T>& attCoeffs) {
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::InnerBordersArray(Photon<T>& photon, std::vector<Vector3D<T>>& bordersArray, std::vector<T>& attCoeffs) {
     using namespace std;
     Vector3D<T> finalBorderPoint;
     Vector3D<T> startPoint = photon.coordinate;
-    vector<Vector3D<int>> trajectoryArrayInt = TrajectoryArrayInt(photon, finalBorderPoint);
+    auto& trajectoryArrayInt = trajectory;
+    TrajectoryArrayInt(photon, finalBorderPoint, trajectoryArrayInt);
 
     Vector3D<int> point = trajectoryArrayInt[0];
-    T val = heterogeneousMatrix3D[point.z](point.x, point.y);
+    auto val = volume->material(point.x, point.y, point.z);
 
     for (int i = 0; i < trajectoryArrayInt.size() - 1; i++) {
 //        Vector3D<int> point = trajectoryArrayInt[i];
         Vector3D<int> point2 = trajectoryArrayInt[i + 1];
-        T val2 = heterogeneousMatrix3D[point2.z](point2.x, point2.y);
+        auto val2 = volume->material(point2.x, point2.y, point2.z);
         /// we will set glass value in the matrix to -1
         if (val != val2) {
            bordersArray.push_back(CartesianCoord(Vector3D<int>(point.x, point.y, point.z)));
-           attCoeffs.push_back(usFunc(val)+uaFunc(val));
-           attCoeffs.push_back(usFunc(val2)+uaFunc(val2));
+           attCoeffs.push_back(volume->properties(val).mut);
+           attCoeffs.push_back(volume->properties(val2).mut);
         }
         point = point2;
         val = val2;
@@ -710,19 +1295,19 @@ void MonteCarlo<T,Nz,Nr,detector>::InnerBordersArray(Photon<T>& photon, std::vec
     bordersArray.insert(bordersArray.begin(), startPoint);
     if (bordersArray.size() == 2) {
         Vector3D<int> point = trajectoryArrayInt[0];
-        attCoeffs.push_back(usFunc(heterogeneousMatrix3D[point.z](point.x, point.y))+uaFunc(heterogeneousMatrix3D[point.z](point.x, point.y)));
+        attCoeffs.push_back((*volume)(point.x, point.y, point.z).mut);
     }
 }
 
-template < typename T, size_t Nz, size_t Nr, bool detector>
-void MonteCarlo<T,Nz,Nr,detector>::HopInHeterogeneousTissue(Photon<T>& photon, const std::vector<Vector3D<T>>& bordersArray, const std::vector<T>& attCoeffs) {
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::HopInHeterogeneousTissue(Photon<T>& photon, const std::vector<Vector3D<T>>& bordersArray, const std::vector<T>& attCoeffs) {
     using namespace std;
 
     vector<Vector3D<T>> bordersArrayFull = bordersArray;
     vector<T> attCoeffsFull = attCoeffs;
     int currentBand = 0;
     T xi = random<T>(0, 1);
-    photon.step = - log(xi) / attCoeffsFull[currentBand];
+    photon.step = -transportLog(xi) / attCoeffsFull[currentBand];
     while ((photon.coordinate.z + photon.step * photon.direction.z > bordersArrayFull[currentBand + 1].z && photon.direction.z > 0) ||
            (photon.coordinate.z + photon.step * photon.direction.z < bordersArrayFull[currentBand + 1].z && photon.direction.z < 0)) {
         currentBand += 1;
@@ -748,7 +1333,7 @@ void MonteCarlo<T,Nz,Nr,detector>::HopInHeterogeneousTissue(Photon<T>& photon, c
                 break;
             }
         }
-        photon.step = -log(xi) / attCoeffsFull[currentBand];
+        photon.step = -transportLog(xi) / attCoeffsFull[currentBand];
         for (int i = 0; i < currentBand; i++)
             photon.step -= attCoeffsFull[i] * abs((bordersArrayFull[i+1].z - bordersArrayFull[i].z) / photon.direction.z) / attCoeffsFull[currentBand];
     }
@@ -757,21 +1342,22 @@ void MonteCarlo<T,Nz,Nr,detector>::HopInHeterogeneousTissue(Photon<T>& photon, c
         photon.alive = false;
 }
 
-template < typename T, size_t Nz, size_t Nr, bool detector>
-void MonteCarlo<T,Nz,Nr,detector>::HopInHeterogeneousTissueNoBorder(Photon<T>& photon) {
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::HopInHeterogeneousTissueNoBorder(Photon<T>& photon) {
     using namespace std;
     if ((debug&& photon.number == debugPhoton))
         cerr << "alive? " << photon.alive << endl;
     while (photon.alive) {
     T xi = random<T>(0, 1);
-    T coord0 = -log(xi);
+    T coord0 = -transportLog(xi);
     T coord = 0;
     T stepTotal = 0;
     Vector3D<T> finalBorderPoint;
 
     int currentPoint = 0;
     int refCount = 0;
-    vector<Vector3D<int>> trajectoryArrayInt = TrajectoryArrayInt(photon, finalBorderPoint);
+    auto& trajectoryArrayInt = trajectory;
+    TrajectoryArrayInt(photon, finalBorderPoint, trajectoryArrayInt);
     Vector3D<int> currentCoordInt = trajectoryArrayInt[currentPoint];
     Vector3D<int> prevCoordInt;
     T weight = photon.weight;
@@ -800,9 +1386,7 @@ void MonteCarlo<T,Nz,Nr,detector>::HopInHeterogeneousTissueNoBorder(Photon<T>& p
                 cerr << "REFLECTION HETERO" << endl;
             photon.coordinate = CartesianCoord(currentCoordInt);
 
-            T Mua = uaFunc<T>(heterogeneousMatrix3D[currentCoordInt.z](currentCoordInt.x, currentCoordInt.y));
-            T Mus = usFunc<T>(heterogeneousMatrix3D[currentCoordInt.z](currentCoordInt.x, currentCoordInt.y));
-            T Mut = Mua + Mus;
+            T Mut = (*volume)(currentCoordInt.x, currentCoordInt.y, currentCoordInt.z).mut;
             T ds = distance<T>(CartesianCoord(currentCoordInt), CartesianCoord(prevCoordInt));
             stepTotal += ds;
             coord += Mut * ds;
@@ -815,10 +1399,10 @@ void MonteCarlo<T,Nz,Nr,detector>::HopInHeterogeneousTissueNoBorder(Photon<T>& p
             Roulette(photon);
 
             CrossOrNot(photon);
-            if (sample.getMedium(photon.layer).getMut() == 0)
+            if (layers[photon.layer].mut == 0)
                 HopInGlass(photon);
             else {
-                trajectoryArrayInt = TrajectoryArrayInt(photon, finalBorderPoint);
+                TrajectoryArrayInt(photon, finalBorderPoint, trajectoryArrayInt);
                 currentPoint = 1;
                 prevCoordInt = trajectoryArrayInt[0];
                 currentCoordInt = trajectoryArrayInt[1];
@@ -842,10 +1426,7 @@ void MonteCarlo<T,Nz,Nr,detector>::HopInHeterogeneousTissueNoBorder(Photon<T>& p
       if ((debug&& photon.number == debugPhoton)  || myDebug)
          cerr << "PREV COORD " << CartesianCoord(prevCoordInt) << " " << prevCoordInt <<  endl;
 
- //       cerr << uaFunc<T>(heterogeneousMatrix3D[230](8+Nr, 8+Nr)) << " " << usFunc<T>(heterogeneousMatrix3D[230](8+Nr, 8+Nr)) << " " << gFunc<T>(heterogeneousMatrix3D[230](8+Nr, 8+Nr)) << endl;
-        T Mua = uaFunc<T>(heterogeneousMatrix3D[prevCoordInt.z](prevCoordInt.x, prevCoordInt.y));
-        T Mus = usFunc<T>(heterogeneousMatrix3D[prevCoordInt.z](prevCoordInt.x, prevCoordInt.y));
-        T Mut = Mua + Mus;
+        T Mut = (*volume)(prevCoordInt.x, prevCoordInt.y, prevCoordInt.z).mut;
   //      if (myDebug)
   //          cerr << Mut << endl;
         T ds = distance<T>(CartesianCoord(currentCoordInt), CartesianCoord(prevCoordInt));
@@ -901,15 +1482,19 @@ void MonteCarlo<T,Nz,Nr,detector>::HopInHeterogeneousTissueNoBorder(Photon<T>& p
     }
     T Mua, Mut, Mus;
     if (homogenous) {
-        Mua = sample.getMedium(layer).getMua();
-        Mut = sample.getMedium(layer).getMut();
-        Mus = sample.getMedium(layer).getMus();
+        Mua = layers[layer].mua;
+        Mut = layers[layer].mut;
+        Mus = layers[layer].mus;
     } else {
-        Mua = uaFunc<T>(heterogeneousMatrix3D[currentCoordInt.z](currentCoordInt.x, currentCoordInt.y));
-        Mus = usFunc<T>(heterogeneousMatrix3D[currentCoordInt.z](currentCoordInt.x, currentCoordInt.y));
-        Mut = Mua + Mus;
+        const auto& material = (*volume)(currentCoordInt.x, currentCoordInt.y, currentCoordInt.z);
+        Mua = material.mua;
+        Mus = material.mus;
+        Mut = material.mut;
     }
-    A(iz, min(ir, Nr-1)) += photon.weight * Mua / Mut;
+    if constexpr (Tallies::absorptionGrid)
+        A(iz, min(ir, Nr-1)) += photon.weight * Mua / Mut;
+    else
+        absorbedWeight += photon.weight * Mua / Mut;
 
     photon.weight *= Mus / Mut;
     Spin(photon);
@@ -917,56 +1502,60 @@ void MonteCarlo<T,Nz,Nr,detector>::HopInHeterogeneousTissueNoBorder(Photon<T>& p
     }
 }
 /*
-template < typename T, size_t Nz, size_t Nr, bool detector>
-void MonteCarlo<T,Nz,Nr,detector>::HopInHeterogeneousTissueNoBorder(Photon<T>& photon) {
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::HopInHeterogeneousTissueNoBorder(Photon<T>& photon) {
     T xi = random<T>(0, 1);
-    T sleft = -log(xi);
+    T sleft = -transportLog(xi);
     while (sleft > 0) {
         auto currentCoordInt = CartesianGridPoint<T>(photon.coordinate);
-        T Mus = usFunc<T>(heterogeneousMatrix3D[currentCoordInt.z](currentCoordInt.x, currentCoordInt.y));
+        T Mus = (*volume)(currentCoordInt.x, currentCoordInt.y, currentCoordInt.z).mus;
         T s = sleft / Mus;
         auto tempCoord = photon.coordinate + photon.direction * s;
 }*/
 
-template < typename T, size_t Nz, size_t Nr, bool detector>
-void MonteCarlo<T,Nz,Nr,detector>::StepSizeInGlass(Photon<T>& photon) {
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::StepSizeInGlass(Photon<T>& photon) {
     const auto uz = photon.direction.z;
     photon.step = 0;
     if (uz > 0)
-        photon.step = (sample.CurrentLowerBorderZ(photon.layer) - photon.coordinate.z) / uz;
+        photon.step = (layers[photon.layer].zLower - photon.coordinate.z) / uz;
     else if (uz < 0)
-        photon.step = (sample.CurrentUpperBorderZ(photon.layer) - photon.coordinate.z) / uz;
+        photon.step = (layers[photon.layer].zUpper - photon.coordinate.z) / uz;
     /// TODO: doesn't it freeze if uz == 0?
 }
 
-template < typename T, size_t Nz, size_t Nr, bool detector>
-void MonteCarlo<T,Nz,Nr,detector>::StepSizeInTissue(Photon<T>& photon) {
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::StepSizeInTissue(Photon<T>& photon) {
     using namespace Math_NS;
     using namespace std;
 
     T mT;
     if (homogenous)
-        mT = sample.getMedium(photon.layer).getMut();
+        mT = layers[photon.layer].mut;
     else {
         Vector3D<int> point = CartesianGridPoint(photon.coordinate);
-        T Mua = uaFunc<T>(heterogeneousMatrix3D[point.z](point.x, point.y));
-        T Mus = usFunc<T>(heterogeneousMatrix3D[point.z](point.x, point.y));
-        mT = Mua + Mus;
+        mT = (*volume)(point.x, point.y, point.z).mut;
     }
     if (photon.stepLeft == 0) // new step
-        photon.step = -log(random<T>(0, 1)) / mT;
+        photon.step = -transportLog(Uniform(STEP)) / mT;
     else { // leftover step
         photon.step = photon.stepLeft / mT;
         photon.stepLeft = 0;
     }
 }
 
-template < typename T, size_t Nz, size_t Nr, bool detector>
-void MonteCarlo<T,Nz,Nr,detector>::RecordR(Photon<T>& photon, const T& FRefl, const T& cosT) {
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::RecordR(Photon<T>& photon, const T& FRefl, const T& cosT) {
     using namespace Math_NS;
     using namespace Utils_NS;
     using namespace std;
 
+    /// adjoint packets leaving the sample miss the beam, it comes along the normal
+    if (adjoint) {
+        photon.weight *= FRefl;
+        return;
+    }
+
     const auto r = sqrt(sqr(photon.coordinate.x) + sqr(photon.coordinate.y));
     const size_t ir = floor(r/dr);
 
@@ -981,17 +1570,35 @@ void MonteCarlo<T,Nz,Nr,detector>::RecordR(Photon<T>& photon, const T& FRefl, co
     auto exitDir = Vector3D<T>(photon.direction.x, photon.direction.y, cosT);
     auto exitWeight = (1 - FRefl) * photon.weight;
     Photon<T> exitPhoton = Photon<T>(exitCoord, exitDir, exitWeight, photon.number);
-    PhotonDetectionSphereR(exitPhoton);
+    detectorsR.push(exitPhoton);
+    if (!photon.estimatedR)
+        for (const auto& fiber: fibersR)
+            fiber->detect(exitPhoton);
+    if (!beams.empty())
+        BeamDetectionR(exitPhoton);
+    RecordAngle(exitPhoton, arrayAnglesR);
+    if (spectral) {
+        spectralRR.col(min(ir, Nr-1)) += exitWeight * lanes.matrix();
+        SpectralDetection(exitPhoton, spectralAnglesR, spheresR->catchLight(exitPhoton), spectralDetectedR);
+    }
 
     photon.weight *= FRefl;
+    /// the reflected part takes a path the estimators did not follow
+    photon.estimatedR = false;
+    photon.estimatedT = false;
 }
 
-template < typename T, size_t Nz, size_t Nr, bool detector>
-void MonteCarlo<T,Nz,Nr,detector>::RecordT(Photon<T>& photon, const T& FRefl, const T& cosT) {
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::RecordT(Photon<T>& photon, const T& FRefl, const T& cosT) {
     using namespace Math_NS;
     using namespace Utils_NS;
     using namespace std;
 
+    if (adjoint) {
+        photon.weight *= FRefl;
+        return;
+    }
+
     const auto r = sqrt(sqr(photon.coordinate.x) + sqr(photon.coordinate.y));
     const size_t ir = floor(r/dr);
 
@@ -1006,72 +1613,104 @@ void MonteCarlo<T,Nz,Nr,detector>::RecordT(Photon<T>& photon, const T& FRefl, co
     auto exitDir = Vector3D<T>(photon.direction.x, photon.direction.y, cosT);
     auto exitWeight = (1 - FRefl) * photon.weight;
     Photon<T> exitPhoton = Photon<T>(exitCoord, exitDir, exitWeight, photon.number);
-    PhotonDetectionSphereT(exitPhoton);
+    detectorsT.push(exitPhoton);
+    if (!photon.estimatedT)
+        for (const auto& fiber: fibersT)
+            fiber->detect(exitPhoton);
+    if (!beams.empty())
+        BeamDetectionT(exitPhoton);
+    RecordAngle(exitPhoton, arrayAnglesT);
+    if (spectral) {
+        spectralTT.col(min(ir, Nr-1)) += exitWeight * lanes.matrix();
+        SpectralDetection(exitPhoton, spectralAnglesT, spheresT->catchLight(exitPhoton), spectralDetectedT);
+    }
 
     photon.weight *= FRefl;
+    photon.estimatedR = false;
+    photon.estimatedT = false;
 }
 
-template < typename T, size_t Nz, size_t Nr, bool detector>
-void MonteCarlo<T,Nz,Nr,detector>::Hop(Photon<T>& photon) {
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::Hop(Photon<T>& photon) {
     photon.coordinate += photon.step * photon.direction;
+    if (spectral)
+        AbsorbSpectrum(photon);
 }
 
-template < typename T, size_t Nz, size_t Nr, bool detector>
-void MonteCarlo<T,Nz,Nr,detector>::Drop(Photon<T>& photon) {
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::AbsorbSpectrum(const Photon<T>& photon) {
     using namespace Math_NS;
-    using namespace Utils_NS;
     using namespace std;
 
-    const int layer = photon.layer;
+    if (layers[photon.layer].mut == 0) // no absorption in glass
+        return;
+
+    /// continuous absorption along the step is deposited at its end
+    const typename Spectrum<T>::Lanes transmitted = (-photon.step * spectrum.getMua(photon.layer)).exp();
     const auto r = sqrt(sqr(photon.coordinate.x) + sqr(photon.coordinate.y));
     const size_t ir = floor(r / dr);
-    const size_t iz = abs(floor(photon.coordinate.z / dz));
+    const Vector3D<int> point = CartesianGridPoint(photon.coordinate);
+    spectralA.col(min(ir, Nr-1) * Nz + point.z) += (photon.weight * lanes * (1 - transmitted)).matrix();
+    lanes *= transmitted;
+}
 
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::Drop(Photon<T>& photon) {
+    Drop(photon, LocalMaterial(photon));
+}
 
-    if (iz >= Nz) {
-        cout << "ACHTUNG!!! iz = " << iz << " exceeds Nz during drop of photon N " << photon.number << endl;
-        cerr << photon.coordinate << endl;
-        cerr << photon.direction << endl;
-    }
-    T Mua, Mut, Mus;
-    Vector3D<int> point = CartesianGridPoint(photon.coordinate);
-    if (homogenous) {
-        Mua = sample.getMedium(layer).getMua();
-        Mut = sample.getMedium(layer).getMut();
-        Mus = sample.getMedium(layer).getMus();
-    } else {
-        Mua = uaFunc<T>(heterogeneousMatrix3D[point.z](point.x, point.y));
-        Mus = usFunc<T>(heterogeneousMatrix3D[point.z](point.x, point.y));
-        Mut = Mua + Mus;
-    }
-    A(point.z, min(ir, Nr-1)) += photon.weight * Mua / Mut;
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::Drop(Photon<T>& photon, const MaterialProperties<T>& material) {
+    using namespace Math_NS;
+    using namespace Utils_NS;
+    using namespace std;
 
-    photon.weight *= Mus / Mut;
+    Absorb(photon, photon.coordinate, photon.weight * material.mua / material.mut);
+    photon.weight *= material.mus / material.mut;
 }
 
-template < typename T, size_t Nz, size_t Nr, bool detector>
-void MonteCarlo<T,Nz,Nr,detector>::Spin(Photon<T>& photon) {
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::Absorb(const Photon<T>& photon, const Vector3D<T>& coordinate, const T& weight) {
     using namespace Math_NS;
     using namespace Utils_NS;
     using namespace std;
 
-    const int layer = photon.layer;
-    T g;
-    if (homogenous)
-        g = sample.getMedium(layer).getG();
-    else {
-        Vector3D<int> point = CartesianGridPoint(photon.coordinate);
-        g = gFunc<T>(heterogeneousMatrix3D[point.z](point.x, point.y));
-    }
+    if constexpr (Tallies::absorptionGrid) {
+        const auto r = sqrt(sqr(coordinate.x) + sqr(coordinate.y));
+        const size_t ir = floor(r / dr);
+        const size_t iz = abs(floor(coordinate.z / dz));
 
-    const auto RND1 = random<T>(0, 1);
+
+        if (iz >= Nz) {
+            cout << "ACHTUNG!!! iz = " << iz << " exceeds Nz during drop of photon N " << photon.number << endl;
+            cerr << coordinate << endl;
+            cerr << photon.direction << endl;
+        }
+        const Vector3D<int> point = CartesianGridPoint(coordinate);
+        A(point.z, min(ir, Nr-1)) += weight;
+    } else
+        absorbedWeight += weight;
+}
+
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::Spin(Photon<T>& photon) {
+    Spin(photon, LocalMaterial(photon).g);
+}
+
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::Spin(Photon<T>& photon, const T& g) {
+    using namespace Math_NS;
+    using namespace Utils_NS;
+    using namespace std;
+
+    const auto RND1 = Uniform(COS);
     T cosHG = (1 + sqr(g) - sqr((1 - sqr(g)) / (1 - g + 2 * g * RND1))) / (2 * g);
     if (g == 0)
         cosHG = 2 * RND1 - 1;
     else if (g == 1)
         cosHG = 1;
 
-    const auto RND2 = random<T>(0, 1);
+    const auto RND2 = Uniform(PHI);
     const auto phi = 2 * M_PI * RND2; // radians
 
     if (debug && photon.number == debugPhoton)
@@ -1081,16 +1720,20 @@ void MonteCarlo<T,Nz,Nr,detector>::Spin(Photon<T>& photon) {
     T uy = photon.direction.y;
     T uz = photon.direction.z;
 
+    T sinPhi, cosPhi;
+    transportSincos<T>(phi, sinPhi, cosPhi);
+
     const auto sinHG = sqrt(1 - sqr(cosHG));
-    const auto temp  = sqrt(1 - sqr(uz));
+    const T invTemp = transportRsqrt<T>(1 - sqr(uz));
+    const T temp = (1 - sqr(uz)) * invTemp;
 
-    T uxx = +sinHG * (ux * uz * cos(phi) - uy * sin(phi)) / temp + ux * cosHG;
-    T uyy = +sinHG * (uy * uz * cos(phi) + ux * sin(phi)) / temp + uy * cosHG;
-    T uzz = -sinHG *            cos(phi)                  * temp + uz * cosHG;
+    T uxx = +sinHG * (ux * uz * cosPhi - uy * sinPhi) * invTemp + ux * cosHG;
+    T uyy = +sinHG * (uy * uz * cosPhi + ux * sinPhi) * invTemp + uy * cosHG;
+    T uzz = -sinHG *            cosPhi                * temp    + uz * cosHG;
 
     if (abs(abs(uz) - 1)  < 1E-6) {
-        uxx = sinHG * cos(phi);
-        uyy = sinHG * sin(phi);
+        uxx = sinHG * cosPhi;
+        uyy = sinHG * sinPhi;
         uzz = uz >= 0 ? cosHG : -cosHG;
     }
 
@@ -1099,31 +1742,136 @@ void MonteCarlo<T,Nz,Nr,detector>::Spin(Photon<T>& photon) {
     photon.direction.z = uzz;
 }
 
-template < typename T, size_t Nz, size_t Nr, bool detector>
-bool MonteCarlo<T,Nz,Nr,detector>::HitBoundary(Photon<T>& photon) {
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::BiasedSpin(Photon<T>& photon) {
+    using namespace Math_NS;
+    using namespace Utils_NS;
+    using namespace std;
+
+    const auto& layer = layers[photon.layer];
+    const bool nearTop = photon.coordinate.z - turbidTop <= biasing.depth;
+    const bool nearBottom = turbidBottom - photon.coordinate.z <= biasing.depth;
+    if (tracingBranch || spectral || (!nearTop && !nearBottom) || layer.g >= 1 || SpheresArrayR.empty() || random<T>(0, 1) >= biasing.probability) {
+        Spin(photon, layer.g);
+        return;
+    }
+
+    cones.clear();
+    if (nearTop)
+        for (const auto& sphere: SpheresArrayR)
+            cones.push_back(BiasCone<T>::toSphere(photon.coordinate, sphere, layer.n, layers[0].nUpper, true, biasing.margin));
+    if (nearBottom)
+        for (const auto& sphere: SpheresArrayT)
+            cones.push_back(BiasCone<T>::toSphere(photon.coordinate, sphere, layer.n, layers[layers.getNlayers() - 1].nLower, false, biasing.margin));
+    const auto inCones = [this](const Vector3D<T>& direction) {
+        T density = 0;
+        for (const auto& cone: cones)
+            if (cone.contains(direction))
+                density += cone.density();
+        return density / isize(cones);
+    };
+
+    /// branch uniform over the cones carries the phase function inside them
+    Photon<T> branch = photon;
+    const auto& cone = cones[min(static_cast<int>(random<T>(0, 1) * isize(cones)), isize(cones) - 1)];
+    const T u1 = random<T>(0, 1);
+    branch.direction = cone.sample(u1, random<T>(0, 1));
+    branch.weight *= HenyeyGreenstein(photon.direction * branch.direction, layer.g) / inCones(branch.direction);
+
+    /// photon keeps the phase function outside the cones and is replaced by the branch inside them
+    Spin(photon, layer.g);
+    if (inCones(photon.direction) > 0) {
+        photon = branch;
+        return;
+    }
+    tracingBranch = true;
+    while (branch.alive)
+        HopDropSpin(branch);
+    tracingBranch = false;
+}
+
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+bool MonteCarlo<T,Nz,Nr,detector,Tallies>::DiffusionJump(Photon<T>& photon) {
+    using namespace Math_NS;
+    using namespace std;
+
+    if (++photon.scatterings <= handoff.scatterings)
+        return false;
+
+    const auto& layer = layers[photon.layer];
+    const T transportPath = 1 / (layer.mua + layer.mus * (1 - layer.g));
+    /// photon keeps its direction for g transport mean free paths on average, diffusion starts there
+    const Vector3D<T> centre = photon.coordinate + layer.g * transportPath * photon.direction;
+    const T distance = min(centre.z - layer.zUpper, layer.zLower - centre.z);
+    if (distance < handoff.depth * transportPath)
+        return false;
+
+    const auto isotropic = [] {
+        const T cosTheta = 2 * random<T>(0, 1) - 1;
+        const T sinTheta = sqrt(1 - sqr(cosTheta));
+        T sinPhi, cosPhi;
+        transportSincos<T>(2 * T(M_PI) * random<T>(0, 1), sinPhi, cosPhi);
+        return Vector3D<T>(sinTheta * cosPhi, sinTheta * sinPhi, cosTheta);
+    };
+
+    const T sphereRadius = distance - handoff.margin * transportPath;
+    /// fluence of transport vanishes at Milne extrapolation length beyond the surface where photons first cross it,
+    /// effective attenuation is sqrt(3 mua (mua + mus'))
+    const T extrapolated = sphereRadius + DiffusionHandoff<T>::EXTRAPOLATION * transportPath;
+    const T k = sqrt(3 * layer.mua / transportPath) * extrapolated;
+    const T reach = DiffusionHandoff<T>::reach(k);
+    if (reach < 1)
+        Absorb(photon, centre + min(DiffusionHandoff<T>::absorptionRadius(k, random<T>(0, 1)) * extrapolated, sphereRadius) * isotropic(),
+               photon.weight * (1 - reach));
+    photon.weight *= reach;
+
+    /// light leaves the surface of the sphere of zero fluence along the normal with cosine density
+    const Vector3D<T> normal = isotropic();
+    photon.coordinate = centre + sphereRadius * normal;
+    photon.direction = normal + isotropic();
+    photon.direction /= photon.direction.norm();
+    /// the next flight does not start from a scattering event estimated for fibers
+    photon.estimatedR = false;
+    photon.estimatedT = false;
+    return true;
+}
+
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+MaterialProperties<T> MonteCarlo<T,Nz,Nr,detector,Tallies>::LocalMaterial(const Photon<T>& photon) {
+    if (homogenous) // absorption of spectral runs is applied along the path in AbsorbSpectrum
+        return layers.material(photon.layer);
+    if (inclusions)
+        return (*inclusions)(photon.coordinate);
+
+    const Vector3D<int> point = CartesianGridPoint(photon.coordinate);
+    return (*volume)(point.x, point.y, point.z);
+}
+
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+bool MonteCarlo<T,Nz,Nr,detector,Tallies>::HitBoundary(Photon<T>& photon) {
     const auto uz = photon.direction.z;
 
     T distToBnd = 0;
     if (uz > 0)
-        distToBnd = (sample.CurrentLowerBorderZ(photon.layer) - photon.coordinate.z) / uz;
+        distToBnd = (layers[photon.layer].zLower - photon.coordinate.z) / uz;
     else if (uz < 0)
-        distToBnd = (sample.CurrentUpperBorderZ(photon.layer) - photon.coordinate.z) / uz;
+        distToBnd = (layers[photon.layer].zUpper - photon.coordinate.z) / uz;
 
     if (uz != 0 && photon.step > distToBnd) {
-        photon.stepLeft = (photon.step - distToBnd) * sample.getMedium(photon.layer).getMut();
+        photon.stepLeft = (photon.step - distToBnd) * layers[photon.layer].mut;
         photon.step = distToBnd;
         return true;
     }
     return false;
 }
 
-template < typename T, size_t Nz, size_t Nr, bool detector>
-void MonteCarlo<T,Nz,Nr,detector>::CrossOrNot(Photon<T>& photon) {
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::CrossOrNot(Photon<T>& photon) {
     return photon.direction.z < 0 ? CrossUpOrNot(photon) : CrossDownOrNot(photon);
 }
 
-template < typename T, size_t Nz, size_t Nr, bool detector>
-void MonteCarlo<T,Nz,Nr,detector>::CrossUpOrNot(Photon<T>& photon) {
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::CrossUpOrNot(Photon<T>& photon) {
     using namespace Math_NS;
     using namespace Physics_NS;
     using namespace std;
@@ -1133,8 +1881,8 @@ void MonteCarlo<T,Nz,Nr,detector>::CrossUpOrNot(Photon<T>& photon) {
 
     const T cosi = photon.direction.z;
     const int layer = photon.layer;
-    const auto ni = sample.getMedium(layer).getN();
-    const auto nt = layer == 0 ? sample.getNvacUpper() : sample.getMedium(layer - 1).getN();
+    const auto ni = layers[layer].n;
+    const auto nt = layers[layer].nUpper;
     const auto cost = TransmittanceCos(ni, nt, cosi);
     const auto Ri = FresnelReflectance<T>(ni, nt, cosi);
     const auto RND = random<T>(0, 1); // reflected or transmitted on inner borders?
@@ -1142,15 +1890,15 @@ void MonteCarlo<T,Nz,Nr,detector>::CrossUpOrNot(Photon<T>& photon) {
     if (debug && photon.number == debugPhoton)
         cout << "cost = " << cost << " FresnelReflectance = " << Ri << " RND = " << RND << endl;
 
-    if (layer == 0 && Ri < 1) { // partially transmitted -- only on sample border
+    if (layers[layer].upper < 0 && Ri < 1) { // partially transmitted -- only on sample border
         if (debug && photon.number == debugPhoton)
             cout << "SAMPLE BORDER" << endl;
         RecordR(photon, Ri, cost);
         photon.direction.z = - photon.direction.z;
-    } else if (RND > Ri) { // fully transmitted
+    } else if (SplitAtBoundary(photon, Ri) || RND > Ri) { // fully transmitted or transmitted part of split photon
         if (debug && photon.number == debugPhoton)
             cout << "TRANSMITTED THROUGH BND" << endl;
-        photon.layer -= 1;
+        photon.layer = layers[layer].upper;
         photon.direction.x *= ni / nt;
         photon.direction.y *= ni / nt;
         photon.direction.z = cost;
@@ -1158,11 +1906,13 @@ void MonteCarlo<T,Nz,Nr,detector>::CrossUpOrNot(Photon<T>& photon) {
         if (debug && photon.number == debugPhoton)
             cout << "REFLECTED FROM BND" << endl;
         photon.direction.z = -photon.direction.z;
+        photon.estimatedR = false;
+        photon.estimatedT = false;
     }
 }
 
-template < typename T, size_t Nz, size_t Nr, bool detector>
-void MonteCarlo<T,Nz,Nr,detector>::CrossDownOrNot(Photon<T>& photon) {
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::CrossDownOrNot(Photon<T>& photon) {
     using namespace Math_NS;
     using namespace Physics_NS;
     using namespace std;
@@ -1171,8 +1921,8 @@ void MonteCarlo<T,Nz,Nr,detector>::CrossDownOrNot(Photon<T>& photon) {
         cout << "CrossDownOrNot" << endl;
     const auto cosi = photon.direction.z;
     const int layer = photon.layer;
-    const auto ni = sample.getMedium(layer).getN();
-    const auto nt = layer == sample.getNlayers()-1 ? sample.getNvacLower() : sample.getMedium(layer + 1).getN();
+    const auto ni = layers[layer].n;
+    const auto nt = layers[layer].nLower;
     const auto cost = TransmittanceCos(ni, nt, cosi);
     const auto Ri = FresnelReflectance<T>(ni, nt, cosi);
     const auto RND = random<T>(0, 1); // reflected or transmitted on inner borders?
@@ -1180,15 +1930,15 @@ void MonteCarlo<T,Nz,Nr,detector>::CrossDownOrNot(Photon<T>& photon) {
     if (debug && photon.number == debugPhoton)
         cout << "cost = " << cost << " FresnelReflectance = "<< Ri << " RND = "<< RND << endl;
 
-    if (layer == (sample.getNlayers() - 1) && Ri < 1) { // partially transmitted -- only on sample border
+    if (layers[layer].lower < 0 && Ri < 1) { // partially transmitted -- only on sample border
         if (debug && photon.number == debugPhoton)
             cout << "SAMPLE BORDER" << endl;
         RecordT(photon, Ri, cost);
         photon.direction.z *= -1;
-    } else if (RND > Ri) { // fully transmitted
+    } else if (SplitAtBoundary(photon, Ri) || RND > Ri) { // fully transmitted or transmitted part of split photon
         if (debug && photon.number == debugPhoton)
             cout << "TRANSMITTED THROUGH BND" << endl;
-        photon.layer += 1;
+        photon.layer = layers[layer].lower;
         photon.direction.x *= ni / nt;
         photon.direction.y *= ni / nt;
         photon.direction.z = cost;
@@ -1196,15 +1946,134 @@ void MonteCarlo<T,Nz,Nr,detector>::CrossDownOrNot(Photon<T>& photon) {
         if (debug && photon.number == debugPhoton)
             cout << "REFLECTED FROM BND" << endl;
         photon.direction.z *= -1;
+        photon.estimatedR = false;
+        photon.estimatedT = false;
     }
 }
 
-template < typename T, size_t Nz, size_t Nr, bool detector>
-void MonteCarlo<T,Nz,Nr,detector>::Roulette(Photon<T>& photon) {
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::EstimateFibers(Photon<T>& photon) {
+    const T top = layers[0].zUpper;
+    const T bottom = layers[layers.getNlayers() - 1].zLower;
+    photon.estimatedR = !fibersR.empty() && photon.coordinate.z - top <= fiberDepth;
+    photon.estimatedT = !fibersT.empty() && bottom - photon.coordinate.z <= fiberDepth;
+    if (photon.estimatedR)
+        for (const auto& fiber: fibersR)
+            fiber->expect(ExpectedFiberSignal(photon, *fiber, true));
+    if (photon.estimatedT)
+        for (const auto& fiber: fibersT)
+            fiber->expect(ExpectedFiberSignal(photon, *fiber, false));
+}
+
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+T MonteCarlo<T,Nz,Nr,detector,Tallies>::ExpectedFiberSignal(const Photon<T>& photon, const MonteCarlo_NS::OpticalFiber<T>& fiber, const bool& up) const {
+    using namespace Math_NS;
+    using namespace Physics_NS;
+    using namespace std;
+
+    const T surface = up ? layers[0].zUpper : layers[layers.getNlayers() - 1].zLower;
+    const T h = abs(photon.coordinate.z - surface);
+    if (h == 0)
+        return 0;
+
+    /// optical depth of the straight way to the surface, flights at angle theta see it over cos(theta)
+    const T tau = OpticalDepth(photon.coordinate.z, surface);
+
+    const T n = layers[0].n;
+    const T nOutside = up ? layers[0].nUpper : layers[layers.getNlayers() - 1].nLower;
+    const T g = layers[photon.layer].g;
+    /// acceptance cone refracted into the sample
+    const T sinInside = min(fiber.getSinAcceptance() * nOutside / n, T(1));
+    const T cosInside = sqrt(1 - sqr(sinInside));
+    /// no point of the core is seen within the cone
+    if (cosInside > 0 && sqrt(sqr(photon.coordinate.x - fiber.getOffset()) + sqr(photon.coordinate.y)) > h * sinInside / cosInside + fiber.getDiameter() / 2)
+        return 0;
+    const T coneSolidAngle = 2 * T(M_PI) * (1 - cosInside);
+    const T coreArea = T(M_PI) * sqr(fiber.getDiameter() / 2);
+
+    /// one exit point uniform over the core and one along a direction uniform in the cone,
+    /// weighted by the balance heuristic, so events right under the core do not blow up the variance
+    const auto sampleSignal = [&](const T& x, const T& y) -> T {
+        if (!fiber.inside(x, y))
+            return 0;
+        const T dx = x - photon.coordinate.x;
+        const T dy = y - photon.coordinate.y;
+        const T L2 = sqr(dx) + sqr(dy) + sqr(h);
+        const T L = sqrt(L2);
+        const T cosi = h / L;
+        if (cosi < cosInside)
+            return 0;
+        const Vector3D<T> direction(dx / L, dy / L, up ? -cosi : cosi);
+        const T signal = HenyeyGreenstein(photon.direction * direction, g) * exp(-tau / cosi)
+                       * (1 - FresnelReflectance<T>(n, nOutside, cosi)) * cosi / L2;
+        return signal / (1 / coreArea + cosi / (L2 * coneSolidAngle));
+    };
+
+    const T rho = fiber.getDiameter() / 2 * sqrt(random<T>(0, 1));
+    T sinA, cosA;
+    transportSincos<T>(2 * T(M_PI) * random<T>(0, 1), sinA, cosA);
+    const T coreSignal = sampleSignal(fiber.getOffset() + rho * cosA, rho * sinA);
+
+    const T cosTheta = 1 - random<T>(0, 1) * (1 - cosInside);
+    const T tanTheta = sqrt(1 - sqr(cosTheta)) / cosTheta;
+    transportSincos<T>(2 * T(M_PI) * random<T>(0, 1), sinA, cosA);
+    const T coneSignal = sampleSignal(photon.coordinate.x + h * tanTheta * cosA, photon.coordinate.y + h * tanTheta * sinA);
+
+    return photon.weight * (coreSignal + coneSignal);
+}
+
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::ScoreAdjoint(const Photon<T>& photon) {
     using namespace Math_NS;
+    using namespace Physics_NS;
     using namespace std;
 
-    if (photon.weight < threshold) {
+    const T E = lightSource.irradiance(photon.coordinate.x, photon.coordinate.y);
+    if (E == 0)
+        return;
+
+    /// beam comes along the normal, per unit solid angle outside the sample the exit cone widens by (n / nUpper)^2
+    const T n = layers[0].n;
+    const T nUpper = layers[0].nUpper;
+    const T tau = OpticalDepth(photon.coordinate.z, layers[0].zUpper);
+    adjointSignal += photon.weight * E * HenyeyGreenstein(-photon.direction.z, layers[photon.layer].g) * exp(-tau)
+                   * (1 - FresnelReflectance<T>(n, nUpper, T(1))) * sqr(nUpper / n);
+}
+
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+T MonteCarlo<T,Nz,Nr,detector,Tallies>::OpticalDepth(const T& z, const T& surface) const {
+    using namespace std;
+
+    T tau = 0;
+    for (int i = 0; i < layers.getNlayers(); i++)
+        tau += layers[i].mut * max(T(0), min(layers[i].zLower, max(surface, z)) - max(layers[i].zUpper, min(surface, z)));
+    return tau;
+}
+
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+bool MonteCarlo<T,Nz,Nr,detector,Tallies>::SplitAtBoundary(Photon<T>& photon, const T& Ri) {
+    if (photon.splits >= maxBoundarySplits || Ri <= 0 || Ri < minSplitReflectance || Ri >= 1)
+        return false;
+
+    photon.splits++;
+    Photon<T> reflected = photon;
+    reflected.weight *= Ri;
+    reflected.direction.z = -reflected.direction.z;
+    reflected.estimatedR = false;
+    reflected.estimatedT = false;
+    secondaries.push_back(reflected);
+    photon.weight *= 1 - Ri;
+    return true;
+}
+
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::Roulette(Photon<T>& photon) {
+    using namespace Math_NS;
+    using namespace std;
+
+    /// spectral photon lives while any wavelength carries weight
+    const T weight = spectral ? photon.weight * lanes.maxCoeff() : photon.weight;
+    if (weight < threshold) {
         const auto RND = random<T>(0, 1);
         if (debug && photon.number == debugPhoton)
             cout << "Kill? RND = " << RND << endl;
@@ -1218,37 +2087,97 @@ void MonteCarlo<T,Nz,Nr,detector>::Roulette(Photon<T>& photon) {
     }
 }
 
-template < typename T, size_t Nz, size_t Nr, bool detector>
-void MonteCarlo<T,Nz,Nr,detector>::Simulation(Photon<T>& photon, const int& num) {
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::ApplyWeightWindow(Photon<T>& photon) {
     using namespace Math_NS;
     using namespace std;
 
-    const auto startCoord = lightSource.getPhotonCoord();
-    results.sourceMatrix.push_back({startCoord.x, startCoord.y});
+    if (!photon.alive)
+        return;
+
+    const int ir = min(static_cast<int>(sqrt(sqr(photon.coordinate.x) + sqr(photon.coordinate.y)) / dr), static_cast<int>(Nr) - 1);
+    const T lower = windows.lower(CartesianGridPoint(photon.coordinate).z, ir);
+    if (lower == 0) {
+        Roulette(photon);
+        return;
+    }
+
+    if (photon.weight > lower * windows.ratio) {
+        const int copies = min(static_cast<int>(ceil(photon.weight / (lower * windows.ratio))), windows.maxSplit);
+        photon.weight /= copies;
+        for (int k = 1; k < copies; k++)
+            secondaries.push_back(photon);
+    } else if (photon.weight < lower) {
+        const T survival = windows.survival(lower);
+        if (random<T>(0, 1) * survival < photon.weight)
+            photon.weight = survival;
+        else
+            photon.alive = false;
+    }
+}
+
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::Simulation(Photon<T>& photon, const int& num, const Vector3D<T>& startCoord) {
+    using namespace Math_NS;
+    using namespace Utils_NS;
+    using namespace std;
+
+    if constexpr (Tallies::sourcePoints)
+        results.sourceMatrix.push_back({startCoord.x, startCoord.y});
 
     const auto startDir = Vector3D<T>(0, 0, 1); // normal incidence for now
     photon = Photon<T>(startCoord, startDir, 1.0, num);
+    quasiPoint = num;
+    std::fill(std::begin(quasiDecisions), std::end(quasiDecisions), 0);
+    if (spectral)
+        lanes.setOnes();
     FirstReflection(photon);
-    if (sample.getMedium(0).getMut() == 0) { // 1st layer is glass -- go directly to tissue
+    if (layers[0].mut == 0) { // 1st layer is glass -- go directly to tissue
         photon.layer = 1;
-        photon.coordinate.z = sample.CurrentUpperBorderZ(photon.layer);
+        photon.coordinate.z = layers[photon.layer].zUpper;
     }
     while(photon.alive)
        HopDropSpin(photon);
+    while (!secondaries.empty()) {
+        photon = secondaries.back();
+        secondaries.pop_back();
+        while (photon.alive)
+            HopDropSpin(photon);
+    }
+}
+
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::TracePhotons(const int& first, const int& last) {
+    using namespace std;
+
+    if constexpr (Tallies::sourcePoints)
+        results.sourceMatrix.reserve(results.sourceMatrix.size() + (last - first));
+    for (int i = first; i < last; i++) {
+        if (i % 1000 == 0 && homogenous == 0)
+            cerr << i << endl;
+        const int launch = (i - first) % LAUNCH_BATCH;
+        if (quasiFlights > 0)
+            launchPoints[launch] = QuasiLaunchPoint(i);
+        else if (launch == 0)
+            lightSource.getPhotonCoords(launchPoints.data(), min(LAUNCH_BATCH, last - i));
+        Photon<T> myPhoton;
+        Simulation(myPhoton, i, launchPoints[launch]);
+        // cout << RRspecular(0) << endl;
+    }
 }
 
-template < typename T, size_t Nz, size_t Nr, bool detector>
-T MonteCarlo<T,Nz,Nr,detector>::Volume(const T& ir) {
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+T MonteCarlo<T,Nz,Nr,detector,Tallies>::Volume(const T& ir) {
     return Area(ir) * dz;
 }
 
-template < typename T, size_t Nz, size_t Nr, bool detector>
-T MonteCarlo<T,Nz,Nr,detector>::Area(const T& ir) {
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+T MonteCarlo<T,Nz,Nr,detector,Tallies>::Area(const T& ir) {
     return 2 * M_PI * (ir - 0.5) * Math_NS::sqr(dr);
 }
 
-template < typename T, size_t Nz, size_t Nr, bool detector>
-Vector3D<int> MonteCarlo<T,Nz,Nr,detector>::CartesianGridPoint(const Vector3D<T>& point) {
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+Vector3D<int> MonteCarlo<T,Nz,Nr,detector,Tallies>::CartesianGridPoint(const Vector3D<T>& point) {
 //    std::cerr << point.x << " " << point.y << " " << point.z << std::endl;
     int iz = floor(point.z / dz);
     if (point.z < 0)
@@ -1262,7 +2191,7 @@ Vector3D<int> MonteCarlo<T,Nz,Nr,detector>::CartesianGridPoint(const Vector3D<T>
     else if (point.x >= 0 && point.x < radius)
         ix = Nr - 1 + floor(point.x / dx);
     else /*(point.x < 0 && point.x > -radius)*/
-        ix = Nr - 1 + floor(point.x / dx);
+        ix = std::max(0, static_cast<int>(Nr - 1 + floor(point.x / dx))); // voxel -1 is out of the volume
 
     if (point.y <= -radius)
         iy = 0;
@@ -1271,7 +2200,7 @@ Vector3D<int> MonteCarlo<T,Nz,Nr,detector>::CartesianGridPoint(const Vector3D<T>
     else if (point.y >= 0 && point.y < radius)
         iy = Nr - 1 + floor(point.y / dy);
     else/* (point.y < 0 && point.y > -radius)*/
-        iy = Nr - 1 + floor(point.y / dy);
+        iy = std::max(0, static_cast<int>(Nr - 1 + floor(point.y / dy))); // voxel -1 is out of the volume
 
     if (iz == Nz)
         iz -= 1;
@@ -1282,8 +2211,8 @@ Vector3D<int> MonteCarlo<T,Nz,Nr,detector>::CartesianGridPoint(const Vector3D<T>
     return Vector3D<int>(ix, iy, iz);
 }
 
-template < typename T, size_t Nz, size_t Nr, bool detector>
-Vector3D<T> MonteCarlo<T,Nz,Nr,detector>::CartesianCoord(const Vector3D<int>& point) {
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+Vector3D<T> MonteCarlo<T,Nz,Nr,detector,Tallies>::CartesianCoord(const Vector3D<int>& point) {
     T x, y, z;
     z = point.z * dz;
     x = (point.x - int(Nr - 1)) * dx;
@@ -1292,36 +2221,43 @@ Vector3D<T> MonteCarlo<T,Nz,Nr,detector>::CartesianCoord(const Vector3D<int>& po
     return Vector3D<T>(x, y, z);
 }
 
-template < typename T, size_t Nz, size_t Nr, bool detector>
-void MonteCarlo<T, Nz, Nr, detector >::Calculate(MCresults<T,Nz,Nr,detector>& res) {
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+void MonteCarlo<T,Nz,Nr,detector,Tallies>::Calculate(MCresults<T,Nz,Nr,detector>& res) {
     using namespace Physics_NS;
     using namespace Utils_NS;
     using namespace std;
 
-    for (int i = 0; i < Nphotons; i++) {
-        if (i % 1000 == 0 && homogenous == 0)
-            cerr << i << endl;
-        Photon<T> myPhoton;
-        Simulation(myPhoton, i);
-        // cout << RRspecular(0) << endl;
-    }
+    TracePhotons(0, Nphotons);
+    detectorsR.calibrate(Nphotons);
+    detectorsT.calibrate(Nphotons);
+    for (const auto& fiber: fibersR)
+        fiber->calibrate(Nphotons);
+    for (const auto& fiber: fibersT)
+        fiber->calibrate(Nphotons);
 
     results.arrayR = RR;
     results.arrayRspecular = RRspecular;
     results.arrayT = TT;
-    results.matrixA = A;
-    results.heatSource = A;
+    if constexpr (Tallies::absorptionGrid) {
+        results.matrixA = A;
+        results.heatSource = A;
 
 
-    for (int i = 0; i < Nz; i++)
-        for (int j = 0; j < Nr; j++) {
-            results.heatSource(i,j) /= (Volume(j+1));
-        }
-    results.heatSourceNorm = results.heatSource / Nphotons;
+        for (int i = 0; i < Nz; i++)
+            for (int j = 0; j < Nr; j++) {
+                results.heatSource(i,j) /= (Volume(j+1));
+            }
+        results.heatSourceNorm = results.heatSource / Nphotons;
+        results.absorbed = A.sum() / Nphotons;
+    } else {
+        results.matrixA.resize(0, 0);
+        results.heatSource.resize(0, 0);
+        results.heatSourceNorm.resize(0, 0);
+        results.absorbed = absorbedWeight / Nphotons;
+    }
     results.diffuseReflection = RR.sum() / Nphotons;
     results.specularReflection = RRspecular.sum() / Nphotons;
     results.diffuseTransmission = TT.sum() / Nphotons;
-    results.absorbed = A.sum() / Nphotons;
     results.arrayAnglesR = arrayAnglesR;
     results.arrayAnglesT = arrayAnglesT;
 
@@ -1338,9 +2274,13 @@ void MonteCarlo<T, Nz, Nr, detector >::Calculate(MCresults<T,Nz,Nr,detector>& re
         results.SpheresArrayR = SpheresArrayR;
         results.SpheresArrayT = SpheresArrayT;
         for (int i = 0; i < isize(SpheresArrayR); i++) {
+            results.SpheresArrayR[i].totalLight = spheresR->totalLight[i];
+            results.SpheresArrayT[i].totalLight = spheresT->totalLight[i];
             /// TODO: use {} instead to make pair
-            results.detectedR.push_back({SpheresArrayR[i].getDistance(), SpheresArrayR[i].totalLight / Nphotons});
-            results.detectedT.push_back({SpheresArrayT[i].getDistance(), SpheresArrayT[i].totalLight / Nphotons});
+            results.detectedR.push_back({SpheresArrayR[i].getDistance(), spheresR->detected[i]});
+            results.detectedT.push_back({SpheresArrayT[i].getDistance(), spheresT->detected[i]});
+            results.detectedRvariance.push_back({SpheresArrayR[i].getDistance(), spheresR->variance[i]});
+            results.detectedTvariance.push_back({SpheresArrayT[i].getDistance(), spheresT->variance[i]});
         }
     }
     /*
@@ -1363,9 +2303,173 @@ void MonteCarlo<T, Nz, Nr, detector >::Calculate(MCresults<T,Nz,Nr,detector>& re
     //*/
 }
 
-template < typename T, size_t Nz, size_t Nr, bool detector>
-MCresults<T,Nz,Nr,detector> MonteCarlo<T, Nz, Nr, detector >::CalculateResult() {
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+MCresults<T,Nz,Nr,detector> MonteCarlo<T,Nz,Nr,detector,Tallies>::CalculateResult() {
     MCresults<T,Nz,Nr,detector> res;
     Calculate(res);
     return res;
 }
+
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+std::vector<MCresults<T,Nz,Nr,detector>> MonteCarlo<T,Nz,Nr,detector,Tallies>::CalculateSpectrum() {
+    using namespace Physics_NS;
+    using namespace Utils_NS;
+    using namespace std;
+
+    MCresults<T,Nz,Nr,detector> reference;
+    Calculate(reference);
+
+    vector<MCresults<T,Nz,Nr,detector>> spectralResults(spectrum.getNwavelengths(), reference);
+    for (int k = 0; k < spectrum.getNwavelengths(); k++) {
+        auto& res = spectralResults[k];
+        res.arrayR = spectralRR.row(k);
+        res.arrayT = spectralTT.row(k);
+        for (int i = 0; i < Nz; i++)
+            for (int j = 0; j < Nr; j++)
+                res.matrixA(i,j) = spectralA(k, j * Nz + i);
+        res.heatSource = res.matrixA;
+
+        for (int i = 0; i < Nz; i++)
+            for (int j = 0; j < Nr; j++) {
+                res.heatSource(i,j) /= (Volume(j+1));
+            }
+        res.heatSourceNorm = res.heatSource / Nphotons;
+        res.diffuseReflection = res.arrayR.sum() / Nphotons;
+        res.diffuseTransmission = res.arrayT.sum() / Nphotons;
+        res.absorbed = res.matrixA.sum() / Nphotons;
+        res.arrayAnglesR = spectralAnglesR.row(k);
+        res.arrayAnglesT = spectralAnglesT.row(k);
+        /// second moments are tallied for the path without absorption only
+        res.detectedRvariance.clear();
+        res.detectedTvariance.clear();
+
+        const auto tau = [&](const int& layer) {
+            const auto medium = sample.getMedium(layer);
+            return (spectrum.getMua(layer)(k) + medium.getMus()) * medium.getD();
+        };
+        if (sample.getNlayers() == 1)
+            res.BugerTransmission = BugerLambert(tau(0), sample.getMedium(0).getN(), sample.getNvacLower(), sample.getNvacLower());
+        else
+            res.BugerTransmission = BugerLambert(tau(1), sample.getMedium(1).getN(), sample.getMedium(0).getN(), sample.getMedium(2).getN());
+
+        if (detector == 1)
+            for (int i = 0; i < isize(SpheresArrayR); i++) {
+                res.SpheresArrayR[i].totalLight = spectralDetectedR(k, i);
+                res.SpheresArrayT[i].totalLight = spectralDetectedT(k, i);
+                res.detectedR[i].second = spectralDetectedR(k, i) / Nphotons;
+                res.detectedT[i].second = spectralDetectedT(k, i) / Nphotons;
+            }
+    }
+    return spectralResults;
+}
+
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+std::vector<MCresults<T,Nz,Nr,detector>> MonteCarlo<T,Nz,Nr,detector,Tallies>::CalculateBeams(const std::vector<BeamProfile<T>>& newBeams) EXCEPT_INPUT_PARAMS {
+    CHECK_ARGUMENT_CONTRACT(lightSource.getType() == SourceType::Point);
+    CHECK_ARGUMENT_CONTRACT(homogenous);
+    CHECK_ARGUMENT_CONTRACT(!spectral);
+
+    beams = newBeams;
+    beamDetectedR = Matrix<T,Dynamic,Dynamic>::Zero(beams.size(), SpheresArrayR.size());
+    beamDetectedT = Matrix<T,Dynamic,Dynamic>::Zero(beams.size(), SpheresArrayT.size());
+
+    MCresults<T,Nz,Nr,detector> pointSpread;
+    Calculate(pointSpread);
+
+    std::vector<MCresults<T,Nz,Nr,detector>> beamResults(beams.size(), pointSpread);
+    for (int b = 0; b < static_cast<int>(beams.size()); b++) {
+        auto& res = beamResults[b];
+        /// totals and angles do not depend on launch point, launch points are not recorded
+        const Matrix<T,Dynamic,Dynamic> K = beams[b].kernel(dr, Nr);
+        res.arrayR = pointSpread.arrayR * K;
+        res.arrayRspecular = pointSpread.arrayRspecular * K;
+        res.arrayT = pointSpread.arrayT * K;
+        if constexpr (Tallies::absorptionGrid) {
+            res.matrixA = pointSpread.matrixA * K;
+            for (int i = 0; i < Nz; i++)
+                for (int j = 0; j < Nr; j++)
+                    res.heatSource(i,j) = res.matrixA(i,j) / Volume(j+1);
+            res.heatSourceNorm = res.heatSource / Nphotons;
+        }
+        res.sourceMatrix.clear();
+        /// second moments are tallied for the point source only
+        res.detectedRvariance.clear();
+        res.detectedTvariance.clear();
+        for (int i = 0; i < static_cast<int>(res.detectedR.size()); i++) {
+            res.detectedR[i].second = beamDetectedR(b, i) / Nphotons;
+            res.detectedT[i].second = beamDetectedT(b, i) / Nphotons;
+        }
+    }
+
+    beams.clear();
+    return beamResults;
+}
+
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies>
+T MonteCarlo<T,Nz,Nr,detector,Tallies>::CalculateAdjoint(const MonteCarlo_NS::OpticalFiber<T>& fiber, const bool& reflection) EXCEPT_INPUT_PARAMS {
+    using namespace Math_NS;
+    using namespace Physics_NS;
+    using namespace std;
+
+    CHECK_ARGUMENT_CONTRACT(lightSource.getType() != SourceType::Point);
+    CHECK_ARGUMENT_CONTRACT(homogenous && !spectral && quasiFlights == 0);
+    CHECK_ARGUMENT_CONTRACT(fibersR.empty() && fibersT.empty());
+    /// adjoint packets leave the sample only through scattering events, jumps have none
+    CHECK_ARGUMENT_CONTRACT(!handoff.enabled());
+    /// packets go straight from scattering events to the top
+    for (int i = 0; i < layers.getNlayers(); i++)
+        CHECK_ARGUMENT_CONTRACT(layers[i].mus > 0 && layers[i].n == layers[0].n);
+
+    const int last = layers.getNlayers() - 1;
+    const T n = layers[0].n;
+    const T nUpper = layers[0].nUpper;
+    const T nLower = layers[last].nLower;
+    const T nFiber = reflection ? nUpper : nLower;
+
+    /// unscattered part of the beam goes along the normal between the surfaces
+    const T Rtop = FresnelReflectance<T>(nUpper, n, T(1));
+    const T Rbottom = FresnelReflectance<T>(n, nLower, T(1));
+    const T attenuation = exp(-OpticalDepth(layers[last].zLower, layers[0].zUpper));
+    const T roundTrips = 1 / (1 - Rtop * Rbottom * sqr(attenuation));
+    const T unscattered = reflection ? Rtop + sqr(1 - Rtop) * Rbottom * sqr(attenuation) * roundTrips
+                                     : (1 - Rtop) * (1 - Rbottom) * attenuation * roundTrips;
+
+    const T sin2Acceptance = sqr(fiber.getSinAcceptance());
+    adjoint = true;
+    adjointSignal = 0;
+    T unscatteredSignal = 0;
+    for (int i = 0; i < Nphotons; i++) {
+        /// uniform over the core and cosine-weighted over the acceptance cone, as the fiber collects radiance
+        const T rho = fiber.getDiameter() / 2 * sqrt(random<T>(0, 1));
+        T sinA, cosA;
+        transportSincos<T>(2 * T(M_PI) * random<T>(0, 1), sinA, cosA);
+        const T x = fiber.getOffset() + rho * cosA;
+        const T y = rho * sinA;
+        unscatteredSignal += unscattered * lightSource.irradiance(x, y);
+
+        const T sinOutside = sqrt(random<T>(0, 1) * sin2Acceptance);
+        const T cosInside = TransmittanceCos(nFiber, n, sqrt(1 - sqr(sinOutside)));
+        if (cosInside == 0)
+            continue;
+        const T sinInside = sinOutside * nFiber / n;
+        transportSincos<T>(2 * T(M_PI) * random<T>(0, 1), sinA, cosA);
+        const Vector3D<T> start(x, y, reflection ? layers[0].zUpper : layers[last].zLower);
+        const Vector3D<T> direction(sinInside * cosA, sinInside * sinA, reflection ? cosInside : -cosInside);
+        Photon<T> packet(start, direction, 1 - FresnelReflectance<T>(nFiber, n, sqrt(1 - sqr(sinOutside))), i);
+        packet.layer = reflection ? 0 : last;
+        while (packet.alive)
+            HopDropSpin(packet);
+        while (!secondaries.empty()) {
+            packet = secondaries.back();
+            secondaries.pop_back();
+            while (packet.alive)
+                HopDropSpin(packet);
+        }
+    }
+    adjoint = false;
+
+    /// packets carry etendue of the fiber, reciprocity between sides of different refraction coefficients
+    /// scales radiance by their squared ratio
+    const T coreArea = T(M_PI) * sqr(fiber.getDiameter() / 2);
+    return (adjointSignal * T(M_PI) * sin2Acceptance * sqr(nFiber / nUpper) + unscatteredSignal) * coreArea / Nphotons;
+}
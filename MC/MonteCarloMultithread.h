@@ -1,13 +1,226 @@
 #pragma once
 
 #include "MonteCarlo.h"
+#include "PartialResults.h"
 
+#include "../Utils/ThreadPlacement.h"
 #include "../Utils/Utils.h"
 
+#include <cstdint>
+#include <memory>
 #include <thread>
+#include <tuple>
+#include <vector>
+
+namespace MonteCarloMultithreadDetail {
+    /// Copy of data shared by workers for one NUMA node,
+    /// shared read-only geometry is deep copied only if it is replicated per node
+    template < typename V >
+    V nodeLocal(const V& value, const bool&) {
+        return value;
+    }
+
+    template < typename V >
+    std::shared_ptr<const V> nodeLocal(const std::shared_ptr<const V>& value, const bool& replicate) {
+        return replicate && value ? std::make_shared<const V>(*value) : value;
+    }
+
+    /// Add tally to sum, tallies disabled by TallyPolicy are empty and leave sum empty
+    template < typename M >
+    void addTally(M& sum, const M& tally) {
+        if (tally.size() == 0)
+            sum.resize(tally.rows(), tally.cols());
+        else
+            sum += tally;
+    }
+
+    /// Add raw tallies of one worker to sum
+    template < typename T, size_t Nz, size_t Nr, bool detector >
+    void addTallies(MCresults<T,Nz,Nr,detector>& sum, const MCresults<T,Nz,Nr,detector>& result) {
+        sum.arrayR += result.arrayR;
+        sum.arrayRspecular += result.arrayRspecular;
+        sum.arrayT += result.arrayT;
+        addTally(sum.matrixA, result.matrixA);
+        addTally(sum.arrayAnglesR, result.arrayAnglesR);
+        addTally(sum.arrayAnglesT, result.arrayAnglesT);
+        addTally(sum.heatSource, result.heatSource);
+        if (result.heatSourceNorm.size() == 0)
+            sum.heatSourceNorm.resize(0, 0);
+        sum.absorbed += result.absorbed;
+
+        sum.mainSphereR = result.mainSphereR;
+        sum.mainSphereT = result.mainSphereT;
+        sum.lightSource = result.lightSource;
+        sum.sourceMatrix = result.sourceMatrix;
+        sum.BugerTransmission = result.BugerTransmission;
+
+        if (detector == 1) {
+            sum.detectedR.resize(result.detectedR.size());
+            sum.detectedT.resize(result.detectedR.size());
+            for (size_t i = 0; i < sum.detectedR.size(); i++) {
+                sum.detectedR[i].first = result.detectedR[i].first;
+                sum.detectedR[i].second += result.detectedR[i].second;
+                sum.detectedT[i].first = result.detectedT[i].first;
+                sum.detectedT[i].second += result.detectedT[i].second;
+            }
+            sum.detectedRvariance.resize(result.detectedRvariance.size());
+            sum.detectedTvariance.resize(result.detectedTvariance.size());
+            for (size_t i = 0; i < sum.detectedRvariance.size(); i++) {
+                sum.detectedRvariance[i].first = result.detectedRvariance[i].first;
+                sum.detectedRvariance[i].second += result.detectedRvariance[i].second;
+                sum.detectedTvariance[i].first = result.detectedTvariance[i].first;
+                sum.detectedTvariance[i].second += result.detectedTvariance[i].second;
+            }
+        }
+    }
+
+    /// Sum raw tallies of workers on every node on that node first, then sum node totals,
+    /// so only one total per node crosses the interconnect
+    /// \param[in] placement placement of workers
+    /// \param[in] result result(thread) is raw tallies of worker, MCresults or PartialResults
+    /// \param[out] finalResults sum of tallies of all workers
+    template < typename Tallies, typename Result >
+    void reduceTallies(const Utils_NS::ThreadPlacement& placement, const Result& result, Tallies& finalResults) {
+        using namespace std;
+
+        vector<unique_ptr<Tallies>> nodeSums(placement.getNnodes());
+        placement.runPerNode([&](const int& node) {
+            auto sum = make_unique<Tallies>();
+            for (const auto& thread: placement.getThreads(node))
+                addTallies(*sum, result(thread));
+            nodeSums[node] = move(sum);
+        });
+        for (const auto& sum: nodeSums)
+            addTallies(finalResults, *sum);
+    }
+
+    /// Normalize summed raw tallies of Np photons traced by threads workers
+    template < typename T, size_t Nz, size_t Nr, bool detector >
+    void normalizeTallies(MCresults<T,Nz,Nr,detector>& finalResults, const int& Np, const int& threads) {
+        finalResults.diffuseReflection   = finalResults.arrayR.sum()         / Np;
+        finalResults.specularReflection  = finalResults.arrayRspecular.sum() / Np;
+        finalResults.diffuseTransmission = finalResults.arrayT.sum()         / Np;
+        /// without absorption grid workers report normalized absorbed fractions
+        finalResults.absorbed            = finalResults.matrixA.size() == 0 ?
+                                           finalResults.absorbed / threads :
+                                           finalResults.matrixA.sum() / Np;
+        finalResults.arrayAnglesT        = finalResults.arrayAnglesT         / Np;
+        finalResults.arrayAnglesR        = finalResults.arrayAnglesR         / Np;
+        finalResults.heatSource          = finalResults.heatSource           / Np;
+
+        for (auto& detected: finalResults.detectedR)
+            detected.second /= threads;
+        for (auto& detected: finalResults.detectedT)
+            detected.second /= threads;
+        /// mean of independent thread estimates
+        for (auto& variance: finalResults.detectedRvariance)
+            variance.second /= Math_NS::sqr(threads);
+        for (auto& variance: finalResults.detectedTvariance)
+            variance.second /= Math_NS::sqr(threads);
+    }
+
+    /// Random streams of workers of a run split over Nshards processes,
+    /// thread of shard draws from stream thread * Nshards + shard, so shards never share a stream whatever their number of threads
+    struct WorkerStreams {
+        std::uint64_t seed = Math_NS::randomSeed();
+        int shard = 0;
+        int Nshards = 1;
+
+        inline std::uint64_t stream(const int& thread) const noexcept {
+            return static_cast<std::uint64_t>(thread) * Nshards + shard;
+        }
+    };
+
+    /// \brief Detectors of one worker thread, added to its MonteCarlo with addDetectorR and addDetectorT.
+    /// Workers do not share detectors, so every worker feeds its own group through its own batches
+    /// and calibrates it by its own photons, signals of the run are means over workers
+    template < typename T >
+    struct WorkerDetectors {
+        std::vector<std::shared_ptr<MonteCarlo_NS::DetectorInterface<T>>> reflection;
+        std::vector<std::shared_ptr<MonteCarlo_NS::DetectorInterface<T>>> transmission;
+    };
+
+    /// Number of photons of every worker thread, the first Np % threads threads trace one photon more, so workers trace all Np photons
+    inline std::vector<int> threadPhotons(const std::int64_t& Np, const int& threads) {
+        std::vector<int> photons(threads, static_cast<int>(Np / threads));
+        for (int thread = 0; thread < Np % threads; thread++)
+            photons[thread]++;
+        return photons;
+    }
+
+    /// Run workers on placed threads, geometry is passed to MonteCarlo constructor of every worker as is.
+    /// Sample, light source and geometry are copied on every node, tallies of a worker are allocated by its own thread,
+    /// so with pinned threads everything a worker touches in the hot loop lives on its NUMA node.
+    /// \param[in] detectors detectors[thread] are added to worker thread, empty if workers have none
+    /// \param[in] photons photons[thread] is number of photons traced by worker thread
+    /// \return raw results of every worker
+    /// \throw std::invalid_argument if ENABLE_CHECK_CONTRACTS is defined and detectors are neither empty nor given for every thread
+    /// or photons are not given for every thread
+    template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies = FullTallies, typename... Geometry >
+    std::vector<std::unique_ptr<MCresults<T,Nz,Nr,detector>>> runWorkerThreads(const Utils_NS::ThreadPlacement& placement, const WorkerStreams& streams,
+                    const std::vector<WorkerDetectors<T>>& detectors,
+                    const Sample<T>& sample, const std::vector<int>& photons, T z, T r,
+                    const IntegratingSphere<T>& sphereR, const IntegratingSphere<T>& sphereT,
+                    const DetectorDistance<T>& dist, const LightSource<T>& source, const Geometry&... geometry) {
+        using namespace std;
+
+        CHECK_ARGUMENT_CONTRACT(detectors.empty() || static_cast<int>(detectors.size()) == placement.getNthreads());
+        CHECK_ARGUMENT_CONTRACT(static_cast<int>(photons.size()) == placement.getNthreads());
+
+        const bool replicate = placement.getNnodes() > 1;
+
+        /// MonteCarlo keeps references to sample and light source, so node copies outlive workers
+        using Shared = tuple<Sample<T>, LightSource<T>, Geometry...>;
+        vector<unique_ptr<Shared>> shared(placement.getNnodes());
+        placement.runPerNode([&](const int& node) {
+            shared[node] = make_unique<Shared>(sample, source, nodeLocal(geometry, replicate)...);
+        });
+
+        vector<unique_ptr<MCresults<T,Nz,Nr,detector>>> mcResults(placement.getNthreads());
+        placement.run([&](const int& thread) {
+            Math_NS::seedRandom(streams.seed, streams.stream(thread));
+            auto result = make_unique<MCresults<T,Nz,Nr,detector>>();
+            apply([&](const Sample<T>& localSample, const LightSource<T>& localSource, const auto&... localGeometry) {
+                MonteCarlo<T,Nz,Nr,detector,Tallies> mc(localSample, photons[thread], z, r, sphereR, sphereT, dist, localSource, localGeometry...);
+                if (!detectors.empty()) {
+                    for (const auto& detectorR: detectors[thread].reflection)
+                        mc.addDetectorR(detectorR);
+                    for (const auto& detectorT: detectors[thread].transmission)
+                        mc.addDetectorT(detectorT);
+                }
+                mc.Calculate(*result);
+            }, *shared[placement.getNode(thread)]);
+            mcResults[thread] = move(result);
+        });
+        return mcResults;
+    }
+
+    template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies = FullTallies, typename... Geometry >
+    void runWorkers(const Sample<T>& sample, int Np, int threads, T z, T r,
+                    MCresults<T,Nz,Nr,detector>& finalResults,
+                    const IntegratingSphere<T>& sphereR, const IntegratingSphere<T>& sphereT,
+                    const DetectorDistance<T>& dist, const LightSource<T>& source,
+                    const std::vector<WorkerDetectors<T>>& detectors, const Geometry&... geometry) {
+        using namespace Physics_NS;
+        using namespace Utils_NS;
+
+        const ThreadPlacement placement(threads, PIN_WORKER_THREADS);
+        const auto mcResults = runWorkerThreads<T,Nz,Nr,detector,Tallies>(placement, WorkerStreams(), detectors, sample, std::vector<int>(threads, Np / threads), z, r, sphereR, sphereT, dist, source, geometry...);
+
+        reduceTallies(placement, [&](const int& thread) -> const MCresults<T,Nz,Nr,detector>& { return *mcResults[thread]; }, finalResults);
+
+        if (sample.getNlayers() == 1)
+            finalResults.BugerTransmission = BugerLambert(sample.getMedium(0).getTau(), sample.getMedium(0).getN(), sample.getNvacLower(), sample.getNvacLower());
+        else
+            finalResults.BugerTransmission = BugerLambert(sample.getMedium(1).getTau(), sample.getMedium(1).getN(), sample.getMedium(0).getN(), sample.getMedium(2).getN());
+
+        normalizeTallies(finalResults, Np, threads);
+    }
+}
 
 /// TODO: why not return result?
-template < typename T, size_t Nz, size_t Nr, bool detector >
+/// Tallies is TallyPolicy of workers, DetectorTallies skip everything but detector signals and totals
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies = FullTallies >
 void MCmultithread(const Sample<T>& sample,
                    int Np,
                    int threads,
@@ -18,81 +231,56 @@ void MCmultithread(const Sample<T>& sample,
                    const IntegratingSphere<T>& sphereT,
                    const DetectorDistance<T>& dist,
                    const LightSource<T>& source) {
-    using namespace Physics_NS;
-    using namespace Utils_NS;
-    using namespace std;
-
-    vector<MonteCarlo<T,Nz,Nr,detector>> mcDivided;
-    vector<thread> mcThreads;
-    vector<MCresults<T,Nz,Nr,detector>> mcResults;
-    // MonteCarlo<T,Nz,Nr,detector> mc(sample, (Np / threads), z, r);
-    for (int i = 0; i < threads; i++) {
-        mcDivided.push_back(MonteCarlo<T,Nz,Nr,detector>(sample, (Np / threads), z, r, sphereR, sphereT, dist, source));
-        mcResults.push_back(MCresults <T,Nz,Nr,detector>());
-    }
-
-    for (int i = 0; i < threads; i++)
-        mcThreads.push_back(thread(&MonteCarlo<T,Nz,Nr,detector>::Calculate, ref(mcDivided[i]), ref(mcResults[i])));
-    for (auto& thread: mcThreads)
-        thread.join();
-
-    for (const auto& result: mcResults) {
-        finalResults.arrayR += result.arrayR;
-        finalResults.arrayRspecular += result.arrayRspecular;
-        finalResults.arrayT += result.arrayT;
-        finalResults.matrixA += result.matrixA;
-        finalResults.arrayAnglesR += result.arrayAnglesR;
-        finalResults.arrayAnglesT += result.arrayAnglesT;
-        finalResults.heatSource += result.heatSource;
-
-        finalResults.mainSphereR = result.mainSphereR;
-        finalResults.mainSphereT = result.mainSphereT;
-        finalResults.lightSource = result.lightSource;
-        finalResults.sourceMatrix = result.sourceMatrix;
+    MonteCarloMultithreadDetail::runWorkers<T,Nz,Nr,detector,Tallies>(sample, Np, threads, z, r, finalResults, sphereR, sphereT, dist, source, {});
+}
 
-        if (detector == 1) {
-            finalResults.detectedR.resize(result.detectedR.size());
-            finalResults.detectedT.resize(result.detectedR.size());
-            for (int i = 0; i < isize(finalResults.detectedR); i++) {
-                finalResults.detectedR[i].second += result.detectedR[i].second;
-                finalResults.detectedT[i].second += result.detectedT[i].second;
-            }
-        }
-    }
+/// Run with detectors of every worker thread, see MonteCarloMultithreadDetail::WorkerDetectors
+/// \throw std::invalid_argument if ENABLE_CHECK_CONTRACTS is defined and detectors are not given for every thread
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies = FullTallies >
+void MCmultithread(const Sample<T>& sample,
+                   int Np,
+                   int threads,
+                   T z,
+                   T r,
+                   MCresults<T,Nz,Nr,detector>& finalResults,
+                   const IntegratingSphere<T>& sphereR,
+                   const IntegratingSphere<T>& sphereT,
+                   const DetectorDistance<T>& dist,
+                   const LightSource<T>& source,
+                   const std::vector<MonteCarloMultithreadDetail::WorkerDetectors<T>>& detectors) EXCEPT_INPUT_PARAMS {
+    CHECK_ARGUMENT_CONTRACT(static_cast<int>(detectors.size()) == threads);
 
-    if (sample.getNlayers() == 1)
-        finalResults.BugerTransmission = BugerLambert(sample.getMedium(0).getTau(), sample.getMedium(0).getN(), sample.getNvacLower(), sample.getNvacLower());
-    else
-        finalResults.BugerTransmission = BugerLambert(sample.getMedium(1).getTau(), sample.getMedium(1).getN(), sample.getMedium(0).getN(), sample.getMedium(2).getN());
-
-
-    finalResults.diffuseReflection   = finalResults.arrayR.sum()         / Np;
-    finalResults.specularReflection  = finalResults.arrayRspecular.sum() / Np;
-    finalResults.diffuseTransmission = finalResults.arrayT.sum()         / Np;
-    finalResults.absorbed            = finalResults.matrixA.sum()        / Np;
-    finalResults.arrayAnglesT        = finalResults.arrayAnglesT         / Np;
-    finalResults.arrayAnglesR        = finalResults.arrayAnglesR         / Np;
-    finalResults.heatSource          = finalResults.heatSource           / Np;
-
-    for (int i = 0; i < isize(finalResults.detectedR); i++) {
-        finalResults.detectedR[i].first = mcResults[0].detectedR[i].first;
-        finalResults.detectedR[i].second /= threads;
-        finalResults.detectedT[i].first = mcResults[0].detectedT[i].first;
-        finalResults.detectedT[i].second /= threads;
-    }
+    MonteCarloMultithreadDetail::runWorkers<T,Nz,Nr,detector,Tallies>(sample, Np, threads, z, r, finalResults, sphereR, sphereT, dist, source, detectors);
 }
 
-template < typename T, size_t Nz, size_t Nr, bool detector >
+template < typename T, size_t Nz, size_t Nr, bool detector, typename Tallies = FullTallies >
 MCresults<T,Nz,Nr,detector> MCmultithread(const Sample<T>& sample, int Np, int threads, T z, T r,
                                           const IntegratingSphere<T>& sphereR, const IntegratingSphere<T>& sphereT,
                                           const DetectorDistance<T> dist, const LightSource<T> source) {
     MCresults<T,Nz,Nr,detector> finalResults;
-    MCmultithread(sample, Np, threads, z, r, finalResults, sphereR, sphereT, dist, source);
+    MCmultithread<T,Nz,Nr,detector,Tallies>(sample, Np, threads, z, r, finalResults, sphereR, sphereT, dist, source);
     return finalResults;
 }
 
-/// yeah the code is repeated but im so tired
+/// geometry is passed to MonteCarlo constructor of every thread as is:
+/// shared HeterogeneousVolume with optional TrackingMode or shared InclusionScene
+template < typename T, size_t Nz, size_t Nr, bool detector, typename... Geometry >
+void heterogeneousMCmultithread(const Sample<T>& sample,
+                   int Np,
+                   int threads,
+                   T z,
+                   T r,
+                   MCresults<T,Nz,Nr,detector>& finalResults,
+                   const IntegratingSphere<T>& sphereR,
+                   const IntegratingSphere<T>& sphereT,
+                   const DetectorDistance<T>& dist,
+                   const LightSource<T>& source,
+                   const Geometry&... geometry) {
+    MonteCarloMultithreadDetail::runWorkers<T,Nz,Nr,detector>(sample, Np, threads, z, r, finalResults, sphereR, sphereT, dist, source, {}, geometry...);
+}
 
+/// coag volume is built once here and shared by all threads,
+/// build it with HeterogeneousVolume<T>::create and pass it directly to reuse it between runs on the same phantom
 template < typename T, size_t Nz, size_t Nr, bool detector >
 void heterogeneousMCmultithread(const Sample<T>& sample,
                    int Np,
@@ -104,77 +292,95 @@ void heterogeneousMCmultithread(const Sample<T>& sample,
                    const IntegratingSphere<T>& sphereT,
                    const DetectorDistance<T>& dist,
                    const LightSource<T>& source,
-                   const Matrix<T,Dynamic,Dynamic>& coagMatrix) {
-    using namespace Physics_NS;
+                   const Matrix<T,Dynamic,Dynamic>& coagMatrix,
+                   const TrackingMode& tracking = TrackingMode::VoxelWalk) {
+    heterogeneousMCmultithread(sample, Np, threads, z, r, finalResults, sphereR, sphereT, dist, source, HeterogeneousVolume<T>::create(coagMatrix, sample.getTurbidMedium().getN()), tracking);
+}
+
+template < typename T, size_t Nz, size_t Nr, bool detector, typename... Geometry >
+MCresults<T,Nz,Nr,detector> heterogeneousMCmultithread(const Sample<T>& sample, int Np, int threads, T z, T r,
+                                          const IntegratingSphere<T>& sphereR, const IntegratingSphere<T>& sphereT,
+                                          const DetectorDistance<T> dist, const LightSource<T> source, const Geometry&... geometry) {
+    MCresults<T,Nz,Nr,detector> finalResults;
+    heterogeneousMCmultithread(sample, Np, threads, z, r, finalResults, sphereR, sphereT, dist, source, geometry...);
+    return finalResults;
+}
+
+template < typename T, size_t Nz, size_t Nr, bool detector >
+MCresults<T,Nz,Nr,detector> heterogeneousMCmultithread(const Sample<T>& sample, int Np, int threads, T z, T r,
+                                          const IntegratingSphere<T>& sphereR, const IntegratingSphere<T>& sphereT,
+                                          const DetectorDistance<T> dist, const LightSource<T> source, const Matrix<T,Dynamic,Dynamic>& coagMatrix,
+                                          const TrackingMode& tracking = TrackingMode::VoxelWalk) {
+    return heterogeneousMCmultithread<T,Nz,Nr,detector>(sample, Np, threads, z, r, sphereR, sphereT, dist, source, HeterogeneousVolume<T>::create(coagMatrix, sample.getTurbidMedium().getN()), tracking);
+}
+
+
+/// single-path multi-wavelength run, samples must differ only in absorption,
+/// one path is traced for all of them and results of every sample are returned in the same order
+template < typename T, size_t Nz, size_t Nr, bool detector >
+std::vector<MCresults<T,Nz,Nr,detector>> spectralMCmultithread(const std::vector<Sample<T>>& samples, int Np, int threads, T z, T r,
+                                                              const IntegratingSphere<T>& sphereR, const IntegratingSphere<T>& sphereT,
+                                                              const DetectorDistance<T> dist, const LightSource<T> source) {
+    using namespace MonteCarloMultithreadDetail;
     using namespace Utils_NS;
     using namespace std;
 
-    vector<MonteCarlo<T,Nz,Nr,detector>> mcDivided;
-    vector<thread> mcThreads;
-    vector<MCresults<T,Nz,Nr,detector>> mcResults;
-    // MonteCarlo<T,Nz,Nr,detector> mc(sample, (Np / threads), z, r);
-    for (int i = 0; i < threads; i++) {
-        mcDivided.push_back(MonteCarlo<T,Nz,Nr,detector>(sample, (Np / threads), z, r, sphereR, sphereT, dist, source, coagMatrix));
-        mcResults.push_back(MCresults <T,Nz,Nr,detector>());
-    }
+    const auto spectrum = Spectrum<T>::fromSamples(samples);
+    const ThreadPlacement placement(threads, PIN_WORKER_THREADS);
 
-    for (int i = 0; i < threads; i++)
-        mcThreads.push_back(thread(&MonteCarlo<T,Nz,Nr,detector>::Calculate, ref(mcDivided[i]), ref(mcResults[i])));
-    for (auto& thread: mcThreads)
-        thread.join();
-
-    for (const auto& result: mcResults) {
-        finalResults.arrayR += result.arrayR;
-        finalResults.arrayRspecular += result.arrayRspecular;
-        finalResults.arrayT += result.arrayT;
-        finalResults.matrixA += result.matrixA;
-        finalResults.arrayAnglesR += result.arrayAnglesR;
-        finalResults.arrayAnglesT += result.arrayAnglesT;
-        finalResults.heatSource += result.heatSource;
-
-        finalResults.mainSphereR = result.mainSphereR;
-        finalResults.mainSphereT = result.mainSphereT;
-        finalResults.lightSource = result.lightSource;
-        finalResults.sourceMatrix = result.sourceMatrix;
+    using Shared = tuple<Sample<T>, LightSource<T>, Spectrum<T>>;
+    vector<unique_ptr<Shared>> shared(placement.getNnodes());
+    placement.runPerNode([&](const int& node) {
+        shared[node] = make_unique<Shared>(samples.front(), source, spectrum);
+    });
 
-        if (detector == 1) {
-            finalResults.detectedR.resize(result.detectedR.size());
-            finalResults.detectedT.resize(result.detectedR.size());
-            for (int i = 0; i < isize(finalResults.detectedR); i++) {
-                finalResults.detectedR[i].second += result.detectedR[i].second;
-                finalResults.detectedT[i].second += result.detectedT[i].second;
-            }
-        }
-    }
+    const auto seed = Math_NS::randomSeed();
+    vector<vector<MCresults<T,Nz,Nr,detector>>> mcResults(threads);
+    placement.run([&](const int& thread) {
+        Math_NS::seedRandom(seed, thread);
+        const auto& [localSample, localSource, localSpectrum] = *shared[placement.getNode(thread)];
+        MonteCarlo<T,Nz,Nr,detector> mc(localSample, (Np / threads), z, r, sphereR, sphereT, dist, localSource, localSpectrum);
+        mcResults[thread] = mc.CalculateSpectrum();
+    });
 
-    if (sample.getNlayers() == 1)
-        finalResults.BugerTransmission = BugerLambert(sample.getMedium(0).getTau(), sample.getMedium(0).getN(), sample.getNvacLower(), sample.getNvacLower());
-    else
-        finalResults.BugerTransmission = BugerLambert(sample.getMedium(1).getTau(), sample.getMedium(1).getN(), sample.getMedium(0).getN(), sample.getMedium(2).getN());
-
-
-    finalResults.diffuseReflection   = finalResults.arrayR.sum()         / Np;
-    finalResults.specularReflection  = finalResults.arrayRspecular.sum() / Np;
-    finalResults.diffuseTransmission = finalResults.arrayT.sum()         / Np;
-    finalResults.absorbed            = finalResults.matrixA.sum()        / Np;
-    finalResults.arrayAnglesT        = finalResults.arrayAnglesT         / Np;
-    finalResults.arrayAnglesR        = finalResults.arrayAnglesR         / Np;
-    finalResults.heatSource          = finalResults.heatSource           / Np;
-
-    for (int i = 0; i < isize(finalResults.detectedR); i++) {
-        finalResults.detectedR[i].first = mcResults[0].detectedR[i].first;
-        finalResults.detectedR[i].second /= threads;
-        finalResults.detectedT[i].first = mcResults[0].detectedT[i].first;
-        finalResults.detectedT[i].second /= threads;
+    vector<MCresults<T,Nz,Nr,detector>> finalResults(samples.size());
+    for (int k = 0; k < isize(samples); k++) {
+        reduceTallies(placement, [&](const int& thread) -> const MCresults<T,Nz,Nr,detector>& { return mcResults[thread][k]; }, finalResults[k]);
+        normalizeTallies(finalResults[k], Np, threads);
     }
+    return finalResults;
 }
 
-template < typename T, size_t Nz, size_t Nr, bool detector >
-MCresults<T,Nz,Nr,detector> heterogeneousMCmultithread(const Sample<T>& sample, int Np, int threads, T z, T r,
-                                          const IntegratingSphere<T>& sphereR, const IntegratingSphere<T>& sphereT,
-                                          const DetectorDistance<T> dist, const LightSource<T> source, const Matrix<T,Dynamic,Dynamic>& coagMatrix) {
-    MCresults<T,Nz,Nr,detector> finalResults;
-    heterogeneousMCmultithread(sample, Np, threads, z, r, finalResults, sphereR, sphereT, dist, source, coagMatrix);
-    return finalResults;
+/// Number of photons of shard of a run split over Nshards processes,
+/// shard k traces photons [k * Np / Nshards, (k + 1) * Np / Nshards) of the run, so slices cover it without overlap
+inline std::int64_t shardPhotons(const std::int64_t& Np, const int& shard, const int& Nshards) noexcept {
+    return Np * (shard + 1) / Nshards - Np * shard / Nshards;
 }
 
+/// Shard of a run split over Nshards processes, partial results of all shards are merged with mergePartialResults.
+/// All shards must use the same seed, their threads draw from distinct streams of it.
+/// Geometry is passed to MonteCarlo constructor of every thread as in heterogeneousMCmultithread.
+/// \return raw tallies of shard, photons of shard which do not divide evenly between threads are traced by its first threads
+/// \throw std::invalid_argument if ENABLE_CHECK_CONTRACTS is defined and shard is not in [0, Nshards) or threads is not positive
+template < typename T, size_t Nz, size_t Nr, bool detector, typename... Geometry >
+PartialResults<T,Nz,Nr,detector> shardMCmultithread(const Sample<T>& sample, std::int64_t Np, int shard, int Nshards, std::uint64_t seed, int threads, T z, T r,
+                                                    const IntegratingSphere<T>& sphereR, const IntegratingSphere<T>& sphereT,
+                                                    const DetectorDistance<T> dist, const LightSource<T> source, const Geometry&... geometry) EXCEPT_INPUT_PARAMS {
+    using namespace MonteCarloMultithreadDetail;
+    using namespace Utils_NS;
+    using namespace std;
+
+    CHECK_ARGUMENT_CONTRACT(Nshards > 0 && shard >= 0 && shard < Nshards);
+    CHECK_ARGUMENT_CONTRACT(threads > 0);
+
+    const ThreadPlacement placement(threads, PIN_WORKER_THREADS);
+    const auto photons = threadPhotons(shardPhotons(Np, shard, Nshards), threads);
+    const auto mcResults = runWorkerThreads<T,Nz,Nr,detector>(placement, WorkerStreams{seed, shard, Nshards}, {}, sample, photons, z, r, sphereR, sphereT, dist, source, geometry...);
+
+    /// Nphotons of partial sums exact photon counts of workers
+    PartialResults<T,Nz,Nr,detector> partial;
+    reduceTallies(placement, [&](const int& thread) { return toPartialResults(*mcResults[thread], photons[thread]); }, partial);
+    partial.shard = shard;
+    partial.Nshards = Nshards;
+    return partial;
+}
@@ -0,0 +1,345 @@
+#pragma once
+
+#include "MonteCarlo.h"
+
+#include "../eigen/Eigen/Dense"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+/// \brief Raw tallies of a part of a run: one worker thread or one shard of a run split over processes
+/// Tallies are sums over photons, not normalized, so partials of one run are merged exactly by summation
+/// and normalized once by the total number of traced photons.
+template < typename T, size_t Nz, size_t Nr, bool detector >
+struct PartialResults {
+    std::int64_t Nphotons = 0;
+    /// index of the shard and number of shards of the run
+    int shard = 0;
+    int Nshards = 1;
+    T BugerTransmission = 0;
+
+    Matrix<T,Dynamic,Dynamic> matrixA = Matrix<T, Nz, Nr>::Constant(0);
+    Matrix<T,1,Dynamic> arrayR = Matrix<T, 1, Nr>::Constant(0);
+    Matrix<T,1,Dynamic> arrayRspecular = Matrix<T, 1, Nr>::Constant(0);
+    Matrix<T,1,Dynamic> arrayT = Matrix<T, 1, Nr>::Constant(0);
+    Matrix<T,Dynamic,Dynamic> heatSource = Matrix<T, Nz, Nr>::Constant(0);
+
+    Matrix<T,1,Dynamic> arrayAnglesR = Matrix<T, 1, 100>::Constant(0);
+    Matrix<T,1,Dynamic> arrayAnglesT = Matrix<T, 1, 100>::Constant(0);
+
+    /// detector distance and total light caught by the sphere
+    std::vector<std::pair<T,T>> detectedR;
+    std::vector<std::pair<T,T>> detectedT;
+    /// detector distance and variance of detected light times squared number of photons,
+    /// so variances of independent parts add up like the other tallies
+    std::vector<std::pair<T,T>> detectedRvariance;
+    std::vector<std::pair<T,T>> detectedTvariance;
+};
+
+/// Raw tallies of one MonteCarlo worker
+/// \param[in] results results of MonteCarlo::Calculate
+/// \param[in] Nphotons number of photons traced by the worker
+/// \return raw tallies
+template < typename T, size_t Nz, size_t Nr, bool detector >
+PartialResults<T,Nz,Nr,detector> toPartialResults(const MCresults<T,Nz,Nr,detector>& results, const std::int64_t& Nphotons);
+
+/// Add raw tallies of one part of a run to sum
+/// \param[in,out] sum tallies to add to, empty sum takes detector distances of part
+/// \param[in] part tallies to add
+/// \throw std::invalid_argument if parts have different detectors or unscattered transmission
+template < typename T, size_t Nz, size_t Nr, bool detector >
+void addTallies(PartialResults<T,Nz,Nr,detector>& sum, const PartialResults<T,Nz,Nr,detector>& part);
+
+/// Merge partial results of all shards of one run
+/// Shards are summed in order of their indices, so the result does not depend on the order of partials.
+/// \param[in] partials partial results of every shard of the run, each shard exactly once
+/// \return results normalized by the total number of photons
+/// \throw std::invalid_argument if partials is empty, shards are missing or repeated or partials do not belong to one run
+template < typename T, size_t Nz, size_t Nr, bool detector >
+MCresults<T,Nz,Nr,detector> mergePartialResults(std::vector<PartialResults<T,Nz,Nr,detector>> partials);
+
+/// Normalize raw tallies into results
+/// \param[in] partial raw tallies of a whole run
+/// \return results normalized by the number of photons
+template < typename T, size_t Nz, size_t Nr, bool detector >
+MCresults<T,Nz,Nr,detector> normalizedResults(const PartialResults<T,Nz,Nr,detector>& partial);
+
+/// Write partial results to binary file, values are stored in native byte order
+/// \param[in] partial partial results
+/// \param[in] fileName file name
+/// \throw std::invalid_argument if file cannot be written
+template < typename T, size_t Nz, size_t Nr, bool detector >
+void writePartialResults(const PartialResults<T,Nz,Nr,detector>& partial, const std::string& fileName);
+
+/// Read partial results from binary file written by writePartialResults
+/// \param[in] fileName file name
+/// \return partial results
+/// \throw std::invalid_argument if file cannot be read, is truncated or was written for other T, Nz, Nr or detector
+template < typename T, size_t Nz, size_t Nr, bool detector >
+PartialResults<T,Nz,Nr,detector> readPartialResults(const std::string& fileName);
+
+/******************
+ * IMPLEMENTATION *
+ ******************/
+
+namespace PartialResultsDetail {
+    constexpr char MAGIC[8] = {'M', 'C', 'P', 'A', 'R', 'T', '0', '2'};
+
+    template < typename V >
+    void writeValue(std::ofstream& file, const V& value) {
+        file.write(reinterpret_cast<const char*>(&value), sizeof(V));
+    }
+
+    template < typename V >
+    V readValue(std::ifstream& file) {
+        V value;
+        if (!file.read(reinterpret_cast<char*>(&value), sizeof(V)))
+            throw std::invalid_argument("Partial results file is truncated");
+        return value;
+    }
+
+    template < typename M >
+    void writeMatrix(std::ofstream& file, const M& matrix) {
+        writeValue<std::int64_t>(file, matrix.rows());
+        writeValue<std::int64_t>(file, matrix.cols());
+        /// Eigen matrices are contiguous
+        file.write(reinterpret_cast<const char*>(matrix.data()), sizeof(typename M::Scalar) * matrix.size());
+    }
+
+    template < typename M >
+    void readMatrix(std::ifstream& file, M& matrix) {
+        const auto rows = readValue<std::int64_t>(file);
+        const auto cols = readValue<std::int64_t>(file);
+        if (rows != matrix.rows() || cols != matrix.cols())
+            throw std::invalid_argument("Partial results file has tallies of other size");
+        if (!file.read(reinterpret_cast<char*>(matrix.data()), sizeof(typename M::Scalar) * matrix.size()))
+            throw std::invalid_argument("Partial results file is truncated");
+    }
+
+    template < typename T >
+    void writePairs(std::ofstream& file, const std::vector<std::pair<T,T>>& pairs) {
+        writeValue<std::int64_t>(file, pairs.size());
+        for (const auto& [first, second]: pairs) {
+            writeValue(file, first);
+            writeValue(file, second);
+        }
+    }
+
+    template < typename T >
+    void readPairs(std::ifstream& file, std::vector<std::pair<T,T>>& pairs) {
+        const auto size = readValue<std::int64_t>(file);
+        if (size < 0 || size > (1 << 20))
+            throw std::invalid_argument("Partial results file is corrupted");
+        pairs.resize(size);
+        for (auto& [first, second]: pairs) {
+            first  = readValue<T>(file);
+            second = readValue<T>(file);
+        }
+    }
+
+    /// add tallies of detectors of part to sum, detectors must be at the same distances
+    template < typename T >
+    void addPairs(std::vector<std::pair<T,T>>& sum, const std::vector<std::pair<T,T>>& part) {
+        if (sum.size() != part.size())
+            throw std::invalid_argument("Partial results have different detectors");
+        for (size_t i = 0; i < sum.size(); i++) {
+            if (sum[i].first != part[i].first)
+                throw std::invalid_argument("Partial results have different detectors");
+            sum[i].second += part[i].second;
+        }
+    }
+}
+
+template < typename T, size_t Nz, size_t Nr, bool detector >
+PartialResults<T,Nz,Nr,detector> toPartialResults(const MCresults<T,Nz,Nr,detector>& results, const std::int64_t& Nphotons) {
+    PartialResults<T,Nz,Nr,detector> partial;
+    partial.Nphotons = Nphotons;
+    partial.BugerTransmission = results.BugerTransmission;
+    partial.matrixA = results.matrixA;
+    partial.arrayR = results.arrayR;
+    partial.arrayRspecular = results.arrayRspecular;
+    partial.arrayT = results.arrayT;
+    partial.heatSource = results.heatSource;
+    /// angular distributions of a worker are raw, they are normalized only after merging
+    partial.arrayAnglesR = results.arrayAnglesR;
+    partial.arrayAnglesT = results.arrayAnglesT;
+
+    if (detector == 1) {
+        for (const auto& sphere: results.SpheresArrayR)
+            partial.detectedR.push_back({sphere.getDistance(), sphere.totalLight});
+        for (const auto& sphere: results.SpheresArrayT)
+            partial.detectedT.push_back({sphere.getDistance(), sphere.totalLight});
+        /// variances of results are of light per photon
+        const T squaredPhotons = Math_NS::sqr(static_cast<T>(Nphotons));
+        for (const auto& [distance, variance]: results.detectedRvariance)
+            partial.detectedRvariance.push_back({distance, variance * squaredPhotons});
+        for (const auto& [distance, variance]: results.detectedTvariance)
+            partial.detectedTvariance.push_back({distance, variance * squaredPhotons});
+    }
+    return partial;
+}
+
+template < typename T, size_t Nz, size_t Nr, bool detector >
+void addTallies(PartialResults<T,Nz,Nr,detector>& sum, const PartialResults<T,Nz,Nr,detector>& part) {
+    using namespace PartialResultsDetail;
+    using namespace std;
+
+    if (sum.Nphotons == 0 && sum.detectedR.empty() && sum.detectedT.empty()) {
+        sum.BugerTransmission = part.BugerTransmission;
+        sum.detectedR = part.detectedR;
+        sum.detectedT = part.detectedT;
+        sum.detectedRvariance = part.detectedRvariance;
+        sum.detectedTvariance = part.detectedTvariance;
+        for (auto* detected: {&sum.detectedR, &sum.detectedT, &sum.detectedRvariance, &sum.detectedTvariance})
+            for (auto& tally: *detected)
+                tally.second = 0;
+    }
+    if (sum.BugerTransmission != part.BugerTransmission)
+        throw invalid_argument("Partial results are of different samples");
+
+    sum.Nphotons += part.Nphotons;
+    sum.matrixA += part.matrixA;
+    sum.arrayR += part.arrayR;
+    sum.arrayRspecular += part.arrayRspecular;
+    sum.arrayT += part.arrayT;
+    sum.heatSource += part.heatSource;
+    sum.arrayAnglesR += part.arrayAnglesR;
+    sum.arrayAnglesT += part.arrayAnglesT;
+    addPairs(sum.detectedR, part.detectedR);
+    addPairs(sum.detectedT, part.detectedT);
+    addPairs(sum.detectedRvariance, part.detectedRvariance);
+    addPairs(sum.detectedTvariance, part.detectedTvariance);
+}
+
+template < typename T, size_t Nz, size_t Nr, bool detector >
+MCresults<T,Nz,Nr,detector> mergePartialResults(std::vector<PartialResults<T,Nz,Nr,detector>> partials) {
+    using namespace std;
+
+    if (partials.empty())
+        throw invalid_argument("No partial results to merge");
+
+    sort(partials.begin(), partials.end(), [](const auto& a, const auto& b) { return a.shard < b.shard; });
+    const int Nshards = partials.front().Nshards;
+    if (static_cast<int>(partials.size()) != Nshards)
+        throw invalid_argument("Expected " + to_string(Nshards) + " shards, got " + to_string(partials.size()));
+
+    PartialResults<T,Nz,Nr,detector> sum;
+    for (int i = 0; i < Nshards; i++) {
+        if (partials[i].shard != i || partials[i].Nshards != Nshards)
+            throw invalid_argument("Shards of the run are missing or repeated");
+        addTallies(sum, partials[i]);
+    }
+    return normalizedResults(sum);
+}
+
+template < typename T, size_t Nz, size_t Nr, bool detector >
+MCresults<T,Nz,Nr,detector> normalizedResults(const PartialResults<T,Nz,Nr,detector>& partial) {
+    MCresults<T,Nz,Nr,detector> results;
+    const T Np = static_cast<T>(partial.Nphotons);
+
+    results.BugerTransmission = partial.BugerTransmission;
+    results.matrixA = partial.matrixA;
+    results.arrayR = partial.arrayR;
+    results.arrayRspecular = partial.arrayRspecular;
+    results.arrayT = partial.arrayT;
+
+    results.diffuseReflection   = partial.arrayR.sum()         / Np;
+    results.specularReflection  = partial.arrayRspecular.sum() / Np;
+    results.diffuseTransmission = partial.arrayT.sum()         / Np;
+    results.absorbed            = partial.matrixA.sum()        / Np;
+    results.arrayAnglesR        = partial.arrayAnglesR         / Np;
+    results.arrayAnglesT        = partial.arrayAnglesT         / Np;
+    results.heatSource          = partial.heatSource           / Np;
+
+    for (const auto& [distance, light]: partial.detectedR)
+        results.detectedR.push_back({distance, light / Np});
+    for (const auto& [distance, light]: partial.detectedT)
+        results.detectedT.push_back({distance, light / Np});
+    for (const auto& [distance, variance]: partial.detectedRvariance)
+        results.detectedRvariance.push_back({distance, variance / (Np * Np)});
+    for (const auto& [distance, variance]: partial.detectedTvariance)
+        results.detectedTvariance.push_back({distance, variance / (Np * Np)});
+    return results;
+}
+
+template < typename T, size_t Nz, size_t Nr, bool detector >
+void writePartialResults(const PartialResults<T,Nz,Nr,detector>& partial, const std::string& fileName) {
+    using namespace PartialResultsDetail;
+    using namespace std;
+
+    ofstream file(fileName, ios::binary);
+    if (!file.is_open())
+        throw invalid_argument("Failed to open file " + fileName);
+
+    file.write(MAGIC, sizeof(MAGIC));
+    writeValue<std::int32_t>(file, sizeof(T));
+    writeValue<std::int64_t>(file, Nz);
+    writeValue<std::int64_t>(file, Nr);
+    writeValue<std::int32_t>(file, detector);
+
+    writeValue<std::int64_t>(file, partial.Nphotons);
+    writeValue<std::int32_t>(file, partial.shard);
+    writeValue<std::int32_t>(file, partial.Nshards);
+    writeValue(file, partial.BugerTransmission);
+
+    writeMatrix(file, partial.matrixA);
+    writeMatrix(file, partial.arrayR);
+    writeMatrix(file, partial.arrayRspecular);
+    writeMatrix(file, partial.arrayT);
+    writeMatrix(file, partial.heatSource);
+    writeMatrix(file, partial.arrayAnglesR);
+    writeMatrix(file, partial.arrayAnglesT);
+    writePairs(file, partial.detectedR);
+    writePairs(file, partial.detectedT);
+    writePairs(file, partial.detectedRvariance);
+    writePairs(file, partial.detectedTvariance);
+
+    if (!file)
+        throw invalid_argument("Failed to write file " + fileName);
+}
+
+template < typename T, size_t Nz, size_t Nr, bool detector >
+PartialResults<T,Nz,Nr,detector> readPartialResults(const std::string& fileName) {
+    using namespace PartialResultsDetail;
+    using namespace std;
+
+    ifstream file(fileName, ios::binary);
+    if (!file.is_open())
+        throw invalid_argument("Failed to open file " + fileName);
+
+    char magic[sizeof(MAGIC)];
+    if (!file.read(magic, sizeof(magic)) || memcmp(magic, MAGIC, sizeof(MAGIC)) != 0)
+        throw invalid_argument(fileName + " is not a partial results file");
+    if (readValue<std::int32_t>(file) != static_cast<std::int32_t>(sizeof(T)) ||
+        readValue<std::int64_t>(file) != static_cast<std::int64_t>(Nz) ||
+        readValue<std::int64_t>(file) != static_cast<std::int64_t>(Nr) ||
+        readValue<std::int32_t>(file) != detector)
+        throw invalid_argument(fileName + " was written for other precision, grid or detector");
+
+    PartialResults<T,Nz,Nr,detector> partial;
+    partial.Nphotons = readValue<std::int64_t>(file);
+    partial.shard = readValue<std::int32_t>(file);
+    partial.Nshards = readValue<std::int32_t>(file);
+    partial.BugerTransmission = readValue<T>(file);
+    if (partial.Nphotons < 0 || partial.Nshards < 1 || partial.shard < 0 || partial.shard >= partial.Nshards)
+        throw invalid_argument(fileName + " is corrupted");
+
+    readMatrix(file, partial.matrixA);
+    readMatrix(file, partial.arrayR);
+    readMatrix(file, partial.arrayRspecular);
+    readMatrix(file, partial.arrayT);
+    readMatrix(file, partial.heatSource);
+    readMatrix(file, partial.arrayAnglesR);
+    readMatrix(file, partial.arrayAnglesT);
+    readPairs(file, partial.detectedR);
+    readPairs(file, partial.detectedT);
+    readPairs(file, partial.detectedRvariance);
+    readPairs(file, partial.detectedTvariance);
+    return partial;
+}
@@ -0,0 +1,251 @@
+#pragma once
+
+#ifndef ENABLE_CHECK_CONTRACTS
+    #define ENABLE_CHECK_CONTRACTS
+#endif // ENABLE_CHECK_CONTRACTS
+
+#include "MonteCarloMultithread.h"
+#include "PartialResults.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace Eigen;
+using namespace std;
+
+class PartialResultsTests : public ::testing::Test {
+protected:
+    using T = double;
+
+    static constexpr size_t Nz = 20;
+    static constexpr size_t Nr = 50;
+    static constexpr bool detector = 1;
+    using Partial = PartialResults<T,Nz,Nr,detector>;
+
+    static constexpr int Np = 20000;
+    static constexpr T d = 1E-3;
+    static constexpr T radius = 1E-2;
+
+    IntegratingSphere<T> sphereR{0.0508, 0.0125, 0.0125};
+    IntegratingSphere<T> sphereT{0.0508, 0.0125, 0.0};
+    DetectorDistance<T>  dist{0, 0.01, 0.002};
+    LightSource<T> source{0.0005, SourceType::Circle};
+    Sample<T> sample{{Medium<T>::fromCoeffs(1.5, 0, 0, 1E-3, 0), Medium<T>::fromCoeffs(1.4, 100, 3000, d, 0.8), Medium<T>::fromCoeffs(1.5, 0, 0, 1E-3, 0)}, 1, 1};
+
+    /// partial with random tallies
+    static Partial randomPartial(const int& shard, const int& Nshards, const unsigned& seed) {
+        mt19937 generator(seed);
+        uniform_real_distribution<T> value(0, 100);
+        const auto fill = [&](auto& matrix) {
+            for (int i = 0; i < matrix.size(); i++)
+                matrix.data()[i] = value(generator);
+        };
+
+        Partial partial;
+        partial.Nphotons = 1000 + shard;
+        partial.shard = shard;
+        partial.Nshards = Nshards;
+        partial.BugerTransmission = 0.25;
+        fill(partial.matrixA);
+        fill(partial.arrayR);
+        fill(partial.arrayRspecular);
+        fill(partial.arrayT);
+        fill(partial.heatSource);
+        fill(partial.arrayAnglesR);
+        fill(partial.arrayAnglesT);
+        for (int i = 0; i < 5; i++) {
+            partial.detectedR.push_back({0.002 * i, value(generator)});
+            partial.detectedT.push_back({0.002 * i, value(generator)});
+            partial.detectedRvariance.push_back({0.002 * i, value(generator)});
+            partial.detectedTvariance.push_back({0.002 * i, value(generator)});
+        }
+        return partial;
+    }
+
+    static void expectEqual(const Partial& a, const Partial& b) {
+        EXPECT_EQ(a.Nphotons, b.Nphotons);
+        EXPECT_EQ(a.shard, b.shard);
+        EXPECT_EQ(a.Nshards, b.Nshards);
+        EXPECT_EQ(a.BugerTransmission, b.BugerTransmission);
+        EXPECT_EQ(a.matrixA, b.matrixA);
+        EXPECT_EQ(a.arrayR, b.arrayR);
+        EXPECT_EQ(a.arrayRspecular, b.arrayRspecular);
+        EXPECT_EQ(a.arrayT, b.arrayT);
+        EXPECT_EQ(a.heatSource, b.heatSource);
+        EXPECT_EQ(a.arrayAnglesR, b.arrayAnglesR);
+        EXPECT_EQ(a.arrayAnglesT, b.arrayAnglesT);
+        EXPECT_EQ(a.detectedR, b.detectedR);
+        EXPECT_EQ(a.detectedT, b.detectedT);
+        EXPECT_EQ(a.detectedRvariance, b.detectedRvariance);
+        EXPECT_EQ(a.detectedTvariance, b.detectedTvariance);
+    }
+
+    string tempFile(const string& name) const {
+        return ::testing::TempDir() + name;
+    }
+};
+
+TEST_F(PartialResultsTests, ShardPhotonsCoverRun) {
+    for (const int Nshards: {1, 3, 7, 64}) {
+        int64_t total = 0;
+        for (int shard = 0; shard < Nshards; shard++) {
+            const auto photons = shardPhotons(1'000'000'007LL, shard, Nshards);
+            EXPECT_LE(abs(photons - 1'000'000'007LL / Nshards), 1);
+            total += photons;
+        }
+        EXPECT_EQ(total, 1'000'000'007LL);
+    }
+}
+
+TEST_F(PartialResultsTests, ThreadPhotonsCoverShard) {
+    EXPECT_EQ(MonteCarloMultithreadDetail::threadPhotons(10, 4), (vector<int>{3, 3, 2, 2}));
+    EXPECT_EQ(MonteCarloMultithreadDetail::threadPhotons(8, 4), (vector<int>{2, 2, 2, 2}));
+    EXPECT_EQ(MonteCarloMultithreadDetail::threadPhotons(2, 3), (vector<int>{1, 1, 0}));
+}
+
+TEST_F(PartialResultsTests, ShardsTraceEveryPhoton) {
+    /// 20000 photons do not divide evenly between 3 shards of 2 threads
+    int64_t total = 0;
+    for (int shard = 0; shard < 3; shard++) {
+        const auto partial = shardMCmultithread<T,Nz,Nr,detector>(sample, Np, shard, 3, 5, 2, 3 * d, radius, sphereR, sphereT, dist, source);
+        EXPECT_EQ(partial.Nphotons, shardPhotons(Np, shard, 3));
+        total += partial.Nphotons;
+    }
+    EXPECT_EQ(total, Np);
+}
+
+TEST_F(PartialResultsTests, WriteReadRoundTrip) {
+    const auto partial = randomPartial(2, 3, 1);
+    const auto fileName = tempFile("PartialResultsRoundTrip.bin");
+    writePartialResults(partial, fileName);
+    expectEqual(readPartialResults<T,Nz,Nr,detector>(fileName), partial);
+    remove(fileName.c_str());
+}
+
+TEST_F(PartialResultsTests, ReadThrows) {
+    const auto fileName = tempFile("PartialResultsWrongGrid.bin");
+    writePartialResults(randomPartial(0, 1, 1), fileName);
+    EXPECT_THROW((readPartialResults<T,Nz + 1,Nr,detector>(fileName)), invalid_argument);
+    EXPECT_THROW((readPartialResults<float,Nz,Nr,detector>(fileName)), invalid_argument);
+
+    /// truncated file
+    ifstream in(fileName, ios::binary);
+    string content((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    in.close();
+    ofstream(fileName, ios::binary) << content.substr(0, content.size() / 2);
+    EXPECT_THROW((readPartialResults<T,Nz,Nr,detector>(fileName)), invalid_argument);
+
+    ofstream(fileName, ios::binary) << "not a partial results file";
+    EXPECT_THROW((readPartialResults<T,Nz,Nr,detector>(fileName)), invalid_argument);
+    remove(fileName.c_str());
+
+    EXPECT_THROW((readPartialResults<T,Nz,Nr,detector>(tempFile("PartialResultsMissing.bin"))), invalid_argument);
+}
+
+TEST_F(PartialResultsTests, MergeIsExactSumOfShards) {
+    vector<Partial> partials;
+    for (int shard = 0; shard < 4; shard++)
+        partials.push_back(randomPartial(shard, 4, shard + 10));
+
+    Partial sum = partials[0];
+    for (int shard = 1; shard < 4; shard++) {
+        sum.Nphotons += partials[shard].Nphotons;
+        sum.matrixA += partials[shard].matrixA;
+        sum.arrayR += partials[shard].arrayR;
+        sum.arrayRspecular += partials[shard].arrayRspecular;
+        sum.arrayT += partials[shard].arrayT;
+        sum.heatSource += partials[shard].heatSource;
+        sum.arrayAnglesR += partials[shard].arrayAnglesR;
+        sum.arrayAnglesT += partials[shard].arrayAnglesT;
+        for (int i = 0; i < 5; i++) {
+            sum.detectedR[i].second += partials[shard].detectedR[i].second;
+            sum.detectedT[i].second += partials[shard].detectedT[i].second;
+            sum.detectedRvariance[i].second += partials[shard].detectedRvariance[i].second;
+            sum.detectedTvariance[i].second += partials[shard].detectedTvariance[i].second;
+        }
+    }
+    const auto expected = normalizedResults(sum);
+
+    /// order of partials does not matter
+    reverse(partials.begin(), partials.end());
+    const auto merged = mergePartialResults(partials);
+
+    EXPECT_EQ(merged.matrixA, expected.matrixA);
+    EXPECT_EQ(merged.arrayR, expected.arrayR);
+    EXPECT_EQ(merged.heatSource, expected.heatSource);
+    EXPECT_EQ(merged.arrayAnglesR, expected.arrayAnglesR);
+    EXPECT_EQ(merged.diffuseReflection, expected.diffuseReflection);
+    EXPECT_EQ(merged.absorbed, expected.absorbed);
+    EXPECT_EQ(merged.detectedR, expected.detectedR);
+    EXPECT_EQ(merged.detectedT, expected.detectedT);
+    EXPECT_EQ(merged.detectedRvariance, expected.detectedRvariance);
+    EXPECT_EQ(merged.detectedTvariance, expected.detectedTvariance);
+    ASSERT_EQ(merged.detectedRvariance.size(), 5);
+    EXPECT_EQ(merged.detectedRvariance[1].second, sum.detectedRvariance[1].second / (sum.Nphotons * sum.Nphotons));
+    EXPECT_EQ(merged.BugerTransmission, 0.25);
+    EXPECT_EQ(merged.diffuseTransmission, sum.arrayT.sum() / sum.Nphotons);
+}
+
+TEST_F(PartialResultsTests, MergeThrows) {
+    EXPECT_THROW(mergePartialResults(vector<Partial>()), invalid_argument);
+    EXPECT_THROW(mergePartialResults(vector<Partial>{randomPartial(0, 3, 1), randomPartial(1, 3, 2)}), invalid_argument);
+    EXPECT_THROW(mergePartialResults(vector<Partial>{randomPartial(0, 2, 1), randomPartial(0, 2, 2)}), invalid_argument);
+
+    auto otherDetectors = randomPartial(1, 2, 2);
+    otherDetectors.detectedR[1].first = 1;
+    EXPECT_THROW(mergePartialResults(vector<Partial>{randomPartial(0, 2, 1), otherDetectors}), invalid_argument);
+
+    auto otherVariances = randomPartial(1, 2, 2);
+    otherVariances.detectedTvariance.pop_back();
+    EXPECT_THROW(mergePartialResults(vector<Partial>{randomPartial(0, 2, 1), otherVariances}), invalid_argument);
+
+    auto otherSample = randomPartial(1, 2, 2);
+    otherSample.BugerTransmission = 0.5;
+    EXPECT_THROW(mergePartialResults(vector<Partial>{randomPartial(0, 2, 1), otherSample}), invalid_argument);
+}
+
+TEST_F(PartialResultsTests, ShardsAreReproducibleAndIndependent) {
+    const auto shard0 = shardMCmultithread<T,Nz,Nr,detector>(sample, Np, 0, 2, 42, 1, 3 * d, radius, sphereR, sphereT, dist, source);
+    const auto again0 = shardMCmultithread<T,Nz,Nr,detector>(sample, Np, 0, 2, 42, 1, 3 * d, radius, sphereR, sphereT, dist, source);
+    const auto shard1 = shardMCmultithread<T,Nz,Nr,detector>(sample, Np, 1, 2, 42, 1, 3 * d, radius, sphereR, sphereT, dist, source);
+
+    expectEqual(shard0, again0);
+    EXPECT_EQ(shard0.Nphotons, Np / 2);
+    EXPECT_NE(shard0.matrixA, shard1.matrixA);
+}
+
+TEST_F(PartialResultsTests, MergedShardsMatchSingleRun) {
+    vector<Partial> partials;
+    for (int shard = 0; shard < 3; shard++)
+        partials.push_back(shardMCmultithread<T,Nz,Nr,detector>(sample, Np, shard, 3, 7, 2, 3 * d, radius, sphereR, sphereT, dist, source));
+    const auto merged = mergePartialResults(partials);
+    const auto single = MCmultithread<T,Nz,Nr,detector>(sample, Np, 2, 3 * d, radius, sphereR, sphereT, dist, source);
+
+    EXPECT_NEAR(merged.specularReflection, single.specularReflection, 1E-12);
+    EXPECT_DOUBLE_EQ(merged.BugerTransmission, single.BugerTransmission);
+    EXPECT_NEAR(merged.diffuseReflection  , single.diffuseReflection  , 0.05 * single.diffuseReflection  );
+    EXPECT_NEAR(merged.diffuseTransmission, single.diffuseTransmission, 0.05 * single.diffuseTransmission);
+    EXPECT_NEAR(merged.absorbed           , single.absorbed           , 0.05 * single.absorbed           );
+    ASSERT_EQ(merged.detectedR.size(), single.detectedR.size());
+    /// sphere signals are noisier than totals
+    for (size_t i = 0; i < single.detectedR.size(); i++) {
+        EXPECT_EQ(merged.detectedR[i].first, single.detectedR[i].first);
+        EXPECT_NEAR(merged.detectedR[i].second, single.detectedR[i].second, 0.15 * single.detectedR[i].second + 1E-3);
+        EXPECT_NEAR(merged.detectedT[i].second, single.detectedT[i].second, 0.15 * single.detectedT[i].second + 1E-3);
+    }
+    /// variances of shards of one run add up to the variance of the whole run
+    ASSERT_EQ(merged.detectedRvariance.size(), single.detectedRvariance.size());
+    ASSERT_EQ(merged.detectedTvariance.size(), single.detectedTvariance.size());
+    for (size_t i = 0; i < single.detectedRvariance.size(); i++) {
+        EXPECT_EQ(merged.detectedRvariance[i].first, single.detectedRvariance[i].first);
+        EXPECT_GT(merged.detectedRvariance[i].second, 0);
+        EXPECT_NEAR(merged.detectedRvariance[i].second, single.detectedRvariance[i].second, 0.3 * single.detectedRvariance[i].second);
+        EXPECT_NEAR(merged.detectedTvariance[i].second, single.detectedTvariance[i].second, 0.3 * single.detectedTvariance[i].second + 1E-12);
+    }
+}
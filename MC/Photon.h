@@ -22,6 +22,10 @@ public:
     int layer = 0;
     int stepN = 0;
     int number = 0;
+    int splits = 0; // splittings at internal boundaries in the history of the packet
+    int scatterings = 0; // scattering events counted for diffusion handoff
+    bool estimatedR = false; // exit of the current flight through the top was tallied by fiber estimators at its scattering event
+    bool estimatedT = false; // the same for the bottom
     bool alive = true;
 };
 
@@ -0,0 +1,104 @@
+#pragma once
+
+#ifndef ENABLE_CHECK_CONTRACTS
+    #define ENABLE_CHECK_CONTRACTS
+#endif // ENABLE_CHECK_CONTRACTS
+
+#include "MonteCarlo.h"
+
+#include "../Math/Basic.h"
+#include "../Math/Random.h"
+
+#include <gtest/gtest.h>
+
+using namespace Eigen;
+using namespace std;
+
+class QuasiRandomTests : public ::testing::Test {
+protected:
+    using T = double;
+
+    static constexpr size_t Nz = 20;
+    static constexpr size_t Nr = 20;
+    static constexpr bool detector = 1;
+
+    static constexpr int Np = 10000;
+    static constexpr T d = 1E-3;
+    static constexpr T radius = 1E-2;
+
+    IntegratingSphere<T> sphereR{0.0508, 0.0125, 0.0125};
+    IntegratingSphere<T> sphereT{0.0508, 0.0125, 0.0};
+    DetectorDistance<T>  dist{0, 0.1, 0.05};
+    const LightSource<T> source{1E-3, SourceType::Circle};
+
+    const Medium<T> glass = Medium<T>::fromCoeffs(1.5, 0, 0, 1E-3, 0);
+    /// optical thickness about 1, signals are decided within the first flights
+    const Sample<T> sample{{glass, Medium<T>::fromCoeffs(1.4, 100, 1000, d, 0.9), glass}, 1, 1};
+
+    MCresults<T,Nz,Nr,detector> run(const int& flights, const std::uint64_t& seed, const int& photons = Np) const {
+        Math_NS::seedRandom(seed);
+        MonteCarlo<T,Nz,Nr,detector> mc(sample, photons, 3 * d, radius, sphereR, sphereT, dist, source);
+        mc.setQuasiRandom(flights);
+        return mc.CalculateResult();
+    }
+
+    /// spread of diffuse transmission and signal of the nearest T sphere over independent runs
+    pair<T,T> replicateVariance(const int& flights, const int& replicates) const {
+        T sumT = 0, squaresT = 0, sumSphere = 0, squaresSphere = 0;
+        for (int i = 0; i < replicates; i++) {
+            const auto result = run(flights, 100 + i);
+            sumT += result.diffuseTransmission;
+            squaresT += Math_NS::sqr(result.diffuseTransmission);
+            sumSphere += result.detectedT[0].second;
+            squaresSphere += Math_NS::sqr(result.detectedT[0].second);
+        }
+        return {squaresT / replicates - Math_NS::sqr(sumT / replicates), squaresSphere / replicates - Math_NS::sqr(sumSphere / replicates)};
+    }
+};
+
+TEST_F(QuasiRandomTests, DisabledKeepsRun) {
+    Math_NS::seedRandom(1);
+    MonteCarlo<T,Nz,Nr,detector> plain(sample, Np, 3 * d, radius, sphereR, sphereT, dist, source);
+    const auto reference = plain.CalculateResult();
+    const auto result = run(0, 1);
+
+    EXPECT_EQ(result.diffuseReflection, reference.diffuseReflection);
+    EXPECT_EQ(result.diffuseTransmission, reference.diffuseTransmission);
+    EXPECT_EQ(result.matrixA, reference.matrixA);
+    EXPECT_EQ(result.detectedR, reference.detectedR);
+}
+
+TEST_F(QuasiRandomTests, QuasiRandomRunIsUnbiased) {
+    const auto analog = run(0, 2, 10 * Np);
+    for (const int& flights: {1, MonteCarlo<T,Nz,Nr,detector>::QUASI_FLIGHTS}) {
+        const auto quasi = run(flights, 3, 10 * Np);
+        EXPECT_NEAR(quasi.diffuseReflection  , analog.diffuseReflection  , 0.03 * analog.diffuseReflection  );
+        EXPECT_NEAR(quasi.diffuseTransmission, analog.diffuseTransmission, 0.01 * analog.diffuseTransmission);
+        EXPECT_NEAR(quasi.absorbed           , analog.absorbed           , 0.03 * analog.absorbed           );
+        EXPECT_NEAR(quasi.specularReflection + quasi.diffuseReflection + quasi.diffuseTransmission + quasi.absorbed, 1, 1E-2);
+        for (size_t i = 0; i < analog.detectedR.size(); i++) {
+            EXPECT_LT(abs(quasi.detectedR[i].second - analog.detectedR[i].second), 4 * sqrt(2 * analog.detectedRvariance[i].second));
+            EXPECT_LT(abs(quasi.detectedT[i].second - analog.detectedT[i].second), 4 * sqrt(2 * analog.detectedTvariance[i].second));
+        }
+    }
+}
+
+TEST_F(QuasiRandomTests, QuasiRandomRunConvergesFaster) {
+    /// about 10 times smaller variance is typical, 20 replicates estimate it within a factor of 2
+    constexpr int replicates = 20;
+    const auto [analogT, analogSphere] = replicateVariance(0, replicates);
+    const auto [quasiT, quasiSphere] = replicateVariance(MonteCarlo<T,Nz,Nr,detector>::QUASI_FLIGHTS, replicates);
+    EXPECT_LT(3 * quasiT, analogT);
+    EXPECT_LT(3 * quasiSphere, analogSphere);
+}
+
+TEST_F(QuasiRandomTests, Throws) {
+    MonteCarlo<T,Nz,Nr,detector> mc(sample, 10, 3 * d, radius, sphereR, sphereT, dist, source);
+    EXPECT_THROW(mc.setQuasiRandom(-1), invalid_argument);
+    EXPECT_THROW(mc.setQuasiRandom(MonteCarlo<T,Nz,Nr,detector>::QUASI_FLIGHTS + 1), invalid_argument);
+
+    const auto tissue = Sample<T>({Medium<T>::fromCoeffs(1.4, 100, 3000, d, 0.8)}, 1, 1);
+    const Matrix<T,Dynamic,Dynamic> coag = Matrix<T,Dynamic,Dynamic>::Ones(Nz, Nr);
+    MonteCarlo<T,Nz,Nr,detector> heterogeneous(tissue, 10, d, radius, sphereR, sphereT, dist, source, coag);
+    EXPECT_THROW(heterogeneous.setQuasiRandom(), invalid_argument);
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#ifndef ENABLE_CHECK_CONTRACTS
+    #define ENABLE_CHECK_CONTRACTS
+#endif // ENABLE_CHECK_CONTRACTS
+
+#include "MonteCarlo.h"
+#include "MonteCarloMultithread.h"
+#include "Spectrum.h"
+
+#include <gtest/gtest.h>
+
+using namespace Eigen;
+using namespace std;
+
+class SpectralMonteCarloTests : public ::testing::Test {
+protected:
+    using T = double;
+
+    static constexpr size_t Nz = 20;
+    static constexpr size_t Nr = 50;
+    static constexpr bool detector = 1;
+
+    static constexpr int Np = 20000;
+    static constexpr T d = 1E-3;
+    static constexpr T radius = 1E-2;
+    static constexpr T n = 1.4;
+    static constexpr T mus = 3000;
+    static constexpr T g = 0.8;
+
+    IntegratingSphere<T> sphereR{0.0508, 0.0125, 0.0125};
+    IntegratingSphere<T> sphereT{0.0508, 0.0125, 0.0};
+    DetectorDistance<T>  dist{0, 0.01, 0.002};
+    LightSource<T> source{0.0005, SourceType::Circle};
+
+    /// tissue between glass slides
+    Sample<T> tissue(const T& mua) const {
+        const auto glass = Medium<T>::fromCoeffs(1.5, 0, 0, 1E-3, 0);
+        const auto medium = Medium<T>::fromCoeffs(n, mua, mus, d, g);
+        return Sample<T>({glass, medium, glass}, 1, 1);
+    }
+
+    vector<Sample<T>> tissues(const vector<T>& muas) const {
+        vector<Sample<T>> samples;
+        for (const auto& mua: muas)
+            samples.push_back(tissue(mua));
+        return samples;
+    }
+
+    /// MonteCarlo keeps reference to sample, so sample must outlive it
+    vector<MCresults<T,Nz,Nr,detector>> run(const vector<Sample<T>>& samples) const {
+        MonteCarlo<T,Nz,Nr,detector> mc(samples.front(), Np, 3 * d, radius, sphereR, sphereT, dist, source, Spectrum<T>::fromSamples(samples));
+        return mc.CalculateSpectrum();
+    }
+};
+
+TEST_F(SpectralMonteCarloTests, SpectrumFromSamples) {
+    const auto spectrum = Spectrum<T>::fromSamples(tissues({10, 100, 500}));
+
+    EXPECT_EQ(spectrum.getNwavelengths(), 3);
+    EXPECT_EQ(spectrum.getNlayers(), 3);
+    EXPECT_TRUE((spectrum.getMua(0) == 0).all());
+    EXPECT_EQ(spectrum.getMua(1)(0), 10);
+    EXPECT_EQ(spectrum.getMua(1)(1), 100);
+    EXPECT_EQ(spectrum.getMua(1)(2), 500);
+}
+
+TEST_F(SpectralMonteCarloTests, SpectrumThrowsForSamplesDifferentInScattering) {
+    auto samples = tissues({10, 100});
+    const auto glass = Medium<T>::fromCoeffs(1.5, 0, 0, 1E-3, 0);
+    samples.push_back(Sample<T>({glass, Medium<T>::fromCoeffs(n, 10, 2 * mus, d, g), glass}, 1, 1));
+
+    EXPECT_THROW(Spectrum<T>::fromSamples(samples), std::invalid_argument);
+    EXPECT_THROW(Spectrum<T>::fromSamples({}), std::invalid_argument);
+    EXPECT_THROW(Spectrum<T>(Matrix<T,Dynamic,Dynamic>::Constant(Spectrum<T>::MAX_WAVELENGTHS + 1, 3, 1)), std::invalid_argument);
+    EXPECT_THROW(Spectrum<T>(Matrix<T,Dynamic,Dynamic>::Constant(2, 3, -1)), std::invalid_argument);
+}
+
+TEST_F(SpectralMonteCarloTests, ThrowsForAbsorptionInGlass) {
+    const auto sample = tissue(10);
+    const Spectrum<T> spectrum(Matrix<T,Dynamic,Dynamic>::Constant(2, 3, 10));
+
+    EXPECT_THROW((MonteCarlo<T,Nz,Nr,detector>(sample, Np, 3 * d, radius, sphereR, sphereT, dist, source, spectrum)), std::invalid_argument);
+}
+
+TEST_F(SpectralMonteCarloTests, LanesMatchSingleWavelengthRuns) {
+    const vector<T> muas = {10, 100, 500};
+    const auto samples = tissues(muas);
+    const auto spectral = run(samples);
+    ASSERT_EQ(spectral.size(), muas.size());
+
+    for (size_t k = 0; k < muas.size(); k++) {
+        MonteCarlo<T,Nz,Nr,detector> mc(samples[k], Np, 3 * d, radius, sphereR, sphereT, dist, source);
+        const auto single = mc.CalculateResult();
+
+        EXPECT_NEAR(spectral[k].specularReflection, single.specularReflection, 1E-12);
+        EXPECT_DOUBLE_EQ(spectral[k].BugerTransmission, single.BugerTransmission);
+        EXPECT_NEAR(spectral[k].diffuseReflection  , single.diffuseReflection  , 0.05 * single.diffuseReflection  );
+        EXPECT_NEAR(spectral[k].diffuseTransmission, single.diffuseTransmission, 0.05 * single.diffuseTransmission);
+        EXPECT_NEAR(spectral[k].absorbed           , single.absorbed           , 0.05 * single.absorbed           );
+        /// sphere signals are noisier than totals
+        for (size_t i = 0; i < single.detectedR.size(); i++) {
+            EXPECT_NEAR(spectral[k].detectedR[i].second, single.detectedR[i].second, 0.15 * single.detectedR[i].second + 1E-3);
+            EXPECT_NEAR(spectral[k].detectedT[i].second, single.detectedT[i].second, 0.15 * single.detectedT[i].second + 1E-3);
+        }
+    }
+}
+
+TEST_F(SpectralMonteCarloTests, EnergyIsConservedInEveryLane) {
+    const auto spectral = run(tissues({0, 10, 100, 500, 5000}));
+
+    for (const auto& lane: spectral)
+        EXPECT_NEAR(lane.specularReflection + lane.diffuseReflection + lane.diffuseTransmission + lane.absorbed, 1, 0.01);
+    EXPECT_EQ(spectral[0].matrixA.sum(), 0);
+    /// absorption only takes light away
+    for (size_t k = 1; k < spectral.size(); k++) {
+        EXPECT_LT(spectral[k].diffuseReflection  , spectral[k - 1].diffuseReflection  );
+        EXPECT_LT(spectral[k].diffuseTransmission, spectral[k - 1].diffuseTransmission);
+        EXPECT_GT(spectral[k].absorbed           , spectral[k - 1].absorbed           );
+    }
+}
+
+TEST_F(SpectralMonteCarloTests, MultithreadMatchesSingleThread) {
+    const auto samples = tissues({10, 100});
+    const auto single = run(samples);
+    const auto multi = spectralMCmultithread<T,Nz,Nr,detector>(samples, Np, 2, 3 * d, radius, sphereR, sphereT, dist, source);
+    ASSERT_EQ(multi.size(), single.size());
+
+    for (size_t k = 0; k < single.size(); k++) {
+        EXPECT_NEAR(multi[k].specularReflection, single[k].specularReflection, 1E-12);
+        EXPECT_NEAR(multi[k].diffuseReflection  , single[k].diffuseReflection  , 0.05 * single[k].diffuseReflection  );
+        EXPECT_NEAR(multi[k].diffuseTransmission, single[k].diffuseTransmission, 0.05 * single[k].diffuseTransmission);
+        EXPECT_NEAR(multi[k].absorbed           , single[k].absorbed           , 0.05 * single[k].absorbed           );
+    }
+}
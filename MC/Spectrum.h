@@ -0,0 +1,88 @@
+#pragma once
+
+#include "Medium.h"
+#include "Sample.h"
+
+#include "../Utils/Contracts.h"
+
+#include "../eigen/Eigen/Dense"
+
+#include <vector>
+
+/// \brief Absorption spectra of sample layers for single-path multi-wavelength Monte Carlo
+/// Photon paths depend only on scattering, refraction and geometry, which are shared by all wavelengths,
+/// so one path is traced with absorption switched off and absorption of every wavelength
+/// is applied along it as a per-wavelength attenuation factor.
+/// Wavelengths are packed in a fixed-capacity vector of at most MAX_WAVELENGTHS lanes, which lives on the stack.
+template < typename T >
+class Spectrum {
+public:
+    static constexpr int MAX_WAVELENGTHS = 16;
+    /// one value per wavelength
+    using Lanes = Eigen::Array<T, Eigen::Dynamic, 1, Eigen::ColMajor, MAX_WAVELENGTHS, 1>;
+    using MuaMatrix = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>;
+
+    Spectrum() noexcept = default;
+
+    /// \param[in] mua Nwavelengths x Nlayers absorption coefficients
+    /// \throw std::invalid_argument if ENABLE_CHECK_CONTRACTS is defined and mua is empty, has more than MAX_WAVELENGTHS rows
+    /// or has negative or non-finite values
+    explicit Spectrum(const MuaMatrix& mua) EXCEPT_INPUT_PARAMS;
+    ~Spectrum() noexcept = default;
+
+    /// Spectrum of samples measured at different wavelengths
+    /// \param[in] samples samples with the same layers differing only in absorption
+    /// \return absorption spectrum of samples, wavelength i is samples[i]
+    /// \throw std::invalid_argument if ENABLE_CHECK_CONTRACTS is defined and samples is empty, has more than MAX_WAVELENGTHS samples
+    /// or samples differ in anything but absorption
+    static Spectrum fromSamples(const std::vector<Sample<T>>& samples) EXCEPT_INPUT_PARAMS;
+
+    /// Absorption coefficients of layer
+    /// \param[in] layer layer index
+    /// \return absorption coefficient of layer for every wavelength
+    inline const Lanes& getMua(const int& layer) const noexcept { return mua[layer]; }
+
+    inline int getNwavelengths() const noexcept { return Nwavelengths; }
+    inline int getNlayers()      const noexcept { return static_cast<int>(mua.size()); }
+
+protected:
+    int Nwavelengths = 0;
+    std::vector<Lanes> mua;
+};
+
+/******************
+ * IMPLEMENTATION *
+ ******************/
+
+template < typename T >
+Spectrum<T>::Spectrum(const MuaMatrix& newMua) EXCEPT_INPUT_PARAMS
+    : Nwavelengths(static_cast<int>(newMua.rows())) {
+    CHECK_ARGUMENT_CONTRACT(newMua.rows() > 0 && newMua.cols() > 0);
+    CHECK_ARGUMENT_CONTRACT(newMua.rows() <= MAX_WAVELENGTHS);
+    CHECK_ARGUMENT_CONTRACT(newMua.allFinite() && newMua.minCoeff() >= 0);
+
+    mua.resize(newMua.cols());
+    for (int layer = 0; layer < newMua.cols(); layer++)
+        mua[layer] = newMua.col(layer).array();
+}
+
+template < typename T >
+Spectrum<T> Spectrum<T>::fromSamples(const std::vector<Sample<T>>& samples) EXCEPT_INPUT_PARAMS {
+    CHECK_ARGUMENT_CONTRACT(!samples.empty());
+
+    const auto& reference = samples.front();
+    MuaMatrix newMua(samples.size(), reference.getNlayers());
+    for (int i = 0; i < static_cast<int>(samples.size()); i++) {
+        const auto& sample = samples[i];
+        CHECK_ARGUMENT_CONTRACT(sample.getNlayers() == reference.getNlayers());
+        CHECK_ARGUMENT_CONTRACT(sample.getNvacUpper() == reference.getNvacUpper() && sample.getNvacLower() == reference.getNvacLower());
+        for (int layer = 0; layer < reference.getNlayers(); layer++) {
+            const auto medium = sample.getMedium(layer);
+            const auto referenceMedium = reference.getMedium(layer);
+            CHECK_ARGUMENT_CONTRACT(medium.getN() == referenceMedium.getN() && medium.getD() == referenceMedium.getD());
+            CHECK_ARGUMENT_CONTRACT(medium.getMus() == referenceMedium.getMus() && medium.getG() == referenceMedium.getG());
+            newMua(i, layer) = medium.getMua();
+        }
+    }
+    return Spectrum(newMua);
+}
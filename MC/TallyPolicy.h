@@ -0,0 +1,18 @@
+#pragma once
+
+/// \brief Tallies recorded by MonteCarlo, selected at compile time.
+/// Disabled tallies are compiled out of the photon loop and are left empty in results.
+/// Detector signals and totals (diffuse reflection, specular reflection, diffuse transmission, absorbed fraction)
+/// are recorded by every policy.
+struct FullTallies {
+    static constexpr bool absorptionGrid = true; ///< matrixA, heatSource and heatSourceNorm
+    static constexpr bool angles         = true; ///< arrayAnglesR and arrayAnglesT
+    static constexpr bool sourcePoints   = true; ///< start points of photons in sourceMatrix
+};
+
+/// \brief Detector signals and totals only, for objective evaluations of inverse solvers
+struct DetectorTallies {
+    static constexpr bool absorptionGrid = false;
+    static constexpr bool angles         = false;
+    static constexpr bool sourcePoints   = false;
+};
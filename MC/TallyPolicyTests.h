@@ -0,0 +1,99 @@
+#pragma once
+
+#ifndef ENABLE_CHECK_CONTRACTS
+    #define ENABLE_CHECK_CONTRACTS
+#endif // ENABLE_CHECK_CONTRACTS
+
+#include "MonteCarlo.h"
+#include "MonteCarloMultithread.h"
+#include "TallyPolicy.h"
+
+#include "../Math/Random.h"
+
+#include <gtest/gtest.h>
+
+using namespace Eigen;
+using namespace std;
+
+class TallyPolicyTests : public ::testing::Test {
+protected:
+    using T = double;
+
+    static constexpr size_t Nz = 20;
+    static constexpr size_t Nr = 50;
+    static constexpr bool detector = 1;
+
+    static constexpr int Np = 20000;
+    static constexpr T d = 1E-3;
+    static constexpr T radius = 1E-2;
+
+    IntegratingSphere<T> sphereR{0.0508, 0.0125, 0.0125};
+    IntegratingSphere<T> sphereT{0.0508, 0.0125, 0.0};
+    DetectorDistance<T>  dist{0, 0.01, 0.002};
+    LightSource<T> source{0.0005, SourceType::Circle};
+    Sample<T> sample{{Medium<T>::fromCoeffs(1.5, 0, 0, 1E-3, 0), Medium<T>::fromCoeffs(1.4, 100, 3000, d, 0.8), Medium<T>::fromCoeffs(1.5, 0, 0, 1E-3, 0)}, 1, 1};
+
+    /// single thread run from fixed random stream
+    template < typename Tallies >
+    MCresults<T,Nz,Nr,detector> run(const std::uint64_t& seed) const {
+        Math_NS::seedRandom(seed);
+        MonteCarlo<T,Nz,Nr,detector,Tallies> mc(sample, Np, 3 * d, radius, sphereR, sphereT, dist, source);
+        return mc.CalculateResult();
+    }
+
+    static void expectEmpty(const MCresults<T,Nz,Nr,detector>& results) {
+        EXPECT_EQ(results.matrixA.size(), 0);
+        EXPECT_EQ(results.heatSource.size(), 0);
+        EXPECT_EQ(results.heatSourceNorm.size(), 0);
+        EXPECT_EQ(results.arrayAnglesR.size(), 0);
+        EXPECT_EQ(results.arrayAnglesT.size(), 0);
+        EXPECT_TRUE(results.sourceMatrix.empty());
+    }
+};
+
+TEST_F(TallyPolicyTests, DetectorTalliesGiveSameSignalsAsFullTallies) {
+    const auto full = run<FullTallies>(42);
+    const auto minimal = run<DetectorTallies>(42);
+
+    /// tallies do not draw random numbers, so both runs trace the same photons
+    EXPECT_EQ(minimal.detectedR, full.detectedR);
+    EXPECT_EQ(minimal.detectedT, full.detectedT);
+    EXPECT_EQ(minimal.specularReflection, full.specularReflection);
+    EXPECT_EQ(minimal.diffuseReflection, full.diffuseReflection);
+    EXPECT_EQ(minimal.diffuseTransmission, full.diffuseTransmission);
+    EXPECT_EQ(minimal.BugerTransmission, full.BugerTransmission);
+    EXPECT_EQ(minimal.arrayR, full.arrayR);
+    EXPECT_EQ(minimal.arrayT, full.arrayT);
+    EXPECT_NEAR(minimal.absorbed, full.absorbed, 1E-12);
+}
+
+TEST_F(TallyPolicyTests, DisabledTalliesAreEmpty) {
+    const auto full = run<FullTallies>(1);
+    EXPECT_EQ(full.matrixA.rows(), Nz);
+    EXPECT_EQ(full.matrixA.cols(), Nr);
+    EXPECT_EQ(full.heatSourceNorm.size(), Nz * Nr);
+    EXPECT_EQ(full.arrayAnglesR.size(), 100);
+    EXPECT_EQ(full.sourceMatrix.size(), Np);
+    EXPECT_GT(full.arrayAnglesR.sum(), 0);
+
+    expectEmpty(run<DetectorTallies>(1));
+}
+
+TEST_F(TallyPolicyTests, MultithreadDetectorTallies) {
+    const auto full = MCmultithread<T,Nz,Nr,detector>(sample, 2 * Np, 2, 3 * d, radius, sphereR, sphereT, dist, source);
+    const auto minimal = MCmultithread<T,Nz,Nr,detector,DetectorTallies>(sample, 2 * Np, 2, 3 * d, radius, sphereR, sphereT, dist, source);
+
+    expectEmpty(minimal);
+    EXPECT_NEAR(minimal.specularReflection, full.specularReflection, 1E-12);
+    EXPECT_NEAR(minimal.diffuseReflection  , full.diffuseReflection  , 0.05 * full.diffuseReflection  );
+    EXPECT_NEAR(minimal.diffuseTransmission, full.diffuseTransmission, 0.05 * full.diffuseTransmission);
+    EXPECT_NEAR(minimal.absorbed           , full.absorbed           , 0.05 * full.absorbed           );
+    EXPECT_NEAR(minimal.specularReflection + minimal.diffuseReflection + minimal.diffuseTransmission + minimal.absorbed, 1, 0.02);
+
+    ASSERT_EQ(minimal.detectedR.size(), full.detectedR.size());
+    for (size_t i = 0; i < full.detectedR.size(); i++) {
+        EXPECT_EQ(minimal.detectedR[i].first, full.detectedR[i].first);
+        EXPECT_NEAR(minimal.detectedR[i].second, full.detectedR[i].second, 0.15 * full.detectedR[i].second + 1E-3);
+        EXPECT_NEAR(minimal.detectedT[i].second, full.detectedT[i].second, 0.15 * full.detectedT[i].second + 1E-3);
+    }
+}
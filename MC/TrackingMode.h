@@ -0,0 +1,8 @@
+#pragma once
+
+/// \brief Free-flight sampling in heterogeneous tissue
+enum class TrackingMode {
+    VoxelWalk = 0, ///< optical depth is integrated voxel by voxel along the path
+    Woodcock  = 1, ///< delta tracking against the global majorant attenuation, null collisions are rejected
+    MacroCell = 2  ///< delta tracking through the macro cells of MajorantGrid against their local majorants
+};
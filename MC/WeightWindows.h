@@ -0,0 +1,50 @@
+#pragma once
+
+#include "../Utils/Contracts.h"
+#include "../eigen/Eigen/Dense"
+
+/// \brief Weight windows on the z/r grid of absorption tallies.
+/// Photons above the window of their bin are split into equal copies, photons below it play roulette
+/// and survive with the weight of the middle of the window. Bins with zero lower bound keep the fixed roulette
+template < typename T >
+struct WeightWindows {
+    Eigen::Matrix<T,Eigen::Dynamic,Eigen::Dynamic> lower; ///< lower bounds of Nz x Nr bins, empty disables windows
+    T ratio = 5;      ///< upper bound of window over lower one
+    int maxSplit = 10; ///< copies of one splitting, at most
+
+    /// Windows which keep the number of photons in bins uniform,
+    /// the window of the brightest bin is centred on the launch weight
+    /// \param[in] fluence fluence of Nz x Nr bins in arbitrary units, bins without it get zero lower bound
+    /// \param[in] newRatio upper bound of window over lower one
+    /// \param[in] newMaxSplit copies of one splitting, at most
+    /// \return windows with lower bounds proportional to fluence
+    /// \throw std::invalid_argument if ENABLE_CHECK_CONTRACTS is defined and fluence is negative or has no positive bins,
+    /// newRatio is not greater than 1 or newMaxSplit is less than 1
+    static WeightWindows fromFluence(const Eigen::Matrix<T,Eigen::Dynamic,Eigen::Dynamic>& fluence,
+                                     const T& newRatio = 5, const int& newMaxSplit = 10) EXCEPT_INPUT_PARAMS;
+
+    inline bool enabled() const noexcept { return lower.size() > 0; }
+    /// \return weight of photons surviving roulette in window with lower bound
+    inline T survival(const T& lowerBound) const noexcept { return lowerBound * (1 + ratio) / 2; }
+};
+
+/******************
+ * IMPLEMENTATION *
+ ******************/
+
+template < typename T >
+WeightWindows<T> WeightWindows<T>::fromFluence(const Eigen::Matrix<T,Eigen::Dynamic,Eigen::Dynamic>& fluence,
+                                               const T& newRatio, const int& newMaxSplit) EXCEPT_INPUT_PARAMS {
+    CHECK_ARGUMENT_CONTRACT(newRatio > 1);
+    CHECK_ARGUMENT_CONTRACT(newMaxSplit >= 1);
+    CHECK_ARGUMENT_CONTRACT(fluence.size() > 0 && fluence.minCoeff() >= 0);
+
+    const T brightest = fluence.maxCoeff();
+    CHECK_ARGUMENT_CONTRACT(brightest > 0);
+
+    WeightWindows windows;
+    windows.ratio = newRatio;
+    windows.maxSplit = newMaxSplit;
+    windows.lower = fluence / brightest * (2 / (1 + newRatio));
+    return windows;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#ifndef ENABLE_CHECK_CONTRACTS
+    #define ENABLE_CHECK_CONTRACTS
+#endif // ENABLE_CHECK_CONTRACTS
+
+#include "MonteCarlo.h"
+#include "WeightWindows.h"
+
+#include "../Math/Random.h"
+
+#include <gtest/gtest.h>
+
+using namespace Eigen;
+using namespace std;
+
+class WeightWindowsTests : public ::testing::Test {
+protected:
+    using T = double;
+
+    static constexpr size_t Nz = 20;
+    static constexpr size_t Nr = 20;
+    static constexpr bool detector = 1;
+
+    static constexpr int Np = 20000;
+    static constexpr T d = 1E-2;
+    static constexpr T radius = 1E-2;
+
+    IntegratingSphere<T> sphereR{0.0508, 0.0125, 0.0125};
+    IntegratingSphere<T> sphereT{0.0508, 0.0125, 0.0};
+    DetectorDistance<T>  dist{0, 0.02, 0.02};
+    const LightSource<T> source{1E-3, SourceType::Circle};
+
+    /// optically thick sample, transmission is about 3E-3
+    const Sample<T> sample{{Medium<T>::fromCoeffs(1.4, 100, 5000, d, 0.8)}, 1, 1};
+
+    MCresults<T,Nz,Nr,detector> run(const WeightWindows<T>& windows, const std::uint64_t& seed) const {
+        Math_NS::seedRandom(seed);
+        MonteCarlo<T,Nz,Nr,detector> mc(sample, Np, d, radius, sphereR, sphereT, dist, source);
+        if (windows.enabled())
+            mc.setWeightWindows(windows);
+        return mc.CalculateResult();
+    }
+};
+
+TEST_F(WeightWindowsTests, FromFluenceCentresBrightestBin) {
+    Matrix<T,Dynamic,Dynamic> fluence(2, 3);
+    fluence << 4, 2, 0,
+               1, 0.5, 0;
+    const auto windows = WeightWindows<T>::fromFluence(fluence, 3, 4);
+    EXPECT_EQ(windows.ratio, 3);
+    EXPECT_EQ(windows.maxSplit, 4);
+    EXPECT_TRUE(windows.enabled());
+    EXPECT_NEAR(windows.survival(windows.lower(0, 0)), 1, 1E-15);
+    EXPECT_NEAR(windows.lower(1, 1), windows.lower(0, 0) / 8, 1E-15);
+    EXPECT_EQ(windows.lower(0, 2), 0);
+    EXPECT_FALSE(WeightWindows<T>().enabled());
+}
+
+TEST_F(WeightWindowsTests, PilotWindowsFollowDepth) {
+    Math_NS::seedRandom(1);
+    MonteCarlo<T,Nz,Nr,detector> mc(sample, Np, d, radius, sphereR, sphereT, dist, source);
+    const auto windows = mc.PilotWeightWindows(2000);
+    ASSERT_EQ(windows.lower.rows(), Nz);
+    ASSERT_EQ(windows.lower.cols(), Nr);
+    EXPECT_NEAR(windows.lower.maxCoeff(), 2.0 / (1 + windows.ratio), 1E-15);
+    EXPECT_GT(windows.lower.minCoeff(), 0);
+    /// light fades with depth
+    EXPECT_LT(windows.lower(Nz - 1, 0), windows.lower(0, 0) / 10);
+    for (size_t iz = 0; iz < Nz; iz++)
+        EXPECT_EQ(windows.lower.row(iz).minCoeff(), windows.lower.row(iz).maxCoeff());
+}
+
+TEST_F(WeightWindowsTests, UnbiasedWithLowerVarianceThroughThickSample) {
+    const auto analog = run(WeightWindows<T>(), 2);
+
+    Math_NS::seedRandom(3);
+    MonteCarlo<T,Nz,Nr,detector> pilot(sample, Np, d, radius, sphereR, sphereT, dist, source);
+    const auto split = run(pilot.PilotWeightWindows(Np / 10, 3), 4);
+
+    EXPECT_NEAR(split.diffuseReflection  , analog.diffuseReflection  , 0.03 * analog.diffuseReflection  );
+    EXPECT_NEAR(split.diffuseTransmission, analog.diffuseTransmission, 0.2  * analog.diffuseTransmission);
+    EXPECT_NEAR(split.absorbed           , analog.absorbed           , 0.01 * analog.absorbed           );
+    EXPECT_NEAR(split.specularReflection + split.diffuseReflection + split.diffuseTransmission + split.absorbed, 1, 1E-2);
+    EXPECT_NEAR(split.matrixA.row(Nz - 1).sum(), analog.matrixA.row(Nz - 1).sum(), 0.2 * analog.matrixA.row(Nz - 1).sum());
+
+    /// sphere right behind the sample catches the transmission
+    const T a = analog.detectedT[0].second;
+    const T b = split.detectedT[0].second;
+    const T va = analog.detectedTvariance[0].second;
+    const T vb = split.detectedTvariance[0].second;
+    EXPECT_LT(abs(a - b), 4 * sqrt(va + vb));
+    EXPECT_LT(vb / Math_NS::sqr(b), va / Math_NS::sqr(a) / 3);
+}
+
+TEST_F(WeightWindowsTests, Throws) {
+    EXPECT_THROW(WeightWindows<T>::fromFluence(-Matrix<T,Dynamic,Dynamic>::Ones(Nz, Nr)), invalid_argument);
+    EXPECT_THROW(WeightWindows<T>::fromFluence(Matrix<T,Dynamic,Dynamic>::Zero(Nz, Nr)), invalid_argument);
+    EXPECT_THROW(WeightWindows<T>::fromFluence(Matrix<T,Dynamic,Dynamic>::Ones(Nz, Nr), 1), invalid_argument);
+    EXPECT_THROW(WeightWindows<T>::fromFluence(Matrix<T,Dynamic,Dynamic>::Ones(Nz, Nr), 5, 0), invalid_argument);
+
+    MonteCarlo<T,Nz,Nr,detector> mc(sample, 10, d, radius, sphereR, sphereT, dist, source);
+    EXPECT_THROW(mc.setWeightWindows(WeightWindows<T>::fromFluence(Matrix<T,Dynamic,Dynamic>::Ones(Nz + 1, Nr))), invalid_argument);
+    EXPECT_THROW(mc.PilotWeightWindows(0), invalid_argument);
+
+    const Matrix<T,Dynamic,Dynamic> coag = Matrix<T,Dynamic,Dynamic>::Ones(Nz, Nr);
+    MonteCarlo<T,Nz,Nr,detector> heterogeneous(sample, 10, d, radius, sphereR, sphereT, dist, source, coag);
+    EXPECT_THROW(heterogeneous.setWeightWindows(WeightWindows<T>::fromFluence(Matrix<T,Dynamic,Dynamic>::Ones(Nz, Nr))), invalid_argument);
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#ifndef ENABLE_CHECK_CONTRACTS
+    #define ENABLE_CHECK_CONTRACTS
+#endif // ENABLE_CHECK_CONTRACTS
+
+#include "MonteCarlo.h"
+#include "TrackingMode.h"
+
+#include <gtest/gtest.h>
+
+using namespace Eigen;
+using namespace std;
+
+class WoodcockTrackingTests : public ::testing::Test {
+protected:
+    using T = double;
+
+    static constexpr size_t Nz = 20;
+    static constexpr size_t Nr = 50;
+    static constexpr bool detector = 1;
+
+    static constexpr int Np = 20000;
+    static constexpr T d = 1E-3;
+    static constexpr T radius = 1E-2;
+    static constexpr T n = 1.4;
+
+    IntegratingSphere<T> sphereR{0.0508, 0.0125, 0.0125};
+    IntegratingSphere<T> sphereT{0.0508, 0.0125, 0.0};
+    DetectorDistance<T>  dist;
+    LightSource<T> source{0.0005, SourceType::Circle};
+
+    /// tissue with coag values of the phantom
+    Sample<T> tissue(const T& coag) const {
+        const auto medium = Medium<T>::fromCoeffs(n, uaFunc<T>(coag), usFunc<T>(coag), d, gFunc<T>(coag));
+        return Sample<T>({medium}, 1, 1);
+    }
+
+    /// native tissue with coagulated core in the middle of the slab
+    Matrix<T, Dynamic, Dynamic> phantom() const {
+        Matrix<T, Dynamic, Dynamic> coag = Matrix<T, Dynamic, Dynamic>::Ones(Nz, Nr);
+        for (size_t i = 0; i < Nz; i++)
+            for (size_t j = 0; j < Nr; j++)
+                if (Math_NS::sqr(T(i) - Nz / 2) + Math_NS::sqr(T(j)) <= Math_NS::sqr(Nz / 2))
+                    coag(i, j) = 0.1;
+        return coag;
+    }
+
+    /// MonteCarlo keeps reference to sample, so sample must outlive it
+    MCresults<T,Nz,Nr,detector> run(const Sample<T>& sample, const Matrix<T, Dynamic, Dynamic>& coag, const TrackingMode& tracking) const {
+        MonteCarlo<T,Nz,Nr,detector> mc(sample, Np, d, radius, sphereR, sphereT, dist, source, coag, tracking);
+        return mc.CalculateResult();
+    }
+};
+
+TEST_F(WoodcockTrackingTests, UniformMapMatchesHomogeneousTissue) {
+    const T coag = 0.0;
+    const auto sample = tissue(coag);
+    const auto woodcock = run(sample, Matrix<T, Dynamic, Dynamic>::Constant(Nz, Nr, coag), TrackingMode::Woodcock);
+
+    MonteCarlo<T,Nz,Nr,detector> mc(sample, Np, d, radius, sphereR, sphereT, dist, source);
+    const auto homogeneous = mc.CalculateResult();
+
+    EXPECT_DOUBLE_EQ(woodcock.specularReflection, homogeneous.specularReflection);
+    EXPECT_NEAR(woodcock.diffuseReflection  , homogeneous.diffuseReflection  , 0.05 * homogeneous.diffuseReflection  );
+    EXPECT_NEAR(woodcock.diffuseTransmission, homogeneous.diffuseTransmission, 0.05 * homogeneous.diffuseTransmission);
+    EXPECT_NEAR(woodcock.absorbed           , homogeneous.absorbed           , 0.05 * homogeneous.absorbed           );
+}
+
+/// voxel walk snaps photons to voxel centers, so only transmission is compared
+TEST_F(WoodcockTrackingTests, PhantomMatchesVoxelWalk) {
+    const auto sample = tissue(1.0);
+    const auto woodcock  = run(sample, phantom(), TrackingMode::Woodcock );
+    const auto voxelWalk = run(sample, phantom(), TrackingMode::VoxelWalk);
+
+    EXPECT_DOUBLE_EQ(woodcock.specularReflection, voxelWalk.specularReflection);
+    EXPECT_NEAR(woodcock.diffuseTransmission, voxelWalk.diffuseTransmission, 0.05 * voxelWalk.diffuseTransmission);
+    EXPECT_LE(woodcock.diffuseReflection + woodcock.diffuseTransmission + woodcock.absorbed + woodcock.specularReflection, 1 + 1E-9);
+}
+
+TEST_F(WoodcockTrackingTests, MacroCellMatchesWoodcock) {
+    const auto sample = tissue(1.0);
+    const auto woodcock  = run(sample, phantom(), TrackingMode::Woodcock );
+    const auto macroCell = run(sample, phantom(), TrackingMode::MacroCell);
+
+    EXPECT_DOUBLE_EQ(macroCell.specularReflection, woodcock.specularReflection);
+    EXPECT_NEAR(macroCell.diffuseReflection  , woodcock.diffuseReflection  , 0.05 * woodcock.diffuseReflection  );
+    EXPECT_NEAR(macroCell.diffuseTransmission, woodcock.diffuseTransmission, 0.05 * woodcock.diffuseTransmission);
+    EXPECT_NEAR(macroCell.absorbed           , woodcock.absorbed           , 0.05 * woodcock.absorbed           );
+}
+
+TEST_F(WoodcockTrackingTests, MacroCellUniformMapMatchesHomogeneousTissue) {
+    const T coag = 0.0;
+    const auto sample = tissue(coag);
+    const auto macroCell = run(sample, Matrix<T, Dynamic, Dynamic>::Constant(Nz, Nr, coag), TrackingMode::MacroCell);
+
+    MonteCarlo<T,Nz,Nr,detector> mc(sample, Np, d, radius, sphereR, sphereT, dist, source);
+    const auto homogeneous = mc.CalculateResult();
+
+    EXPECT_NEAR(macroCell.diffuseReflection  , homogeneous.diffuseReflection  , 0.05 * homogeneous.diffuseReflection  );
+    EXPECT_NEAR(macroCell.diffuseTransmission, homogeneous.diffuseTransmission, 0.05 * homogeneous.diffuseTransmission);
+    EXPECT_NEAR(macroCell.absorbed           , homogeneous.absorbed           , 0.05 * homogeneous.absorbed           );
+}
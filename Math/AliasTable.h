@@ -0,0 +1,91 @@
+#pragma once
+
+#include "../Utils/Contracts.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace Math_NS {
+    /// \brief Walker alias table of discrete distribution.
+    /// Built once in O(n), every draw is one lookup and one comparison regardless of the number of outcomes
+    template < typename T >
+    class AliasTable {
+    public:
+        AliasTable() noexcept = default;
+        /// \param[in] weights non-negative weights of outcomes, normalized by the table
+        /// \throw std::invalid_argument if ENABLE_CHECK_CONTRACTS is defined and weights are empty, negative or all zero
+        explicit AliasTable(const std::vector<T>& weights) EXCEPT_INPUT_PARAMS;
+        ~AliasTable() noexcept = default;
+
+        /// Outcome from two uniform numbers
+        /// \param[in] u1 uniform number in [0, 1), picks a column
+        /// \param[in] u2 uniform number in [0, 1), picks the column outcome or its alias
+        /// \return index of outcome
+        inline int sample(const T& u1, const T& u2) const noexcept;
+
+        inline int size() const noexcept { return threshold.size(); }
+        /// \param[in] i index of outcome
+        /// \return normalized weight of outcome
+        inline T getProbability(const int& i) const noexcept { return probability[i]; }
+
+    protected:
+        std::vector<T> threshold;   ///< part of column kept by its own outcome
+        std::vector<int> alias;     ///< outcome of the rest of column
+        std::vector<T> probability; ///< normalized weights
+    };
+}
+
+/******************
+ * IMPLEMENTATION *
+ ******************/
+
+template < typename T >
+Math_NS::AliasTable<T>::AliasTable(const std::vector<T>& weights) EXCEPT_INPUT_PARAMS
+    : threshold(weights.size())
+    , alias(weights.size())
+    , probability(weights.size()) {
+    CHECK_ARGUMENT_CONTRACT(!weights.empty());
+
+    const int n = weights.size();
+    T total = 0;
+    for (const auto& weight: weights) {
+        CHECK_ARGUMENT_CONTRACT(weight >= 0);
+        total += weight;
+    }
+    CHECK_ARGUMENT_CONTRACT(total > 0);
+
+    /// columns below and above the mean, scaled so that the mean is 1
+    std::vector<int> small, large;
+    small.reserve(n);
+    large.reserve(n);
+    for (int i = 0; i < n; i++) {
+        probability[i] = weights[i] / total;
+        threshold[i] = probability[i] * n;
+        alias[i] = i;
+        (threshold[i] < 1 ? small : large).push_back(i);
+    }
+
+    while (!small.empty() && !large.empty()) {
+        const int s = small.back();
+        const int l = large.back();
+        small.pop_back();
+        alias[s] = l;
+        threshold[l] -= 1 - threshold[s];
+        if (threshold[l] < 1) {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+    /// columns left by rounding are full
+    for (const int i: small)
+        threshold[i] = 1;
+    for (const int i: large)
+        threshold[i] = 1;
+}
+
+template < typename T >
+int Math_NS::AliasTable<T>::sample(const T& u1, const T& u2) const noexcept {
+    const int n = threshold.size();
+    const int column = std::min(static_cast<int>(u1 * n), n - 1);
+    return u2 < threshold[column] ? column : alias[column];
+}
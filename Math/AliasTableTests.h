@@ -0,0 +1,75 @@
+#pragma once
+
+#ifndef ENABLE_CHECK_CONTRACTS
+    #define ENABLE_CHECK_CONTRACTS
+#endif // ENABLE_CHECK_CONTRACTS
+
+#include "AliasTable.h"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace Math_NS;
+using namespace std;
+
+namespace {
+    /// parts of [0, 1)^2 which the table maps to every outcome, on a grid of K x K points per column
+    template < typename T >
+    vector<T> frequencies(const AliasTable<T>& table, const int& K) {
+        const int n = table.size();
+        vector<T> counts(n, 0);
+        for (int c = 0; c < n; c++)
+            for (int k = 0; k < K; k++)
+                counts[table.sample((c + T(0.5)) / n, (k + T(0.5)) / K)] += T(1) / (n * K);
+        return counts;
+    }
+}
+
+TEST(AliasTableTests, ReproducesWeights) {
+    const vector<double> weights = {1, 7, 0, 2, 0.5, 4, 3, 0, 12};
+    const AliasTable<double> table(weights);
+    ASSERT_EQ(table.size(), weights.size());
+
+    double total = 0;
+    for (const auto& weight: weights)
+        total += weight;
+
+    const int K = 10000;
+    const auto counts = frequencies(table, K);
+    for (int i = 0; i < table.size(); i++) {
+        EXPECT_DOUBLE_EQ(table.getProbability(i), weights[i] / total);
+        EXPECT_NEAR(counts[i], weights[i] / total, 1.0 / K);
+    }
+    EXPECT_EQ(counts[2], 0);
+    EXPECT_EQ(counts[7], 0);
+}
+
+TEST(AliasTableTests, SingleOutcome) {
+    const AliasTable<float> table(vector<float>{0, 0, 3, 0});
+    for (float u1: {0.0f, 0.3f, 0.6f, 0.9999f})
+        for (float u2: {0.0f, 0.5f, 0.9999f})
+            EXPECT_EQ(table.sample(u1, u2), 2);
+}
+
+TEST(AliasTableTests, ManyOutcomes) {
+    vector<double> weights(100000);
+    for (int i = 0; i < static_cast<int>(weights.size()); i++)
+        weights[i] = (i % 17) * (i % 5 == 0 ? 100 : 1);
+    const AliasTable<double> table(weights);
+
+    double total = 0;
+    for (const auto& weight: weights)
+        total += weight;
+    /// grid error of every column the outcome fills
+    const int K = 100;
+    const auto counts = frequencies(table, K);
+    for (int i = 0; i < table.size(); i++)
+        EXPECT_NEAR(counts[i], weights[i] / total, 0.01 * weights[i] / total + 1.0 / (table.size() * K));
+}
+
+TEST(AliasTableTests, Throws) {
+    EXPECT_THROW(AliasTable<double>(vector<double>{}), invalid_argument);
+    EXPECT_THROW(AliasTable<double>(vector<double>{1, -1, 2}), invalid_argument);
+    EXPECT_THROW(AliasTable<double>(vector<double>{0, 0}), invalid_argument);
+}
@@ -0,0 +1,369 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace Math_NS {
+    /// \brief Branch-free elementary functions for the photon transport hot loop
+    /// Kernels use range reduction with polynomial approximations from fdlibm and cephes,
+    /// are inlined and have no data dependent branches, so loops over batches are vectorised by the compiler.
+    /// Accuracy is checked in FastMathTests against long double reference, maximal errors are in the comments.
+    /// Engine code calls them through transportLog, transportExp, transportSincos and transportRsqrt,
+    /// which are fast kernels if ENABLE_FAST_MATH is defined and libm otherwise.
+
+    /// Natural logarithm, 1 ULP,
+    /// log(0) = -inf, log(inf) = inf, NaN for negative arguments
+    /// \param[in] x argument
+    /// \return log(x)
+    inline double fastLog(double x) noexcept;
+    inline float  fastLog(float  x) noexcept;
+
+    /// Exponent, 1 ULP,
+    /// flushes to zero below -708.39 for double and -87.33 for float,
+    /// overflows to inf above 709.43 for double and 88.37 for float
+    /// \param[in] x argument
+    /// \return exp(x)
+    inline double fastExp(double x) noexcept;
+    inline float  fastExp(float  x) noexcept;
+
+    /// Sine and cosine at once, 2 ULP for |x| <= 100 and 3 ULP for |x| <= 1E5
+    /// \param[in] x argument, radians
+    /// \param[out] s sin(x)
+    /// \param[out] c cos(x)
+    inline void fastSincos(double x, double& s, double& c) noexcept;
+    inline void fastSincos(float  x, float&  s, float&  c) noexcept;
+
+    /// Reciprocal square root, 3 ULP for positive normal arguments
+    /// \param[in] x argument
+    /// \return 1 / sqrt(x)
+    inline double fastRsqrt(double x) noexcept;
+    inline float  fastRsqrt(float  x) noexcept;
+
+    /// Batched kernels, y[i] = f(x[i]), x and y may be the same array
+    /// \param[in] x arguments
+    /// \param[out] y results
+    /// \param[in] n number of elements
+    template < typename T >
+    void fastLog(const T* x, T* y, const std::size_t& n) noexcept;
+    template < typename T >
+    void fastExp(const T* x, T* y, const std::size_t& n) noexcept;
+    template < typename T >
+    void fastRsqrt(const T* x, T* y, const std::size_t& n) noexcept;
+
+    /// Batched sine and cosine
+    /// \param[in] x arguments
+    /// \param[out] s sines
+    /// \param[out] c cosines
+    /// \param[in] n number of elements
+    template < typename T >
+    void fastSincos(const T* x, T* s, T* c, const std::size_t& n) noexcept;
+
+    template < typename T >
+    inline T transportLog(const T& x) noexcept;
+    template < typename T >
+    inline T transportExp(const T& x) noexcept;
+    template < typename T >
+    inline void transportSincos(const T& x, T& s, T& c) noexcept;
+    template < typename T >
+    inline T transportRsqrt(const T& x) noexcept;
+}
+
+/******************
+ * IMPLEMENTATION *
+ ******************/
+
+namespace Math_NS::FastMathDetail {
+    inline std::uint64_t bits(const double& x) noexcept { std::uint64_t u; std::memcpy(&u, &x, sizeof(u)); return u; }
+    inline std::uint32_t bits(const float&  x) noexcept { std::uint32_t u; std::memcpy(&u, &x, sizeof(u)); return u; }
+    inline double asDouble(const std::uint64_t& u) noexcept { double x; std::memcpy(&x, &u, sizeof(x)); return x; }
+    inline float  asFloat (const std::uint32_t& u) noexcept { float  x; std::memcpy(&x, &u, sizeof(x)); return x; }
+
+    /// adding 1.5 * 2^(mantissa bits) rounds to nearest integer and leaves it in the low mantissa bits
+    constexpr double roundShiftD = 6755399441055744.0;
+    constexpr float  roundShiftF = 12582912.0f;
+}
+
+inline double Math_NS::fastLog(double x) noexcept {
+    using namespace FastMathDetail;
+
+    /// fdlibm e_log.c
+    constexpr double ln2Hi = 6.93147180369123816490e-01;
+    constexpr double ln2Lo = 1.90821492927058770002e-10;
+    constexpr double Lg1 = 6.666666666666735130e-01;
+    constexpr double Lg2 = 3.999999999940941908e-01;
+    constexpr double Lg3 = 2.857142874366239149e-01;
+    constexpr double Lg4 = 2.222219843214978396e-01;
+    constexpr double Lg5 = 1.818357216161805012e-01;
+    constexpr double Lg6 = 1.531383769920937332e-01;
+    constexpr double Lg7 = 1.479819860511658591e-01;
+    constexpr std::uint64_t sqrtHalf = 0x3fe6a09e667f3bcdULL;
+    constexpr std::uint64_t one = 0x3ff0000000000000ULL;
+
+    /// subnormals are scaled to normal range
+    const bool subnormal = x < std::numeric_limits<double>::min();
+    const double xn = subnormal ? x * 18014398509481984.0 : x; // 2^54
+
+    /// x = 2^k * (1 + f), 1 + f in [sqrt(2) / 2, sqrt(2))
+    std::uint64_t u = bits(xn) + (one - sqrtHalf);
+    /// exponent is converted through the mantissa of 2^52, 64-bit integer conversion does not vectorise
+    const double k = asDouble(0x4330000000000000ULL | (u >> 52)) - (4503599627370496.0 + 0x3ff) - (subnormal ? 54.0 : 0.0);
+    u = (u & 0x000fffffffffffffULL) + sqrtHalf;
+    const double f = asDouble(u) - 1;
+
+    const double s = f / (2 + f);
+    const double z = s * s;
+    const double w = z * z;
+    const double R = z * (Lg1 + w * (Lg3 + w * (Lg5 + w * Lg7))) + w * (Lg2 + w * (Lg4 + w * Lg6));
+    const double hfsq = 0.5 * f * f;
+    const double result = k * ln2Hi - ((hfsq - (s * (hfsq + R) + k * ln2Lo)) - f);
+
+    constexpr double inf = std::numeric_limits<double>::infinity();
+    const double special = x == 0 ? -inf : (x == inf ? inf : std::numeric_limits<double>::quiet_NaN());
+    return x > 0 && x < inf ? result : special;
+}
+
+inline float Math_NS::fastLog(float x) noexcept {
+    using namespace FastMathDetail;
+
+    /// musl logf.c
+    constexpr float ln2Hi = 6.9313812256e-01f;
+    constexpr float ln2Lo = 9.0580006145e-06f;
+    constexpr float Lg1 = 0.66666662693f;
+    constexpr float Lg2 = 0.40000972152f;
+    constexpr float Lg3 = 0.28498786688f;
+    constexpr float Lg4 = 0.24279078841f;
+    constexpr std::uint32_t sqrtHalf = 0x3f3504f3U;
+    constexpr std::uint32_t one = 0x3f800000U;
+
+    const bool subnormal = x < std::numeric_limits<float>::min();
+    const float xn = subnormal ? x * 33554432.0f : x; // 2^25
+
+    std::uint32_t u = bits(xn) + (one - sqrtHalf);
+    const float k = asFloat(0x4b000000U | (u >> 23)) - (8388608.0f + 0x7f) - (subnormal ? 25.0f : 0.0f);
+    u = (u & 0x007fffffU) + sqrtHalf;
+    const float f = asFloat(u) - 1;
+
+    const float s = f / (2 + f);
+    const float z = s * s;
+    const float w = z * z;
+    const float R = z * (Lg1 + w * Lg3) + w * (Lg2 + w * Lg4);
+    const float hfsq = 0.5f * f * f;
+    const float result = k * ln2Hi - ((hfsq - (s * (hfsq + R) + k * ln2Lo)) - f);
+
+    constexpr float inf = std::numeric_limits<float>::infinity();
+    const float special = x == 0 ? -inf : (x == inf ? inf : std::numeric_limits<float>::quiet_NaN());
+    return x > 0 && x < inf ? result : special;
+}
+
+inline double Math_NS::fastExp(double x) noexcept {
+    using namespace FastMathDetail;
+
+    /// fdlibm e_exp.c
+    constexpr double invLn2 = 1.44269504088896338700e+00;
+    constexpr double ln2Hi = 6.93147180369123816490e-01;
+    constexpr double ln2Lo = 1.90821492927058770002e-10;
+    constexpr double P1 =  1.66666666666666019037e-01;
+    constexpr double P2 = -2.77777777770155933842e-03;
+    constexpr double P3 =  6.61375632143793436117e-05;
+    constexpr double P4 = -1.65339022054652515390e-06;
+    constexpr double P5 =  4.13813679705723846039e-08;
+    /// 2^k stays a normal number
+    constexpr double minX = -708.3964185322641;
+    constexpr double maxX = 709.4361393;
+
+    const double xc = x < minX ? minX : (x > maxX ? maxX : x);
+
+    /// x = k ln2 + r, |r| <= ln2 / 2
+    double kd = xc * invLn2 + roundShiftD;
+    const std::uint64_t u = bits(kd);
+    kd -= roundShiftD;
+    const double hi = xc - kd * ln2Hi;
+    const double lo = kd * ln2Lo;
+    const double r = hi - lo;
+
+    const double t = r * r;
+    const double c = r - t * (P1 + t * (P2 + t * (P3 + t * (P4 + t * P5))));
+    const double y = 1 - ((lo - (r * c) / (2 - c)) - hi);
+    const double scale = asDouble((u + 1023) << 52);
+
+    const double result = y * scale;
+    return x < minX ? 0 : (x > maxX ? std::numeric_limits<double>::infinity() : result);
+}
+
+inline float Math_NS::fastExp(float x) noexcept {
+    using namespace FastMathDetail;
+
+    /// musl expf.c
+    constexpr float invLn2 = 1.4426950216e+00f;
+    constexpr float ln2Hi = 6.9314575195e-01f;
+    constexpr float ln2Lo = 1.4286067653e-06f;
+    constexpr float P1 =  1.6666625440e-1f;
+    constexpr float P2 = -2.7667332906e-3f;
+    constexpr float minX = -87.336544f;
+    constexpr float maxX = 88.376251f;
+
+    const float xc = x < minX ? minX : (x > maxX ? maxX : x);
+
+    float kd = xc * invLn2 + roundShiftF;
+    const std::uint32_t u = bits(kd);
+    kd -= roundShiftF;
+    const float hi = xc - kd * ln2Hi;
+    const float lo = kd * ln2Lo;
+    const float r = hi - lo;
+
+    const float t = r * r;
+    const float c = r - t * (P1 + t * P2);
+    const float y = 1 - ((lo - (r * c) / (2 - c)) - hi);
+    const float scale = asFloat((u + 127) << 23);
+
+    const float result = y * scale;
+    return x < minX ? 0 : (x > maxX ? std::numeric_limits<float>::infinity() : result);
+}
+
+inline void Math_NS::fastSincos(double x, double& s, double& c) noexcept {
+    using namespace FastMathDetail;
+
+    /// fdlibm k_sin.c and k_cos.c on [-pi/4, pi/4] after reduction by pi/2 in three parts
+    constexpr double twoOverPi = 6.36619772367581382433e-01;
+    constexpr double pio2_1  = 1.57079632673412561417e+00;
+    constexpr double pio2_2  = 6.07710050630396597660e-11;
+    constexpr double pio2_2t = 2.02226624879595063154e-21;
+    constexpr double S1 = -1.66666666666666324348e-01;
+    constexpr double S2 =  8.33333333332248946124e-03;
+    constexpr double S3 = -1.98412698298579493134e-04;
+    constexpr double S4 =  2.75573137070700676789e-06;
+    constexpr double S5 = -2.50507602534068634195e-08;
+    constexpr double S6 =  1.58969099521155010221e-10;
+    constexpr double C1 =  4.16666666666666019037e-02;
+    constexpr double C2 = -1.38888888888741095749e-03;
+    constexpr double C3 =  2.48015872894767294178e-05;
+    constexpr double C4 = -2.75573143513906633035e-07;
+    constexpr double C5 =  2.08757232129817482790e-09;
+    constexpr double C6 = -1.13596475577881948265e-11;
+
+    double jd = x * twoOverPi + roundShiftD;
+    const std::uint64_t q = bits(jd);
+    jd -= roundShiftD;
+    const double r = ((x - jd * pio2_1) - jd * pio2_2) - jd * pio2_2t;
+
+    const double z = r * r;
+    const double v = z * r;
+    const double sr = r + v * (S1 + z * (S2 + z * (S3 + z * (S4 + z * (S5 + z * S6)))));
+    const double hz = 0.5 * z;
+    const double w = 1 - hz;
+    const double cr = w + (((1 - w) - hz) + z * z * (C1 + z * (C2 + z * (C3 + z * (C4 + z * (C5 + z * C6))))));
+
+    /// quadrant swaps sine and cosine and flips their signs
+    const double sq = q & 1 ? cr : sr;
+    const double cq = q & 1 ? sr : cr;
+    s = q & 2 ? -sq : sq;
+    c = (q + 1) & 2 ? -cq : cq;
+}
+
+inline void Math_NS::fastSincos(float x, float& s, float& c) noexcept {
+    using namespace FastMathDetail;
+
+    /// cephes sinf.c and cosf.c, reduction by pi/2 is done in double
+    constexpr double twoOverPi = 6.36619772367581382433e-01;
+    constexpr double pio2_1  = 1.57079632673412561417e+00;
+    constexpr double pio2_1t = 6.07710050650619224932e-11;
+
+    double jd = x * twoOverPi + roundShiftD;
+    const std::uint32_t q = static_cast<std::uint32_t>(bits(jd));
+    jd -= roundShiftD;
+    const float r = static_cast<float>((x - jd * pio2_1) - jd * pio2_1t);
+
+    const float z = r * r;
+    const float sr = ((-1.9515295891E-4f * z + 8.3321608736E-3f) * z - 1.6666654611E-1f) * z * r + r;
+    const float cr = ((2.443315711809948E-5f * z - 1.388731625493765E-3f) * z + 4.166664568298827E-2f) * z * z - 0.5f * z + 1.0f;
+
+    const float sq = q & 1 ? cr : sr;
+    const float cq = q & 1 ? sr : cr;
+    s = q & 2 ? -sq : sq;
+    c = (q + 1) & 2 ? -cq : cq;
+}
+
+inline double Math_NS::fastRsqrt(double x) noexcept {
+    using namespace FastMathDetail;
+
+    /// initial guess from the exponent, every Newton step doubles correct bits
+    double y = asDouble(0x5fe6eb50c7b537a9ULL - (bits(x) >> 1));
+    const double halfX = 0.5 * x;
+    for (int i = 0; i < 4; i++)
+        y = y * (1.5 - halfX * y * y);
+    return y;
+}
+
+inline float Math_NS::fastRsqrt(float x) noexcept {
+    using namespace FastMathDetail;
+
+    float y = asFloat(0x5f375a86U - (bits(x) >> 1));
+    const float halfX = 0.5f * x;
+    for (int i = 0; i < 3; i++)
+        y = y * (1.5f - halfX * y * y);
+    return y;
+}
+
+template < typename T >
+void Math_NS::fastLog(const T* x, T* y, const std::size_t& n) noexcept {
+    for (std::size_t i = 0; i < n; i++)
+        y[i] = fastLog(x[i]);
+}
+
+template < typename T >
+void Math_NS::fastExp(const T* x, T* y, const std::size_t& n) noexcept {
+    for (std::size_t i = 0; i < n; i++)
+        y[i] = fastExp(x[i]);
+}
+
+template < typename T >
+void Math_NS::fastRsqrt(const T* x, T* y, const std::size_t& n) noexcept {
+    for (std::size_t i = 0; i < n; i++)
+        y[i] = fastRsqrt(x[i]);
+}
+
+template < typename T >
+void Math_NS::fastSincos(const T* x, T* s, T* c, const std::size_t& n) noexcept {
+    for (std::size_t i = 0; i < n; i++)
+        fastSincos(x[i], s[i], c[i]);
+}
+
+template < typename T >
+T Math_NS::transportLog(const T& x) noexcept {
+    #ifdef ENABLE_FAST_MATH
+        return fastLog(x);
+    #else
+        return std::log(x);
+    #endif // ENABLE_FAST_MATH
+}
+
+template < typename T >
+T Math_NS::transportExp(const T& x) noexcept {
+    #ifdef ENABLE_FAST_MATH
+        return fastExp(x);
+    #else
+        return std::exp(x);
+    #endif // ENABLE_FAST_MATH
+}
+
+template < typename T >
+void Math_NS::transportSincos(const T& x, T& s, T& c) noexcept {
+    #ifdef ENABLE_FAST_MATH
+        fastSincos(x, s, c);
+    #else
+        s = std::sin(x);
+        c = std::cos(x);
+    #endif // ENABLE_FAST_MATH
+}
+
+template < typename T >
+T Math_NS::transportRsqrt(const T& x) noexcept {
+    #ifdef ENABLE_FAST_MATH
+        return fastRsqrt(x);
+    #else
+        return 1 / std::sqrt(x);
+    #endif // ENABLE_FAST_MATH
+}
@@ -0,0 +1,215 @@
+#pragma once
+
+#ifndef ENABLE_CHECK_CONTRACTS
+    #define ENABLE_CHECK_CONTRACTS
+#endif // ENABLE_CHECK_CONTRACTS
+
+#include "FastMath.h"
+
+#include "../Tests/BenchmarkHelper.h"
+
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace Math_NS;
+using namespace std;
+
+namespace {
+    /// Distance from value to reference in units in the last place of the reference rounded to T
+    template < typename T >
+    long double ulpError(const T& value, const long double& reference) {
+        const T rounded = static_cast<T>(reference);
+        long double ulp = static_cast<long double>(nextafter(abs(rounded), numeric_limits<T>::infinity())) - abs(rounded);
+        if (abs(rounded) < numeric_limits<T>::min())
+            ulp = numeric_limits<T>::denorm_min();
+        return abs(static_cast<long double>(value) - reference) / ulp;
+    }
+
+    constexpr int ULP_SAMPLES = 200000;
+
+    template < typename T >
+    long double maxLogError() {
+        mt19937_64 generator(1);
+        uniform_real_distribution<double> exponent(-80, 80);
+        long double maxError = 0;
+        for (int i = 0; i < ULP_SAMPLES; i++) {
+            const T x = static_cast<T>(exp(exponent(generator)));
+            maxError = max(maxError, ulpError(fastLog(x), logl(x)));
+        }
+        return maxError;
+    }
+
+    template < typename T >
+    long double maxExpError(const double& minX, const double& maxX) {
+        mt19937_64 generator(2);
+        uniform_real_distribution<double> argument(minX, maxX);
+        long double maxError = 0;
+        for (int i = 0; i < ULP_SAMPLES; i++) {
+            const T x = static_cast<T>(argument(generator));
+            maxError = max(maxError, ulpError(fastExp(x), expl(x)));
+        }
+        return maxError;
+    }
+
+    template < typename T >
+    long double maxSincosError(const double& range) {
+        mt19937_64 generator(3);
+        uniform_real_distribution<double> argument(-range, range);
+        long double maxError = 0;
+        for (int i = 0; i < ULP_SAMPLES; i++) {
+            const T x = static_cast<T>(argument(generator));
+            T s, c;
+            fastSincos(x, s, c);
+            maxError = max(maxError, ulpError(s, sinl(x)));
+            maxError = max(maxError, ulpError(c, cosl(x)));
+        }
+        return maxError;
+    }
+
+    template < typename T >
+    long double maxRsqrtError() {
+        mt19937_64 generator(4);
+        uniform_real_distribution<double> exponent(-80, 80);
+        long double maxError = 0;
+        for (int i = 0; i < ULP_SAMPLES; i++) {
+            const T x = static_cast<T>(exp(exponent(generator)));
+            maxError = max(maxError, ulpError(fastRsqrt(x), 1 / sqrtl(x)));
+        }
+        return maxError;
+    }
+}
+
+TEST(FastMathTests, LogDouble) {
+    EXPECT_LE(maxLogError<double>(), 1);
+}
+
+TEST(FastMathTests, LogFloat) {
+    EXPECT_LE(maxLogError<float>(), 1);
+}
+
+TEST(FastMathTests, LogSpecialValues) {
+    EXPECT_EQ(fastLog(0.0), -numeric_limits<double>::infinity());
+    EXPECT_EQ(fastLog(numeric_limits<double>::infinity()), numeric_limits<double>::infinity());
+    EXPECT_TRUE(isnan(fastLog(-1.0)));
+    EXPECT_EQ(fastLog(1.0), 0);
+    EXPECT_EQ(fastLog(0.0f), -numeric_limits<float>::infinity());
+    EXPECT_TRUE(isnan(fastLog(-1.0f)));
+    EXPECT_LE(ulpError(fastLog(5 * numeric_limits<double>::denorm_min()), logl(5 * numeric_limits<double>::denorm_min())), 1);
+    EXPECT_LE(ulpError(fastLog(5 * numeric_limits<float>::denorm_min()), logl(5 * numeric_limits<float>::denorm_min())), 1);
+}
+
+TEST(FastMathTests, ExpDouble) {
+    EXPECT_LE(maxExpError<double>(-1, 1), 1);
+    EXPECT_LE(maxExpError<double>(-708, 709), 1);
+}
+
+TEST(FastMathTests, ExpFloat) {
+    EXPECT_LE(maxExpError<float>(-1, 1), 1);
+    EXPECT_LE(maxExpError<float>(-87, 88), 1);
+}
+
+TEST(FastMathTests, ExpSpecialValues) {
+    EXPECT_EQ(fastExp(0.0), 1);
+    EXPECT_EQ(fastExp(-1000.0), 0);
+    EXPECT_EQ(fastExp(1000.0), numeric_limits<double>::infinity());
+    EXPECT_EQ(fastExp(-numeric_limits<double>::infinity()), 0);
+    EXPECT_EQ(fastExp(0.0f), 1);
+    EXPECT_EQ(fastExp(-100.0f), 0);
+    EXPECT_EQ(fastExp(100.0f), numeric_limits<float>::infinity());
+}
+
+TEST(FastMathTests, SincosDouble) {
+    EXPECT_LE(maxSincosError<double>(2 * M_PI), 2);
+    EXPECT_LE(maxSincosError<double>(100), 2);
+    EXPECT_LE(maxSincosError<double>(1E5), 3);
+}
+
+TEST(FastMathTests, SincosFloat) {
+    EXPECT_LE(maxSincosError<float>(2 * M_PI), 2);
+    EXPECT_LE(maxSincosError<float>(100), 2);
+    EXPECT_LE(maxSincosError<float>(1E5), 3);
+}
+
+TEST(FastMathTests, SincosQuadrants) {
+    for (int i = -8; i <= 8; i++) {
+        double s, c;
+        fastSincos(i * M_PI / 2, s, c);
+        EXPECT_NEAR(s, sin(i * M_PI / 2), 1E-15);
+        EXPECT_NEAR(c, cos(i * M_PI / 2), 1E-15);
+    }
+}
+
+TEST(FastMathTests, RsqrtDouble) {
+    EXPECT_LE(maxRsqrtError<double>(), 3);
+}
+
+TEST(FastMathTests, RsqrtFloat) {
+    EXPECT_LE(maxRsqrtError<float>(), 3);
+}
+
+TEST(FastMathTests, BatchedMatchesScalar) {
+    const size_t n = 1000;
+    vector<double> x(n), y(n), s(n), c(n);
+    for (size_t i = 0; i < n; i++)
+        x[i] = (i + 0.5) / n;
+
+    fastLog(x.data(), y.data(), n);
+    for (size_t i = 0; i < n; i++)
+        EXPECT_EQ(y[i], fastLog(x[i]));
+    fastExp(x.data(), y.data(), n);
+    for (size_t i = 0; i < n; i++)
+        EXPECT_EQ(y[i], fastExp(x[i]));
+    fastRsqrt(x.data(), y.data(), n);
+    for (size_t i = 0; i < n; i++)
+        EXPECT_EQ(y[i], fastRsqrt(x[i]));
+    fastSincos(x.data(), s.data(), c.data(), n);
+    for (size_t i = 0; i < n; i++) {
+        double si, ci;
+        fastSincos(x[i], si, ci);
+        EXPECT_EQ(s[i], si);
+        EXPECT_EQ(c[i], ci);
+    }
+}
+
+namespace {
+    constexpr size_t BATCH = 1 << 16;
+
+    vector<double>& batchArguments() {
+        static vector<double> x = [] {
+            vector<double> v(BATCH);
+            for (size_t i = 0; i < BATCH; i++)
+                v[i] = (i + 0.5) / BATCH;
+            return v;
+        }();
+        return x;
+    }
+
+    void RawLogBatch() {
+        static vector<double> y(BATCH);
+        fastLog(batchArguments().data(), y.data(), BATCH);
+    }
+
+    void RawExpBatch() {
+        static vector<double> y(BATCH);
+        fastExp(batchArguments().data(), y.data(), BATCH);
+    }
+
+    void RawSincosBatch() {
+        static vector<double> s(BATCH), c(BATCH);
+        fastSincos(batchArguments().data(), s.data(), c.data(), BATCH);
+    }
+
+    void RawRsqrtBatch() {
+        static vector<double> y(BATCH);
+        fastRsqrt(batchArguments().data(), y.data(), BATCH);
+    }
+}
+
+BENCHMARK_TEST(HealthCheck_FastMath, LogBatch, RawLogBatch, 1000, 1500)
+BENCHMARK_TEST(HealthCheck_FastMath, ExpBatch, RawExpBatch, 1000, 1500)
+BENCHMARK_TEST(HealthCheck_FastMath, SincosBatch, RawSincosBatch, 1000, 2000)
+BENCHMARK_TEST(HealthCheck_FastMath, RsqrtBatch, RawRsqrtBatch, 1000, 1000)
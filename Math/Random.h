@@ -1,5 +1,9 @@
 #pragma once
 
+#include "Xoshiro.h"
+
+#include <cmath>
+#include <cstdint>
 #include <random>
 #include <stdlib.h>
 #include <time.h>
@@ -11,6 +15,55 @@ namespace Math_NS {
 
     template < typename T >
     static T randomC(T min = static_cast<T>(0), T max = static_cast<T>(1));
+
+    /// Normally distributed number, Box-Muller transform of two uniform numbers
+    /// \param[in] mean mean value
+    /// \param[in] sigma standard deviation
+    /// \return random number
+    template < typename T >
+    static T randomNormal(T mean = static_cast<T>(0), T sigma = static_cast<T>(1));
+
+    /// \brief Buffered uniform numbers of one thread
+    /// Numbers are generated by Xoshiro256 in blocks of BUFFER_SIZE at full SIMD width
+    /// and handed out one by one, so a draw is a load and an index increment.
+    class RandomStream {
+    public:
+        static constexpr std::size_t BUFFER_SIZE = 256;
+
+        /// \param[in] seed seed of the sequence shared by all threads and processes of a run
+        /// \param[in] stream index of the thread or process
+        explicit RandomStream(const std::uint64_t& seed = 0, const std::uint64_t& stream = 0) noexcept
+            : generator(seed, stream) {}
+
+        /// \return uniform number in (0, 1)
+        template < typename T >
+        inline T next() noexcept;
+
+        /// Fill buffer with uniform numbers in (0, 1) directly from the generator
+        /// \param[out] buffer output
+        /// \param[in] n number of elements
+        template < typename T >
+        inline void fill(T* buffer, const std::size_t& n) noexcept { generator.fill(buffer, n); }
+
+    protected:
+        Xoshiro256 generator;
+        alignas(64) double bufferD[BUFFER_SIZE];
+        alignas(64) float  bufferF[BUFFER_SIZE];
+        std::size_t positionD = BUFFER_SIZE;
+        std::size_t positionF = BUFFER_SIZE;
+    };
+
+    /// Random stream of the calling thread, seeded from std::random_device on first use
+    RandomStream& threadRandomStream();
+
+    /// Reseed random stream of the calling thread
+    /// Threads of one run should share seed and use distinct stream indices, their sequences never overlap
+    /// \param[in] seed seed of the run
+    /// \param[in] stream index of the thread or process
+    void seedRandom(const std::uint64_t& seed, const std::uint64_t& stream = 0);
+
+    /// \return 64-bit seed from std::random_device
+    std::uint64_t randomSeed();
 }
 
 /******************
@@ -18,16 +71,44 @@ namespace Math_NS {
  ******************/
 
 template < typename T >
-T Math_NS::random(T min, T max) {
-    using namespace std;
+T Math_NS::RandomStream::next() noexcept {
+    if constexpr (std::is_same_v<T, float>) {
+        if (positionF == BUFFER_SIZE) {
+            generator.fill(bufferF, BUFFER_SIZE);
+            positionF = 0;
+        }
+        return bufferF[positionF++];
+    } else {
+        if (positionD == BUFFER_SIZE) {
+            generator.fill(bufferD, BUFFER_SIZE);
+            positionD = 0;
+        }
+        return static_cast<T>(bufferD[positionD++]);
+    }
+}
+
+inline Math_NS::RandomStream& Math_NS::threadRandomStream() {
+    static thread_local RandomStream stream(randomSeed());
+    return stream;
+}
+
+inline void Math_NS::seedRandom(const std::uint64_t& seed, const std::uint64_t& stream) {
+    threadRandomStream() = RandomStream(seed, stream);
+}
+
+inline std::uint64_t Math_NS::randomSeed() {
+    std::random_device rd;
+    return (static_cast<std::uint64_t>(rd()) << 32) ^ rd();
+}
 
+template < typename T >
+T Math_NS::random(T min, T max) {
     if constexpr (std::is_integral<T>())
         return static_cast<T>(random<double>(min, max));
     else {
-        static thread_local random_device rd;
-        static thread_local default_random_engine generator(rd());
-        static thread_local uniform_real_distribution<T> distribution(0, 1);
-        return min + (max - min) * distribution(generator);
+        const T value = min + (max - min) * threadRandomStream().next<T>();
+        /// rounding of the product may reach max
+        return value < max ? value : std::nextafter(max, min);
     }
 }
 
@@ -37,3 +118,11 @@ T Math_NS::randomC(T min, T max) {
     rnd -= rnd == RAND_MAX ? 1 : 0;
     return min + (max - min) * static_cast<T>(rnd) / static_cast<T>(RAND_MAX);
 }
+
+template < typename T >
+T Math_NS::randomNormal(T mean, T sigma) {
+    auto& stream = threadRandomStream();
+    const T u1 = stream.next<T>();
+    const T u2 = stream.next<T>();
+    return mean + sigma * std::sqrt(-2 * std::log(u1)) * std::cos(2 * T(M_PI) * u2);
+}
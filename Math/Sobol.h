@@ -0,0 +1,153 @@
+#pragma once
+
+#include "../Utils/Contracts.h"
+
+#include <array>
+#include <cstdint>
+
+namespace Math_NS {
+    /// \brief Owen-scrambled Sobol sequence in a few dimensions.
+    /// Points are digital (t, s)-sequences in base 2, so the first 2^m points of every dimension fall one per interval
+    /// of length 2^-m. Every dimension is scrambled by a nested uniform permutation of its digits (Laine-Karras hash, Burley 2020)
+    /// with a seed of its own, so every point is uniform on the unit cube and sequences of different seeds are independent
+    class ScrambledSobol {
+    public:
+        static constexpr int DIMENSIONS = 19;
+
+        /// \param[in] seed seed of scrambling, expanded to seeds of dimensions
+        explicit ScrambledSobol(const std::uint64_t& seed = 0) noexcept;
+        ~ScrambledSobol() noexcept = default;
+
+        /// Coordinate of point
+        /// \param[in] index index of point
+        /// \param[in] dimension dimension in [0, DIMENSIONS)
+        /// \return coordinate in (0, 1)
+        /// \throw std::invalid_argument if ENABLE_CHECK_CONTRACTS is defined and dimension is out of range
+        template < typename T >
+        inline T get(const std::uint32_t& index, const int& dimension) const EXCEPT_INPUT_PARAMS;
+
+        /// Unscrambled coordinate of point, 32 digits from the most significant
+        /// \param[in] index index of point
+        /// \param[in] dimension dimension in [0, DIMENSIONS)
+        /// \return digits of coordinate
+        static inline std::uint32_t sobol(const std::uint32_t& index, const int& dimension) noexcept;
+
+    protected:
+        std::array<std::uint32_t, DIMENSIONS> seeds;
+
+        /// direction numbers of dimensions, primitive polynomials and initial numbers of Joe and Kuo (2008)
+        using Directions = std::array<std::array<std::uint32_t, 32>, DIMENSIONS>;
+        static const Directions& directions() noexcept;
+        static Directions makeDirections() noexcept;
+
+        static inline std::uint32_t reverseBits(std::uint32_t x) noexcept;
+        static inline std::uint32_t laineKarras(std::uint32_t x, const std::uint32_t& seed) noexcept;
+    };
+}
+
+/******************
+ * IMPLEMENTATION *
+ ******************/
+
+inline Math_NS::ScrambledSobol::ScrambledSobol(const std::uint64_t& seed) noexcept {
+    /// splitmix64 of seed
+    std::uint64_t x = seed;
+    for (auto& dimensionSeed: seeds) {
+        std::uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        dimensionSeed = static_cast<std::uint32_t>((z ^ (z >> 31)) >> 32);
+    }
+}
+
+template < typename T >
+T Math_NS::ScrambledSobol::get(const std::uint32_t& index, const int& dimension) const EXCEPT_INPUT_PARAMS {
+    CHECK_ARGUMENT_CONTRACT(dimension >= 0 && dimension < DIMENSIONS);
+
+    /// nested uniform scramble permutes digits from the most significant one, the hash runs from the least significant bit
+    const std::uint32_t digits = reverseBits(laineKarras(reverseBits(sobol(index, dimension)), seeds[dimension]));
+    /// middle of the interval of 32 digits
+    return (static_cast<T>(digits) + T(0.5)) * T(1.0 / 4294967296.0);
+}
+
+std::uint32_t Math_NS::ScrambledSobol::sobol(const std::uint32_t& index, const int& dimension) noexcept {
+    const auto& v = directions()[dimension];
+    std::uint32_t x = 0;
+    std::uint32_t i = index;
+    for (int bit = 0; i != 0; bit++, i >>= 1)
+        if (i & 1)
+            x ^= v[bit];
+    return x;
+}
+
+inline const Math_NS::ScrambledSobol::Directions& Math_NS::ScrambledSobol::directions() noexcept {
+    static const Directions table = makeDirections();
+    return table;
+}
+
+inline Math_NS::ScrambledSobol::Directions Math_NS::ScrambledSobol::makeDirections() noexcept {
+    /// degree, coefficients and initial numbers of primitive polynomials of dimensions 1..DIMENSIONS-1
+    struct Polynomial {
+        int s;
+        std::uint32_t a;
+        std::array<std::uint32_t, 6> m;
+    };
+    static constexpr Polynomial polynomials[DIMENSIONS - 1] = {
+        {1, 0, {1}},
+        {2, 1, {1, 3}},
+        {3, 1, {1, 3, 1}},
+        {3, 2, {1, 1, 1}},
+        {4, 1, {1, 1, 3, 3}},
+        {4, 4, {1, 3, 5, 13}},
+        {5, 2, {1, 1, 5, 5, 17}},
+        {5, 4, {1, 1, 5, 5, 5}},
+        {5, 7, {1, 1, 7, 11, 19}},
+        {5, 11, {1, 1, 5, 1, 1}},
+        {5, 13, {1, 1, 1, 3, 11}},
+        {5, 14, {1, 3, 5, 5, 31}},
+        {6, 1, {1, 1, 1, 9, 23, 37}},
+        {6, 13, {1, 3, 3, 5, 19, 33}},
+        {6, 16, {1, 1, 3, 13, 11, 7}},
+        {6, 19, {1, 1, 7, 13, 25, 5}},
+        {6, 22, {1, 3, 5, 11, 7, 11}},
+        {6, 25, {1, 1, 1, 3, 13, 39}},
+    };
+
+    Directions v{};
+    /// the first dimension is van der Corput sequence
+    for (int k = 0; k < 32; k++)
+        v[0][k] = std::uint32_t(1) << (31 - k);
+
+    for (int d = 1; d < DIMENSIONS; d++) {
+        const auto& [s, a, m] = polynomials[d - 1];
+        for (int k = 0; k < 32; k++) {
+            if (k < s) {
+                v[d][k] = m[k] << (31 - k);
+                continue;
+            }
+            v[d][k] = v[d][k - s] ^ (v[d][k - s] >> s);
+            for (int j = 1; j < s; j++)
+                if ((a >> (s - 1 - j)) & 1)
+                    v[d][k] ^= v[d][k - j];
+        }
+    }
+    return v;
+}
+
+std::uint32_t Math_NS::ScrambledSobol::reverseBits(std::uint32_t x) noexcept {
+    x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+    x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+    x = ((x >> 4) & 0x0f0f0f0fu) | ((x & 0x0f0f0f0fu) << 4);
+    x = ((x >> 8) & 0x00ff00ffu) | ((x & 0x00ff00ffu) << 8);
+    return (x >> 16) | (x << 16);
+}
+
+std::uint32_t Math_NS::ScrambledSobol::laineKarras(std::uint32_t x, const std::uint32_t& seed) noexcept {
+    /// every output bit depends on the input bits below it only, which makes it a nested permutation
+    x += seed;
+    x ^= x * 0x6c50b47cu;
+    x ^= x * 0xb82f1e52u;
+    x ^= x * 0xc7afe638u;
+    x ^= x * 0x8d22f6e6u;
+    return x;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#ifndef ENABLE_CHECK_CONTRACTS
+    #define ENABLE_CHECK_CONTRACTS
+#endif // ENABLE_CHECK_CONTRACTS
+
+#include "Sobol.h"
+
+#include <cmath>
+#include <cstdint>
+#include <set>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace Math_NS;
+using namespace std;
+
+TEST(SobolTests, FirstPointsOfReferenceSequence) {
+    /// 0, 1/2, 1/4 and 3/4 in the first two dimensions, then 3/4, 1/4 in the second one
+    const vector<uint32_t> first  = { 0, 0x80000000u, 0x40000000u, 0xc0000000u };
+    const vector<uint32_t> second = { 0, 0x80000000u, 0xc0000000u, 0x40000000u };
+    for (uint32_t i = 0; i < first.size(); i++) {
+        EXPECT_EQ(ScrambledSobol::sobol(i, 0), first[i]);
+        EXPECT_EQ(ScrambledSobol::sobol(i, 1), second[i]);
+    }
+}
+
+TEST(SobolTests, DimensionsAreStratified) {
+    /// 2^m points of every dimension fall one per interval of length 2^-m
+    constexpr int m = 12;
+    constexpr uint32_t N = 1u << m;
+    const ScrambledSobol sobol(17);
+    for (int d = 0; d < ScrambledSobol::DIMENSIONS; d++) {
+        vector<int> intervals(N, 0);
+        for (uint32_t i = 0; i < N; i++)
+            intervals[static_cast<int>(sobol.get<double>(i, d) * N)]++;
+        for (const auto& count: intervals)
+            ASSERT_EQ(count, 1) << "dimension " << d;
+    }
+}
+
+TEST(SobolTests, FirstTwoDimensionsAreNet) {
+    /// the first two dimensions are a (0, m, 2)-net: 2^m points fill every 2^k x 2^(m-k) grid one per cell
+    constexpr int m = 10;
+    constexpr uint32_t N = 1u << m;
+    const ScrambledSobol sobol(5);
+    for (int k = 0; k <= m; k++) {
+        vector<int> cells(N, 0);
+        for (uint32_t i = 0; i < N; i++) {
+            const int c1 = static_cast<int>(sobol.get<double>(i, 0) * (1 << k));
+            const int c2 = static_cast<int>(sobol.get<double>(i, 1) * (1 << (m - k)));
+            cells[(c1 << (m - k)) + c2]++;
+        }
+        for (const auto& count: cells)
+            ASSERT_EQ(count, 1) << "grid " << (1 << k) << " x " << (1 << (m - k));
+    }
+}
+
+TEST(SobolTests, ScrambledPointsAreInUnitInterval) {
+    const ScrambledSobol sobol(3);
+    for (uint32_t i = 0; i < 4096; i++)
+        for (int d = 0; d < ScrambledSobol::DIMENSIONS; d++) {
+            const auto x = sobol.get<float>(i, d);
+            ASSERT_GT(x, 0);
+            ASSERT_LT(x, 1);
+        }
+}
+
+TEST(SobolTests, ScramblingDependsOnSeed) {
+    const ScrambledSobol a(1), b(1), c(2);
+    set<double> firstPoints;
+    for (uint32_t i = 0; i < 64; i++) {
+        EXPECT_EQ(a.get<double>(i, 3), b.get<double>(i, 3));
+        firstPoints.insert(a.get<double>(i, 3));
+    }
+    EXPECT_NE(a.get<double>(0, 3), c.get<double>(0, 3));
+    /// scrambled point 0 is not the origin and dimensions have seeds of their own
+    EXPECT_NE(a.get<double>(0, 0), a.get<double>(0, 1));
+    EXPECT_EQ(firstPoints.size(), 64u);
+}
+
+TEST(SobolTests, MeanOverReplicatesIsUniform) {
+    /// scrambled points are uniform, so the mean of a coordinate over seeds is 1/2
+    constexpr int seeds = 4096;
+    double mean = 0;
+    for (int seed = 0; seed < seeds; seed++)
+        mean += ScrambledSobol(seed).get<double>(5, 4);
+    mean /= seeds;
+    EXPECT_NEAR(mean, 0.5, 5 * sqrt(1.0 / 12 / seeds));
+}
+
+TEST(SobolTests, Throws) {
+    const ScrambledSobol sobol;
+    EXPECT_THROW(sobol.get<double>(0, -1), std::invalid_argument);
+    EXPECT_THROW(sobol.get<double>(0, ScrambledSobol::DIMENSIONS), std::invalid_argument);
+}
@@ -0,0 +1,203 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace Math_NS {
+    /// \brief Vectorised xoshiro256++ generator
+    /// LANES independent xoshiro256++ generators are stepped together, their states are stored lane by lane,
+    /// so one step of all lanes is a handful of vector instructions and buffers are filled at full SIMD width.
+    /// Lanes are 2^128 steps apart on one sequence (jump), streams are 2^192 steps apart (long jump),
+    /// so up to 2^64 streams of 2^64 lanes never overlap. One stream is meant for one thread or process.
+    class Xoshiro256 {
+    public:
+        static constexpr std::size_t LANES = 8;
+        using State = std::array<std::uint64_t, 4>;
+
+        /// \param[in] seed seed of the sequence, expanded with splitmix64
+        /// \param[in] stream index of the stream, thread or process number
+        explicit Xoshiro256(const std::uint64_t& seed = 0, const std::uint64_t& stream = 0) noexcept;
+
+        /// Fill buffer with uniformly distributed numbers in (0, 1),
+        /// element i is produced by lane i % LANES
+        /// \param[out] buffer output
+        /// \param[in] n number of elements
+        template < typename T >
+        void fill(T* buffer, const std::size_t& n) noexcept;
+
+        /// Fill buffer with raw 64-bit outputs, element i is produced by lane i % LANES
+        /// \param[out] buffer output
+        /// \param[in] n number of elements
+        void fillBits(std::uint64_t* buffer, const std::size_t& n) noexcept;
+
+        /// Advance every lane by 2^128 steps
+        void jump() noexcept;
+
+        /// Advance every lane by 2^192 steps
+        void longJump() noexcept;
+
+        /// State of the lane in reference xoshiro256++ order
+        /// \param[in] lane lane index
+        /// \return s[0], s[1], s[2], s[3] of the lane
+        State getState(const std::size_t& lane) const noexcept;
+
+        /// Uniform number in (0, 1) from 64 random bits, 52 bits for double and 23 bits for float are used,
+        /// so that the result is exact and never hits 0 or 1
+        template < typename T >
+        static inline T toUniform(const std::uint64_t& bits) noexcept;
+
+    protected:
+        static constexpr State JUMP      = { 0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL };
+        static constexpr State LONG_JUMP = { 0x76e15d3efefdcbbfULL, 0xc5004e441c522fb3ULL, 0x77710069854ee241ULL, 0x39109bb02acbe635ULL };
+
+        static inline std::uint64_t rotl(const std::uint64_t& x, const int& k) noexcept { return (x << k) | (x >> (64 - k)); }
+        static std::uint64_t splitmix64(std::uint64_t& x) noexcept;
+
+        /// step all lanes and write their outputs
+        inline void next(std::uint64_t* out) noexcept;
+
+        /// polynomial jump of every lane
+        void jump(const State& polynomial) noexcept;
+
+        alignas(64) std::uint64_t s0[LANES];
+        alignas(64) std::uint64_t s1[LANES];
+        alignas(64) std::uint64_t s2[LANES];
+        alignas(64) std::uint64_t s3[LANES];
+    };
+}
+
+/******************
+ * IMPLEMENTATION *
+ ******************/
+
+inline Math_NS::Xoshiro256::Xoshiro256(const std::uint64_t& seed, const std::uint64_t& stream) noexcept {
+    std::uint64_t x = seed;
+    s0[0] = splitmix64(x);
+    s1[0] = splitmix64(x);
+    s2[0] = splitmix64(x);
+    s3[0] = splitmix64(x);
+    /// all zero state is the only fixed point
+    if ((s0[0] | s1[0] | s2[0] | s3[0]) == 0)
+        s0[0] = 1;
+
+    for (std::size_t lane = 1; lane < LANES; lane++) {
+        s0[lane] = s0[0];
+        s1[lane] = s1[0];
+        s2[lane] = s2[0];
+        s3[lane] = s3[0];
+    }
+
+    /// stream first, then lane l is jumped l times, lanes stay within 2^192 steps of the stream start
+    for (std::uint64_t i = 0; i < stream; i++)
+        jump(LONG_JUMP);
+    for (std::size_t step = 1; step < LANES; step++) {
+        /// jump all lanes at once and roll back those which are already in place
+        std::uint64_t keep[4][LANES];
+        for (std::size_t lane = 0; lane < step; lane++) {
+            keep[0][lane] = s0[lane];
+            keep[1][lane] = s1[lane];
+            keep[2][lane] = s2[lane];
+            keep[3][lane] = s3[lane];
+        }
+        jump(JUMP);
+        for (std::size_t lane = 0; lane < step; lane++) {
+            s0[lane] = keep[0][lane];
+            s1[lane] = keep[1][lane];
+            s2[lane] = keep[2][lane];
+            s3[lane] = keep[3][lane];
+        }
+    }
+}
+
+template < typename T >
+void Math_NS::Xoshiro256::fill(T* buffer, const std::size_t& n) noexcept {
+    alignas(64) std::uint64_t bits[LANES];
+    std::size_t i = 0;
+    for (; i + LANES <= n; i += LANES) {
+        next(bits);
+        for (std::size_t lane = 0; lane < LANES; lane++)
+            buffer[i + lane] = toUniform<T>(bits[lane]);
+    }
+    if (i < n) {
+        next(bits);
+        for (std::size_t lane = 0; i + lane < n; lane++)
+            buffer[i + lane] = toUniform<T>(bits[lane]);
+    }
+}
+
+inline void Math_NS::Xoshiro256::fillBits(std::uint64_t* buffer, const std::size_t& n) noexcept {
+    alignas(64) std::uint64_t bits[LANES];
+    std::size_t i = 0;
+    for (; i + LANES <= n; i += LANES)
+        next(buffer + i);
+    if (i < n) {
+        next(bits);
+        for (std::size_t lane = 0; i + lane < n; lane++)
+            buffer[i + lane] = bits[lane];
+    }
+}
+
+inline void Math_NS::Xoshiro256::jump() noexcept {
+    jump(JUMP);
+}
+
+inline void Math_NS::Xoshiro256::longJump() noexcept {
+    jump(LONG_JUMP);
+}
+
+inline Math_NS::Xoshiro256::State Math_NS::Xoshiro256::getState(const std::size_t& lane) const noexcept {
+    return { s0[lane], s1[lane], s2[lane], s3[lane] };
+}
+
+template < typename T >
+T Math_NS::Xoshiro256::toUniform(const std::uint64_t& bits) noexcept {
+    if constexpr (sizeof(T) == sizeof(float))
+        return (static_cast<T>(bits >> 41) + T(0.5)) * T(0x1.0p-23);
+    else
+        return (static_cast<T>(bits >> 12) + T(0.5)) * T(0x1.0p-52);
+}
+
+inline std::uint64_t Math_NS::Xoshiro256::splitmix64(std::uint64_t& x) noexcept {
+    std::uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+inline void Math_NS::Xoshiro256::next(std::uint64_t* out) noexcept {
+    for (std::size_t lane = 0; lane < LANES; lane++) {
+        out[lane] = rotl(s0[lane] + s3[lane], 23) + s0[lane];
+        const std::uint64_t t = s1[lane] << 17;
+        s2[lane] ^= s0[lane];
+        s3[lane] ^= s1[lane];
+        s1[lane] ^= s2[lane];
+        s0[lane] ^= s3[lane];
+        s2[lane] ^= t;
+        s3[lane] = rotl(s3[lane], 45);
+    }
+}
+
+inline void Math_NS::Xoshiro256::jump(const State& polynomial) noexcept {
+    std::uint64_t j0[LANES] = {}, j1[LANES] = {}, j2[LANES] = {}, j3[LANES] = {};
+    std::uint64_t discard[LANES];
+    for (const auto& word: polynomial) {
+        for (int b = 0; b < 64; b++) {
+            if (word & (std::uint64_t(1) << b)) {
+                for (std::size_t lane = 0; lane < LANES; lane++) {
+                    j0[lane] ^= s0[lane];
+                    j1[lane] ^= s1[lane];
+                    j2[lane] ^= s2[lane];
+                    j3[lane] ^= s3[lane];
+                }
+            }
+            next(discard);
+        }
+    }
+    for (std::size_t lane = 0; lane < LANES; lane++) {
+        s0[lane] = j0[lane];
+        s1[lane] = j1[lane];
+        s2[lane] = j2[lane];
+        s3[lane] = j3[lane];
+    }
+}
@@ -0,0 +1,200 @@
+#pragma once
+
+#ifndef ENABLE_CHECK_CONTRACTS
+    #define ENABLE_CHECK_CONTRACTS
+#endif // ENABLE_CHECK_CONTRACTS
+
+#include "Random.h"
+#include "Xoshiro.h"
+
+#include "../Tests/BenchmarkHelper.h"
+
+#include <array>
+#include <cstdint>
+#include <random>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace Math_NS;
+using namespace std;
+
+namespace {
+    /// scalar xoshiro256++ from the reference implementation by Blackman and Vigna
+    struct ReferenceXoshiro {
+        array<uint64_t, 4> s;
+
+        static uint64_t rotl(const uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+        uint64_t next() {
+            const uint64_t result = rotl(s[0] + s[3], 23) + s[0];
+            const uint64_t t = s[1] << 17;
+            s[2] ^= s[0];
+            s[3] ^= s[1];
+            s[1] ^= s[2];
+            s[0] ^= s[3];
+            s[2] ^= t;
+            s[3] = rotl(s[3], 45);
+            return result;
+        }
+
+        void jump(const array<uint64_t, 4>& polynomial) {
+            array<uint64_t, 4> j = {0, 0, 0, 0};
+            for (const auto& word: polynomial)
+                for (int b = 0; b < 64; b++) {
+                    if (word & (uint64_t(1) << b))
+                        for (int k = 0; k < 4; k++)
+                            j[k] ^= s[k];
+                    next();
+                }
+            s = j;
+        }
+    };
+
+    constexpr array<uint64_t, 4> JUMP = { 0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL };
+    constexpr array<uint64_t, 4> LONG_JUMP = { 0x76e15d3efefdcbbfULL, 0xc5004e441c522fb3ULL, 0x77710069854ee241ULL, 0x39109bb02acbe635ULL };
+    constexpr size_t L = Xoshiro256::LANES;
+}
+
+TEST(XoshiroTests, ReferenceOutput) {
+    ReferenceXoshiro reference{{1, 2, 3, 4}};
+    EXPECT_EQ(reference.next(), 41943041ULL);
+    EXPECT_EQ(reference.next(), 58720359ULL);
+}
+
+TEST(XoshiroTests, LanesAreJumpedReferenceStreams) {
+    Xoshiro256 generator(42);
+    ReferenceXoshiro reference{generator.getState(0)};
+    for (size_t lane = 1; lane < L; lane++) {
+        reference.jump(JUMP);
+        EXPECT_EQ(generator.getState(lane), reference.s);
+    }
+
+    vector<ReferenceXoshiro> lanes;
+    for (size_t lane = 0; lane < L; lane++)
+        lanes.push_back({generator.getState(lane)});
+    vector<uint64_t> bits(100 * L + 3);
+    generator.fillBits(bits.data(), bits.size());
+    for (size_t i = 0; i < bits.size(); i++)
+        ASSERT_EQ(bits[i], lanes[i % L].next());
+}
+
+TEST(XoshiroTests, StreamsAreLongJumped) {
+    const Xoshiro256 stream0(7, 0);
+    const Xoshiro256 stream3(7, 3);
+    ReferenceXoshiro reference{stream0.getState(0)};
+    for (int i = 0; i < 3; i++)
+        reference.jump(LONG_JUMP);
+    EXPECT_EQ(stream3.getState(0), reference.s);
+
+    Xoshiro256 jumped(7, 0);
+    jumped.longJump();
+    jumped.longJump();
+    jumped.longJump();
+    for (size_t lane = 0; lane < L; lane++)
+        EXPECT_EQ(jumped.getState(lane), stream3.getState(lane));
+}
+
+TEST(XoshiroTests, Reproducible) {
+    Xoshiro256 a(123, 5), b(123, 5), c(124, 5), d(123, 6);
+    vector<double> x(1000), y(1000), z(1000), w(1000);
+    a.fill(x.data(), x.size());
+    b.fill(y.data(), y.size());
+    c.fill(z.data(), z.size());
+    d.fill(w.data(), w.size());
+    EXPECT_EQ(x, y);
+    EXPECT_NE(x, z);
+    EXPECT_NE(x, w);
+}
+
+TEST(XoshiroTests, UniformBounds) {
+    EXPECT_GT(Xoshiro256::toUniform<double>(0), 0);
+    EXPECT_LT(Xoshiro256::toUniform<double>(~uint64_t(0)), 1);
+    EXPECT_GT(Xoshiro256::toUniform<float>(0), 0);
+    EXPECT_LT(Xoshiro256::toUniform<float>(~uint64_t(0)), 1);
+}
+
+TEST(XoshiroTests, UniformMoments) {
+    constexpr size_t N = 1 << 20;
+    Xoshiro256 generator(1);
+    vector<double> x(N);
+    generator.fill(x.data(), N);
+    double mean = 0, variance = 0;
+    for (const auto& v: x)
+        mean += v;
+    mean /= N;
+    for (const auto& v: x)
+        variance += (v - mean) * (v - mean);
+    variance /= N;
+    /// 5 sigma of the estimators
+    EXPECT_NEAR(mean, 0.5, 5 * sqrt(1.0 / 12 / N));
+    EXPECT_NEAR(variance, 1.0 / 12, 5 * sqrt(1.0 / 180 / N));
+}
+
+TEST(XoshiroTests, SeededThreadStreamsDoNotRepeat) {
+    constexpr int threads = 4;
+    vector<vector<double>> draws(threads, vector<double>(1000));
+    vector<thread> workers;
+    for (int i = 0; i < threads; i++)
+        workers.push_back(thread([&, i]() {
+            seedRandom(99, i);
+            for (auto& x: draws[i])
+                x = random<double>(0, 1);
+        }));
+    for (auto& worker: workers)
+        worker.join();
+
+    set<double> unique;
+    for (const auto& thread: draws)
+        unique.insert(thread.begin(), thread.end());
+    EXPECT_EQ(unique.size(), threads * draws.front().size());
+
+    seedRandom(99, 2);
+    for (const auto& x: draws[2])
+        ASSERT_EQ(random<double>(0, 1), x);
+}
+
+TEST(XoshiroTests, NormalMoments) {
+    constexpr int N = 1 << 20;
+    seedRandom(5);
+    double mean = 0, variance = 0;
+    for (int i = 0; i < N; i++) {
+        const double x = randomNormal<double>(1, 2);
+        mean += x;
+        variance += (x - 1) * (x - 1);
+    }
+    mean /= N;
+    variance /= N;
+    EXPECT_NEAR(mean, 1, 5 * 2 / sqrt(N));
+    EXPECT_NEAR(variance, 4, 5 * 4 * sqrt(2.0 / N));
+}
+
+namespace {
+    constexpr size_t BATCH = 1 << 16;
+
+    void RawXoshiroFill() {
+        static Xoshiro256 generator(1);
+        static vector<double> x(BATCH);
+        generator.fill(x.data(), BATCH);
+    }
+
+    void RawRandomStream() {
+        static vector<double> x(BATCH);
+        for (auto& v: x)
+            v = random<double>(0, 1);
+    }
+
+    void RawStdUniform() {
+        static default_random_engine generator(1);
+        static uniform_real_distribution<double> distribution(0, 1);
+        static vector<double> x(BATCH);
+        for (auto& v: x)
+            v = distribution(generator);
+    }
+}
+
+BENCHMARK_TEST(HealthCheck_Xoshiro, FillBatch, RawXoshiroFill, 1000, 500)
+BENCHMARK_TEST(HealthCheck_Xoshiro, RandomStream, RawRandomStream, 1000, 1000)
+BENCHMARK_TEST(HealthCheck_Xoshiro, StdUniformBaseline, RawStdUniform, 1000, 3000)
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "SaveResults.h"
+
+#include "../Inverse/InverseProblem.h"
+#include "../MC/PartialResults.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+/// file with partial results of shard, shards of one run are told apart by parameters of the sample
+template < typename T >
+std::string shardFileName(T inA, T inT, T inG, int shard, int Nshards) {
+    using namespace std;
+    return "Output files/Shards/Partial_" + to_string(inA) + "_" + to_string(inT) + "_" + to_string(inG) + "_" + to_string(shard) + "_of_" + to_string(Nshards) + ".bin";
+}
+
+/// One shard of directMC run of Nphotons split over Nshards processes, writes its raw tallies to shardFileName
+template < typename T, size_t Nz, size_t Nr, bool detector>
+PartialResults<T,Nz,Nr,detector> shardMC(T inA, T inT, T inG, T inNtop, T inDtop, T inN, T inD, T inNbottom, T inDbottom, bool moveable,
+                                         std::int64_t Nphotons, int shard, int Nshards, std::uint64_t seed, int Nthreads) {
+    using namespace Inverse_NS;
+    using namespace std;
+
+    vector<Medium<T>> layers;
+    auto tissue = Medium<T>::fromAlbedo(inN, inA, inT, inD, inG);
+    if (inDtop != 0 && inDbottom != 0) {
+        auto glassTop = Medium<T>::fromCoeffs(inNtop, 0.0, 0.0, inDtop, 0.0);
+        auto glassBottom = Medium<T>::fromCoeffs(inNbottom, 0.0, 0.0, inDbottom, 0.0);
+        layers = {glassTop, tissue, glassBottom};
+    } else if (inDtop == 0 && inDbottom == 0)
+        layers = {tissue};
+    else
+        throw invalid_argument("It seems that you want to calculate 2 layers, you can only do 1 or 3");
+    Sample<T> mySample(layers);
+    LightSource<T> source(0.0005, SourceType::Gaussian);
+    IntegratingSphere<T> SphereT(0.0508, 0.0125, 0.0); // dPort2 = zero if the sphere has one port
+    IntegratingSphere<T> SphereR(0.0508, 0.0125, 0.0125);
+    DetectorDistance<T> distances;
+    distances.max  = moveable ? 0.16 : 0.0;
+    distances.min  = 0;
+    distances.step = 0.005; // please, enter correct step for your borders
+
+    constexpr T selectedRadius = 1E-2;
+
+    const auto partial = shardMCmultithread<T,Nz,Nr,detector>(mySample, Nphotons, shard, Nshards, seed, Nthreads, mySample.getTotalThickness(), selectedRadius,
+                                                              SphereR, SphereT, distances, source);
+    filesystem::create_directories("Output files/Shards");
+    writePartialResults(partial, shardFileName(inA, inT, inG, shard, Nshards));
+    cout << "Shard " << shard << " of " << Nshards << ": " << partial.Nphotons << " photons" << endl;
+
+    return partial;
+}
+
+/// Merge partial results written by shardMC for all Nshards shards
+template < typename T, size_t Nz, size_t Nr, bool detector>
+MCresults<T,Nz,Nr,detector> mergeShards(T inA, T inT, T inG, int Nshards, bool save) {
+    using namespace std;
+
+    vector<PartialResults<T,Nz,Nr,detector>> partials;
+    for (int shard = 0; shard < Nshards; shard++)
+        partials.push_back(readPartialResults<T,Nz,Nr,detector>(shardFileName(inA, inT, inG, shard, Nshards)));
+
+    const auto myResults = mergePartialResults(partials);
+    cout << myResults << endl;
+    if (save)
+        saveResults<T,Nz,Nr,detector>(myResults, inA, inT, inG, 1);
+
+    return myResults;
+}
@@ -5,8 +5,9 @@
 #include "../Inverse/StartingPoints.h"
 #include "DirectMC.h"
 
+#include "../Math/Random.h"
+
 #include <time.h>
-#include <random>
 
 template < typename T, size_t N, Inverse_NS::FixedParameter fix, size_t M, size_t Nz, size_t Nr, bool detector >
 void spoiltData(T inA, T inT, T inG, T inN, T inD, T inNtop, T inDtop, T inNbottom, T inDbottom, bool moveable, int Nthreads, double err) {
@@ -53,25 +54,23 @@ void spoiltData(T inA, T inT, T inG, T inN, T inD, T inNtop, T inDtop, T inNbott
         fout.open("Output files/Error script/" + to_string(inA) + "_" + to_string(inT) + "_" + to_string(inG) + "_" + to_string(err) + "_fixed.txt");
     fout << "a, tau, g, time" << '\n';
 
-    /// TODO: Utils\Random.h
-    static default_random_engine generator(time(nullptr));
-    normal_distribution<T> distribution(0, err);
+    const auto distribution = [err]() { return Math_NS::randomNormal<T>(0, err); };
 
     for (int i = 0; i < 20; i++) {
         clock_t begin = clock();
         T diff = 0;
         for (const auto& x: rsmeas) {
-            T e1 = distribution(generator);
+            T e1 = distribution();
             rSpoilt.push_back({x.first, x.second + e1});
             diff += e1;
         }
         for (const auto& x: tsmeas) {
-            T e2 = distribution(generator);
+            T e2 = distribution();
             tSpoilt.push_back({x.first, x.second + e2});
             diff += e2;
         }
         for (const auto& x: tcmeas) {
-            T e3 = distribution(generator);
+            T e3 = distribution();
             tcSpoilt.push_back({x.first, x.second + e3});
             diff += e3;
         }
@@ -0,0 +1 @@
+#include "../MC/AdjointTests.h"
@@ -0,0 +1 @@
+#include "../Math/AliasTableTests.h"
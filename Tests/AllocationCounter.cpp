@@ -0,0 +1,33 @@
+#include "AllocationCounter.h"
+
+#include <cstdlib>
+#include <new>
+
+/// kept out of the test sources, so the compiler does not pair inlined free with calls of operator new there
+
+void* operator new(std::size_t size) {
+    AllocationCounter::count();
+    if (void* pointer = std::malloc(size ? size : 1))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <atomic>
+
+/// Counts heap allocations through operator new, which AllocationCounter.cpp replaces in the allocation_free_tests binary only
+namespace AllocationCounter {
+    inline std::atomic<bool> enabled{false};
+    inline std::atomic<long> allocations{0};
+
+    inline void count() noexcept {
+        if (enabled.load(std::memory_order_relaxed))
+            allocations++;
+    }
+}
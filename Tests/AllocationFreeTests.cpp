@@ -0,0 +1 @@
+#include "../MC/AllocationFreeTests.h"
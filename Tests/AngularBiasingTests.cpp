@@ -0,0 +1 @@
+#include "../MC/AngularBiasingTests.h"
@@ -0,0 +1 @@
+#include "../MC/BeamConvolutionTests.h"
@@ -40,14 +40,14 @@ TEST(TEST_CASE_NAME, TEST_NAME##_Benchmark##_x##CNT##_Expected_##DURATION_MS##ms
  * IMPLEMENTATION *
  ******************/
 
-void Tests_NS::BenchmarkHelper::start() noexcept {
+inline void Tests_NS::BenchmarkHelper::start() noexcept {
     time.start();
 }
 
-void Tests_NS::BenchmarkHelper::finish() noexcept {
+inline void Tests_NS::BenchmarkHelper::finish() noexcept {
     time.finish();
 }
 
-double Tests_NS::BenchmarkHelper::elapsed() noexcept {
+inline double Tests_NS::BenchmarkHelper::elapsed() noexcept {
     return time.msecElapsedDuration();
 }
@@ -0,0 +1 @@
+#include "../MC/BoundarySplittingTests.h"
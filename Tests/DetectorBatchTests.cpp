@@ -0,0 +1 @@
+#include "../MC/Detector/DetectorBatchTests.h"
@@ -0,0 +1 @@
+#include "../MC/DiffusionHandoffTests.h"
@@ -0,0 +1 @@
+#include "../Math/FastMathTests.h"
@@ -0,0 +1 @@
+#include "../MC/FiberEstimatorTests.h"
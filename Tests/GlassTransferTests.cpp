@@ -0,0 +1 @@
+#include "../MC/GlassTransferTests.h"
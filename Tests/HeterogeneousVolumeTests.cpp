@@ -0,0 +1 @@
+#include "../MC/HeterogeneousVolumeTests.h"
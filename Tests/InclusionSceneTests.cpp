@@ -0,0 +1 @@
+#include "../MC/InclusionSceneTests.h"
@@ -0,0 +1 @@
+#include "../MC/InclusionTests.h"
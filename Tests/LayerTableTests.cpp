@@ -0,0 +1 @@
+#include "../MC/LayerTableTests.h"
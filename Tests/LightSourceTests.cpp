@@ -0,0 +1 @@
+#include "../MC/LightSourceTests.h"
@@ -0,0 +1 @@
+#include "../MC/MajorantGridTests.h"
@@ -0,0 +1 @@
+#include "../MC/MonteCarloMultithreadTests.h"
@@ -0,0 +1 @@
+#include "../MC/PartialResultsTests.h"
@@ -0,0 +1 @@
+#include "../MC/QuasiRandomTests.h"
@@ -0,0 +1 @@
+#include "../Math/SobolTests.h"
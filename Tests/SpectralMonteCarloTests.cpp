@@ -0,0 +1 @@
+#include "../MC/SpectralMonteCarloTests.h"
@@ -0,0 +1 @@
+#include "../MC/TallyPolicyTests.h"
@@ -0,0 +1 @@
+#include "../Utils/ThreadPlacementTests.h"
@@ -0,0 +1 @@
+#include "../MC/WeightWindowsTests.h"
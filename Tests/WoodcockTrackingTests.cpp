@@ -0,0 +1 @@
+#include "../MC/WoodcockTrackingTests.h"
@@ -0,0 +1 @@
+#include "../Math/XoshiroTests.h"
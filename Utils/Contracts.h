@@ -4,11 +4,12 @@
 #include <string>
 
 namespace Utils_NS {
+    /// message strings are built only when a contract fails, so passing checks never allocate
     template < typename Exception >
     class Contract {
     public:
-        static void Except(const std::string& file, int line, const std::string& contract, bool value);
-        static void Fail(const std::string& file, int line, const std::string& reason);
+        static void Except(const char* file, int line, const char* contract, bool value);
+        static void Fail(const char* file, int line, const char* reason);
     };
 }
 
@@ -21,7 +22,7 @@ namespace Utils_NS {
 #define FAIL_RANGE_CONTRACT(REASON) FAIL_CONTRACT(REASON, std::out_of_range)
 
 #ifdef ENABLE_CHECK_CONTRACTS
-    #define CHECK_CONTRACT(CONTRACT,EXCEPTION) Utils_NS::Contract<EXCEPTION>::Except(std::string(__FILE__), __LINE__, std::string(#CONTRACT),  CONTRACT)
+    #define CHECK_CONTRACT(CONTRACT,EXCEPTION) Utils_NS::Contract<EXCEPTION>::Except(__FILE__, __LINE__, #CONTRACT, CONTRACT)
     #define FAIL_CONTRACT(REASON,EXCEPTION) throw EXCEPTION(std::string(__FILE__) + ":" + std::to_string(__LINE__) + " - " + std::string(#REASON))
     #define EXCEPT_INPUT_PARAMS
 #else
@@ -35,12 +36,12 @@ namespace Utils_NS {
  ******************/
 
 template < typename Exception >
-void Utils_NS::Contract<Exception>::Except(const std::string& file, int line, const std::string& contract, bool value) {
+void Utils_NS::Contract<Exception>::Except(const char* file, int line, const char* contract, bool value) {
     if (!(value))
-        throw Exception(file + ":" + std::to_string(line) + " - " + contract + " failed");
+        throw Exception(std::string(file) + ":" + std::to_string(line) + " - " + contract + " failed");
 }
 
 template < typename Exception >
-void Utils_NS::Contract<Exception>::Fail(const std::string& file, int line, const std::string& reason) {
-    throw Exception(file + ":" + std::to_string(line) + " - " + reason + " failed");
+void Utils_NS::Contract<Exception>::Fail(const char* file, int line, const char* reason) {
+    throw Exception(std::string(file) + ":" + std::to_string(line) + " - " + reason + " failed");
 }
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <limits>
+#include <new>
+#include <tuple>
+
+#ifdef __linux__
+    #include <sys/mman.h>
+#endif // __linux__
+
+namespace Utils_NS {
+    /// cache line size used for alignment of shared read-only data
+    constexpr std::size_t CACHE_LINE_SIZE = 64;
+    /// transparent huge page size on x86-64 linux
+    constexpr std::size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+    /// \brief STL allocator returning cache-aligned memory, huge-page-backed for big blocks where available
+    /// Blocks smaller than HUGE_PAGE_SIZE are aligned to CACHE_LINE_SIZE.
+    /// Bigger blocks are aligned to HUGE_PAGE_SIZE and on linux are advised to be backed by transparent huge pages.
+    template < typename T >
+    class HugePageAllocator {
+    public:
+        using value_type = T;
+
+        HugePageAllocator() noexcept = default;
+        template < typename U >
+        HugePageAllocator(const HugePageAllocator<U>&) noexcept {}
+
+        /// Allocate memory for n elements
+        /// \param[in] n number of elements
+        /// \return pointer to allocated memory
+        /// \throw std::bad_alloc if allocation failed
+        T* allocate(std::size_t n);
+
+        /// Deallocate memory allocated by allocate
+        /// \param[in] p pointer to memory
+        /// \param[in] n number of elements
+        void deallocate(T* p, std::size_t n) noexcept;
+
+        template < typename U >
+        bool operator == (const HugePageAllocator<U>&) const noexcept { return true;  }
+        template < typename U >
+        bool operator != (const HugePageAllocator<U>&) const noexcept { return false; }
+    };
+}
+
+/******************
+ * IMPLEMENTATION *
+ ******************/
+
+template < typename T >
+T* Utils_NS::HugePageAllocator<T>::allocate(std::size_t n) {
+    using namespace std;
+
+    if (n > numeric_limits<size_t>::max() / sizeof(T))
+        throw bad_alloc();
+
+    const size_t bytes = n * sizeof(T);
+    const size_t alignment = bytes >= HUGE_PAGE_SIZE ? HUGE_PAGE_SIZE : CACHE_LINE_SIZE;
+    const size_t rounded = (bytes + alignment - 1) / alignment * alignment;
+
+    void* p = aligned_alloc(alignment, rounded == 0 ? alignment : rounded);
+    if (p == nullptr)
+        throw bad_alloc();
+
+    #ifdef MADV_HUGEPAGE
+        if (alignment == HUGE_PAGE_SIZE)
+            madvise(p, rounded, MADV_HUGEPAGE);
+    #endif // MADV_HUGEPAGE
+
+    return static_cast<T*>(p);
+}
+
+template < typename T >
+void Utils_NS::HugePageAllocator<T>::deallocate(T* p, std::size_t n) noexcept {
+    std::ignore = n;
+    std::free(p);
+}
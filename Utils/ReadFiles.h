@@ -5,6 +5,7 @@
 #include "../MC/MonteCarlo.h"
 #include "../MC/Sample.h"
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <string>
@@ -78,6 +79,34 @@ void getTimesKinetics(std::vector<T>& times, const std::string& fileName) {
     myFileStream.close();
 }
 
+/// Measured beam image, one row of pixels per line separated by tabs, spaces or commas
+template < typename T >
+void readImage(Eigen::Matrix<T,Eigen::Dynamic,Eigen::Dynamic>& image, const std::string& fileName) {
+    using namespace std;
+
+    ifstream myFileStream(fileName);
+    if (!myFileStream.is_open())
+        cout << "Failed to open file " << fileName << endl;
+
+    vector<vector<T>> rows;
+    string line;
+    while(getline(myFileStream, line)) {
+        replace(line.begin(), line.end(), ',', ' ');
+        stringstream ss(line);
+        vector<T> row;
+        for (double value; ss >> value;)
+            row.push_back(static_cast<T>(value));
+        if (!row.empty())
+            rows.push_back(row);
+    }
+    myFileStream.close();
+
+    image.resize(rows.size(), rows.empty() ? 0 : rows.front().size());
+    for (int i = 0; i < image.rows(); i++)
+        for (int j = 0; j < image.cols(); j++)
+            image(i, j) = j < static_cast<int>(rows[i].size()) ? rows[i][j] : 0;
+}
+
 template < typename T, Inverse_NS::FixedParameter fix >
 void readSettings(const std::string& fileName,
                   Sample<T>& emptySample,
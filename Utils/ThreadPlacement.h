@@ -0,0 +1,204 @@
+#pragma once
+
+#include "Contracts.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+    #include <pthread.h>
+    #include <sched.h>
+#endif // __linux__
+
+namespace Utils_NS {
+    /// worker threads of multithreaded runs are pinned to cpus if ENABLE_THREAD_PINNING is defined
+#ifdef ENABLE_THREAD_PINNING
+    constexpr bool PIN_WORKER_THREADS = true;
+#else
+    constexpr bool PIN_WORKER_THREADS = false;
+#endif // ENABLE_THREAD_PINNING
+
+    /// \brief NUMA nodes of the machine and cpus available to the process on every node
+    struct NumaTopology {
+        /// cpus of every node, nodes without available cpus are skipped
+        std::vector<std::vector<int>> cpus;
+
+        /// Read topology from /sys/devices/system/node on linux,
+        /// falls back to one node with all hardware threads elsewhere or if sysfs is not readable
+        /// \return topology
+        static NumaTopology detect();
+
+        /// Parse linux cpu list
+        /// \param[in] list cpu list like "0-3,8,10-11"
+        /// \return cpus in the list
+        static std::vector<int> parseCpuList(const std::string& list);
+    };
+
+    /// Pin calling thread to cpu
+    /// \param[in] cpu cpu index
+    /// \return if thread was pinned, always false on platforms other than linux
+    bool pinCurrentThread(const int& cpu) noexcept;
+
+    /// \brief Placement of worker threads of a run on NUMA nodes
+    /// Pinned threads are dealt over nodes round robin and pinned to distinct cpus of their node while there are any,
+    /// so data first touched by a worker is allocated on its node. Floating threads are all on one node.
+    /// Nodes are numbered from 0 to getNnodes() - 1 over nodes that got at least one thread.
+    class ThreadPlacement {
+    public:
+        /// \param[in] threads number of worker threads
+        /// \param[in] pinned pin threads to cpus
+        /// \param[in] topology NUMA topology of the machine
+        /// \throw std::invalid_argument if ENABLE_CHECK_CONTRACTS is defined and threads is not positive or topology has no cpus
+        ThreadPlacement(const int& threads, const bool& pinned, const NumaTopology& topology = NumaTopology::detect()) EXCEPT_INPUT_PARAMS;
+
+        /// Run work(thread) on every worker thread and wait for all of them
+        /// \param[in] work callable with worker index
+        template < typename Work >
+        void run(const Work& work) const;
+
+        /// Run work(node) on one thread per node and wait for all of them
+        /// \param[in] work callable with node index
+        template < typename Work >
+        void runPerNode(const Work& work) const;
+
+        inline int getNthreads() const noexcept { return static_cast<int>(nodeOfThread.size()); }
+        inline int getNnodes()   const noexcept { return static_cast<int>(threadsOfNode.size()); }
+        inline bool isPinned()   const noexcept { return pinned; }
+        inline int getNode(const int& thread) const noexcept { return nodeOfThread[thread]; }
+        /// cpu of thread, -1 for floating threads
+        inline int getCpu (const int& thread) const noexcept { return cpuOfThread[thread];  }
+        /// worker threads on node
+        inline const std::vector<int>& getThreads(const int& node) const noexcept { return threadsOfNode[node]; }
+
+    protected:
+        bool pinned;
+        std::vector<int> nodeOfThread;
+        std::vector<int> cpuOfThread;
+        std::vector<std::vector<int>> threadsOfNode;
+    };
+}
+
+/******************
+ * IMPLEMENTATION *
+ ******************/
+
+inline Utils_NS::NumaTopology Utils_NS::NumaTopology::detect() {
+    using namespace std;
+
+    NumaTopology topology;
+#ifdef __linux__
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    const bool restricted = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+
+    for (int node = 0; ; node++) {
+        ifstream file("/sys/devices/system/node/node" + to_string(node) + "/cpulist");
+        if (!file.is_open())
+            break;
+        string list;
+        getline(file, list);
+
+        vector<int> cpus;
+        for (const auto& cpu: parseCpuList(list))
+            if (!restricted || (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed)))
+                cpus.push_back(cpu);
+        if (!cpus.empty())
+            topology.cpus.push_back(cpus);
+    }
+#endif // __linux__
+
+    if (topology.cpus.empty()) {
+        vector<int> cpus(max(1u, thread::hardware_concurrency()));
+        for (int i = 0; i < static_cast<int>(cpus.size()); i++)
+            cpus[i] = i;
+        topology.cpus = {cpus};
+    }
+    return topology;
+}
+
+inline std::vector<int> Utils_NS::NumaTopology::parseCpuList(const std::string& list) {
+    using namespace std;
+
+    vector<int> cpus;
+    stringstream ss(list);
+    string range;
+    while (getline(ss, range, ',')) {
+        if (range.empty())
+            continue;
+        const auto dash = range.find('-');
+        const int first = stoi(range.substr(0, dash));
+        const int last = dash == string::npos ? first : stoi(range.substr(dash + 1));
+        for (int cpu = first; cpu <= last; cpu++)
+            cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+inline bool Utils_NS::pinCurrentThread(const int& cpu) noexcept {
+#ifdef __linux__
+    if (cpu < 0 || cpu >= CPU_SETSIZE)
+        return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    static_cast<void>(cpu);
+    return false;
+#endif // __linux__
+}
+
+inline Utils_NS::ThreadPlacement::ThreadPlacement(const int& threads, const bool& newPinned, const NumaTopology& topology) EXCEPT_INPUT_PARAMS
+    : pinned(newPinned)
+    , nodeOfThread(std::max(threads, 0))
+    , cpuOfThread(std::max(threads, 0), -1) {
+    CHECK_ARGUMENT_CONTRACT(threads > 0);
+    CHECK_ARGUMENT_CONTRACT(!topology.cpus.empty());
+
+    if (!pinned) {
+        threadsOfNode.resize(1);
+        for (int thread = 0; thread < threads; thread++)
+            threadsOfNode[0].push_back(thread);
+        return;
+    }
+
+    const int Nnodes = std::min(threads, static_cast<int>(topology.cpus.size()));
+    threadsOfNode.resize(Nnodes);
+    for (int thread = 0; thread < threads; thread++) {
+        const int node = thread % Nnodes;
+        const auto& cpus = topology.cpus[node];
+        nodeOfThread[thread] = node;
+        cpuOfThread[thread] = cpus[(thread / Nnodes) % cpus.size()];
+        threadsOfNode[node].push_back(thread);
+    }
+}
+
+template < typename Work >
+void Utils_NS::ThreadPlacement::run(const Work& work) const {
+    std::vector<std::thread> workers;
+    for (int thread = 0; thread < getNthreads(); thread++)
+        workers.emplace_back([&, thread]() {
+            if (pinned)
+                pinCurrentThread(cpuOfThread[thread]);
+            work(thread);
+        });
+    for (auto& worker: workers)
+        worker.join();
+}
+
+template < typename Work >
+void Utils_NS::ThreadPlacement::runPerNode(const Work& work) const {
+    std::vector<std::thread> workers;
+    for (int node = 0; node < getNnodes(); node++)
+        workers.emplace_back([&, node]() {
+            if (pinned)
+                pinCurrentThread(cpuOfThread[threadsOfNode[node].front()]);
+            work(node);
+        });
+    for (auto& worker: workers)
+        worker.join();
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#ifndef ENABLE_CHECK_CONTRACTS
+    #define ENABLE_CHECK_CONTRACTS
+#endif // ENABLE_CHECK_CONTRACTS
+
+#include "ThreadPlacement.h"
+
+#include <atomic>
+#include <set>
+#include <vector>
+
+#ifdef __linux__
+    #include <sched.h>
+#endif // __linux__
+
+#include <gtest/gtest.h>
+
+using namespace Utils_NS;
+using namespace std;
+
+TEST(ThreadPlacementTests, ParseCpuList) {
+    EXPECT_EQ(NumaTopology::parseCpuList("0-3,8,10-11"), vector<int>({0, 1, 2, 3, 8, 10, 11}));
+    EXPECT_EQ(NumaTopology::parseCpuList("5"), vector<int>({5}));
+    EXPECT_EQ(NumaTopology::parseCpuList(""), vector<int>());
+}
+
+TEST(ThreadPlacementTests, DetectedTopologyHasDistinctCpus) {
+    const auto topology = NumaTopology::detect();
+    ASSERT_FALSE(topology.cpus.empty());
+
+    set<int> cpus;
+    int count = 0;
+    for (const auto& node: topology.cpus) {
+        EXPECT_FALSE(node.empty());
+        cpus.insert(node.begin(), node.end());
+        count += static_cast<int>(node.size());
+    }
+    EXPECT_EQ(static_cast<int>(cpus.size()), count);
+}
+
+TEST(ThreadPlacementTests, PinnedThreadsAreDealtOverNodes) {
+    const NumaTopology topology{{{0, 1}, {2, 3}}};
+    const ThreadPlacement placement(5, true, topology);
+
+    EXPECT_EQ(placement.getNnodes(), 2);
+    EXPECT_EQ(placement.getThreads(0), vector<int>({0, 2, 4}));
+    EXPECT_EQ(placement.getThreads(1), vector<int>({1, 3}));
+    const vector<int> cpus = {0, 2, 1, 3, 0};
+    for (int thread = 0; thread < 5; thread++)
+        EXPECT_EQ(placement.getCpu(thread), cpus[thread]);
+}
+
+TEST(ThreadPlacementTests, FewThreadsUseFewNodes) {
+    const NumaTopology topology{{{0, 1}, {2, 3}, {4, 5}}};
+    const ThreadPlacement placement(2, true, topology);
+
+    EXPECT_EQ(placement.getNnodes(), 2);
+    EXPECT_EQ(placement.getCpu(0), 0);
+    EXPECT_EQ(placement.getCpu(1), 2);
+}
+
+TEST(ThreadPlacementTests, FloatingThreadsAreOnOneNode) {
+    const NumaTopology topology{{{0, 1}, {2, 3}}};
+    const ThreadPlacement placement(3, false, topology);
+
+    EXPECT_EQ(placement.getNnodes(), 1);
+    EXPECT_EQ(placement.getThreads(0), vector<int>({0, 1, 2}));
+    for (int thread = 0; thread < 3; thread++) {
+        EXPECT_EQ(placement.getNode(thread), 0);
+        EXPECT_EQ(placement.getCpu(thread), -1);
+    }
+}
+
+TEST(ThreadPlacementTests, Throws) {
+    EXPECT_THROW(ThreadPlacement(0, true), invalid_argument);
+    EXPECT_THROW(ThreadPlacement(2, true, NumaTopology()), invalid_argument);
+}
+
+TEST(ThreadPlacementTests, RunVisitsEveryThreadAndNode) {
+    const ThreadPlacement placement(6, true);
+    vector<atomic<int>> visits(6);
+    placement.run([&](const int& thread) { visits[thread]++; });
+    for (const auto& count: visits)
+        EXPECT_EQ(count, 1);
+
+    vector<atomic<int>> nodeVisits(placement.getNnodes());
+    placement.runPerNode([&](const int& node) { nodeVisits[node]++; });
+    for (const auto& count: nodeVisits)
+        EXPECT_EQ(count, 1);
+}
+
+#ifdef __linux__
+TEST(ThreadPlacementTests, PinnedThreadsRunOnTheirCpus) {
+    const ThreadPlacement placement(4, true);
+    vector<int> cpus(4, -1);
+    placement.run([&](const int& thread) { cpus[thread] = sched_getcpu(); });
+    for (int thread = 0; thread < 4; thread++)
+        EXPECT_EQ(cpus[thread], placement.getCpu(thread));
+}
+#endif // __linux__
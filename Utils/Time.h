@@ -163,142 +163,142 @@ namespace Utils_NS {
  * IMPLEMENTATION *
  ******************/
 
-void Utils_NS::Time::reset() noexcept {
+inline void Utils_NS::Time::reset() noexcept {
     overall_time = 0;
 }
 
-void Utils_NS::Time::start() noexcept {
+inline void Utils_NS::Time::start() noexcept {
     time_start = std::chrono::high_resolution_clock::now();
 }
 
-void Utils_NS::Time::finish() noexcept {
+inline void Utils_NS::Time::finish() noexcept {
     time_finish = std::chrono::high_resolution_clock::now();
     auto elapsed = std::chrono::duration_cast < std::chrono::microseconds > (time_finish - time_start);
     overall_time += elapsed.count();
 }
 
-unsigned long long Utils_NS::Time::usecOverallDuration() const noexcept {
+inline unsigned long long Utils_NS::Time::usecOverallDuration() const noexcept {
     return overall_time;
 }
 
-unsigned long long Utils_NS::Time::msecOverallDuration() const noexcept {
+inline unsigned long long Utils_NS::Time::msecOverallDuration() const noexcept {
     return overall_time / 1000;
 }
 
-unsigned long long Utils_NS::Time::secOverallDuration() const noexcept {
+inline unsigned long long Utils_NS::Time::secOverallDuration() const noexcept {
     return overall_time / 1000 / 1000;
 }
 
-void Utils_NS::Time::setOverallDuration(const unsigned long long& new_duration) noexcept {
+inline void Utils_NS::Time::setOverallDuration(const unsigned long long& new_duration) noexcept {
     overall_time = new_duration;
 }
 
-void Utils_NS::Time::addOverallDuration(const unsigned long long& new_duration) noexcept {
+inline void Utils_NS::Time::addOverallDuration(const unsigned long long& new_duration) noexcept {
     overall_time += new_duration;
 }
 
-double Utils_NS::Time::nsecElapsed(const std::chrono::high_resolution_clock::time_point& time) const noexcept {
+inline double Utils_NS::Time::nsecElapsed(const std::chrono::high_resolution_clock::time_point& time) const noexcept {
     auto elapsed = std::chrono::duration_cast < std::chrono::nanoseconds > (time - time_start);
     return elapsed.count();
 }
 
-double Utils_NS::Time::usecElapsed(const std::chrono::high_resolution_clock::time_point& time) const noexcept {
+inline double Utils_NS::Time::usecElapsed(const std::chrono::high_resolution_clock::time_point& time) const noexcept {
     auto elapsed = std::chrono::duration_cast < std::chrono::microseconds > (time - time_start);
     return elapsed.count();
 }
 
-double Utils_NS::Time::msecElapsed(const std::chrono::high_resolution_clock::time_point& time) const noexcept {
+inline double Utils_NS::Time::msecElapsed(const std::chrono::high_resolution_clock::time_point& time) const noexcept {
     auto elapsed = std::chrono::duration_cast < std::chrono::milliseconds > (time - time_start);
     return elapsed.count();
 }
 
-double Utils_NS::Time::secElapsed(const std::chrono::high_resolution_clock::time_point& time) const noexcept {
+inline double Utils_NS::Time::secElapsed(const std::chrono::high_resolution_clock::time_point& time) const noexcept {
     auto elapsed = std::chrono::duration_cast < std::chrono::seconds > (time - time_start);
     return elapsed.count();
 }
 
-double Utils_NS::Time::nsecElapsedNow() const noexcept {
+inline double Utils_NS::Time::nsecElapsedNow() const noexcept {
     return nsecElapsed(std::chrono::high_resolution_clock::now());
 }
 
-double Utils_NS::Time::nsecElapsedDuration() const noexcept {
+inline double Utils_NS::Time::nsecElapsedDuration() const noexcept {
     return nsecElapsed(time_finish);
 }
 
-double Utils_NS::Time::usecElapsedNow() const noexcept {
+inline double Utils_NS::Time::usecElapsedNow() const noexcept {
     return usecElapsed(std::chrono::high_resolution_clock::now());
 }
 
-double Utils_NS::Time::usecElapsedDuration() const noexcept {
+inline double Utils_NS::Time::usecElapsedDuration() const noexcept {
     return usecElapsed(time_finish);
 }
 
-double Utils_NS::Time::msecElapsedNow() const noexcept {
+inline double Utils_NS::Time::msecElapsedNow() const noexcept {
     return msecElapsed(std::chrono::high_resolution_clock::now());
 }
 
-double Utils_NS::Time::msecElapsedDuration() const noexcept {
+inline double Utils_NS::Time::msecElapsedDuration() const noexcept {
     return msecElapsed(time_finish);
 }
 
-double Utils_NS::Time::secElapsedNow() const noexcept {
+inline double Utils_NS::Time::secElapsedNow() const noexcept {
     return secElapsed(std::chrono::high_resolution_clock::now());
 }
 
-double Utils_NS::Time::secElapsedDuration() const noexcept {
+inline double Utils_NS::Time::secElapsedDuration() const noexcept {
     return secElapsed(time_finish);
 }
 
-unsigned long long Utils_NS::Time::msecSinceEpoch(const std::chrono::high_resolution_clock::time_point& time) const noexcept {
+inline unsigned long long Utils_NS::Time::msecSinceEpoch(const std::chrono::high_resolution_clock::time_point& time) const noexcept {
     return 1000 * secSinceEpoch(time);
 }
 
-unsigned long long Utils_NS::Time::secSinceEpoch(const std::chrono::high_resolution_clock::time_point& time) const noexcept {
+inline unsigned long long Utils_NS::Time::secSinceEpoch(const std::chrono::high_resolution_clock::time_point& time) const noexcept {
     return time.time_since_epoch() / std::chrono::seconds(1);
 }
 
-unsigned long long Utils_NS::Time::msecSinceEpochNow() const noexcept {
+inline unsigned long long Utils_NS::Time::msecSinceEpochNow() const noexcept {
     return msecSinceEpoch(std::chrono::high_resolution_clock::now());
 }
 
-unsigned long long Utils_NS::Time::msecSinceEpochStart() const noexcept {
+inline unsigned long long Utils_NS::Time::msecSinceEpochStart() const noexcept {
     return msecSinceEpoch(time_start);
 }
 
-unsigned long long Utils_NS::Time::msecSinceEpochFinish() const noexcept {
+inline unsigned long long Utils_NS::Time::msecSinceEpochFinish() const noexcept {
     return msecSinceEpoch(time_finish);
 }
 
-unsigned long long Utils_NS::Time::secSinceEpochNow() const noexcept {
+inline unsigned long long Utils_NS::Time::secSinceEpochNow() const noexcept {
     return secSinceEpoch(std::chrono::high_resolution_clock::now());
 }
 
-unsigned long long Utils_NS::Time::secSinceEpochStart() const noexcept {
+inline unsigned long long Utils_NS::Time::secSinceEpochStart() const noexcept {
     return secSinceEpoch(time_start);
 }
 
-unsigned long long Utils_NS::Time::secSinceEpochFinish() const noexcept {
+inline unsigned long long Utils_NS::Time::secSinceEpochFinish() const noexcept {
     return secSinceEpoch(time_finish);
 }
 
-std::string Utils_NS::Time::to_string_and_appbegin(const int& value, const size_t& min_length) const noexcept {
+inline std::string Utils_NS::Time::to_string_and_appbegin(const int& value, const size_t& min_length) const noexcept {
     std::string result = std::to_string(value);
     while (result.length() < min_length)
         result = "0" + result;
     return result;
 }
 
-std::string Utils_NS::Time::getCurrentTime() noexcept {
+inline std::string Utils_NS::Time::getCurrentTime() noexcept {
     getCurrentDateTime();
     return current_time;
 }
 
-std::string Utils_NS::Time::getCurrentDate() noexcept {
+inline std::string Utils_NS::Time::getCurrentDate() noexcept {
     getCurrentDateTime();
     return current_date;
 }
 
-std::string Utils_NS::Time::getCurrentDateTime() noexcept {
+inline std::string Utils_NS::Time::getCurrentDateTime() noexcept {
     std::time_t current_date_time = std::time(nullptr);
     std::tm* now = std::localtime(&current_date_time);
 
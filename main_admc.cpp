@@ -4,6 +4,7 @@
 #include "Scripts/DirectMC.h"
 #include "Scripts/DirectHeterogeneousMC.h"
 #include "Scripts/InverseMC.h"
+#include "Scripts/ShardMC.h"
 #include "Scripts/SpoiltData.h"
 #include "Scripts/KineticsIMC.h"
 //#include "MC/MonteCarloTests.h"
@@ -55,6 +56,9 @@ int main() {
     cout << "THE FOLLOWING MODES ARE FOR INVERSE PROBLEM TESTING (ADDING ERRORS TO DATA):" << endl;
     cout << "MODE 5: Direct + inverse problem for fixed/moveable spheres and one set of parameters" << endl;
     cout << "MODE 6: Direct + inverse problem for fixed/moveable spheres and several sets of parameters (grid of taus 0.5 0.75 1.0 1.5 2.0 4.0)" << endl;
+    cout << "THE FOLLOWING MODES ARE FOR RUNS SPLIT OVER SEVERAL PROCESSES:" << endl;
+    cout << "MODE 7: one shard of R(z) and T(z) run, writes partial results" << endl;
+    cout << "MODE 8: merge partial results of all shards of R(z) and T(z) run" << endl;
     cin >> mode;
 
     string settingsFname = "Settings & input files/SETTINGS.txt";
@@ -139,6 +143,39 @@ int main() {
             inT = gridT(i);
             spoiltData<T,2,FixedParameter::Tau,M,Nz,Nr,detector>(inA, inT, inG, inN, inD, inNG, inDG, inNG, inDG, moveable, Nthreads, err);
         }
+    } else if (mode == 7) {
+        cout << "Enter tissue and glass parameters: a tau g nGlassTop dGlassTop n d nGlassBottom dGlassBottom" << endl;
+        cin >> inA >> inT >> inG >> inNglassTop >> inDglassTop >> inN >> inD >> inNglassBottom >> inDglassBottom;
+
+        bool moveable;
+        cout << "Moveable = 1, fixed = 0" << endl;
+        cin >> moveable;
+
+        double Nphotons;
+        cout << "Enter number of photons of the whole run" << endl;
+        cin >> Nphotons;
+
+        int shard, Nshards;
+        cout << "Enter shard index and number of shards" << endl;
+        cin >> shard >> Nshards;
+
+        uint64_t seed;
+        cout << "Enter seed, the same for all shards" << endl;
+        cin >> seed;
+
+        int Nthreads;
+        cout << "Enter number of threads" << endl;
+        cin >> Nthreads;
+        shardMC<T,Nz,Nr,detector>(inA, inT, inG, inNglassTop, inDglassTop, inN, inD, inNglassBottom, inDglassBottom, moveable,
+                                  static_cast<int64_t>(Nphotons), shard, Nshards, seed, Nthreads);
+    } else if (mode == 8) {
+        cout << "Enter tissue parameters: a tau g" << endl;
+        cin >> inA >> inT >> inG;
+
+        int Nshards;
+        cout << "Enter number of shards" << endl;
+        cin >> Nshards;
+        MCresults<T,Nz,Nr,detector> myRes = mergeShards<T,Nz,Nr,detector>(inA, inT, inG, Nshards, 1);
     }
 
     return 0;